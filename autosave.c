@@ -20,8 +20,20 @@
 #include <boolean.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include "file_ops.h"
 #include "general.h"
 
+/* SRAM is compared to the last save page by page, taking the lock
+ * for a batch of pages at a time, so that the core never waits
+ * more than a few microseconds for it. */
+#define AUTOSAVE_PAGE_SIZE     4096
+#define AUTOSAVE_BATCH_PAGES   16
+
+/* Passes over SRAM which may still find changes, before copying
+ * all of it under the lock. */
+#define AUTOSAVE_MAX_PASSES    4
+
 struct autosave
 {
    volatile bool quit;
@@ -60,6 +72,80 @@ static void autosave_unlock(autosave_t *handle)
    slock_unlock(handle->lock);
 }
 
+/**
+ * autosave_snapshot_pass:
+ * @handle          : pointer to autosave object
+ *
+ * Copies the pages of SRAM which changed since the last pass,
+ * letting the core run between batches of pages.
+ *
+ * Returns: true (1) if any page changed, otherwise false (0).
+ **/
+static bool autosave_snapshot_pass(autosave_t *handle)
+{
+   size_t offset      = 0;
+   bool differ        = false;
+   uint8_t *buffer    = (uint8_t*)handle->buffer;
+   const uint8_t *ram = (const uint8_t*)handle->retro_buffer;
+
+   while (offset < handle->bufsize)
+   {
+      size_t end = offset + AUTOSAVE_PAGE_SIZE * AUTOSAVE_BATCH_PAGES;
+
+      if (end > handle->bufsize)
+         end = handle->bufsize;
+
+      autosave_lock(handle);
+
+      for (; offset < end; offset += AUTOSAVE_PAGE_SIZE)
+      {
+         size_t size = end - offset;
+
+         if (size > AUTOSAVE_PAGE_SIZE)
+            size = AUTOSAVE_PAGE_SIZE;
+
+         if (memcmp(buffer + offset, ram + offset, size) == 0)
+            continue;
+
+         memcpy(buffer + offset, ram + offset, size);
+         differ = true;
+      }
+
+      autosave_unlock(handle);
+   }
+
+   return differ;
+}
+
+/**
+ * autosave_snapshot:
+ * @handle          : pointer to autosave object
+ *
+ * Copies the pages of SRAM which changed since the last save.
+ * A pass may hold pages from different frames, so passes are
+ * repeated until one finds no more changes. Should SRAM keep
+ * changing, the last copy is taken in one go under the lock.
+ *
+ * Returns: true (1) if any page changed, otherwise false (0).
+ **/
+static bool autosave_snapshot(autosave_t *handle)
+{
+   unsigned i;
+
+   if (!autosave_snapshot_pass(handle))
+      return false;
+
+   for (i = 0; i < AUTOSAVE_MAX_PASSES; i++)
+      if (!autosave_snapshot_pass(handle))
+         return true;
+
+   autosave_lock(handle);
+   memcpy(handle->buffer, handle->retro_buffer, handle->bufsize);
+   autosave_unlock(handle);
+
+   return true;
+}
+
 /**
  * autosave_thread:
  * @data            : pointer to autosave object
@@ -73,41 +159,22 @@ static void autosave_thread(void *data)
 
    while (!save->quit)
    {
-      bool differ = false;
-
-      autosave_lock(save);
-      differ = memcmp(save->buffer, save->retro_buffer,
-            save->bufsize) != 0;
-      if (differ)
-         memcpy(save->buffer, save->retro_buffer, save->bufsize);
-      autosave_unlock(save);
-
-      if (differ)
+      if (autosave_snapshot(save))
       {
-         /* Should probably deal with this more elegantly. */
-         FILE *file = fopen(save->path, "wb");
-
-         if (file)
+         /* Avoid spamming down stderr ... */
+         if (first_log)
          {
-            bool failed = false;
-
-            /* Avoid spamming down stderr ... */
-            if (first_log)
-            {
-               RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
-                     save->path, save->interval);
-               first_log = false;
-            }
-            else
-               RARCH_LOG("SRAM changed ... autosaving ...\n");
-
-            failed |= fwrite(save->buffer, 1, save->bufsize, file)
-               != save->bufsize;
-            failed |= fflush(file) != 0;
-            failed |= fclose(file) != 0;
-            if (failed)
-               RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+            RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
+                  save->path, save->interval);
+            first_log = false;
          }
+         else
+            RARCH_LOG("SRAM changed ... autosaving ...\n");
+
+         /* The old save stays in place until the new one
+          * is completely written out. */
+         if (!write_file_atomic(save->path, save->buffer, save->bufsize))
+            RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
       }
 
       slock_lock(save->cond_lock);
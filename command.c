@@ -37,6 +37,7 @@
 
 #include "command.h"
 
+#include "frame_stats.h"
 #include "general.h"
 #include "runloop.h"
 
@@ -53,9 +54,13 @@ struct rarch_cmd
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
    int net_fd;
+   /* Sender of the message being parsed, replies go there. */
+   struct sockaddr_storage reply_addr;
+   socklen_t reply_addr_len;
 #endif
 
-   bool state[RARCH_BIND_LIST_END];
+   /* Keys pressed through commands, indexed by bind ID. */
+   uint64_t state;
 };
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
@@ -180,6 +185,12 @@ struct cmd_action_map
    const char *arg_desc;
 };
 
+struct cmd_query_map
+{
+   const char *str;
+   size_t (*query)(char *s, size_t len);
+};
+
 static const struct cmd_map map[] = {
    { "FAST_FORWARD",           RARCH_FAST_FORWARD_KEY },
    { "FAST_FORWARD_HOLD",      RARCH_FAST_FORWARD_HOLD_KEY },
@@ -255,10 +266,84 @@ static bool cmd_set_shader(const char *arg)
    return video_driver_set_shader(type, arg);
 }
 
+/**
+ * cmd_dump_frame_stats:
+ * @arg                 : File name.
+ *
+ * Writes the frame statistics to @arg in the config directory.
+ * Commands can come from anyone able to reach the network
+ * command port, so @arg may not hold a directory.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool cmd_dump_frame_stats(const char *arg)
+{
+   const char *c;
+   char config_dir[PATH_MAX_LENGTH] = {0};
+   char path[PATH_MAX_LENGTH]       = {0};
+   settings_t *settings             = config_get_ptr();
+   global_t   *global               = global_get_ptr();
+
+   if (!*arg || !strcmp(arg, ".") || !strcmp(arg, ".."))
+      goto error;
+
+   for (c = arg; *c; c++)
+      if (path_char_is_slash(*c) || *c == ':')
+         goto error;
+
+   if (*settings->menu_config_directory)
+      strlcpy(config_dir, settings->menu_config_directory,
+            sizeof(config_dir));
+   else if (*global->path.config)
+      fill_pathname_basedir(config_dir, global->path.config,
+            sizeof(config_dir));
+   else
+   {
+      RARCH_ERR("%s\n", msg_hash_to_str(MSG_CONFIG_DIRECTORY_NOT_SET));
+      return false;
+   }
+
+   fill_pathname_join(path, config_dir, arg, sizeof(path));
+
+   if (!frame_stats_dump(path))
+      return false;
+
+   RARCH_LOG("Frame statistics written to \"%s\".\n", path);
+   return true;
+
+error:
+   RARCH_ERR("DUMP_FRAME_STATS takes a file name without a directory.\n");
+   return false;
+}
+
+static size_t cmd_reset_frame_stats(char *s, size_t len)
+{
+   frame_stats_reset();
+   return strlcpy(s, "OK\n", len);
+}
+
 static const struct cmd_action_map action_map[] = {
-   { "SET_SHADER", cmd_set_shader, "<shader path>" },
+   { "SET_SHADER",       cmd_set_shader,       "<shader path>" },
+   { "DUMP_FRAME_STATS", cmd_dump_frame_stats, "<file name>" },
+};
+
+/* Commands answered to their sender. */
+static const struct cmd_query_map query_map[] = {
+   { "GET_FRAME_STATS",   frame_stats_get_summary },
+   { "RESET_FRAME_STATS", cmd_reset_frame_stats },
 };
 
+static const struct cmd_query_map *command_get_query(const char *tok)
+{
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(query_map); i++)
+      if (!strcmp(tok, query_map[i].str))
+         return &query_map[i];
+
+   return NULL;
+}
+
 static bool command_get_arg(const char *tok,
       const char **arg, unsigned *index)
 {
@@ -300,12 +385,35 @@ static bool command_get_arg(const char *tok,
    return false;
 }
 
+static void cmd_reply(rarch_cmd_t *handle, const char *data, size_t len)
+{
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   if (handle->reply_addr_len)
+   {
+      sendto(handle->net_fd, data, len, 0,
+            (struct sockaddr*)&handle->reply_addr, handle->reply_addr_len);
+      return;
+   }
+#endif
+
+   fwrite(data, 1, len, stdout);
+   fflush(stdout);
+}
+
 static void parse_sub_msg(rarch_cmd_t *handle, const char *tok)
 {
-   const char *arg = NULL;
-   unsigned index  = 0;
+   const char *arg                    = NULL;
+   unsigned index                     = 0;
+   const struct cmd_query_map *query  = command_get_query(tok);
 
-   if (command_get_arg(tok, &arg, &index))
+   if (query)
+   {
+      char reply[1024];
+      size_t len = query->query(reply, sizeof(reply));
+
+      cmd_reply(handle, reply, len);
+   }
+   else if (command_get_arg(tok, &arg, &index))
    {
       if (arg)
       {
@@ -313,7 +421,7 @@ static void parse_sub_msg(rarch_cmd_t *handle, const char *tok)
             RARCH_ERR("Command \"%s\" failed.\n", arg);
       }
       else
-         handle->state[map[index].id] = true;
+         BIT64_SET(handle->state, map[index].id);
    }
    else
       RARCH_WARN("%s \"%s\" %s.\n",
@@ -337,12 +445,17 @@ static void parse_msg(rarch_cmd_t *handle, char *buf)
 void rarch_cmd_set(rarch_cmd_t *handle, unsigned id)
 {
    if (id < RARCH_BIND_LIST_END)
-      handle->state[id] = true;
+      BIT64_SET(handle->state, id);
 }
 
 bool rarch_cmd_get(rarch_cmd_t *handle, unsigned id)
 {
-   return id < RARCH_BIND_LIST_END && handle->state[id];
+   return id < RARCH_BIND_LIST_END && BIT64_GET(handle->state, id);
+}
+
+uint64_t rarch_cmd_get_keys(rarch_cmd_t *handle)
+{
+   return handle->state;
 }
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
@@ -366,8 +479,11 @@ static void network_cmd_poll(rarch_cmd_t *handle)
    for (;;)
    {
       char buf[1024];
-      ssize_t ret = recvfrom(handle->net_fd, buf,
-            sizeof(buf) - 1, 0, NULL, NULL);
+      ssize_t ret;
+
+      handle->reply_addr_len = sizeof(handle->reply_addr);
+      ret = recvfrom(handle->net_fd, buf, sizeof(buf) - 1, 0,
+            (struct sockaddr*)&handle->reply_addr, &handle->reply_addr_len);
 
       if (ret <= 0)
          break;
@@ -375,6 +491,8 @@ static void network_cmd_poll(rarch_cmd_t *handle)
       buf[ret] = '\0';
       parse_msg(handle, buf);
    }
+
+   handle->reply_addr_len = 0;
 }
 #endif
 
@@ -530,7 +648,7 @@ static void stdin_cmd_poll(rarch_cmd_t *handle)
 
 void rarch_cmd_poll(rarch_cmd_t *handle)
 {
-   memset(handle->state, 0, sizeof(handle->state));
+   BIT64_CLEAR_ALL(handle->state);
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
    network_cmd_poll(handle);
@@ -542,8 +660,39 @@ void rarch_cmd_poll(rarch_cmd_t *handle)
 }
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+/**
+ * wait_udp_reply:
+ * @fd                  : Socket the command was sent from.
+ *
+ * Waits up to a second for the answer to a query
+ * and prints it.
+ *
+ * Returns: true if an answer arrived, otherwise false.
+ **/
+static bool wait_udp_reply(int fd)
+{
+   fd_set fds;
+   char buf[1024];
+   ssize_t ret;
+   struct timeval tv = {1, 0};
+
+   FD_ZERO(&fds);
+   FD_SET(fd, &fds);
+
+   if (socket_select(fd + 1, &fds, NULL, NULL, &tv) <= 0)
+      return false;
+
+   ret = recvfrom(fd, buf, sizeof(buf), 0, NULL, NULL);
+   if (ret <= 0)
+      return false;
+
+   fwrite(buf, 1, ret, stdout);
+   fflush(stdout);
+   return true;
+}
+
 static bool send_udp_packet(const char *host,
-      uint16_t port, const char *msg)
+      uint16_t port, const char *msg, bool wait_reply)
 {
    char port_buf[16]           = {0};
    struct addrinfo hints       = {0};
@@ -586,6 +735,10 @@ static bool send_udp_packet(const char *host,
          goto end;
       }
 
+      /* Stop at the first target that answers. */
+      if (wait_reply && wait_udp_reply(fd))
+         goto end;
+
       socket_close(fd);
       fd = -1;
       tmp = tmp->ai_next;
@@ -602,7 +755,7 @@ static bool verify_command(const char *cmd)
 {
    unsigned i;
 
-   if (command_get_arg(cmd, NULL, NULL))
+   if (command_get_query(cmd) || command_get_arg(cmd, NULL, NULL))
       return true;
 
    RARCH_ERR("Command \"%s\" is not recognized by the program.\n", cmd);
@@ -613,6 +766,9 @@ static bool verify_command(const char *cmd)
    for (i = 0; i < sizeof(action_map) / sizeof(action_map[0]); i++)
       RARCH_ERR("\t\t%s %s\n", action_map[i].str, action_map[i].arg_desc);
 
+   for (i = 0; i < sizeof(query_map) / sizeof(query_map[0]); i++)
+      RARCH_ERR("\t\t%s\n", query_map[i].str);
+
    return false;
 }
 
@@ -658,7 +814,8 @@ bool network_cmd_send(const char *cmd_)
          msg_hash_to_str(MSG_SENDING_COMMAND),
          cmd, host, (unsigned short)port);
 
-   ret = verify_command(cmd) && send_udp_packet(host, port, cmd);
+   ret = verify_command(cmd) && send_udp_packet(host, port, cmd,
+         command_get_query(cmd) != NULL);
    free(command);
 
    global->verbosity = old_verbose;
@@ -41,6 +41,10 @@ void rarch_cmd_set(rarch_cmd_t *handle, unsigned id);
 
 bool rarch_cmd_get(rarch_cmd_t *handle, unsigned id);
 
+/* Keys pressed through commands since the last poll,
+ * indexed by bind ID. */
+uint64_t rarch_cmd_get_keys(rarch_cmd_t *handle);
+
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
 bool network_cmd_send(const char *cmd);
 #endif
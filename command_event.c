@@ -19,6 +19,9 @@
 
 #include "general.h"
 #include "performance.h"
+#include "frame_stats.h"
+#include "runahead.h"
+#include "replay_hash.h"
 #include "dynamic.h"
 #include "content.h"
 #include "screenshot.h"
@@ -179,6 +182,36 @@ static void event_init_movie(void)
       }
 
       global->bsv.movie_playback = true;
+
+      /* Older movies have no frame boundaries, they are
+       * converted by recording them as they play back. */
+      if (*global->bsv.convert_path &&
+            !(global->bsv.convert = bsv_movie_init(global->bsv.convert_path,
+                  RARCH_MOVIE_RECORD)))
+         rarch_fail(1, "event_init_movie()");
+
+      if (global->bsv.start_frame)
+      {
+         uint64_t reached = 0;
+
+         if (!bsv_movie_seek(global->bsv.movie,
+                  global->bsv.start_frame, &reached))
+         {
+            RARCH_ERR("Could not seek movie to frame %llu, "
+                  "only BSV2 movies can be seeked.\n",
+                  (unsigned long long)global->bsv.start_frame);
+            rarch_fail(1, "event_init_movie()");
+         }
+
+         RARCH_LOG("Seeked movie to keyframe %llu.\n",
+               (unsigned long long)reached);
+      }
+
+      if ((*global->bsv.hash_log_path || *global->bsv.hash_check_path)
+            && !replay_hash_init(global->bsv.hash_log_path,
+               global->bsv.hash_check_path, global->bsv.start_frame))
+         rarch_fail(1, "event_init_movie()");
+
       rarch_main_msg_queue_push_new(MSG_STARTING_MOVIE_PLAYBACK, 2, 180, false);
       RARCH_LOG("%s.\n", msg_hash_to_str(MSG_STARTING_MOVIE_PLAYBACK));
       settings->rewind_granularity = 1;
@@ -534,6 +567,8 @@ static void event_deinit_core(bool reinit)
    global_t *global     = global_get_ptr();
    settings_t *settings = config_get_ptr();
 
+   runahead_deinit();
+
    pretro_unload_game();
    pretro_deinit();
 
@@ -905,14 +940,24 @@ static bool event_save_core_config(void)
  * @s               : Message.
  * @len             : Size of @s.
  *
- * Saves a state with path being @path.
+ * Saves a state with path being @path. The state is written
+ * in the background, @s is only set if it could not be saved.
  **/
 static void event_save_state(const char *path,
       char *s, size_t len)
 {
-   settings_t *settings = config_get_ptr();
+   char msg[PATH_MAX_LENGTH] = {0};
+   settings_t *settings      = config_get_ptr();
 
-   if (!save_state(path))
+   if (settings->state_slot < 0)
+      snprintf(msg, sizeof(msg), "%s #-1 (auto).",
+            msg_hash_to_str(MSG_SAVED_STATE_TO_SLOT));
+   else
+      snprintf(msg, sizeof(msg), "%s #%d.",
+            msg_hash_to_str(MSG_SAVED_STATE_TO_SLOT),
+            settings->state_slot);
+
+   if (!save_state_async(path, msg))
    {
       snprintf(s, len, "%s \"%s\".",
             msg_hash_to_str(MSG_FAILED_TO_SAVE_STATE_TO),
@@ -920,11 +965,14 @@ static void event_save_state(const char *path,
       return;
    }
 
-   if (settings->state_slot < 0)
-      snprintf(s, len, "%s #-1 (auto).", msg_hash_to_str(MSG_SAVED_STATE_TO_SLOT));
-   else
-      snprintf(s, len, "%s #%d.", msg_hash_to_str(MSG_SAVED_STATE_TO_SLOT),
-            settings->state_slot);
+   if (settings->savestate_thumbnail_enable)
+   {
+      char thumbnail_path[PATH_MAX_LENGTH] = {0};
+
+      fill_pathname_join_delim(thumbnail_path, path, "png",
+            '.', sizeof(thumbnail_path));
+      take_savestate_thumbnail(thumbnail_path);
+   }
 }
 
 /**
@@ -985,6 +1033,10 @@ static void event_main_state(unsigned cmd)
    else
       strlcpy(msg, msg_hash_to_str(MSG_CORE_DOES_NOT_SUPPORT_SAVESTATES), sizeof(msg));
 
+   /* Saved states report back once written. */
+   if (msg[0] == '\0')
+      return;
+
    rarch_main_msg_queue_push(msg, 2, 180, true);
    RARCH_LOG("%s\n", msg);
 }
@@ -1534,6 +1586,9 @@ bool event_command(enum event_command cmd)
          if (global->bsv.movie)
             bsv_movie_free(global->bsv.movie);
          global->bsv.movie = NULL;
+         bsv_movie_free(global->bsv.convert);
+         global->bsv.convert = NULL;
+         replay_hash_deinit();
          break;
       case EVENT_CMD_BSV_MOVIE_INIT:
          event_command(EVENT_CMD_BSV_MOVIE_DEINIT);
@@ -1698,6 +1753,7 @@ bool event_command(enum event_command cmd)
          break;
       case EVENT_CMD_PERFCNT_REPORT_FRONTEND_LOG:
          rarch_perf_log();
+         frame_stats_log();
          break;
       case EVENT_CMD_VOLUME_UP:
          event_set_volume(0.5f);
@@ -413,6 +413,10 @@ static const unsigned hard_sync_frames = 0;
  */
 static const unsigned frame_delay = 0;
 
+/* Picks the frame delay from how long recent frames took,
+ * instead of using a fixed one. Requires VSync. */
+static const bool frame_delay_auto = false;
+
 /* Inserts a black frame inbetween frames.
  * Useful for 120 Hz monitors who want to play 60 Hz material with eliminated
  * ghosting. video_refresh_rate should still be configured as if it
@@ -566,6 +570,17 @@ static const bool post_filter_record = false;
 /* Screenshots post-shaded GPU output if available. */
 static const bool gpu_screenshot = true;
 
+/* PNG screenshot deflate level, 1 (fastest) to 9 (smallest).
+ * Levels 3 and below also use cheaper line filtering. */
+static const unsigned screenshot_png_level = 9;
+
+/* Number of threads used to encode a PNG screenshot. */
+#ifdef HAVE_THREADS
+static const unsigned screenshot_png_threads = 2;
+#else
+static const unsigned screenshot_png_threads = 1;
+#endif
+
 /* Record post-shaded GPU output instead of raw game footage if available. */
 static const bool gpu_record = false;
 
@@ -645,6 +660,15 @@ static const unsigned rewind_buffer_size = 20 << 20; /* 20MiB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Number of frames to run ahead of the displayed one, hiding
+ * that much of the input lag built into the emulated system.
+ * Requires save state support, a value of 0 disables it. */
+static const unsigned run_ahead_frames = 0;
+
+/* Run ahead in a second instance of the core, so the audio
+ * of the first one is never disturbed by loading states. */
+static const bool run_ahead_secondary_instance = false;
+
 /* Pause gameplay when gameplay loses focus. */
 static const bool pause_nonactive = false;
 
@@ -673,6 +697,11 @@ static const bool savestate_auto_index = false;
 static const bool savestate_auto_save = false;
 static const bool savestate_auto_load = false;
 
+/* Saves a PNG thumbnail of the current frame ($STATE_PATH.png) and
+ * a metadata file ($STATE_PATH.meta) alongside each savestate, so
+ * states can be browsed without loading them. */
+static const bool savestate_thumbnail_enable = false;
+
 /* Slowmotion ratio. */
 static const float slowmotion_ratio = 3.0;
 
@@ -723,6 +752,15 @@ static const unsigned turbo_duty_cycle = 3;
  * gamepads, plug-and-play style. */
 static const bool input_autodetect_enable = true;
 
+/* Read input devices on a separate thread as soon as events
+ * arrive, instead of once per frame. Only supported by the
+ * udev input and joypad drivers. */
+static const bool input_threaded = false;
+
+/* Poll input when the core first reads it, instead of when
+ * it asks for a poll, which can be well before in the frame. */
+static const bool input_poll_late = false;
+
 /* Show the input descriptors set by the core instead
  * of the default ones. */
 static const bool input_descriptor_label_show = true;
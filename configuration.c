@@ -478,6 +478,7 @@ static void config_set_defaults(void)
    settings->video.hard_sync             = hard_sync;
    settings->video.hard_sync_frames      = hard_sync_frames;
    settings->video.frame_delay           = frame_delay;
+   settings->video.frame_delay_auto      = frame_delay_auto;
    settings->video.black_frame_insertion = black_frame_insertion;
    settings->video.swap_interval         = swap_interval;
    settings->video.threaded              = video_threaded;
@@ -523,6 +524,8 @@ static void config_set_defaults(void)
    settings->video.post_filter_record          = post_filter_record;
    settings->video.gpu_record                  = gpu_record;
    settings->video.gpu_screenshot              = gpu_screenshot;
+   settings->video.screenshot_png_level        = screenshot_png_level;
+   settings->video.screenshot_png_threads      = screenshot_png_threads;
    settings->video.rotation                    = ORIENTATION_NORMAL;
 
    settings->audio.enable                      = audio_enable;
@@ -548,6 +551,8 @@ static void config_set_defaults(void)
    settings->rewind_enable                     = rewind_enable;
    settings->rewind_buffer_size                = rewind_buffer_size;
    settings->rewind_granularity                = rewind_granularity;
+   settings->run_ahead_frames                  = run_ahead_frames;
+   settings->run_ahead_secondary_instance      = run_ahead_secondary_instance;
    settings->slowmotion_ratio                  = slowmotion_ratio;
    settings->fastforward_ratio                 = fastforward_ratio;
    settings->pause_nonactive                   = pause_nonactive;
@@ -557,6 +562,7 @@ static void config_set_defaults(void)
    settings->savestate_auto_index              = savestate_auto_index;
    settings->savestate_auto_save               = savestate_auto_save;
    settings->savestate_auto_load               = savestate_auto_load;
+   settings->savestate_thumbnail_enable        = savestate_thumbnail_enable;
    settings->network_cmd_enable                = network_cmd_enable;
    settings->network_cmd_port                  = network_cmd_port;
    settings->stdin_cmd_enable                  = stdin_cmd_enable;
@@ -624,6 +630,7 @@ static void config_set_defaults(void)
    }
    memset(settings->input.autoconfigured, 0,
          sizeof(settings->input.autoconfigured));
+   input_driver_invalidate_binds();
 
    /* Verify that binds are in proper order. */
    for (i = 0; i < MAX_USERS; i++)
@@ -650,6 +657,8 @@ static void config_set_defaults(void)
    settings->input.overlay_opacity                 = 0.7f;
    settings->input.overlay_scale                   = 1.0f;
    settings->input.autodetect_enable               = input_autodetect_enable;
+   settings->input.threaded                        = input_threaded;
+   settings->input.poll_late                       = input_poll_late;
    *settings->input.keyboard_layout                = '\0';
 
    settings->osk.enable                            = true;
@@ -1148,6 +1157,8 @@ static void config_read_keybinds_conf(config_file_t *conf)
 
    for (i = 0; i < MAX_USERS; i++)
       read_keybinds_user(conf, i);
+
+   input_driver_invalidate_binds();
 }
 
 /* Also dumps inherited values, useful for logging. */
@@ -1305,6 +1316,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, video.frame_delay, "video_frame_delay");
    if (settings->video.frame_delay > 15)
       settings->video.frame_delay = 15;
+   CONFIG_GET_BOOL_BASE(conf, settings, video.frame_delay_auto, "video_frame_delay_auto");
 
    CONFIG_GET_BOOL_BASE(conf, settings, video.black_frame_insertion, "video_black_frame_insertion");
    CONFIG_GET_INT_BASE(conf, settings, video.swap_interval, "video_swap_interval");
@@ -1393,6 +1405,8 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL_BASE(conf, settings, video.post_filter_record, "video_post_filter_record");
    CONFIG_GET_BOOL_BASE(conf, settings, video.gpu_record, "video_gpu_record");
    CONFIG_GET_BOOL_BASE(conf, settings, video.gpu_screenshot, "video_gpu_screenshot");
+   CONFIG_GET_INT_BASE(conf, settings, video.screenshot_png_level, "video_screenshot_png_level");
+   CONFIG_GET_INT_BASE(conf, settings, video.screenshot_png_threads, "video_screenshot_png_threads");
 
    config_get_path(conf, "video_shader_dir", settings->video.shader_dir, sizeof(settings->video.shader_dir));
    if (!strcmp(settings->video.shader_dir, "default"))
@@ -1604,6 +1618,9 @@ static bool config_load_file(const char *path, bool set_defaults)
    }
 
    CONFIG_GET_INT_BASE(conf, settings, rewind_granularity, "rewind_granularity");
+   CONFIG_GET_INT_BASE(conf, settings, run_ahead_frames, "run_ahead_frames");
+   CONFIG_GET_BOOL_BASE(conf, settings, run_ahead_secondary_instance,
+         "run_ahead_secondary_instance");
    CONFIG_GET_FLOAT_BASE(conf, settings, slowmotion_ratio, "slowmotion_ratio");
    if (settings->slowmotion_ratio < 1.0f)
       settings->slowmotion_ratio = 1.0f;
@@ -1627,6 +1644,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_index, "savestate_auto_index");
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_save, "savestate_auto_save");
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_load, "savestate_auto_load");
+   CONFIG_GET_BOOL_BASE(conf, settings, savestate_thumbnail_enable, "savestate_thumbnail_enable");
 
    CONFIG_GET_BOOL_BASE(conf, settings, network_cmd_enable, "network_cmd_enable");
    CONFIG_GET_INT_BASE(conf, settings, network_cmd_port, "network_cmd_port");
@@ -1643,6 +1661,8 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, input.turbo_duty_cycle, "input_duty_cycle");
 
    CONFIG_GET_BOOL_BASE(conf, settings, input.autodetect_enable, "input_autodetect_enable");
+   CONFIG_GET_BOOL_BASE(conf, settings, input.threaded, "input_threaded");
+   CONFIG_GET_BOOL_BASE(conf, settings, input.poll_late, "input_poll_late");
    CONFIG_GET_PATH_BASE(conf, settings, input.autoconfig_dir, "joypad_autoconfig_dir");
 
    if (!global->has_set.username)
@@ -2475,6 +2495,9 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "audio_sync",    settings->audio.sync);
    config_set_int(conf,   "audio_block_frames", settings->audio.block_frames);
    config_set_int(conf,   "rewind_granularity", settings->rewind_granularity);
+   config_set_int(conf,   "run_ahead_frames", settings->run_ahead_frames);
+   config_set_bool(conf,  "run_ahead_secondary_instance",
+         settings->run_ahead_secondary_instance);
    config_set_path(conf,  "video_shader", settings->video.shader_path);
    config_set_bool(conf,  "video_shader_enable",
          settings->video.shader_enable);
@@ -2532,6 +2555,7 @@ bool config_save_file(const char *path)
    config_set_int(conf,   "video_hard_sync_frames",
          settings->video.hard_sync_frames);
    config_set_int(conf,   "video_frame_delay", settings->video.frame_delay);
+   config_set_bool(conf,  "video_frame_delay_auto", settings->video.frame_delay_auto);
    config_set_bool(conf,  "video_black_frame_insertion",
          settings->video.black_frame_insertion);
    config_set_bool(conf,  "video_disable_composition",
@@ -2539,6 +2563,10 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "pause_nonactive", settings->pause_nonactive);
    config_set_int(conf, "video_swap_interval", settings->video.swap_interval);
    config_set_bool(conf, "video_gpu_screenshot", settings->video.gpu_screenshot);
+   config_set_int(conf, "video_screenshot_png_level",
+         settings->video.screenshot_png_level);
+   config_set_int(conf, "video_screenshot_png_threads",
+         settings->video.screenshot_png_threads);
    config_set_int(conf, "video_rotation", settings->video.rotation);
    config_set_path(conf, "screenshot_directory",
          *settings->screenshot_directory ?
@@ -2654,6 +2682,8 @@ bool config_save_file(const char *path)
          settings->input.autoconfig_dir);
    config_set_bool(conf, "input_autodetect_enable",
          settings->input.autodetect_enable);
+   config_set_bool(conf, "input_threaded", settings->input.threaded);
+   config_set_bool(conf, "input_poll_late", settings->input.poll_late);
 
 #ifdef HAVE_OVERLAY
    config_set_path(conf, "overlay_directory",
@@ -2715,6 +2745,8 @@ bool config_save_file(const char *path)
          settings->savestate_auto_save);
    config_set_bool(conf, "savestate_auto_load",
          settings->savestate_auto_load);
+   config_set_bool(conf, "savestate_thumbnail_enable",
+         settings->savestate_thumbnail_enable);
    config_set_bool(conf, "history_list_enable",
          settings->history_list_enable);
 
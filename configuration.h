@@ -49,6 +49,7 @@ typedef struct settings
       unsigned swap_interval;
       unsigned hard_sync_frames;
       unsigned frame_delay;
+      bool frame_delay_auto;
 #ifdef GEKKO
       unsigned viwidth;
       bool vfilter;
@@ -86,6 +87,8 @@ typedef struct settings
       bool post_filter_record;
       bool gpu_record;
       bool gpu_screenshot;
+      unsigned screenshot_png_level;
+      unsigned screenshot_png_threads;
 
       bool allow_rotate;
       bool shared_context;
@@ -204,6 +207,8 @@ typedef struct settings
       char driver[32];
       char joypad_driver[32];
       char keyboard_layout[64];
+      bool threaded;
+      bool poll_late;
 
       unsigned remap_ids[MAX_USERS][RARCH_BIND_LIST_END];
       struct retro_keybind binds[MAX_USERS][RARCH_BIND_LIST_END];
@@ -312,6 +317,9 @@ typedef struct settings
    size_t rewind_buffer_size;
    unsigned rewind_granularity;
 
+   unsigned run_ahead_frames;
+   bool run_ahead_secondary_instance;
+
    float slowmotion_ratio;
    float fastforward_ratio;
 
@@ -322,6 +330,7 @@ typedef struct settings
    bool savestate_auto_index;
    bool savestate_auto_save;
    bool savestate_auto_load;
+   bool savestate_thumbnail_enable;
 
    bool network_cmd_enable;
    unsigned network_cmd_port;
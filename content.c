@@ -33,6 +33,10 @@
 #include <compat/strl.h>
 #include <file/file_path.h>
 #include <file/file_extract.h>
+#include <file/config_file.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "msg_hash.h"
 #include "content.h"
@@ -43,45 +47,171 @@
 #include "patch.h"
 #include "system.h"
 
+/* Content list of the last successful load, see content_reload. */
+static struct string_list *content_loaded;
+static const struct retro_subsystem_info *content_loaded_special;
+
+#ifdef HAVE_THREADS
+/* CRC32 of mapped content is computed in the background,
+ * see content_get_crc. */
+static sthread_t *content_crc_thread;
+static char content_crc_path[PATH_MAX_LENGTH];
+
+static void content_crc_thread_func(void *data)
+{
+   ssize_t len;
+   void *buf        = NULL;
+   global_t *global = global_get_ptr();
+
+   (void)data;
+
+   /* Maps the file again, the mapping handed to the
+    * core is released as soon as it has loaded. */
+   if (!map_file(content_crc_path, &buf, &len))
+      return;
+
+#ifdef HAVE_ZLIB
+   global->content_crc = zlib_crc32_calculate((const uint8_t*)buf, len);
+
+   RARCH_LOG("CRC32: 0x%x .\n", (unsigned)global->content_crc);
+#endif
+
+   unmap_file(buf, len);
+}
+#endif
+
+static void state_deinit(void);
+
+/**
+ * content_crc_init:
+ * @path         : path of the content file.
+ * @buf          : mapped content.
+ * @length       : size of @buf.
+ *
+ * Starts computing the CRC32 of mapped content.
+ **/
+static void content_crc_init(const char *path,
+      const uint8_t *buf, ssize_t length)
+{
+   global_t *global = global_get_ptr();
+
+   global->content_crc = 0;
+
+#ifdef HAVE_THREADS
+   strlcpy(content_crc_path, path, sizeof(content_crc_path));
+   content_crc_thread = sthread_create(content_crc_thread_func, NULL);
+
+   if (content_crc_thread)
+      return;
+#endif
+
+#ifdef HAVE_ZLIB
+   global->content_crc = zlib_crc32_calculate(buf, length);
+
+   RARCH_LOG("CRC32: 0x%x .\n", (unsigned)global->content_crc);
+#endif
+}
+
+/**
+ * content_get_crc:
+ *
+ * Waits for the CRC32 of the loaded content to be computed,
+ * if it is still pending.
+ *
+ * Returns: CRC32 of the loaded content.
+ **/
+uint32_t content_get_crc(void)
+{
+   global_t *global = global_get_ptr();
+
+#ifdef HAVE_THREADS
+   if (content_crc_thread)
+   {
+      sthread_join(content_crc_thread);
+      content_crc_thread = NULL;
+   }
+#endif
+
+   return global->content_crc;
+}
+
+/**
+ * content_deinit:
+ *
+ * Waits for background work on the loaded content to finish.
+ **/
+void content_deinit(void)
+{
+   content_get_crc();
+   state_deinit();
+
+   if (content_loaded)
+      string_list_free(content_loaded);
+   content_loaded         = NULL;
+   content_loaded_special = NULL;
+}
+
 /**
  * read_content_file:
  * @path         : buffer of the content file.
  * @buf          : size   of the content file.
  * @length       : size of the content file that has been read from.
+ * @mapped       : set to true if @buf is a read-only mapping
+ *                 which has to be released with unmap_file.
+ * @checksum     : compute the CRC32 of the content.
  *
- * Read the content file. If read into memory, also performs soft patching
+ * Read the content file and performs soft patching
  * (see patch_content function) in case soft patching has not been
  * blocked by the enduser.
  *
+ * Uncompressed content is mapped instead of read. If it is
+ * not patched, its CRC32 is computed in the background.
+ *
  * Returns: true if successful, false on error.
  **/
 static bool read_content_file(unsigned i, const char *path, void **buf,
-      ssize_t *length)
+      ssize_t *length, bool *mapped, bool checksum)
 {
    uint8_t *ret_buf = NULL;
    global_t *global = global_get_ptr();
 
    RARCH_LOG("%s: %s.\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), path);
-   if (!read_file(path, (void**) &ret_buf, length))
+
+   if (map_file(path, (void**)&ret_buf, length))
+      *mapped = true;
+   else if (!read_file(path, (void**) &ret_buf, length))
       return false;
 
    if (*length < 0)
       return false;
 
    if (i != 0)
+   {
+      *buf = ret_buf;
       return true;
+   }
 
    /* Attempt to apply a patch. */
    if (!global->patch.block_patch)
-      patch_content(&ret_buf, length);
+      patch_content(&ret_buf, length, mapped);
+
+   *buf = ret_buf;
+
+   if (!checksum)
+      return true;
+
+   if (*mapped)
+   {
+      content_crc_init(path, ret_buf, *length);
+      return true;
+   }
    
 #ifdef HAVE_ZLIB
    global->content_crc = zlib_crc32_calculate(ret_buf, *length);
 
    RARCH_LOG("CRC32: 0x%x .\n", (unsigned)global->content_crc);
 #endif
-   *buf = ret_buf;
 
    return true;
 }
@@ -136,6 +266,482 @@ struct sram_block
    size_t size;
 };
 
+/* States are compressed behind this magic and the size
+ * of the state as a little-endian uint64_t. Files without
+ * it hold the state as is. */
+#define STATE_ZLIB_MAGIC         "RASTATEZ"
+#define STATE_ZLIB_HEADER_SIZE   16
+#define STATE_ZLIB_LEVEL         1
+
+#ifdef HAVE_THREADS
+#define HAVE_STATE_THREAD
+
+/* Serialize buffers kept around for the next state. */
+#define STATE_POOL_SIZE          2
+#endif
+
+struct state_job
+{
+   char path[PATH_MAX_LENGTH];
+   /* Shown once the state is written, with room for @path. */
+   char msg[PATH_MAX_LENGTH + 128];
+   uint8_t *data;
+   size_t size;
+   /* Written alongside the state, if set. */
+   config_file_t *meta;
+   struct state_job *next;
+};
+
+#ifdef HAVE_STATE_THREAD
+struct state_queue
+{
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   scond_t *done;
+   struct state_job *head;
+   struct state_job *tail;
+   /* Jobs queued plus the one being written. */
+   unsigned pending;
+   bool quit;
+
+   uint8_t *pool[STATE_POOL_SIZE];
+   size_t pool_size[STATE_POOL_SIZE];
+};
+
+static struct state_queue *state_queue;
+#endif
+
+/**
+ * state_write:
+ * @path      : path of saved state that shall be written to.
+ * @data      : serialized state.
+ * @size      : size of @data.
+ *
+ * Compresses a state if possible, then writes it to a temporary
+ * file renamed over @path once it is on disk.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool state_write(const char *path, const uint8_t *data, size_t size)
+{
+#ifdef HAVE_ZLIB_DEFLATE
+   unsigned i;
+   bool ret          = false;
+   uint64_t out_size = 0;
+   size_t bound      = size + (size >> 10) + 64;
+   void *stream      = zlib_stream_new();
+   uint8_t *buf      = (uint8_t*)malloc(STATE_ZLIB_HEADER_SIZE + bound);
+
+   if (!stream || !buf)
+      goto end;
+
+   if (!zlib_deflate_init2(stream, STATE_ZLIB_LEVEL))
+      goto end;
+
+   zlib_set_stream(stream, size, bound, data,
+         buf + STATE_ZLIB_HEADER_SIZE);
+
+   if (zlib_deflate_data_to_file(stream) == 1)
+      out_size = zlib_stream_get_total_out(stream);
+   zlib_stream_deflate_free(stream);
+
+   /* States which do not shrink are written as is. */
+   if (!out_size || STATE_ZLIB_HEADER_SIZE + out_size >= size)
+      goto end;
+
+   memcpy(buf, STATE_ZLIB_MAGIC, 8);
+   for (i = 0; i < 8; i++)
+      buf[8 + i] = (uint8_t)((uint64_t)size >> (8 * i));
+
+   ret = write_file_atomic(path, buf, STATE_ZLIB_HEADER_SIZE + out_size);
+   free(stream);
+   free(buf);
+   return ret;
+
+end:
+   free(stream);
+   free(buf);
+#endif
+
+   return write_file_atomic(path, data, size);
+}
+
+/**
+ * state_decompress:
+ * @buf       : state read from disk, replaced with the
+ *              decompressed state.
+ * @size      : size of @buf.
+ *
+ * Returns: true if @buf holds an uncompressed state,
+ * false if it could not be decompressed.
+ **/
+static bool state_decompress(void **buf, ssize_t *size)
+{
+   unsigned i;
+   uint64_t state_size = 0;
+   uint8_t *data       = (uint8_t*)*buf;
+   uint8_t *state      = NULL;
+
+   if (*size < STATE_ZLIB_HEADER_SIZE
+         || memcmp(data, STATE_ZLIB_MAGIC, 8) != 0)
+      return true;
+
+   for (i = 0; i < 8; i++)
+      state_size |= (uint64_t)data[8 + i] << (8 * i);
+
+#ifdef HAVE_ZLIB
+   if (state_size && (uint64_t)(ssize_t)state_size == state_size)
+   {
+      bool ret     = false;
+      void *stream = zlib_stream_new();
+
+      state = (uint8_t*)malloc(state_size);
+
+      if (stream && state && zlib_inflate_init2(stream))
+      {
+         zlib_set_stream(stream, *size - STATE_ZLIB_HEADER_SIZE,
+               state_size, data + STATE_ZLIB_HEADER_SIZE, state);
+         ret = zlib_inflate_data_to_file_iterate(stream) == 1
+            && zlib_stream_get_total_out(stream) == state_size;
+         zlib_stream_free(stream);
+      }
+
+      free(stream);
+
+      if (!ret)
+      {
+         free(state);
+         state = NULL;
+      }
+   }
+#endif
+
+   if (!state)
+      return false;
+
+   free(*buf);
+   *buf  = state;
+   *size = state_size;
+   return true;
+}
+
+/**
+ * state_meta_new:
+ *
+ * Describes the state being saved: the core which saved it,
+ * the content it was saved from, when and at which frame.
+ *
+ * Returns: metadata to write alongside the state, or NULL.
+ **/
+static config_file_t *state_meta_new(void)
+{
+   rarch_system_info_t *system = rarch_system_info_get_ptr();
+   config_file_t *conf         = config_file_new(NULL);
+
+   if (!conf)
+      return NULL;
+
+   if (system->info.library_name)
+      config_set_string(conf, "core_name", system->info.library_name);
+   if (system->info.library_version)
+      config_set_string(conf, "core_version", system->info.library_version);
+   config_set_hex(conf, "content_crc", content_get_crc());
+   config_set_uint64(conf, "timestamp", (uint64_t)time(NULL));
+   config_set_uint64(conf, "frame_count", *video_driver_get_frame_count());
+
+   return conf;
+}
+
+static void state_job_finish(struct state_job *job)
+{
+   char meta_path[PATH_MAX_LENGTH] = {0};
+
+   if (!state_write(job->path, job->data, job->size))
+   {
+      snprintf(job->msg, sizeof(job->msg), "%s \"%s\".",
+            msg_hash_to_str(MSG_FAILED_TO_SAVE_STATE_TO),
+            job->path);
+      RARCH_ERR("%s\n", job->msg);
+      rarch_main_msg_queue_push(job->msg, 2, 180, true);
+      goto end;
+   }
+
+   if (job->meta)
+   {
+      fill_pathname_join_delim(meta_path, job->path, "meta",
+            '.', sizeof(meta_path));
+
+      if (!config_file_write(job->meta, meta_path))
+         RARCH_WARN("Failed to write savestate metadata \"%s\".\n",
+               meta_path);
+   }
+
+   RARCH_LOG("%s\n", job->msg);
+   rarch_main_msg_queue_push(job->msg, 2, 180, true);
+
+end:
+   config_file_free(job->meta);
+   job->meta = NULL;
+}
+
+#ifdef HAVE_STATE_THREAD
+/* Called with the queue locked. */
+static uint8_t *state_buffer_get(struct state_queue *queue, size_t size)
+{
+   unsigned i;
+
+   for (i = 0; i < STATE_POOL_SIZE; i++)
+   {
+      uint8_t *buf = queue->pool[i];
+
+      if (buf && queue->pool_size[i] == size)
+      {
+         queue->pool[i] = NULL;
+         return buf;
+      }
+   }
+
+   return (uint8_t*)malloc(size);
+}
+
+/* Called with the queue locked. */
+static void state_buffer_put(struct state_queue *queue,
+      uint8_t *buf, size_t size)
+{
+   unsigned i;
+
+   for (i = 0; i < STATE_POOL_SIZE; i++)
+   {
+      if (queue->pool[i])
+         continue;
+
+      queue->pool[i]      = buf;
+      queue->pool_size[i] = size;
+      return;
+   }
+
+   free(buf);
+}
+
+static void state_thread(void *data)
+{
+   struct state_queue *queue = (struct state_queue*)data;
+
+   for (;;)
+   {
+      struct state_job *job = NULL;
+
+      slock_lock(queue->lock);
+
+      while (!queue->head && !queue->quit)
+         scond_wait(queue->cond, queue->lock);
+
+      /* Pending jobs are drained before honoring quit. */
+      job = queue->head;
+      if (job)
+      {
+         queue->head = job->next;
+         if (!queue->head)
+            queue->tail = NULL;
+      }
+
+      slock_unlock(queue->lock);
+
+      if (!job)
+         break;
+
+      state_job_finish(job);
+
+      slock_lock(queue->lock);
+      state_buffer_put(queue, job->data, job->size);
+      queue->pending--;
+      scond_broadcast(queue->done);
+      slock_unlock(queue->lock);
+
+      free(job);
+   }
+}
+
+static struct state_queue *state_queue_new(void)
+{
+   struct state_queue *queue = (struct state_queue*)
+      calloc(1, sizeof(*queue));
+
+   if (!queue)
+      return NULL;
+
+   queue->lock   = slock_new();
+   queue->cond   = scond_new();
+   queue->done   = scond_new();
+
+   if (!queue->lock || !queue->cond || !queue->done)
+      goto error;
+
+   queue->thread = sthread_create(state_thread, queue);
+
+   if (!queue->thread)
+      goto error;
+
+   return queue;
+
+error:
+   if (queue->lock)
+      slock_free(queue->lock);
+   if (queue->cond)
+      scond_free(queue->cond);
+   if (queue->done)
+      scond_free(queue->done);
+   free(queue);
+   return NULL;
+}
+#endif
+
+/**
+ * state_flush:
+ *
+ * Waits for the states being saved to be written.
+ **/
+static void state_flush(void)
+{
+#ifdef HAVE_STATE_THREAD
+   struct state_queue *queue = state_queue;
+
+   if (!queue)
+      return;
+
+   slock_lock(queue->lock);
+   while (queue->pending)
+      scond_wait(queue->done, queue->lock);
+   slock_unlock(queue->lock);
+#endif
+}
+
+static void state_deinit(void)
+{
+#ifdef HAVE_STATE_THREAD
+   unsigned i;
+   struct state_queue *queue = state_queue;
+
+   if (!queue)
+      return;
+
+   slock_lock(queue->lock);
+   queue->quit = true;
+   scond_signal(queue->cond);
+   slock_unlock(queue->lock);
+
+   sthread_join(queue->thread);
+
+   for (i = 0; i < STATE_POOL_SIZE; i++)
+      free(queue->pool[i]);
+
+   slock_free(queue->lock);
+   scond_free(queue->cond);
+   scond_free(queue->done);
+   free(queue);
+
+   state_queue = NULL;
+#endif
+}
+
+/**
+ * save_state_async:
+ * @path      : path of saved state that shall be written to.
+ * @msg       : message shown once the state is written.
+ *
+ * Saves a state from memory, then compresses and writes it
+ * to disk on a worker thread. Without thread support, the
+ * state is written right away.
+ *
+ * If savestate_thumbnail_enable is set, metadata describing
+ * the state is written alongside it, to @path with a .meta
+ * extension appended.
+ *
+ * Returns: true if the state was saved from memory,
+ * false otherwise.
+ **/
+bool save_state_async(const char *path, const char *msg)
+{
+   struct state_job *job = NULL;
+   settings_t *settings  = config_get_ptr();
+   size_t size           = pretro_serialize_size();
+
+   RARCH_LOG("%s: \"%s\".\n",
+         msg_hash_to_str(MSG_SAVING_STATE),
+         path);
+
+   if (size == 0)
+      return false;
+
+   job = (struct state_job*)calloc(1, sizeof(*job));
+   if (!job)
+      return false;
+
+   strlcpy(job->path, path, sizeof(job->path));
+   strlcpy(job->msg, msg, sizeof(job->msg));
+   job->size = size;
+
+#ifdef HAVE_STATE_THREAD
+   if (!state_queue)
+      state_queue = state_queue_new();
+
+   if (state_queue)
+   {
+      slock_lock(state_queue->lock);
+      job->data = state_buffer_get(state_queue, size);
+      slock_unlock(state_queue->lock);
+   }
+   else
+#endif
+      job->data = (uint8_t*)malloc(size);
+
+   if (!job->data)
+      goto error;
+
+   RARCH_LOG("%s: %d %s.\n",
+         msg_hash_to_str(MSG_STATE_SIZE),
+         (int)size,
+         msg_hash_to_str(MSG_BYTES));
+
+   if (!pretro_serialize(job->data, size))
+      goto error;
+
+   if (settings->savestate_thumbnail_enable)
+      job->meta = state_meta_new();
+
+#ifdef HAVE_STATE_THREAD
+   if (state_queue)
+   {
+      slock_lock(state_queue->lock);
+
+      if (state_queue->tail)
+         state_queue->tail->next = job;
+      else
+         state_queue->head       = job;
+      state_queue->tail          = job;
+      state_queue->pending++;
+
+      scond_signal(state_queue->cond);
+      slock_unlock(state_queue->lock);
+      return true;
+   }
+#endif
+
+   state_job_finish(job);
+   free(job->data);
+   free(job);
+   return true;
+
+error:
+   RARCH_ERR("%s \"%s\".\n",
+         msg_hash_to_str(MSG_FAILED_TO_SAVE_STATE_TO),
+         path);
+   free(job->data);
+   free(job);
+   return false;
+}
+
 /**
  * save_state:
  * @path      : path of saved state that shall be written to.
@@ -168,8 +774,11 @@ bool save_state(const char *path)
          msg_hash_to_str(MSG_BYTES));
    ret = pretro_serialize(data, size);
 
+   /* A state still being written might be to the same path. */
+   state_flush();
+
    if (ret)
-      ret = write_file(path, data, size);
+      ret = state_write(path, (const uint8_t*)data, size);
 
    if (!ret)
       RARCH_ERR("%s \"%s\".\n", 
@@ -198,12 +807,20 @@ bool load_state(const char *path)
    struct sram_block *blocks = NULL;
    settings_t *settings      = config_get_ptr();
    global_t *global          = global_get_ptr();
-   bool ret                  = read_file(path, &buf, &size);
+   bool ret                  = false;
 
    RARCH_LOG("%s: \"%s\".\n",
          msg_hash_to_str(MSG_LOADING_STATE),
          path);
 
+   /* The state might still be being written. */
+   state_flush();
+
+   ret = read_file(path, &buf, &size);
+
+   if (ret && size >= 0)
+      ret = state_decompress(&buf, &size);
+
    if (!ret || size < 0)
    {
       RARCH_ERR("%s \"%s\".\n",
@@ -347,19 +964,16 @@ void save_ram_file(const char *path, int type)
 }
 
 static bool load_content_dont_need_fullpath(
-      struct retro_game_info *info, unsigned i, const char *path)
+      struct retro_game_info *info, unsigned i, const char *path,
+      bool *mapped, bool checksum)
 {
    ssize_t len;
    /* Load the content into memory. */
 
    /* First content file is significant, attempt to do patching,
     * CRC checking, etc. */
-   bool ret = false;
-
-   if (i == 0)
-      ret = read_content_file(i, path, (void**)&info->data, &len);
-   else
-      ret = read_file(path, (void**)&info->data, &len);
+   bool ret = read_content_file(i, path, (void**)&info->data, &len,
+         mapped, checksum);
 
    if (!ret || len < 0)
    {
@@ -449,24 +1063,34 @@ static bool load_content_need_fullpath(
 /**
  * load_content:
  * @special          : subsystem of content to be loaded. Can be NULL.
- * content           : 
+ * @content          : content files to be loaded.
+ * @load_game        : retro_load_game of the core.
+ * @load_game_special: retro_load_game_special of the core.
+ * @checksum         : compute the CRC32 of the content.
  *
  * Load content file (for libretro core).
  *
  * Returns : true if successful, otherwise false.
  **/
 static bool load_content(const struct retro_subsystem_info *special,
-      const struct string_list *content)
+      const struct string_list *content,
+      bool (*load_game)(const struct retro_game_info*),
+      bool (*load_game_special)(unsigned,
+         const struct retro_game_info*, size_t),
+      bool checksum)
 {
    unsigned i;
    bool ret = true;
    struct string_list* additional_path_allocs = string_list_new();
    struct retro_game_info *info = (struct retro_game_info*)
       calloc(content->size, sizeof(*info));
+   bool *mapped = (bool*)calloc(content->size, sizeof(*mapped));
 
-   if (!info)
+   if (!info || !mapped)
    {
       string_list_free(additional_path_allocs);
+      free(info);
+      free(mapped);
       return false;
    }
 
@@ -491,7 +1115,8 @@ static bool load_content(const struct retro_subsystem_info *special,
 
       if (!need_fullpath && *path)
       {
-         if (!load_content_dont_need_fullpath(&info[i], i, path))
+         if (!load_content_dont_need_fullpath(&info[i], i, path,
+                  &mapped[i], checksum))
             goto end;
       }
       else
@@ -506,18 +1131,25 @@ static bool load_content(const struct retro_subsystem_info *special,
    }
 
    if (special)
-      ret = pretro_load_game_special(special->id, info, content->size);
+      ret = load_game_special(special->id, info, content->size);
    else
-      ret = pretro_load_game(*content->elems[0].data ? info : NULL);
+      ret = load_game(*content->elems[0].data ? info : NULL);
 
    if (!ret)
       RARCH_ERR("%s.\n", msg_hash_to_str(MSG_FAILED_TO_LOAD_CONTENT));
 
 end:
+   /* Cores have to copy the data during retro_load_game. */
    for (i = 0; i < content->size; i++)
-      free((void*)info[i].data);
+   {
+      if (mapped[i])
+         unmap_file((void*)info[i].data, info[i].size);
+      else
+         free((void*)info[i].data);
+   }
 
    string_list_free(additional_path_allocs);
+   free(mapped);
    if (info)
       free(info);
    return ret;
@@ -545,6 +1177,9 @@ bool init_content_file(void)
    rarch_system_info_t *system                = rarch_system_info_get_ptr();
    global_t   *global                         = global_get_ptr();
 
+   /* Previous content might still be checksummed. */
+   content_deinit();
+
    global->temporary_content                  = string_list_new();
 
    if (!global->temporary_content)
@@ -652,7 +1287,15 @@ bool init_content_file(void)
 #endif
 
    /* Set attr to need_fullpath as appropriate. */
-   ret = load_content(special, content);
+   ret = load_content(special, content,
+         pretro_load_game, pretro_load_game_special, true);
+
+   if (ret)
+   {
+      content_loaded         = content;
+      content_loaded_special = special;
+      content                = NULL;
+   }
 
 error:
    global->inited.content = (ret) ? true : false;
@@ -661,3 +1304,24 @@ error:
       string_list_free(content);
    return ret;
 }
+
+/**
+ * content_reload:
+ * @load_game        : retro_load_game of another core instance.
+ * @load_game_special: retro_load_game_special of another core instance.
+ *
+ * Loads the content loaded by init_content_file again,
+ * into another instance of the current core.
+ *
+ * Returns : true if successful, otherwise false.
+ **/
+bool content_reload(bool (*load_game)(const struct retro_game_info*),
+      bool (*load_game_special)(unsigned,
+         const struct retro_game_info*, size_t))
+{
+   if (!content_loaded)
+      return false;
+
+   return load_content(content_loaded_special, content_loaded,
+         load_game, load_game_special, false);
+}
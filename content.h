@@ -23,6 +23,8 @@
 #include <stddef.h>
 #include <sys/types.h>
 
+#include "libretro.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -49,6 +51,23 @@ bool load_state(const char *path);
  **/
 bool save_state(const char *path);
 
+/**
+ * save_state_async:
+ * @path      : path of saved state that shall be written to.
+ * @msg       : message shown once the state is written.
+ *
+ * Save a state from memory, then compress and write it to
+ * disk in the background.
+ *
+ * If savestate_thumbnail_enable is set, metadata describing
+ * the state is written alongside it, to @path with a .meta
+ * extension appended.
+ *
+ * Returns: true if the state was saved from memory,
+ * false otherwise.
+ **/
+bool save_state_async(const char *path, const char *msg);
+
 /**
  * load_ram_file:
  * @path             : path of RAM state that will be loaded from.
@@ -83,6 +102,37 @@ void save_ram_file(const char *path, int type);
  **/
 bool init_content_file(void);
 
+/**
+ * content_reload:
+ * @load_game        : retro_load_game of another core instance.
+ * @load_game_special: retro_load_game_special of another core instance.
+ *
+ * Loads the content loaded by init_content_file again,
+ * into another instance of the current core.
+ *
+ * Returns : true if successful, otherwise false.
+ **/
+bool content_reload(bool (*load_game)(const struct retro_game_info*),
+      bool (*load_game_special)(unsigned,
+         const struct retro_game_info*, size_t));
+
+/**
+ * content_get_crc:
+ *
+ * Waits for the CRC32 of the loaded content to be computed,
+ * if it is still pending.
+ *
+ * Returns: CRC32 of the loaded content.
+ **/
+uint32_t content_get_crc(void);
+
+/**
+ * content_deinit:
+ *
+ * Waits for background work on the loaded content to finish.
+ **/
+void content_deinit(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,8 +15,15 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #include "core_info.h"
 #include "general.h"
+#include "file_ops.h"
+#include "msg_hash.h"
 #include <file/file_path.h>
 #include "file_ext.h"
 #include <file/file_extract.h>
@@ -59,31 +66,452 @@ static void core_info_list_resolve_all_extensions(
    }
 }
 
-static void core_info_list_resolve_all_firmware(
-      core_info_list_t *core_info_list)
+/* Binary cache of the parsed .info files. It is stored in the
+ * config directory, which unlike the .info directory of a system
+ * install is writable, under a name keyed by the .info directory.
+ * Cores whose .info file still has the recorded modification time
+ * and size are filled in from the cache, everything else is parsed
+ * and the cache gets rewritten.
+ *
+ * Layout: header, core records sorted by .info file name, firmware
+ * records, string table. Strings are offsets into the table, with
+ * offset 0 meaning the key was not set. */
+
+#define CORE_INFO_CACHE_FILE    "core_info_%08x.cache"
+#define CORE_INFO_CACHE_MAGIC   0x52414349 /* RACI */
+#define CORE_INFO_CACHE_VERSION 1
+
+enum core_info_cache_string
 {
-   size_t i;
-   unsigned c;
+   CORE_INFO_CACHE_DISPLAY_NAME = 0,
+   CORE_INFO_CACHE_CORE_NAME,
+   CORE_INFO_CACHE_SYSTEMNAME,
+   CORE_INFO_CACHE_MANUFACTURER,
+   CORE_INFO_CACHE_SUPPORTED_EXTENSIONS,
+   CORE_INFO_CACHE_AUTHORS,
+   CORE_INFO_CACHE_PERMISSIONS,
+   CORE_INFO_CACHE_LICENSES,
+   CORE_INFO_CACHE_CATEGORIES,
+   CORE_INFO_CACHE_DATABASES,
+   CORE_INFO_CACHE_NOTES,
+   CORE_INFO_CACHE_STRINGS
+};
+
+static const size_t core_info_cache_fields[CORE_INFO_CACHE_STRINGS] = {
+   offsetof(core_info_t, display_name),
+   offsetof(core_info_t, core_name),
+   offsetof(core_info_t, systemname),
+   offsetof(core_info_t, system_manufacturer),
+   offsetof(core_info_t, supported_extensions),
+   offsetof(core_info_t, authors),
+   offsetof(core_info_t, permissions),
+   offsetof(core_info_t, licenses),
+   offsetof(core_info_t, categories),
+   offsetof(core_info_t, databases),
+   offsetof(core_info_t, notes),
+};
+
+#define CORE_INFO_FIELD(info, i) \
+   (*(char**)((char*)(info) + core_info_cache_fields[i]))
+
+typedef struct
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t core_count;
+   uint32_t firmware_count;
+   uint32_t strings_size;
+   uint32_t reserved;
+} core_info_cache_header_t;
+
+typedef struct
+{
+   uint64_t mtime;
+   uint64_t size;
+   uint32_t name;
+   uint32_t strings[CORE_INFO_CACHE_STRINGS];
+   uint32_t firmware_first;
+   uint32_t firmware_count;
+   uint32_t supports_no_game;
+} core_info_cache_core_t;
+
+typedef struct
+{
+   uint32_t path;
+   uint32_t desc;
+   uint32_t optional;
+} core_info_cache_firmware_t;
 
-   if (!core_info_list)
-      return;
+typedef struct
+{
+   void *buf;
+   ssize_t len;
+   bool mapped;
+   const core_info_cache_header_t *header;
+   const core_info_cache_core_t *cores;
+   const core_info_cache_firmware_t *firmware;
+   const char *strings;
+} core_info_cache_t;
+
+/* Where a core's .info file was found, used to validate
+ * and rewrite the cache. */
+typedef struct
+{
+   char *name;
+   uint64_t mtime;
+   uint64_t size;
+   size_t index;
+} core_info_stamp_t;
 
-   for (i = 0; i < core_info_list->count; i++)
+static void core_info_cache_free(core_info_cache_t *cache)
+{
+   if (cache->mapped)
+      unmap_file(cache->buf, cache->len);
+   else
+      free(cache->buf);
+   memset(cache, 0, sizeof(*cache));
+}
+
+/**
+ * core_info_cache_load:
+ * @cache            : cache to fill in.
+ * @path             : path to the cache file.
+ *
+ * Maps the cache file, or reads it in one go where mapping is
+ * not available, and checks it is complete.
+ *
+ * Returns: true if @cache can be used, otherwise false.
+ **/
+static bool core_info_cache_load(core_info_cache_t *cache, const char *path)
+{
+   const core_info_cache_header_t *header = NULL;
+   uint64_t expected = 0;
+
+   memset(cache, 0, sizeof(*cache));
+
+   if (!path_file_exists(path))
+      return false;
+
+   if (map_file(path, &cache->buf, &cache->len))
+      cache->mapped = true;
+   else if (!read_file(path, &cache->buf, &cache->len))
+      return false;
+
+   if (!cache->buf || cache->len < (ssize_t)sizeof(*header))
+      goto error;
+
+   header   = (const core_info_cache_header_t*)cache->buf;
+   expected = sizeof(*header)
+      + (uint64_t)header->core_count * sizeof(core_info_cache_core_t)
+      + (uint64_t)header->firmware_count * sizeof(core_info_cache_firmware_t)
+      + header->strings_size;
+
+   if (header->magic != CORE_INFO_CACHE_MAGIC
+         || header->version != CORE_INFO_CACHE_VERSION
+         || header->strings_size == 0
+         || expected != (uint64_t)cache->len)
+      goto error;
+
+   cache->header   = header;
+   cache->cores    = (const core_info_cache_core_t*)(header + 1);
+   cache->firmware = (const core_info_cache_firmware_t*)
+      (cache->cores + header->core_count);
+   cache->strings  = (const char*)(cache->firmware + header->firmware_count);
+
+   if (cache->strings[header->strings_size - 1] != '\0')
+      goto error;
+
+   return true;
+
+error:
+   RARCH_WARN("Ignoring invalid core info cache: %s.\n", path);
+   core_info_cache_free(cache);
+   return false;
+}
+
+static const char *core_info_cache_string(const core_info_cache_t *cache,
+      uint32_t offset)
+{
+   if (!offset || offset >= cache->header->strings_size)
+      return NULL;
+   return cache->strings + offset;
+}
+
+static const core_info_cache_core_t *core_info_cache_find(
+      const core_info_cache_t *cache, const char *name)
+{
+   size_t lo = 0, hi;
+
+   if (!cache->header)
+      return NULL;
+
+   hi = cache->header->core_count;
+
+   while (lo < hi)
    {
-      unsigned count    = 0;
-      core_info_t *info = (core_info_t*)&core_info_list->list[i];
+      size_t mid           = lo + (hi - lo) / 2;
+      const char *mid_name = core_info_cache_string(cache,
+            cache->cores[mid].name);
+      int cmp              = mid_name ? strcmp(name, mid_name) : 1;
+
+      if (cmp == 0)
+         return &cache->cores[mid];
+      if (cmp < 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
 
-      if (!info || !info->data)
-         continue;
+   return NULL;
+}
+
+/**
+ * core_info_cache_read:
+ * @cache            : loaded cache.
+ * @stamp            : .info file of the core.
+ * @info             : core info to fill in.
+ *
+ * Returns: true if @info was filled in from the cache, false if
+ * the .info file is not cached or changed since.
+ **/
+static bool core_info_cache_read(const core_info_cache_t *cache,
+      const core_info_stamp_t *stamp, core_info_t *info)
+{
+   unsigned i;
+   const core_info_cache_core_t *core = core_info_cache_find(
+         cache, stamp->name);
+
+   if (!core || core->mtime != stamp->mtime || core->size != stamp->size)
+      return false;
+
+   if ((uint64_t)core->firmware_first + core->firmware_count
+         > cache->header->firmware_count)
+      return false;
+
+   for (i = 0; i < CORE_INFO_CACHE_STRINGS; i++)
+   {
+      const char *str = core_info_cache_string(cache, core->strings[i]);
+      if (str)
+         CORE_INFO_FIELD(info, i) = strdup(str);
+   }
+
+   info->supports_no_game = core->supports_no_game;
+
+   if (core->firmware_count)
+   {
+      info->firmware = (core_info_firmware_t*)
+         calloc(core->firmware_count, sizeof(*info->firmware));
+      if (!info->firmware)
+         return true;
+
+      info->firmware_count = core->firmware_count;
+
+      for (i = 0; i < core->firmware_count; i++)
+      {
+         const core_info_cache_firmware_t *fw =
+            &cache->firmware[core->firmware_first + i];
+         const char *path = core_info_cache_string(cache, fw->path);
+         const char *desc = core_info_cache_string(cache, fw->desc);
+
+         info->firmware[i].path     = path ? strdup(path) : NULL;
+         info->firmware[i].desc     = desc ? strdup(desc) : NULL;
+         info->firmware[i].optional = fw->optional;
+      }
+   }
+
+   return true;
+}
 
-      if (!config_get_uint(info->data, "firmware_count", &count))
+static uint32_t core_info_cache_add_string(char *strings, size_t *pos,
+      const char *str)
+{
+   size_t offset = *pos;
+
+   if (!str)
+      return 0;
+
+   strcpy(strings + offset, str);
+   *pos += strlen(str) + 1;
+   return (uint32_t)offset;
+}
+
+static int core_info_stamp_cmp(const void *a_, const void *b_)
+{
+   const core_info_stamp_t *a = (const core_info_stamp_t*)a_;
+   const core_info_stamp_t *b = (const core_info_stamp_t*)b_;
+
+   /* Cores without an .info file go last. */
+   if (!a->name || !b->name)
+      return !a->name - !b->name;
+   return strcmp(a->name, b->name);
+}
+
+/**
+ * core_info_cache_save:
+ * @path             : path to the cache file.
+ * @list             : core info list to store.
+ * @stamps           : .info files the entries of @list were read from,
+ *                     NULL names are skipped. Gets sorted by name
+ *                     and duplicates are released.
+ * @num_stamps       : number of elements in @stamps.
+ *
+ * Writes the cache file. A cache that could not be written
+ * completely fails validation on the next start.
+ **/
+static void core_info_cache_save(const char *path,
+      const core_info_list_t *list, core_info_stamp_t *stamps,
+      size_t num_stamps)
+{
+   size_t i, j, k, size;
+   size_t pos                         = 1;
+   size_t strings_size                = 1;
+   size_t core_count                  = 0;
+   size_t firmware_count              = 0;
+   uint8_t *buf                       = NULL;
+   core_info_cache_header_t *header   = NULL;
+   core_info_cache_core_t *cores      = NULL;
+   core_info_cache_firmware_t *fw     = NULL;
+   char *strings                      = NULL;
+
+   qsort(stamps, num_stamps, sizeof(*stamps), core_info_stamp_cmp);
+
+   /* Several cores can share an .info file, only store it once. */
+   for (i = 0, j = 0; i < num_stamps; i++)
+   {
+      const core_info_t *info = NULL;
+
+      if (!stamps[i].name)
+         continue;
+      if (j && !strcmp(stamps[j - 1].name, stamps[i].name))
+      {
+         free(stamps[i].name);
+         stamps[i].name = NULL;
          continue;
+      }
+
+      if (i != j)
+      {
+         stamps[j]      = stamps[i];
+         stamps[i].name = NULL;
+      }
+      info = &list->list[stamps[j].index];
+
+      strings_size += strlen(stamps[j++].name) + 1;
+      for (k = 0; k < CORE_INFO_CACHE_STRINGS; k++)
+         if (CORE_INFO_FIELD(info, k))
+            strings_size += strlen(CORE_INFO_FIELD(info, k)) + 1;
+      for (k = 0; k < info->firmware_count; k++)
+      {
+         if (info->firmware[k].path)
+            strings_size += strlen(info->firmware[k].path) + 1;
+         if (info->firmware[k].desc)
+            strings_size += strlen(info->firmware[k].desc) + 1;
+      }
+      firmware_count += info->firmware_count;
+   }
+   core_count = j;
+
+   size = sizeof(*header) + core_count * sizeof(*cores)
+      + firmware_count * sizeof(*fw) + strings_size;
+   buf  = (uint8_t*)calloc(1, size);
+   if (!buf)
+      return;
+
+   header  = (core_info_cache_header_t*)buf;
+   cores   = (core_info_cache_core_t*)(header + 1);
+   fw      = (core_info_cache_firmware_t*)(cores + core_count);
+   strings = (char*)(fw + firmware_count);
+
+   header->magic          = CORE_INFO_CACHE_MAGIC;
+   header->version        = CORE_INFO_CACHE_VERSION;
+   header->core_count     = core_count;
+   header->firmware_count = firmware_count;
+   header->strings_size   = strings_size;
+
+   for (i = 0, j = 0; i < core_count; i++)
+   {
+      const core_info_t *info = &list->list[stamps[i].index];
+
+      cores[i].mtime            = stamps[i].mtime;
+      cores[i].size             = stamps[i].size;
+      cores[i].name             = core_info_cache_add_string(
+            strings, &pos, stamps[i].name);
+      cores[i].supports_no_game = info->supports_no_game;
+      cores[i].firmware_first   = j;
+      cores[i].firmware_count   = info->firmware_count;
+
+      for (k = 0; k < CORE_INFO_CACHE_STRINGS; k++)
+         cores[i].strings[k] = core_info_cache_add_string(
+               strings, &pos, CORE_INFO_FIELD(info, k));
+
+      for (k = 0; k < info->firmware_count; k++, j++)
+      {
+         fw[j].path     = core_info_cache_add_string(
+               strings, &pos, info->firmware[k].path);
+         fw[j].desc     = core_info_cache_add_string(
+               strings, &pos, info->firmware[k].desc);
+         fw[j].optional = info->firmware[k].optional;
+      }
+   }
+
+   errno = 0;
+   if (!write_file(path, buf, size))
+   {
+      /* Nothing to warn about if the cache can't be kept there. */
+      bool writable = errno != EACCES && errno != EPERM && errno != ENOENT;
+#ifdef EROFS
+      writable      = writable && errno != EROFS;
+#endif
+      if (writable)
+         RARCH_WARN("Could not write core info cache: %s.\n", path);
+   }
+
+   free(buf);
+}
+
+static bool core_info_stamp_init(core_info_stamp_t *stamp,
+      const char *info_path)
+{
+   struct stat st;
+
+   if (stat(info_path, &st) != 0)
+      return false;
 
+   stamp->name  = strdup(path_basename(info_path));
+   stamp->mtime = (uint64_t)st.st_mtime;
+   stamp->size  = (uint64_t)st.st_size;
+   return stamp->name != NULL;
+}
+
+static bool core_info_parse(core_info_t *info, const char *info_path)
+{
+   unsigned c, count   = 0;
+   config_file_t *conf = config_file_new(info_path);
+
+   if (!conf)
+      return false;
+
+   config_get_string(conf, "display_name", &info->display_name);
+   config_get_string(conf, "corename", &info->core_name);
+   config_get_string(conf, "systemname", &info->systemname);
+   config_get_string(conf, "manufacturer", &info->system_manufacturer);
+   config_get_string(conf, "supported_extensions",
+         &info->supported_extensions);
+   config_get_string(conf, "authors", &info->authors);
+   config_get_string(conf, "permissions", &info->permissions);
+   config_get_string(conf, "license", &info->licenses);
+   config_get_string(conf, "categories", &info->categories);
+   config_get_string(conf, "database", &info->databases);
+   config_get_string(conf, "notes", &info->notes);
+   config_get_bool(conf, "supports_no_game", &info->supports_no_game);
+
+   if (config_get_uint(conf, "firmware_count", &count) && count)
       info->firmware = (core_info_firmware_t*)
          calloc(count, sizeof(*info->firmware));
 
-      if (!info->firmware)
-         continue;
+   if (info->firmware)
+   {
+      info->firmware_count = count;
 
       for (c = 0; c < count; c++)
       {
@@ -95,87 +523,135 @@ static void core_info_list_resolve_all_firmware(
          snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
          snprintf(opt_key, sizeof(opt_key), "firmware%u_opt", c);
 
-         config_get_string(info->data, path_key, &info->firmware[c].path);
-         config_get_string(info->data, desc_key, &info->firmware[c].desc);
-         config_get_bool(info->data, opt_key , &info->firmware[c].optional);
+         config_get_string(conf, path_key, &info->firmware[c].path);
+         config_get_string(conf, desc_key, &info->firmware[c].desc);
+         config_get_bool(conf, opt_key , &info->firmware[c].optional);
       }
    }
+
+   config_file_free(conf);
+   return true;
+}
+
+static void core_info_resolve_lists(core_info_t *info)
+{
+   if (info->supported_extensions)
+      info->supported_extensions_list =
+         string_split(info->supported_extensions, "|");
+   if (info->authors)
+      info->authors_list     = string_split(info->authors, "|");
+   if (info->permissions)
+      info->permissions_list = string_split(info->permissions, "|");
+   if (info->licenses)
+      info->licenses_list    = string_split(info->licenses, "|");
+   if (info->categories)
+      info->categories_list  = string_split(info->categories, "|");
+   if (info->databases)
+      info->databases_list   = string_split(info->databases, "|");
+   if (info->notes)
+      info->note_list        = string_split(info->notes, "|");
+}
+
+static void core_info_get_info_path(const char *core_path,
+      char *s, size_t len)
+{
+   char info_path_base[PATH_MAX_LENGTH] = {0};
+   settings_t *settings                 = config_get_ptr();
+
+   fill_pathname_base(info_path_base, core_path, sizeof(info_path_base));
+   path_remove_extension(info_path_base);
+
+#if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP))
+   char *substr = strrchr(info_path_base, '_');
+   if (substr)
+      *substr = '\0';
+#endif
+
+   strlcat(info_path_base, ".info", sizeof(info_path_base));
+
+   fill_pathname_join(s, (*settings->libretro_info_path) ?
+         settings->libretro_info_path : settings->libretro_directory,
+         info_path_base, len);
 }
 
 void core_info_get_name(const char *path, char *s, size_t len)
 {
    size_t i;
-   core_info_t *core_info = NULL;
-   core_info_list_t *core_info_list = NULL;
-   settings_t *settings = config_get_ptr();
    struct string_list *contents = dir_list_new_special(NULL, DIR_LIST_CORES);
 
    if (!contents)
       return;
 
-   core_info_list = (core_info_list_t*)calloc(1, sizeof(*core_info_list));
-   if (!core_info_list)
-      goto error;
-
-   core_info = (core_info_t*)calloc(contents->size, sizeof(*core_info));
-   if (!core_info)
-      goto error;
-
-   core_info_list->list = core_info;
-   core_info_list->count = contents->size;
-
    for (i = 0; i < contents->size; i++)
    {
-      char info_path_base[PATH_MAX_LENGTH] = {0};
-      char info_path[PATH_MAX_LENGTH]      = {0};
+      char info_path[PATH_MAX_LENGTH] = {0};
+      char *core_name                 = NULL;
+      config_file_t *conf             = NULL;
 
-      core_info[i].path = strdup(contents->elems[i].data);
-
-      if (!core_info[i].path)
-         break;
-
-      if (strcmp(core_info[i].path, path) != 0)
-            continue;
-
-      fill_pathname_base(info_path_base, contents->elems[i].data,
-            sizeof(info_path_base));
-      path_remove_extension(info_path_base);
-
-#if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP))
-      char *substr = strrchr(info_path_base, '_');
-      if (substr)
-         *substr = '\0';
-#endif
-
-      strlcat(info_path_base, ".info", sizeof(info_path_base));
-
-      fill_pathname_join(info_path, (*settings->libretro_info_path) ?
-            settings->libretro_info_path : settings->libretro_directory,
-            info_path_base, sizeof(info_path));
+      if (strcmp(contents->elems[i].data, path) != 0)
+         continue;
 
-      core_info[i].data = config_file_new(info_path);
+      core_info_get_info_path(contents->elems[i].data,
+            info_path, sizeof(info_path));
 
-      if (core_info[i].data)
-         config_get_string(core_info[i].data, "corename",
-               &core_info[i].core_name);
+      conf = config_file_new(info_path);
+      if (!conf)
+         continue;
 
-      strlcpy(s, core_info[i].core_name, len);
+      if (config_get_string(conf, "corename", &core_name))
+      {
+         strlcpy(s, core_name, len);
+         free(core_name);
+      }
+      config_file_free(conf);
    }
 
-error:
-   if (contents)
-      dir_list_free(contents);
-   contents = NULL;
-   core_info_list_free(core_info_list);
+   dir_list_free(contents);
+}
+
+/**
+ * core_info_cache_path:
+ * @s                : output path.
+ * @len              : size of @s.
+ * @info_dir         : directory holding the .info files.
+ *
+ * Gets the path of the cache for the .info files in @info_dir.
+ * It is stored in the config directory, or in @info_dir when
+ * there is none.
+ **/
+static void core_info_cache_path(char *s, size_t len, const char *info_dir)
+{
+   char name[PATH_MAX_LENGTH]       = {0};
+   char config_dir[PATH_MAX_LENGTH] = {0};
+   settings_t *settings             = config_get_ptr();
+   global_t   *global               = global_get_ptr();
+
+   snprintf(name, sizeof(name), CORE_INFO_CACHE_FILE,
+         (unsigned)msg_hash_calculate(info_dir));
+
+   if (*settings->menu_config_directory)
+      strlcpy(config_dir, settings->menu_config_directory,
+            sizeof(config_dir));
+   else if (*global->path.config)
+      fill_pathname_basedir(config_dir, global->path.config,
+            sizeof(config_dir));
+   else
+      strlcpy(config_dir, info_dir, sizeof(config_dir));
+
+   fill_pathname_join(s, config_dir, name, len);
 }
 
 core_info_list_t *core_info_list_new(void)
 {
    size_t i;
-   core_info_t *core_info = NULL;
+   char cache_path[PATH_MAX_LENGTH] = {0};
+   core_info_cache_t cache;
+   bool cache_dirty                 = false;
+   core_info_t *core_info           = NULL;
+   core_info_stamp_t *stamps        = NULL;
    core_info_list_t *core_info_list = NULL;
-   settings_t *settings = config_get_ptr();
-   struct string_list *contents = dir_list_new_special(NULL, DIR_LIST_CORES);
+   settings_t *settings             = config_get_ptr();
+   struct string_list *contents     = dir_list_new_special(NULL, DIR_LIST_CORES);
 
    if (!contents)
       return NULL;
@@ -191,97 +667,61 @@ core_info_list_t *core_info_list_new(void)
    core_info_list->list = core_info;
    core_info_list->count = contents->size;
 
+   stamps = (core_info_stamp_t*)calloc(contents->size, sizeof(*stamps));
+   if (!stamps)
+      goto error;
+
+   core_info_cache_path(cache_path, sizeof(cache_path),
+         (*settings->libretro_info_path) ?
+         settings->libretro_info_path : settings->libretro_directory);
+   core_info_cache_load(&cache, cache_path);
+
    for (i = 0; i < contents->size; i++)
    {
-      char info_path_base[PATH_MAX_LENGTH] = {0};
-      char info_path[PATH_MAX_LENGTH]      = {0};
+      char info_path[PATH_MAX_LENGTH] = {0};
       core_info[i].path = strdup(contents->elems[i].data);
 
       if (!core_info[i].path)
          break;
 
-      fill_pathname_base(info_path_base, contents->elems[i].data,
-            sizeof(info_path_base));
-      path_remove_extension(info_path_base);
-
-#if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP))
-      char *substr = strrchr(info_path_base, '_');
-      if (substr)
-         *substr = '\0';
-#endif
-
-      strlcat(info_path_base, ".info", sizeof(info_path_base));
+      core_info_get_info_path(contents->elems[i].data,
+            info_path, sizeof(info_path));
 
-      fill_pathname_join(info_path, (*settings->libretro_info_path) ?
-            settings->libretro_info_path : settings->libretro_directory,
-            info_path_base, sizeof(info_path));
+      stamps[i].index = i;
 
-      core_info[i].data = config_file_new(info_path);
-
-      if (core_info[i].data)
+      if (core_info_stamp_init(&stamps[i], info_path))
       {
-         unsigned count = 0;
-         config_get_string(core_info[i].data, "display_name",
-               &core_info[i].display_name);
-         config_get_string(core_info[i].data, "corename",
-               &core_info[i].core_name);
-         config_get_string(core_info[i].data, "systemname",
-               &core_info[i].systemname);
-         config_get_string(core_info[i].data, "manufacturer",
-               &core_info[i].system_manufacturer);
-         config_get_uint(core_info[i].data, "firmware_count", &count);
-         core_info[i].firmware_count = count;
-         if (config_get_string(core_info[i].data, "supported_extensions",
-                  &core_info[i].supported_extensions) &&
-               core_info[i].supported_extensions)
-            core_info[i].supported_extensions_list =
-               string_split(core_info[i].supported_extensions, "|");
-
-         if (config_get_string(core_info[i].data, "authors",
-                  &core_info[i].authors) &&
-               core_info[i].authors)
-            core_info[i].authors_list =
-               string_split(core_info[i].authors, "|");
-
-         if (config_get_string(core_info[i].data, "permissions",
-                  &core_info[i].permissions) &&
-               core_info[i].permissions)
-            core_info[i].permissions_list =
-               string_split(core_info[i].permissions, "|");
-
-         if (config_get_string(core_info[i].data, "license",
-                  &core_info[i].licenses) &&
-               core_info[i].licenses)
-            core_info[i].licenses_list =
-               string_split(core_info[i].licenses, "|");
-
-         if (config_get_string(core_info[i].data, "categories",
-                  &core_info[i].categories) &&
-               core_info[i].categories)
-            core_info[i].categories_list =
-               string_split(core_info[i].categories, "|");
-
-         if (config_get_string(core_info[i].data, "database",
-                  &core_info[i].databases) &&
-               core_info[i].databases)
-            core_info[i].databases_list =
-               string_split(core_info[i].databases, "|");
-
-         if (config_get_string(core_info[i].data, "notes",
-                  &core_info[i].notes) &&
-               core_info[i].notes)
-            core_info[i].note_list = string_split(core_info[i].notes, "|");
-
-         config_get_bool(core_info[i].data, "supports_no_game",
-               &core_info[i].supports_no_game);
+         if (core_info_cache_read(&cache, &stamps[i], &core_info[i]))
+            core_info[i].has_info = true;
+         else
+         {
+            core_info[i].has_info = core_info_parse(&core_info[i], info_path);
+            cache_dirty           = true;
+         }
+
+         if (!core_info[i].has_info)
+         {
+            free(stamps[i].name);
+            stamps[i].name = NULL;
+         }
       }
 
+      core_info_resolve_lists(&core_info[i]);
+
       if (!core_info[i].display_name)
          core_info[i].display_name = strdup(path_basename(core_info[i].path));
    }
 
+   core_info_cache_free(&cache);
+
+   if (cache_dirty)
+      core_info_cache_save(cache_path, core_info_list, stamps, i);
+
+   for (i = 0; i < contents->size; i++)
+      free(stamps[i].name);
+   free(stamps);
+
    core_info_list_resolve_all_extensions(core_info_list);
-   core_info_list_resolve_all_firmware(core_info_list);
 
    dir_list_free(contents);
    return core_info_list;
@@ -327,7 +767,6 @@ void core_info_list_free(core_info_list_t *core_info_list)
       string_list_free(info->licenses_list);
       string_list_free(info->categories_list);
       string_list_free(info->databases_list);
-      config_file_free(info->data);
 
       for (j = 0; j < info->firmware_count; j++)
       {
@@ -350,7 +789,7 @@ size_t core_info_list_num_info_files(core_info_list_t *core_info_list)
       return 0;
 
    for (i = 0; i < core_info_list->count; i++)
-      num += !!core_info_list->list[i].data;
+      num += core_info_list->list[i].has_info;
 
    return num;
 }
@@ -38,7 +38,8 @@ typedef struct
 typedef struct
 {
    char *path;
-   config_file_t *data;
+   /* Whether an .info file was found for the core. */
+   bool has_info;
    char *display_name;
    char *core_name;
    char *system_manufacturer;
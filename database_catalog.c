@@ -0,0 +1,539 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <file/dir_list.h>
+#include <retro_miscellaneous.h>
+
+#include "database_catalog.h"
+#include "general.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+enum catalog_field
+{
+   CATALOG_FIELD_NAME = 0,
+   CATALOG_FIELD_DEVELOPER,
+   CATALOG_FIELD_PUBLISHER,
+   CATALOG_FIELD_RELEASEYEAR,
+   CATALOG_FIELD_CRC,
+   CATALOG_FIELD_SERIAL,
+   CATALOG_FIELD_LAST
+};
+
+static const char *catalog_field_names[CATALOG_FIELD_LAST] = {
+   "name",
+   "developer",
+   "publisher",
+   "releaseyear",
+   "crc",
+   "serial"
+};
+
+/* One key of one item. Postings are sorted by hash, then
+ * by database and offset, so every key is a single run in
+ * the order a scan would find the items in. */
+struct catalog_posting
+{
+   uint32_t hash;
+   uint32_t db;
+   uint32_t offset;
+};
+
+struct catalog_postings
+{
+   struct catalog_posting *list;
+   size_t count;
+   size_t capacity;
+};
+
+struct catalog_db
+{
+   libretrodb_t db;
+   time_t mtime;
+   off_t size;
+};
+
+struct database_catalog
+{
+   char dir[PATH_MAX_LENGTH];
+   struct catalog_db *dbs;
+   unsigned count;
+   struct catalog_postings fields[CATALOG_FIELD_LAST];
+};
+
+static uint32_t catalog_hash(const char *s, size_t len)
+{
+   size_t i;
+   uint32_t hash = 5381;
+
+   for (i = 0; i < len; i++)
+      hash = (hash << 5) + hash + (uint8_t)s[i];
+
+   return hash;
+}
+
+/* Gets the text a field is looked up by: strings as they are,
+ * integers in decimal and binary values in hex. @s is used for
+ * anything that is not a string. */
+static size_t catalog_key(const struct rmsgpack_view *val,
+      char *s, size_t len, const char **key)
+{
+   uint32_t i;
+
+   *key = s;
+
+   switch (val->type)
+   {
+      case RDT_STRING:
+         *key = (const char*)val->data;
+         return val->len;
+      case RDT_UINT:
+         snprintf(s, len, "%llu", (unsigned long long)val->val.uint_);
+         return strlen(s);
+      case RDT_INT:
+         snprintf(s, len, "%lld", (long long)val->val.int_);
+         return strlen(s);
+      case RDT_BINARY:
+         for (i = 0; i < val->len && (i + 1) * 2 < len; i++)
+            snprintf(s + i * 2, 3, "%02X", val->data[i]);
+         return i * 2;
+      default:
+         break;
+   }
+
+   return 0;
+}
+
+static enum catalog_field catalog_find_field(const char *key, size_t len)
+{
+   unsigned i;
+
+   for (i = 0; i < CATALOG_FIELD_LAST; i++)
+      if (strlen(catalog_field_names[i]) == len
+            && !memcmp(catalog_field_names[i], key, len))
+         return (enum catalog_field)i;
+
+   return CATALOG_FIELD_LAST;
+}
+
+static bool catalog_add(struct catalog_postings *postings,
+      const char *key, size_t len, unsigned db, uint64_t offset)
+{
+   struct catalog_posting *posting = NULL;
+
+   if (postings->count == postings->capacity)
+   {
+      size_t capacity = postings->capacity ? postings->capacity * 2 : 4096;
+      struct catalog_posting *list = (struct catalog_posting*)
+         realloc(postings->list, capacity * sizeof(*list));
+
+      if (!list)
+         return false;
+
+      postings->list     = list;
+      postings->capacity = capacity;
+   }
+
+   posting         = &postings->list[postings->count++];
+   posting->hash   = catalog_hash(key, len);
+   posting->db     = db;
+   posting->offset = (uint32_t)offset;
+   return true;
+}
+
+static bool catalog_add_item(database_catalog_t *catalog, unsigned db,
+      const struct rmsgpack_view *item, uint64_t offset)
+{
+   uint32_t i;
+   struct rmsgpack_view key, val;
+   const uint8_t *ptr = item->data;
+
+   if (item->type != RDT_MAP)
+      return true;
+
+   for (i = 0; i < item->len; i++)
+   {
+      char buf[64];
+      size_t len;
+      const char *str = NULL;
+      enum catalog_field field;
+
+      if (rmsgpack_view_read(&ptr, item->end, &key) != 0)
+         break;
+      if (rmsgpack_view_read(&ptr, item->end, &val) != 0)
+         break;
+
+      if (key.type != RDT_STRING)
+         continue;
+
+      field = catalog_find_field((const char*)key.data, key.len);
+      if (field == CATALOG_FIELD_LAST)
+         continue;
+
+      len = catalog_key(&val, buf, sizeof(buf), &str);
+      if (len == 0)
+         continue;
+
+      if (field == CATALOG_FIELD_DEVELOPER)
+      {
+         /* Every developer gets a key of its own. */
+         const char *end = str + len;
+
+         while (str < end)
+         {
+            const char *sep = (const char*)memchr(str, '|', end - str);
+
+            if (!sep)
+               sep = end;
+            if (sep > str && !catalog_add(&catalog->fields[field],
+                     str, sep - str, db, offset))
+               return false;
+            str = sep + 1;
+         }
+      }
+      else if (!catalog_add(&catalog->fields[field], str, len, db, offset))
+         return false;
+   }
+
+   return true;
+}
+
+static int catalog_posting_cmp(const void *a_, const void *b_)
+{
+   const struct catalog_posting *a = (const struct catalog_posting*)a_;
+   const struct catalog_posting *b = (const struct catalog_posting*)b_;
+
+   if (a->hash != b->hash)
+      return (a->hash < b->hash) ? -1 : 1;
+   if (a->db != b->db)
+      return (a->db < b->db) ? -1 : 1;
+   if (a->offset != b->offset)
+      return (a->offset < b->offset) ? -1 : 1;
+   return 0;
+}
+
+static bool catalog_load_db(database_catalog_t *catalog, const char *path)
+{
+   unsigned i;
+   struct stat st;
+   size_t counts[CATALOG_FIELD_LAST];
+   libretrodb_cursor_t cur         = {0};
+   struct catalog_db *entry        = &catalog->dbs[catalog->count];
+   bool ret                        = false;
+
+   if (stat(path, &st) != 0)
+      return false;
+
+   if (libretrodb_open(path, &entry->db) != 0)
+      return false;
+
+   for (i = 0; i < CATALOG_FIELD_LAST; i++)
+      counts[i] = catalog->fields[i].count;
+
+   /* Postings only have room for 32-bit offsets. */
+   if (entry->db.size > UINT32_MAX
+         || libretrodb_cursor_open(&entry->db, &cur, NULL) != 0)
+      goto end;
+
+   for (;;)
+   {
+      struct rmsgpack_view item;
+      uint64_t offset = cur.offset;
+
+      if (libretrodb_cursor_read_item_view(&cur, &item) != 0)
+         break;
+
+      if (!catalog_add_item(catalog, catalog->count, &item, offset))
+         goto end;
+   }
+
+   entry->mtime = st.st_mtime;
+   entry->size  = st.st_size;
+   ret          = true;
+
+end:
+   if (cur.is_valid)
+      libretrodb_cursor_close(&cur);
+   if (ret)
+      catalog->count++;
+   else
+   {
+      /* Drop whatever got posted for this database. */
+      for (i = 0; i < CATALOG_FIELD_LAST; i++)
+         catalog->fields[i].count = counts[i];
+      libretrodb_close(&entry->db);
+   }
+   return ret;
+}
+
+database_catalog_t *database_catalog_new(const char *dir)
+{
+   unsigned i;
+   database_catalog_t *catalog = NULL;
+   struct string_list *list    = dir_list_new(dir, "rdb", false, false);
+
+   if (!list)
+      return NULL;
+
+   dir_list_sort(list, true);
+
+   catalog = (database_catalog_t*)calloc(1, sizeof(*catalog));
+   if (!catalog)
+      goto error;
+
+   catalog->dbs = (struct catalog_db*)calloc(list->size + 1,
+         sizeof(*catalog->dbs));
+   if (!catalog->dbs)
+      goto error;
+
+   strlcpy(catalog->dir, dir, sizeof(catalog->dir));
+
+   for (i = 0; i < list->size; i++)
+   {
+      if (!catalog_load_db(catalog, list->elems[i].data))
+         RARCH_WARN("Could not add %s to database catalog.\n",
+               list->elems[i].data);
+   }
+
+   if (catalog->count == 0)
+      goto error;
+
+   for (i = 0; i < CATALOG_FIELD_LAST; i++)
+      qsort(catalog->fields[i].list, catalog->fields[i].count,
+            sizeof(struct catalog_posting), catalog_posting_cmp);
+
+   string_list_free(list);
+   return catalog;
+
+error:
+   string_list_free(list);
+   database_catalog_free(catalog);
+   return NULL;
+}
+
+void database_catalog_free(database_catalog_t *catalog)
+{
+   unsigned i;
+
+   if (!catalog)
+      return;
+
+   for (i = 0; i < catalog->count; i++)
+      libretrodb_close(&catalog->dbs[i].db);
+   for (i = 0; i < CATALOG_FIELD_LAST; i++)
+      free(catalog->fields[i].list);
+
+   free(catalog->dbs);
+   free(catalog);
+}
+
+bool database_catalog_is_stale(database_catalog_t *catalog,
+      const char *dir)
+{
+   unsigned i;
+
+   if (strcmp(catalog->dir, dir))
+      return true;
+
+   for (i = 0; i < catalog->count; i++)
+   {
+      struct stat st;
+      const struct catalog_db *entry = &catalog->dbs[i];
+
+      if (stat(entry->db.path, &st) != 0
+            || st.st_mtime != entry->mtime || st.st_size != entry->size)
+         return true;
+   }
+
+   return false;
+}
+
+static bool catalog_list_append(database_info_list_t *list,
+      const struct rmsgpack_view *item)
+{
+   database_info_t *info = NULL;
+   database_info_t *tmp  = (database_info_t*)realloc(list->list,
+         (list->count + 1) * sizeof(database_info_t));
+
+   if (!tmp)
+      return false;
+
+   list->list = tmp;
+   info       = &list->list[list->count];
+   memset(info, 0, sizeof(*info));
+
+   if (database_info_read_view(item, info) == 0)
+      list->count++;
+   return true;
+}
+
+/* Hashes can collide, so every candidate gets checked against
+ * the item itself. */
+static bool catalog_item_matches(const struct rmsgpack_view *item,
+      enum catalog_field field, const char *value, size_t value_len)
+{
+   char buf[64];
+   size_t len;
+   struct rmsgpack_view val;
+   const char *str = NULL;
+
+   if (rmsgpack_view_map_find(item, catalog_field_names[field], &val) != 0)
+      return false;
+
+   len = catalog_key(&val, buf, sizeof(buf), &str);
+
+   if (field == CATALOG_FIELD_DEVELOPER)
+   {
+      const char *end = str + len;
+
+      while (str < end)
+      {
+         const char *sep = (const char*)memchr(str, '|', end - str);
+
+         if (!sep)
+            sep = end;
+         if ((size_t)(sep - str) == value_len
+               && !memcmp(str, value, value_len))
+            return true;
+         str = sep + 1;
+      }
+
+      return false;
+   }
+
+   return len == value_len && !memcmp(str, value, value_len);
+}
+
+static int catalog_find_db(database_catalog_t *catalog, const char *path)
+{
+   unsigned i;
+
+   for (i = 0; i < catalog->count; i++)
+      if (!strcmp(catalog->dbs[i].db.path, path))
+         return i;
+
+   return -1;
+}
+
+static bool catalog_list_db(database_catalog_t *catalog, unsigned db,
+      database_info_list_t *list)
+{
+   struct rmsgpack_view item;
+   bool ret                = true;
+   libretrodb_cursor_t cur = {0};
+
+   if (libretrodb_cursor_open(&catalog->dbs[db].db, &cur, NULL) != 0)
+      return false;
+
+   while (ret && libretrodb_cursor_read_item_view(&cur, &item) == 0)
+      ret = catalog_list_append(list, &item);
+
+   libretrodb_cursor_close(&cur);
+   return ret;
+}
+
+database_info_list_t *database_catalog_find(database_catalog_t *catalog,
+      const char *rdb_path, const char *field, const char *value)
+{
+   size_t lo, hi, value_len;
+   uint32_t hash;
+   int db                          = -1;
+   enum catalog_field id           = CATALOG_FIELD_LAST;
+   const struct catalog_postings *postings = NULL;
+   database_info_list_t *list      = NULL;
+
+   if (!catalog)
+      return NULL;
+
+   if (rdb_path && (db = catalog_find_db(catalog, rdb_path)) < 0)
+      return NULL;
+
+   if (field)
+   {
+      id = catalog_find_field(field, strlen(field));
+      if (id == CATALOG_FIELD_LAST || !value)
+         return NULL;
+   }
+
+   list = (database_info_list_t*)calloc(1, sizeof(*list));
+   if (!list)
+      return NULL;
+
+   if (!field)
+   {
+      unsigned i;
+
+      for (i = 0; i < catalog->count; i++)
+         if ((db < 0 || (unsigned)db == i)
+               && !catalog_list_db(catalog, i, list))
+            goto error;
+
+      return list;
+   }
+
+   postings  = &catalog->fields[id];
+   value_len = strlen(value);
+   hash      = catalog_hash(value, value_len);
+
+   /* Find the first posting of the key. */
+   lo = 0;
+   hi = postings->count;
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (postings->list[mid].hash < hash)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   for (; lo < postings->count && postings->list[lo].hash == hash; lo++)
+   {
+      struct rmsgpack_view item;
+      const struct catalog_posting *posting = &postings->list[lo];
+
+      if (db >= 0 && posting->db != (unsigned)db)
+         continue;
+
+      /* Items listing a developer twice are posted twice. */
+      if (lo > 0 && !catalog_posting_cmp(posting, posting - 1))
+         continue;
+
+      if (libretrodb_read_item_view_at(&catalog->dbs[posting->db].db,
+               posting->offset, &item) != 0)
+         continue;
+
+      if (!catalog_item_matches(&item, id, value, value_len))
+         continue;
+
+      if (!catalog_list_append(list, &item))
+         goto error;
+   }
+
+   return list;
+
+error:
+   database_info_list_free(list);
+   return NULL;
+}
@@ -0,0 +1,74 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_CATALOG_H_
+#define DATABASE_CATALOG_H_
+
+#include <boolean.h>
+#include "database_info.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct database_catalog database_catalog_t;
+
+/**
+ * database_catalog_new:
+ * @dir                 : Directory containing the .rdb files.
+ *
+ * Opens every database in @dir and builds one index over the name,
+ * developer, publisher, releaseyear, crc and serial fields of all
+ * of them. The databases stay mapped until the catalog is freed.
+ *
+ * Returns: new catalog, NULL if no database could be opened.
+ **/
+database_catalog_t *database_catalog_new(const char *dir);
+
+void database_catalog_free(database_catalog_t *catalog);
+
+/**
+ * database_catalog_is_stale:
+ * @catalog             : Catalog handle.
+ * @dir                 : Directory the catalog should cover.
+ *
+ * Returns: true if @catalog was built from another directory, or
+ * any of its databases changed on disk since.
+ **/
+bool database_catalog_is_stale(database_catalog_t *catalog,
+      const char *dir);
+
+/**
+ * database_catalog_find:
+ * @catalog             : Catalog handle.
+ * @rdb_path            : Database to search, NULL to search all.
+ * @field               : Field to match, NULL to list every entry.
+ * @value               : Value @field has to be equal to. Integers are
+ *                        matched in decimal, binary fields in upper case
+ *                        hex. Developers match any of the '|' separated
+ *                        names.
+ *
+ * Returns: list of matching entries, NULL if @field is not indexed
+ * or @rdb_path is not part of @catalog.
+ **/
+database_info_list_t *database_catalog_find(database_catalog_t *catalog,
+      const char *rdb_path, const char *field, const char *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -108,82 +108,79 @@ static void database_info_build_query_add_glob_close(char *s, size_t len)
    strlcat(s, "*')", len);
 }
 
+struct database_info_query_field
+{
+   uint32_t label;
+   const char *field;
+   bool add_quotes;
+   bool add_glob;
+};
+
+static const struct database_info_query_field database_info_query_fields[] = {
+   { DB_QUERY_ENTRY,                         "name",           true,  false },
+   { DB_QUERY_ENTRY_PUBLISHER,               "publisher",      true,  false },
+   { DB_QUERY_ENTRY_DEVELOPER,               "developer",      false, true  },
+   { DB_QUERY_ENTRY_ORIGIN,                  "origin",         true,  false },
+   { DB_QUERY_ENTRY_FRANCHISE,               "franchise",      true,  false },
+   { DB_QUERY_ENTRY_RATING,                  "esrb_rating",    true,  false },
+   { DB_QUERY_ENTRY_BBFC_RATING,             "bbfc_rating",    true,  false },
+   { DB_QUERY_ENTRY_ELSPA_RATING,            "elspa_rating",   true,  false },
+   { DB_QUERY_ENTRY_PEGI_RATING,             "pegi_rating",    true,  false },
+   { DB_QUERY_ENTRY_CERO_RATING,             "cero_rating",    true,  false },
+   { DB_QUERY_ENTRY_ENHANCEMENT_HW,          "enhancement_hw", true,  false },
+   { DB_QUERY_ENTRY_EDGE_MAGAZINE_RATING,    "edge_rating",    false, false },
+   { DB_QUERY_ENTRY_EDGE_MAGAZINE_ISSUE,     "edge_issue",     false, false },
+   { DB_QUERY_ENTRY_FAMITSU_MAGAZINE_RATING, "famitsu_rating", false, false },
+   { DB_QUERY_ENTRY_RELEASEDATE_MONTH,       "releasemonth",   false, false },
+   { DB_QUERY_ENTRY_RELEASEDATE_YEAR,        "releaseyear",    false, false },
+   { DB_QUERY_ENTRY_MAX_USERS,               "users",          false, false },
+};
+
+static const struct database_info_query_field *database_info_find_query_field(
+      const char *label)
+{
+   unsigned i;
+   uint32_t value = msg_hash_calculate(label);
+
+   for (i = 0; i < ARRAY_SIZE(database_info_query_fields); i++)
+      if (database_info_query_fields[i].label == value)
+         return &database_info_query_fields[i];
+
+   return NULL;
+}
+
+/**
+ * database_info_query_field:
+ * @label               : Menu label of a database query.
+ *
+ * Returns: name of the database field @label searches by,
+ * NULL if @label is not a database query.
+ **/
+const char *database_info_query_field(const char *label)
+{
+   const struct database_info_query_field *entry =
+      database_info_find_query_field(label);
+   return entry ? entry->field : NULL;
+}
+
 int database_info_build_query(char *s, size_t len,
       const char *label, const char *path)
 {
-   uint32_t value  = 0;
    bool add_quotes = true;
    bool add_glob   = false;
+   const struct database_info_query_field *entry =
+      database_info_find_query_field(label);
 
    database_info_build_query_add_bracket_open(s, len);
 
-   value = msg_hash_calculate(label);
-
-   switch (value)
+   if (entry)
    {
-      case DB_QUERY_ENTRY:
-         strlcat(s, "name", len);
-         break;
-      case DB_QUERY_ENTRY_PUBLISHER:
-         strlcat(s, "publisher", len);
-         break;
-      case DB_QUERY_ENTRY_DEVELOPER:
-         strlcat(s, "developer", len);
-         add_glob = true;
-         add_quotes = false;
-         break;
-      case DB_QUERY_ENTRY_ORIGIN:
-         strlcat(s, "origin", len);
-         break;
-      case DB_QUERY_ENTRY_FRANCHISE:
-         strlcat(s, "franchise", len);
-         break;
-      case DB_QUERY_ENTRY_RATING:
-         strlcat(s, "esrb_rating", len);
-         break;
-      case DB_QUERY_ENTRY_BBFC_RATING:
-         strlcat(s, "bbfc_rating", len);
-         break;
-      case DB_QUERY_ENTRY_ELSPA_RATING:
-         strlcat(s, "elspa_rating", len);
-         break;
-      case DB_QUERY_ENTRY_PEGI_RATING:
-         strlcat(s, "pegi_rating", len);
-         break;
-      case DB_QUERY_ENTRY_CERO_RATING:
-         strlcat(s, "cero_rating", len);
-         break;
-      case DB_QUERY_ENTRY_ENHANCEMENT_HW:
-         strlcat(s, "enhancement_hw", len);
-         break;
-      case DB_QUERY_ENTRY_EDGE_MAGAZINE_RATING:
-         strlcat(s, "edge_rating", len);
-         add_quotes = false;
-         break;
-      case DB_QUERY_ENTRY_EDGE_MAGAZINE_ISSUE:
-         strlcat(s, "edge_issue", len);
-         add_quotes = false;
-         break;
-      case DB_QUERY_ENTRY_FAMITSU_MAGAZINE_RATING:
-         strlcat(s, "famitsu_rating", len);
-         add_quotes = false;
-         break;
-      case DB_QUERY_ENTRY_RELEASEDATE_MONTH:
-         strlcat(s, "releasemonth", len);
-         add_quotes = false;
-         break;
-      case DB_QUERY_ENTRY_RELEASEDATE_YEAR:
-         strlcat(s, "releaseyear", len);
-         add_quotes = false;
-         break;
-      case DB_QUERY_ENTRY_MAX_USERS:
-         strlcat(s, "users", len);
-         add_quotes = false;
-         break;
-      default:
-         RARCH_LOG("Unknown label: %s\n", label);
-         break;
+      strlcat(s, entry->field, len);
+      add_quotes = entry->add_quotes;
+      add_glob   = entry->add_glob;
    }
+   else
+      RARCH_LOG("Unknown label: %s\n", label);
 
    database_info_build_query_add_colon(s, len);
    if (add_glob)
@@ -218,131 +215,182 @@ static char *bin_to_hex_alloc(const uint8_t *data, size_t len)
 }
 
 
-static int database_cursor_iterate(libretrodb_cursor_t *cur,
+static char *database_view_strdup(const struct rmsgpack_view *val)
+{
+   char *ret = (char*)malloc(val->len + 1);
+
+   if (!ret)
+      return NULL;
+
+   memcpy(ret, val->data, val->len);
+   ret[val->len] = '\0';
+   return ret;
+}
+
+/* msg_hash_calculate of a string inside the database, which is
+ * not NUL terminated. */
+static uint32_t database_view_hash(const struct rmsgpack_view *val)
+{
+   size_t i;
+   uint32_t hash = 5381;
+
+   for (i = 0; i < val->len; i++)
+      hash = (hash << 5) + hash + val->data[i];
+
+   return hash;
+}
+
+/**
+ * database_info_read_view:
+ * @item                : Database item, decoded in place.
+ * @db_info             : Entry to fill in.
+ *
+ * Only the fields stored in @db_info get copied out of the database.
+ *
+ * Returns: 0 if successful, 1 if @item is not a map.
+ **/
+int database_info_read_view(const struct rmsgpack_view *item,
       database_info_t *db_info)
 {
    unsigned i;
-   struct rmsgpack_dom_value item;
-   const char* str                = NULL;
-
-   if (libretrodb_cursor_read_item(cur, &item) != 0)
-      return -1;
+   struct rmsgpack_view key, val;
+   const uint8_t *ptr             = NULL;
+   char *developer                = NULL;
+   uint32_t crc32                 = 0;
 
-   if (item.type != RDT_MAP)
-   {
-      rmsgpack_dom_value_free(&item);
+   if (item->type != RDT_MAP)
       return 1;
-   }
 
    db_info->analog_supported       = -1;
    db_info->rumble_supported       = -1;
 
-   for (i = 0; i < item.val.map.len; i++)
+   ptr = item->data;
+
+   for (i = 0; i < item->len; i++)
    {
       uint32_t                 value = 0;
-      struct rmsgpack_dom_value *key = &item.val.map.items[i].key;
-      struct rmsgpack_dom_value *val = &item.val.map.items[i].value;
 
-      if (!key || !val)
+      if (rmsgpack_view_read(&ptr, item->end, &key) != 0)
+         break;
+      if (rmsgpack_view_read(&ptr, item->end, &val) != 0)
+         break;
+
+      if (key.type != RDT_STRING)
          continue;
 
-      str   = key->val.string.buff;
-      value = msg_hash_calculate(str);
+      value = database_view_hash(&key);
 
       switch (value)
       {
          case DB_CURSOR_SERIAL:
-            db_info->serial = strdup(val->val.string.buff);
+            db_info->serial = database_view_strdup(&val);
             break;
          case DB_CURSOR_ROM_NAME:
-            db_info->rom_name = strdup(val->val.string.buff);
+            db_info->rom_name = database_view_strdup(&val);
             break;
          case DB_CURSOR_NAME:
-            db_info->name = strdup(val->val.string.buff);
+            db_info->name = database_view_strdup(&val);
             break;
          case DB_CURSOR_DESCRIPTION:
-            db_info->description = strdup(val->val.string.buff);
+            db_info->description = database_view_strdup(&val);
             break;
          case DB_CURSOR_PUBLISHER:
-            db_info->publisher = strdup(val->val.string.buff);
+            db_info->publisher = database_view_strdup(&val);
             break;
          case DB_CURSOR_DEVELOPER:
-            db_info->developer = string_split(val->val.string.buff, "|");
+            developer = database_view_strdup(&val);
+            if (developer)
+               db_info->developer = string_split(developer, "|");
+            free(developer);
             break;
          case DB_CURSOR_ORIGIN:
-            db_info->origin = strdup(val->val.string.buff);
+            db_info->origin = database_view_strdup(&val);
             break;
          case DB_CURSOR_FRANCHISE:
-            db_info->franchise = strdup(val->val.string.buff);
+            db_info->franchise = database_view_strdup(&val);
             break;
          case DB_CURSOR_BBFC_RATING:
-            db_info->bbfc_rating = strdup(val->val.string.buff);
+            db_info->bbfc_rating = database_view_strdup(&val);
             break;
          case DB_CURSOR_ESRB_RATING:
-            db_info->esrb_rating = strdup(val->val.string.buff);
+            db_info->esrb_rating = database_view_strdup(&val);
             break;
          case DB_CURSOR_ELSPA_RATING:
-            db_info->elspa_rating = strdup(val->val.string.buff);
+            db_info->elspa_rating = database_view_strdup(&val);
             break;
          case DB_CURSOR_CERO_RATING:
-            db_info->cero_rating = strdup(val->val.string.buff);
+            db_info->cero_rating = database_view_strdup(&val);
             break;
          case DB_CURSOR_PEGI_RATING:
-            db_info->pegi_rating = strdup(val->val.string.buff);
+            db_info->pegi_rating = database_view_strdup(&val);
             break;
          case DB_CURSOR_ENHANCEMENT_HW:
-            db_info->enhancement_hw = strdup(val->val.string.buff);
+            db_info->enhancement_hw = database_view_strdup(&val);
             break;
          case DB_CURSOR_EDGE_MAGAZINE_REVIEW:
-            db_info->edge_magazine_review = strdup(val->val.string.buff);
+            db_info->edge_magazine_review = database_view_strdup(&val);
             break;
          case DB_CURSOR_EDGE_MAGAZINE_RATING:
-            db_info->edge_magazine_rating = val->val.uint_;
+            db_info->edge_magazine_rating = val.val.uint_;
             break;
          case DB_CURSOR_EDGE_MAGAZINE_ISSUE:
-            db_info->edge_magazine_issue = val->val.uint_;
+            db_info->edge_magazine_issue = val.val.uint_;
             break;
          case DB_CURSOR_FAMITSU_MAGAZINE_RATING:
-            db_info->famitsu_magazine_rating = val->val.uint_;
+            db_info->famitsu_magazine_rating = val.val.uint_;
             break;
          case DB_CURSOR_MAX_USERS:
-            db_info->max_users = val->val.uint_;
+            db_info->max_users = val.val.uint_;
             break;
          case DB_CURSOR_RELEASEDATE_MONTH:
-            db_info->releasemonth = val->val.uint_;
+            db_info->releasemonth = val.val.uint_;
             break;
          case DB_CURSOR_RELEASEDATE_YEAR:
-            db_info->releaseyear = val->val.uint_;
+            db_info->releaseyear = val.val.uint_;
             break;
          case DB_CURSOR_RUMBLE_SUPPORTED:
-            db_info->rumble_supported = val->val.uint_;
+            db_info->rumble_supported = val.val.uint_;
             break;
          case DB_CURSOR_ANALOG_SUPPORTED:
-            db_info->analog_supported = val->val.uint_;
+            db_info->analog_supported = val.val.uint_;
             break;
          case DB_CURSOR_SIZE:
-            db_info->size = val->val.uint_;
+            db_info->size = val.val.uint_;
             break;
          case DB_CURSOR_CHECKSUM_CRC32:
-            db_info->crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff);
+            if (val.len < sizeof(uint32_t))
+               break;
+            /* Not necessarily aligned inside the database. */
+            memcpy(&crc32, val.data, sizeof(crc32));
+            db_info->crc32 = swap_if_little32(crc32);
             break;
          case DB_CURSOR_CHECKSUM_SHA1:
-            db_info->sha1 = bin_to_hex_alloc((uint8_t*)val->val.binary.buff, val->val.binary.len);
+            db_info->sha1 = bin_to_hex_alloc(val.data, val.len);
             break;
          case DB_CURSOR_CHECKSUM_MD5:
-            db_info->md5 = bin_to_hex_alloc((uint8_t*)val->val.binary.buff, val->val.binary.len);
+            db_info->md5 = bin_to_hex_alloc(val.data, val.len);
             break;
          default:
-            RARCH_LOG("Unknown key: %s\n", str);
+            RARCH_LOG("Unknown key: %.*s\n", (int)key.len,
+                  (const char*)key.data);
             break;
       }
    }
 
-   rmsgpack_dom_value_free(&item);
-
    return 0;
 }
 
+static int database_cursor_iterate(libretrodb_cursor_t *cur,
+      database_info_t *db_info)
+{
+   struct rmsgpack_view item;
+
+   if (libretrodb_cursor_read_item_view(cur, &item) != 0)
+      return -1;
+
+   return database_info_read_view(&item, db_info);
+}
+
 static int database_cursor_open(libretrodb_t *db,
       libretrodb_cursor_t *cur, const char *path, const char *query)
 {
@@ -112,6 +112,11 @@ void database_info_free(database_info_handle_t *handle);
 int database_info_build_query(
       char *query, size_t len, const char *label, const char *path);
 
+const char *database_info_query_field(const char *label);
+
+int database_info_read_view(const struct rmsgpack_view *item,
+      database_info_t *db_info);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,9 @@
 
 #include "file_ops.h"
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
 
 #ifdef HAVE_7ZIP
 #include "decompress/7zip_support.h"
@@ -67,6 +70,11 @@
 #include <unistd.h>
 #endif
 
+#if defined(HAVE_MMAP) && !defined(_WIN32)
+#include <fcntl.h>
+#include <memmap.h>
+#endif
+
 /**
  * write_file:
  * @path             : path to file.
@@ -89,6 +97,57 @@ bool write_file(const char *path, const void *data, ssize_t size)
    return (ret == size);
 }
 
+/**
+ * write_file_atomic:
+ * @path             : path to file.
+ * @data             : contents to write to the file.
+ * @size             : size of the contents.
+ *
+ * Writes data to a temporary file next to @path, flushes it to
+ * disk and renames it over @path, so that @path holds either its
+ * old or its new contents if the write is interrupted.
+ *
+ * Returns: true (1) on success, false (0) otherwise.
+ */
+bool write_file_atomic(const char *path, const void *data, ssize_t size)
+{
+   bool ret                        = false;
+   char tmp_path[PATH_MAX_LENGTH]  = {0};
+   FILE *file                      = NULL;
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+   if (!(file = fopen(tmp_path, "wb")))
+      return false;
+
+   ret = fwrite(data, 1, size, file) == (size_t)size;
+   ret = fflush(file) == 0 && ret;
+#if defined(_WIN32) && !defined(_XBOX)
+   ret = _commit(_fileno(file)) == 0 && ret;
+#elif defined(__unix__) || defined(__APPLE__)
+   ret = fsync(fileno(file)) == 0 && ret;
+#endif
+   ret = fclose(file) == 0 && ret;
+
+   if (ret)
+   {
+#if defined(_WIN32) && !defined(_XBOX)
+      /* rename() fails on Windows if @path exists. */
+      ret = MoveFileEx(tmp_path, path,
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+#ifdef _XBOX
+      remove(path);
+#endif
+      ret = rename(tmp_path, path) == 0;
+#endif
+   }
+
+   if (!ret)
+      remove(tmp_path);
+   return ret;
+}
+
 /**
  * read_generic_file:
  * @path             : path to file.
@@ -247,6 +306,85 @@ int read_file(const char *path, void **buf, ssize_t *length)
    return read_generic_file(path, buf, length);
 }
 
+/**
+ * map_file:
+ * @path             : path to file.
+ * @buf              : read-only mapping of the file contents.
+ *                     Needs to be released with unmap_file.
+ * @length           : size of the mapping, -1 on error.
+ *
+ * Maps the contents of an uncompressed file into memory,
+ * avoiding a heap copy of the whole file.
+ *
+ * Returns: 1 if file mapped, 0 on error or if mapping
+ * is not supported, in which case read_file should be used.
+ */
+int map_file(const char *path, void **buf, ssize_t *length)
+{
+#if defined(HAVE_MMAP) && !defined(_WIN32)
+   struct stat fds;
+   void *data = NULL;
+   int fd     = -1;
+
+   *buf       = NULL;
+   *length    = -1;
+
+#ifdef HAVE_COMPRESSION
+   if (path_contains_compressed_file(path))
+      return 0;
+#endif
+
+   fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return 0;
+
+   if (fstat(fd, &fds) < 0 || !S_ISREG(fds.st_mode) || fds.st_size <= 0)
+      goto error;
+
+   data = mmap(NULL, fds.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if (data == MAP_FAILED)
+      goto error;
+
+#ifdef MADV_SEQUENTIAL
+   /* Cores typically copy the whole buffer front to back. */
+   madvise(data, fds.st_size, MADV_SEQUENTIAL);
+#endif
+
+   /* The mapping stays valid after the descriptor is closed. */
+   close(fd);
+
+   *buf    = data;
+   *length = fds.st_size;
+   return 1;
+
+error:
+   close(fd);
+#else
+   (void)path;
+   *buf    = NULL;
+   *length = -1;
+#endif
+   return 0;
+}
+
+/**
+ * unmap_file:
+ * @buf              : mapping returned by map_file.
+ * @length           : size of the mapping.
+ *
+ * Releases a mapping created by map_file.
+ */
+void unmap_file(void *buf, ssize_t length)
+{
+#if defined(HAVE_MMAP) && !defined(_WIN32)
+   if (buf && length > 0)
+      munmap(buf, length);
+#else
+   (void)buf;
+   (void)length;
+#endif
+}
+
 struct string_list *compressed_file_list_new(const char *path,
       const char* ext)
 {
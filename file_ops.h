@@ -51,6 +51,30 @@ int read_compressed_file(const char * path, void **buf,
  */
 int read_file(const char *path, void **buf, ssize_t *length);
 
+/**
+ * map_file:
+ * @path             : path to file.
+ * @buf              : read-only mapping of the file contents.
+ *                     Needs to be released with unmap_file.
+ * @length           : size of the mapping, -1 on error.
+ *
+ * Maps the contents of an uncompressed file into memory,
+ * avoiding a heap copy of the whole file.
+ *
+ * Returns: 1 if file mapped, 0 on error or if mapping
+ * is not supported, in which case read_file should be used.
+ */
+int map_file(const char *path, void **buf, ssize_t *length);
+
+/**
+ * unmap_file:
+ * @buf              : mapping returned by map_file.
+ * @length           : size of the mapping.
+ *
+ * Releases a mapping created by map_file.
+ */
+void unmap_file(void *buf, ssize_t length);
+
 /**
  * write_file:
  * @path             : path to file.
@@ -63,6 +87,20 @@ int read_file(const char *path, void **buf, ssize_t *length);
  */
 bool write_file(const char *path, const void *buf, ssize_t size);
 
+/**
+ * write_file_atomic:
+ * @path             : path to file.
+ * @data             : contents to write to the file.
+ * @size             : size of the contents.
+ *
+ * Writes data to a temporary file next to @path, flushes it to
+ * disk and renames it over @path, so that @path holds either its
+ * old or its new contents if the write is interrupted.
+ *
+ * Returns: true (1) on success, false (0) otherwise.
+ */
+bool write_file_atomic(const char *path, const void *buf, ssize_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,384 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <compat/posix_string.h>
+
+#include "frame_stats.h"
+#include "performance.h"
+#include "general.h"
+
+/* Histogram buckets hold values with 5 significant bits,
+ * so percentiles are within about 3% of the recorded values. */
+#define FRAME_STATS_SUB_BITS 5
+#define FRAME_STATS_SUB      (1 << FRAME_STATS_SUB_BITS)
+#define FRAME_STATS_BUCKETS  (FRAME_STATS_SUB * (32 - FRAME_STATS_SUB_BITS + 1))
+
+/* Most recent frames kept for dumps, a bit over a minute at 60 Hz. */
+#define FRAME_STATS_RING_SIZE 4096
+
+enum frame_stats_hist
+{
+   FRAME_STATS_HIST_FRAME_TIME = 0,
+   FRAME_STATS_HIST_RUN,
+   FRAME_STATS_HIST_SWAP,
+   FRAME_STATS_HIST_LATENCY,
+   FRAME_STATS_HIST_RUN_AHEAD,
+   FRAME_STATS_HIST_INPUT_TO_POLL,
+   FRAME_STATS_HIST_LAST
+};
+
+typedef struct frame_stats_histogram
+{
+   uint64_t count;
+   uint32_t max;
+   uint32_t buckets[FRAME_STATS_BUCKETS];
+} frame_stats_hist_t;
+
+typedef struct frame_stats_sample
+{
+   retro_time_t start;
+   /* Time since the previous frame started, 0 after a break. */
+   uint32_t frame_time;
+   uint32_t end;
+   /* Offsets from start, valid if the bit of the mark is set. */
+   uint32_t marks[FRAME_STATS_MARK_LAST];
+   unsigned reached;
+} frame_stats_sample_t;
+
+static struct
+{
+   frame_stats_hist_t hists[FRAME_STATS_HIST_LAST];
+   frame_stats_sample_t ring[FRAME_STATS_RING_SIZE];
+   /* Frames recorded since the last reset. */
+   uint64_t frames;
+   uint64_t missed_vsyncs;
+   double frame_time_sum;
+   double frame_time_sum_sq;
+   retro_time_t interval;
+   retro_time_t last_start;
+   bool in_frame;
+
+   /* The frame just ended, see frame_stats_last_frame. */
+   retro_time_t last_busy;
+   bool last_missed_vsync;
+   bool last_valid;
+} frame_stats;
+
+static const char *frame_stats_hist_names[FRAME_STATS_HIST_LAST] = {
+   "frame_time_us",
+   "run_us",
+   "swap_us",
+   "latency_us",
+   "run_ahead_us",
+   "input_to_poll_us",
+};
+
+static unsigned frame_stats_bucket(uint32_t value)
+{
+   unsigned shift = 0;
+
+   while ((value >> shift) >= 2 * FRAME_STATS_SUB)
+      shift++;
+
+   return FRAME_STATS_SUB * (shift + 1) + (value >> shift) - FRAME_STATS_SUB;
+}
+
+/* Highest value counted in bucket @idx. */
+static uint32_t frame_stats_bucket_value(unsigned idx)
+{
+   unsigned shift = (idx < 2 * FRAME_STATS_SUB)
+      ? 0 : idx / FRAME_STATS_SUB - 1;
+   uint64_t value = idx - FRAME_STATS_SUB * shift;
+
+   return (uint32_t)(((value + 1) << shift) - 1);
+}
+
+static void frame_stats_hist_add(enum frame_stats_hist hist, uint32_t value)
+{
+   frame_stats_hist_t *h = &frame_stats.hists[hist];
+
+   h->buckets[frame_stats_bucket(value)]++;
+   h->count++;
+   if (value > h->max)
+      h->max = value;
+}
+
+static uint32_t frame_stats_hist_percentile(enum frame_stats_hist hist,
+      double percentile)
+{
+   unsigned i;
+   uint64_t seen                 = 0;
+   const frame_stats_hist_t *h   = &frame_stats.hists[hist];
+   uint64_t target               = (uint64_t)
+      ceil(h->count * percentile / 100.0);
+
+   if (!h->count)
+      return 0;
+
+   if (!target)
+      target = 1;
+
+   for (i = 0; i < FRAME_STATS_BUCKETS; i++)
+   {
+      seen += h->buckets[i];
+      if (seen >= target)
+      {
+         uint32_t value = frame_stats_bucket_value(i);
+         return (value < h->max) ? value : h->max;
+      }
+   }
+
+   return h->max;
+}
+
+void frame_stats_frame_begin(retro_time_t interval)
+{
+   frame_stats_sample_t *sample = &frame_stats.ring[
+      frame_stats.frames % FRAME_STATS_RING_SIZE];
+   retro_time_t now             = rarch_get_time_usec();
+
+   memset(sample, 0, sizeof(*sample));
+   sample->start = now;
+
+   if (frame_stats.last_start)
+      sample->frame_time = (uint32_t)(now - frame_stats.last_start);
+
+   frame_stats.interval   = interval;
+   frame_stats.last_start = now;
+   frame_stats.in_frame   = true;
+   frame_stats.last_valid = false;
+}
+
+void frame_stats_mark(enum frame_stats_mark mark)
+{
+   frame_stats_sample_t *sample = NULL;
+
+   if (!frame_stats.in_frame)
+      return;
+
+   sample = &frame_stats.ring[frame_stats.frames % FRAME_STATS_RING_SIZE];
+
+   if (sample->reached & (1 << mark))
+      return;
+
+   sample->marks[mark] = (uint32_t)(rarch_get_time_usec() - sample->start);
+   sample->reached    |= 1 << mark;
+}
+
+void frame_stats_frame_end(void)
+{
+   uint32_t presented;
+   frame_stats_sample_t *sample = NULL;
+
+   if (!frame_stats.in_frame)
+      return;
+
+   sample      = &frame_stats.ring[frame_stats.frames % FRAME_STATS_RING_SIZE];
+   sample->end = (uint32_t)(rarch_get_time_usec() - sample->start);
+
+   frame_stats.last_busy         = sample->end;
+   frame_stats.last_missed_vsync = false;
+   frame_stats.last_valid        = true;
+
+   frame_stats_hist_add(FRAME_STATS_HIST_RUN, sample->end);
+
+   if (sample->frame_time)
+   {
+      double frame_time = sample->frame_time;
+
+      frame_stats_hist_add(FRAME_STATS_HIST_FRAME_TIME, sample->frame_time);
+      frame_stats.frame_time_sum    += frame_time;
+      frame_stats.frame_time_sum_sq += frame_time * frame_time;
+
+      /* A frame taking 1.5 intervals or more missed a vsync. */
+      if (frame_stats.interval
+            && 2 * (retro_time_t)sample->frame_time >= 3 * frame_stats.interval)
+      {
+         frame_stats.missed_vsyncs += (sample->frame_time
+               + frame_stats.interval / 2) / frame_stats.interval - 1;
+         frame_stats.last_missed_vsync = true;
+      }
+   }
+
+   if ((sample->reached & (1 << FRAME_STATS_SWAP_BEGIN))
+         && (sample->reached & (1 << FRAME_STATS_SWAP_END)))
+   {
+      uint32_t swap = sample->marks[FRAME_STATS_SWAP_END]
+         - sample->marks[FRAME_STATS_SWAP_BEGIN];
+
+      frame_stats_hist_add(FRAME_STATS_HIST_SWAP, swap);
+
+      /* Waiting for vsync is idle time, not work. */
+      frame_stats.last_busy -= swap;
+   }
+
+   /* Without a swap, the frame is shown once the driver returns. */
+   presented = (sample->reached & (1 << FRAME_STATS_SWAP_END))
+      ? sample->marks[FRAME_STATS_SWAP_END] : sample->end;
+
+   /* Cores polling input after drawing add no latency sample. */
+   if ((sample->reached & (1 << FRAME_STATS_INPUT_POLL))
+         && presented >= sample->marks[FRAME_STATS_INPUT_POLL])
+      frame_stats_hist_add(FRAME_STATS_HIST_LATENCY,
+            presented - sample->marks[FRAME_STATS_INPUT_POLL]);
+
+   /* Extra cost of running ahead, including restoring the state. */
+   if (sample->reached & (1 << FRAME_STATS_RUN_AHEAD))
+      frame_stats_hist_add(FRAME_STATS_HIST_RUN_AHEAD,
+            sample->end - sample->marks[FRAME_STATS_RUN_AHEAD]);
+
+   frame_stats.frames++;
+   frame_stats.in_frame = false;
+}
+
+void frame_stats_break(void)
+{
+   frame_stats.last_start = 0;
+   frame_stats.in_frame   = false;
+   frame_stats.last_valid = false;
+}
+
+bool frame_stats_last_frame(retro_time_t *busy, bool *missed_vsync)
+{
+   if (!frame_stats.last_valid)
+      return false;
+
+   *busy         = frame_stats.last_busy;
+   *missed_vsync = frame_stats.last_missed_vsync;
+   return true;
+}
+
+void frame_stats_input_latency(retro_time_t latency)
+{
+   if (latency < 0)
+      return;
+
+   frame_stats_hist_add(FRAME_STATS_HIST_INPUT_TO_POLL,
+         (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency);
+}
+
+void frame_stats_reset(void)
+{
+   memset(&frame_stats, 0, sizeof(frame_stats));
+}
+
+size_t frame_stats_get_summary(char *s, size_t len)
+{
+   unsigned i;
+   size_t pos            = 0;
+   uint64_t timed        = frame_stats.hists[FRAME_STATS_HIST_FRAME_TIME].count;
+   double jitter         = 0.0;
+
+   if (timed)
+   {
+      double mean     = frame_stats.frame_time_sum / timed;
+      double variance = frame_stats.frame_time_sum_sq / timed - mean * mean;
+
+      jitter = (variance > 0.0) ? sqrt(variance) : 0.0;
+   }
+
+   if (!len)
+      return 0;
+   s[0] = '\0';
+
+   pos += snprintf(s + pos, len - pos,
+         "frames: %llu\nmissed_vsyncs: %llu\njitter_us: %.1f\n",
+         (unsigned long long)frame_stats.frames,
+         (unsigned long long)frame_stats.missed_vsyncs, jitter);
+
+   for (i = 0; i < FRAME_STATS_HIST_LAST && pos < len; i++)
+      pos += snprintf(s + pos, len - pos,
+            "%s: p50 %u p99 %u p99.9 %u max %u\n",
+            frame_stats_hist_names[i],
+            frame_stats_hist_percentile((enum frame_stats_hist)i, 50.0),
+            frame_stats_hist_percentile((enum frame_stats_hist)i, 99.0),
+            frame_stats_hist_percentile((enum frame_stats_hist)i, 99.9),
+            frame_stats.hists[i].max);
+
+   return (pos < len) ? pos : len - 1;
+}
+
+bool frame_stats_dump(const char *path)
+{
+   unsigned i, j;
+   uint64_t first;
+   char summary[1024];
+   FILE *file = fopen(path, "w");
+
+   if (!file)
+      return false;
+
+   frame_stats_get_summary(summary, sizeof(summary));
+   fputs(summary, file);
+
+   for (i = 0; i < FRAME_STATS_HIST_LAST; i++)
+   {
+      fprintf(file, "\n# %s histogram: upper bound, count\n",
+            frame_stats_hist_names[i]);
+
+      for (j = 0; j < FRAME_STATS_BUCKETS; j++)
+         if (frame_stats.hists[i].buckets[j])
+            fprintf(file, "%u,%u\n", frame_stats_bucket_value(j),
+                  frame_stats.hists[i].buckets[j]);
+   }
+
+   fputs("\n# frames: frame, frame_time, input_poll, video_frame, "
+         "swap_begin, swap_end, run_ahead, end (us, -1 if not reached)\n", file);
+
+   first = (frame_stats.frames > FRAME_STATS_RING_SIZE)
+      ? frame_stats.frames - FRAME_STATS_RING_SIZE : 0;
+
+   for (; first < frame_stats.frames; first++)
+   {
+      const frame_stats_sample_t *sample =
+         &frame_stats.ring[first % FRAME_STATS_RING_SIZE];
+
+      fprintf(file, "%llu,%u", (unsigned long long)first,
+            sample->frame_time);
+
+      for (j = 0; j < FRAME_STATS_MARK_LAST; j++)
+      {
+         if (sample->reached & (1 << j))
+            fprintf(file, ",%u", sample->marks[j]);
+         else
+            fputs(",-1", file);
+      }
+
+      fprintf(file, ",%u\n", sample->end);
+   }
+
+   return fclose(file) == 0;
+}
+
+void frame_stats_log(void)
+{
+   char summary[1024];
+   char *save      = NULL;
+   const char *tok = NULL;
+
+   if (!frame_stats.frames)
+      return;
+
+   frame_stats_get_summary(summary, sizeof(summary));
+
+   for (tok = strtok_r(summary, "\n", &save); tok;
+         tok = strtok_r(NULL, "\n", &save))
+      RARCH_LOG("[PERF]: %s\n", tok);
+}
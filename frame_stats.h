@@ -0,0 +1,132 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RARCH_FRAME_STATS_H
+#define _RARCH_FRAME_STATS_H
+
+#include <stddef.h>
+#include <boolean.h>
+
+#include "libretro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Points in a frame timed relative to its start. */
+enum frame_stats_mark
+{
+   FRAME_STATS_INPUT_POLL = 0,
+   FRAME_STATS_VIDEO_FRAME,
+   FRAME_STATS_SWAP_BEGIN,
+   FRAME_STATS_SWAP_END,
+   /* Frames run ahead start, see runahead_run. */
+   FRAME_STATS_RUN_AHEAD,
+   FRAME_STATS_MARK_LAST
+};
+
+/**
+ * frame_stats_frame_begin:
+ * @interval            : Vsync interval in microseconds, 0 if
+ *                        frames are not paced by vsync.
+ *
+ * Starts timing a frame, right before retro_run.
+ **/
+void frame_stats_frame_begin(retro_time_t interval);
+
+/**
+ * frame_stats_mark:
+ * @mark                : Point reached.
+ *
+ * Records the time @mark is first reached in the current frame.
+ * Does nothing outside of a frame.
+ **/
+void frame_stats_mark(enum frame_stats_mark mark);
+
+/**
+ * frame_stats_frame_end:
+ *
+ * Finishes timing the current frame, right after retro_run.
+ **/
+void frame_stats_frame_end(void);
+
+/**
+ * frame_stats_break:
+ *
+ * Tells that frames stopped running back to back, e.g. because
+ * of the menu or pausing, so the time until the next frame
+ * does not count as a frame time.
+ **/
+void frame_stats_break(void);
+
+/**
+ * frame_stats_last_frame:
+ * @busy                : Time in microseconds the frame took,
+ *                        not counting the wait for vsync.
+ * @missed_vsync        : Whether the frame missed a vsync.
+ *
+ * Gets the timing of the frame ended last, e.g. to adapt
+ * the frame delay to it.
+ *
+ * Returns: true if a frame ended since the last call to
+ * frame_stats_frame_begin or frame_stats_break.
+ **/
+bool frame_stats_last_frame(retro_time_t *busy, bool *missed_vsync);
+
+/**
+ * frame_stats_input_latency:
+ * @latency             : Time in microseconds from an input event
+ *                        to the poll handing it over to the core.
+ *
+ * Records the age of an input event. Called by input drivers
+ * which know when their events happened.
+ **/
+void frame_stats_input_latency(retro_time_t latency);
+
+void frame_stats_reset(void);
+
+/**
+ * frame_stats_get_summary:
+ * @s                   : Output buffer.
+ * @len                 : Size of @s.
+ *
+ * Writes percentiles of the frame times, retro_run durations,
+ * swap durations, input poll to swap latencies, time spent
+ * running ahead and input event to poll latencies recorded
+ * since the last reset, one line per statistic.
+ *
+ * Returns: length of the summary.
+ **/
+size_t frame_stats_get_summary(char *s, size_t len);
+
+/**
+ * frame_stats_dump:
+ * @path                : File to write.
+ *
+ * Writes the summary, the histograms and the most recent
+ * frames to @path.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool frame_stats_dump(const char *path);
+
+void frame_stats_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,6 +23,7 @@
 #include "../retroarch.h"
 #include "../runloop.h"
 #include "../runloop_data.h"
+#include "../replay_hash.h"
 
 #include "frontend.h"
 
@@ -351,6 +352,9 @@ int rarch_main(int argc, char *argv[], void *data)
    }while(ret != -1);
 
    main_exit(args);
+
+   if (replay_hash_diverged())
+      return 1;
 #endif
 
    return 0;
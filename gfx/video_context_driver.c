@@ -15,6 +15,7 @@
  */
 
 #include "../general.h"
+#include "../frame_stats.h"
 #include "video_context_driver.h"
 #include <string.h>
 
@@ -138,9 +139,20 @@ void gfx_ctx_get_video_output_next(void *data)
 void gfx_ctx_swap_buffers(void *data)
 {
    const gfx_ctx_driver_t *ctx = gfx_ctx_get_ptr();
-   
-   if (ctx->swap_buffers)
-      ctx->swap_buffers(data);
+   settings_t *settings        = config_get_ptr();
+   /* Threaded video swaps outside of the frame being timed. */
+   bool timed                  = !settings->video.threaded;
+
+   if (!ctx->swap_buffers)
+      return;
+
+   if (timed)
+      frame_stats_mark(FRAME_STATS_SWAP_BEGIN);
+
+   ctx->swap_buffers(data);
+
+   if (timed)
+      frame_stats_mark(FRAME_STATS_SWAP_END);
 }
 
 void gfx_ctx_bind_hw_render(void *data, bool enable)
@@ -55,6 +55,8 @@ PERFORMANCE
 #endif
 
 #include "../performance.c"
+#include "../frame_stats.c"
+#include "../runahead.c"
 
 /*============================================================
 COMPATIBILITY
@@ -357,6 +359,7 @@ INPUT
 #endif
 
 #ifdef HAVE_UDEV
+#include "../input/input_evdev.c"
 #include "../input/drivers/udev_input.c"
 #include "../input/drivers_joypad/udev_joypad.c"
 #endif
@@ -587,7 +590,10 @@ FILE
 #include "../libretro-common/string/string_list.c"
 #include "../libretro-common/string/stdstring.c"
 #include "../file_ops.c"
+#include "../libretro-common/file/nbio/nbio_intf.c"
 #include "../libretro-common/file/nbio/nbio_stdio.c"
+#include "../libretro-common/file/nbio/nbio_thread.c"
+#include "../libretro-common/file/nbio/nbio_io_uring.c"
 #include "../libretro-common/file/file_list.c"
 
 /*============================================================
@@ -701,6 +707,7 @@ RETROARCH
 RECORDING
 ============================================================ */
 #include "../movie.c"
+#include "../replay_hash.c"
 #include "../record/record_driver.c"
 #include "../record/drivers/record_null.c"
 
@@ -892,12 +899,12 @@ XML
  LIBRETRODB
 ============================================================ */
 #ifdef HAVE_LIBRETRODB
-#include "../libretro-db/bintree.c"
 #include "../libretro-db/libretrodb.c"
 #include "../libretro-db/rmsgpack.c"
 #include "../libretro-db/rmsgpack_dom.c"
 #include "../libretro-db/query.c"
 #include "../database_info.c"
+#include "../database_catalog.c"
 #endif
 
 
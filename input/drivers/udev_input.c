@@ -35,7 +35,9 @@
 
 #include "../input_joypad.h"
 #include "../input_keymaps.h"
+#include "../input_evdev.h"
 #include "../../general.h"
+#include "../../performance.h"
 
 #ifdef HAVE_CONFIG_H
 #include "../../config.h"
@@ -48,6 +50,9 @@
 
 #define MOD_MAP_SIZE 5
 
+/* Key events read on the input thread between two polls. */
+#define UDEV_MAX_KEY_EVENTS 64
+
 #endif
 
 typedef struct udev_input udev_input_t;
@@ -80,6 +85,16 @@ struct input_device
    } state;
 };
 
+/* State built from the events read, see udev_input_poll. */
+struct udev_input_state
+{
+   uint8_t key_state[(KEY_MAX + 7) / 8];
+
+   int16_t mouse_x;
+   int16_t mouse_y;
+   bool mouse_l, mouse_r, mouse_m, mouse_wu, mouse_wd, mouse_whu, mouse_whd;
+};
+
 struct udev_input
 {
    bool blocked;
@@ -92,18 +107,22 @@ struct udev_input
    struct xkb_state *xkb_state;
    xkb_mod_index_t *mod_map_idx;
    uint16_t        *mod_map_bit;
+
+   struct input_event key_events[UDEV_MAX_KEY_EVENTS];
+   unsigned num_key_events;
 #endif
 
    const input_device_driver_t *joypad;
-   uint8_t key_state[(KEY_MAX + 7) / 8];
+
+   /* Read by the core until the next poll. */
+   struct udev_input_state state;
+   /* Updated as events are read, on the input thread if any. */
+   struct udev_input_state live;
 
    int epfd;
+   input_evdev_thread_t *thread;
    struct input_device **devices;
    unsigned num_devices;
-
-   int16_t mouse_x;
-   int16_t mouse_y;
-   bool mouse_l, mouse_r, mouse_m, mouse_wu, mouse_wd, mouse_whu, mouse_whd;
 };
 
 #ifdef HAVE_XKBCOMMON
@@ -121,12 +140,19 @@ static void udev_handle_keyboard(udev_input_t *udev,
    {
       case EV_KEY:
          if (event->value)
-            BIT_SET(udev->key_state, event->code);
+            BIT_SET(udev->live.key_state, event->code);
          else
-            BIT_CLEAR(udev->key_state, event->code);
+            BIT_CLEAR(udev->live.key_state, event->code);
 
 #ifdef HAVE_XKBCOMMON
-         handle_xkb(udev->xkb_state, udev->mod_map_idx, udev->mod_map_bit, event->code, event->value);
+         /* Keyboard callbacks have to run on the main thread. */
+         if (udev->thread)
+         {
+            if (udev->num_key_events < UDEV_MAX_KEY_EVENTS)
+               udev->key_events[udev->num_key_events++] = *event;
+         }
+         else
+            handle_xkb(udev->xkb_state, udev->mod_map_idx, udev->mod_map_bit, event->code, event->value);
 #endif
          break;
 
@@ -152,7 +178,7 @@ static void udev_handle_touchpad(udev_input_t *udev,
                float rel_x  = x_norm - dev->state.touchpad.x;
 
                if (dev->state.touchpad.touch)
-                  udev->mouse_x += (int16_t)
+                  udev->live.mouse_x += (int16_t)
                      roundf(dev->state.touchpad.mod_x * rel_x);
 
                dev->state.touchpad.x = x_norm;
@@ -170,7 +196,7 @@ static void udev_handle_touchpad(udev_input_t *udev,
                float rel_y  = y_norm - dev->state.touchpad.y;
 
                if (dev->state.touchpad.touch)
-                  udev->mouse_y += (int16_t)roundf(dev->state.touchpad.mod_y * rel_y);
+                  udev->live.mouse_y += (int16_t)roundf(dev->state.touchpad.mod_y * rel_y);
 
                dev->state.touchpad.y = y_norm;
 
@@ -209,15 +235,15 @@ static void udev_handle_mouse(udev_input_t *udev,
          switch (event->code)
          {
             case BTN_LEFT:
-               udev->mouse_l = event->value;
+               udev->live.mouse_l = event->value;
                break;
 
             case BTN_RIGHT:
-               udev->mouse_r = event->value;
+               udev->live.mouse_r = event->value;
                break;
 
             case BTN_MIDDLE:
-               udev->mouse_m = event->value;
+               udev->live.mouse_m = event->value;
                break;
             default:
                break;
@@ -228,23 +254,23 @@ static void udev_handle_mouse(udev_input_t *udev,
          switch (event->code)
          {
             case REL_X:
-               udev->mouse_x += event->value;
+               udev->live.mouse_x += event->value;
                break;
 
             case REL_Y:
-               udev->mouse_y += event->value;
+               udev->live.mouse_y += event->value;
                break;
             case REL_WHEEL:
                if (event->value == 1)
-                  udev->mouse_wu = 1;
+                  udev->live.mouse_wu = 1;
                else if (event->value == -1)
-                  udev->mouse_wd = 1;
+                  udev->live.mouse_wd = 1;
                break;
             case REL_HWHEEL:
                if (event->value == 1)
-                  udev->mouse_whu = 1;
+                  udev->live.mouse_whu = 1;
                else if (event->value == -1)
-                  udev->mouse_whd = 1;
+                  udev->live.mouse_whd = 1;
                break;
                break;
             default:
@@ -274,6 +300,7 @@ static bool add_device(udev_input_t *udev,
       const char *devnode, device_handle_cb cb)
 {
    int fd;
+   bool added                  = false;
    struct input_device **tmp;
    struct input_device *device = NULL;
    struct stat st              = {0};
@@ -302,22 +329,42 @@ static bool add_device(udev_input_t *udev,
           ioctl(fd, EVIOCGABS(ABS_Y), &device->state.touchpad.info_y) < 0))
       goto error;
 
+   input_evdev_open(fd);
+
+   if (udev->thread)
+      input_evdev_thread_lock(udev->thread);
+
    tmp = (struct input_device**)realloc(udev->devices,
          (udev->num_devices + 1) * sizeof(*udev->devices));
 
-   if (!tmp)
-      goto error;
+   if (tmp)
+   {
+      tmp[udev->num_devices++] = device;
+      udev->devices            = tmp;
+      added                    = true;
 
-   tmp[udev->num_devices++] = device;
-   udev->devices            = tmp;
+      if (udev->thread)
+      {
+         if (!input_evdev_thread_add(udev->thread, fd))
+            RARCH_ERR("Failed to add FD (%d) to input thread.\n", fd);
+      }
+      else
+      {
+         event.events          = EPOLLIN;
+         event.data.ptr        = device;
 
-   event.events             = EPOLLIN;
-   event.data.ptr           = device;
+         /* Shouldn't happen, but just check it. */
+         if (epoll_ctl(udev->epfd, EPOLL_CTL_ADD, fd, &event) < 0)
+            RARCH_ERR("Failed to add FD (%d) to epoll list (%s).\n",
+                  fd, strerror(errno));
+      }
+   }
 
-   /* Shouldn't happen, but just check it. */
-   if (epoll_ctl(udev->epfd, EPOLL_CTL_ADD, fd, &event) < 0)
-      RARCH_ERR("Failed to add FD (%d) to epoll list (%s).\n",
-            fd, strerror(errno));
+   if (udev->thread)
+      input_evdev_thread_unlock(udev->thread);
+
+   if (!added)
+      goto error;
 
    return true;
 
@@ -333,17 +380,26 @@ static void udev_input_remove_device(udev_input_t *udev, const char *devnode)
 {
    unsigned i;
 
+   if (udev->thread)
+      input_evdev_thread_lock(udev->thread);
+
    for (i = 0; i < udev->num_devices; i++)
    {
       if (strcmp(devnode, udev->devices[i]->devnode) != 0)
          continue;
 
+      if (udev->thread)
+         input_evdev_thread_remove(udev->thread, udev->devices[i]->fd);
+
       close(udev->devices[i]->fd);
       free(udev->devices[i]);
       memmove(udev->devices + i, udev->devices + i + 1,
             (udev->num_devices - (i + 1)) * sizeof(*udev->devices));
       udev->num_devices--;
    }
+
+   if (udev->thread)
+      input_evdev_thread_unlock(udev->thread);
 }
 
 static void udev_input_handle_hotplug(udev_input_t *udev)
@@ -405,18 +461,69 @@ end:
    udev_device_unref(dev);
 }
 
-static void udev_input_poll(void *data)
+/* Input thread event handler, see input_evdev_thread_new. */
+static void udev_input_thread_event(void *data, int fd,
+      const struct input_event *event)
 {
-   int i, ret;
-   struct epoll_event events[32];
+   unsigned i;
    udev_input_t *udev = (udev_input_t*)data;
 
-   udev->mouse_x   = udev->mouse_y   = 0;
-   udev->mouse_wu  = udev->mouse_wd  = 0;
-   udev->mouse_whu = udev->mouse_whd = 0;
+   for (i = 0; i < udev->num_devices; i++)
+   {
+      if (udev->devices[i]->fd != fd)
+         continue;
+
+      udev->devices[i]->handle_cb(udev, event, udev->devices[i]);
+      break;
+   }
+}
+
+/* Hands the state built so far over to the core.
+ * Mouse motion and wheels are counted from the last poll. */
+static void udev_input_publish(udev_input_t *udev)
+{
+   udev->state          = udev->live;
+
+   udev->live.mouse_x   = udev->live.mouse_y   = 0;
+   udev->live.mouse_wu  = udev->live.mouse_wd  = 0;
+   udev->live.mouse_whu = udev->live.mouse_whd = 0;
+}
+
+static void udev_input_poll_thread(udev_input_t *udev)
+{
+#ifdef HAVE_XKBCOMMON
+   unsigned i;
+   unsigned num_key_events;
+   struct input_event key_events[UDEV_MAX_KEY_EVENTS];
+#endif
+
+   input_evdev_thread_lock(udev->thread);
+
+   input_evdev_thread_latency(udev->thread, rarch_get_time_usec());
+   udev_input_publish(udev);
+
+#ifdef HAVE_XKBCOMMON
+   num_key_events       = udev->num_key_events;
+   memcpy(key_events, udev->key_events,
+         num_key_events * sizeof(*key_events));
+   udev->num_key_events = 0;
+#endif
+
+   input_evdev_thread_unlock(udev->thread);
+
+#ifdef HAVE_XKBCOMMON
+   for (i = 0; i < num_key_events; i++)
+      handle_xkb(udev->xkb_state, udev->mod_map_idx, udev->mod_map_bit,
+            key_events[i].code, key_events[i].value);
+#endif
+}
+
+static void udev_input_poll_events(udev_input_t *udev)
+{
+   int i, ret;
+   struct epoll_event events[32];
+   retro_time_t now = rarch_get_time_usec();
 
-   while (udev_input_hotplug_available(udev))
-      udev_input_handle_hotplug(udev);
 
    ret = epoll_wait(udev->epfd, events, ARRAY_SIZE(events), 0);
 
@@ -432,11 +539,29 @@ static void udev_input_poll(void *data)
          {
             len /= sizeof(*input_events);
             for (j = 0; j < len; j++)
+            {
                device->handle_cb(udev, &input_events[j], device);
+               input_evdev_latency(&input_events[j], now);
+            }
          }
       }
    }
 
+   udev_input_publish(udev);
+}
+
+static void udev_input_poll(void *data)
+{
+   udev_input_t *udev = (udev_input_t*)data;
+
+   while (udev_input_hotplug_available(udev))
+      udev_input_handle_hotplug(udev);
+
+   if (udev->thread)
+      udev_input_poll_thread(udev);
+   else
+      udev_input_poll_events(udev);
+
    if (udev->joypad)
       udev->joypad->poll();
 }
@@ -446,23 +571,23 @@ static int16_t udev_mouse_state(udev_input_t *udev, unsigned id)
    switch (id)
    {
       case RETRO_DEVICE_ID_MOUSE_X:
-         return udev->mouse_x;
+         return udev->state.mouse_x;
       case RETRO_DEVICE_ID_MOUSE_Y:
-         return udev->mouse_y;
+         return udev->state.mouse_y;
       case RETRO_DEVICE_ID_MOUSE_LEFT:
-         return udev->mouse_l;
+         return udev->state.mouse_l;
       case RETRO_DEVICE_ID_MOUSE_RIGHT:
-         return udev->mouse_r;
+         return udev->state.mouse_r;
       case RETRO_DEVICE_ID_MOUSE_MIDDLE:
-         return udev->mouse_m;
+         return udev->state.mouse_m;
       case RETRO_DEVICE_ID_MOUSE_WHEELUP:
-         return udev->mouse_wu;
+         return udev->state.mouse_wu;
       case RETRO_DEVICE_ID_MOUSE_WHEELDOWN:
-         return udev->mouse_wd;
+         return udev->state.mouse_wd;
       case RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELUP:
-         return udev->mouse_whu;
+         return udev->state.mouse_whu;
       case RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELDOWN:
-         return udev->mouse_whd;
+         return udev->state.mouse_whd;
    }
 
    return 0;
@@ -473,19 +598,19 @@ static int16_t udev_lightgun_state(udev_input_t *udev, unsigned id)
    switch (id)
    {
       case RETRO_DEVICE_ID_LIGHTGUN_X:
-         return udev->mouse_x;
+         return udev->state.mouse_x;
       case RETRO_DEVICE_ID_LIGHTGUN_Y:
-         return udev->mouse_y;
+         return udev->state.mouse_y;
       case RETRO_DEVICE_ID_LIGHTGUN_TRIGGER:
-         return udev->mouse_l;
+         return udev->state.mouse_l;
       case RETRO_DEVICE_ID_LIGHTGUN_CURSOR:
-         return udev->mouse_m;
+         return udev->state.mouse_m;
       case RETRO_DEVICE_ID_LIGHTGUN_TURBO:
-         return udev->mouse_r;
+         return udev->state.mouse_r;
       case RETRO_DEVICE_ID_LIGHTGUN_START:
-         return udev->mouse_m && udev->mouse_r; 
+         return udev->state.mouse_m && udev->state.mouse_r; 
       case RETRO_DEVICE_ID_LIGHTGUN_PAUSE:
-         return udev->mouse_m && udev->mouse_l; 
+         return udev->state.mouse_m && udev->state.mouse_l; 
    }
 
    return 0;
@@ -497,7 +622,7 @@ static bool udev_input_is_pressed(udev_input_t *udev, const struct retro_keybind
    {
       const struct retro_keybind *bind = &binds[id];
       unsigned bit = input_keymaps_translate_rk_to_keysym(binds[id].key);
-      return bind->valid && BIT_GET(udev->key_state, bit);
+      return bind->valid && BIT_GET(udev->state.key_state, bit);
    }
    return false;
 }
@@ -540,7 +665,7 @@ static int16_t udev_input_state(void *data, const struct retro_keybind **binds,
       case RETRO_DEVICE_KEYBOARD:
          {
             unsigned bit = input_keymaps_translate_rk_to_keysym((enum retro_key)id);
-            return id < RETROK_LAST && BIT_GET(udev->key_state, bit);
+            return id < RETROK_LAST && BIT_GET(udev->state.key_state, bit);
          }
       case RETRO_DEVICE_MOUSE:
          return udev_mouse_state(udev, id);
@@ -574,6 +699,9 @@ static void udev_input_free(void *data)
    if (!data || !udev)
       return;
 
+   /* Stop reading before the devices are closed. */
+   input_evdev_thread_free(udev->thread);
+
    if (udev->joypad)
       udev->joypad->destroy();
 
@@ -796,6 +924,16 @@ static void *udev_input_init(void)
       goto error;
    }
 
+   if (settings->input.threaded)
+   {
+      udev->thread = input_evdev_thread_new(udev_input_thread_event, udev);
+
+      if (udev->thread)
+         RARCH_LOG("[udev]: Reading keyboards, mice and touchpads on a separate thread.\n");
+      else
+         RARCH_WARN("[udev]: Failed to start input thread, reading input once per frame.\n");
+   }
+
    if (!open_devices(udev, "ID_INPUT_KEYBOARD", udev_handle_keyboard))
    {
       RARCH_ERR("Failed to open keyboard.\n");
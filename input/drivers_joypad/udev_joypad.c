@@ -14,7 +14,9 @@
  */
 
 #include "../input_autodetect.h"
+#include "../input_evdev.h"
 #include "../../general.h"
+#include "../../performance.h"
 #include <unistd.h>
 #include <stdint.h>
 #include <string.h>
@@ -47,15 +49,22 @@
    (((1UL << ((nr) % (sizeof(long) * CHAR_BIT))) & ((addr)[(nr) / (sizeof(long) * CHAR_BIT)])) != 0)
 #define NBITS(x) ((((x) - 1) / (sizeof(long) * CHAR_BIT)) + 1)
 
+struct udev_joypad_state
+{
+   uint64_t buttons;
+   int16_t axes[NUM_AXES];
+   int8_t hats[NUM_HATS][2];
+};
+
 struct udev_joypad
 {
    int fd;
    dev_t device;
 
    /* Input state polled. */
-   uint64_t buttons;
-   int16_t axes[NUM_AXES];
-   int8_t hats[NUM_HATS][2];
+   struct udev_joypad_state state;
+   /* Updated as events are read, on the input thread if any. */
+   struct udev_joypad_state live;
 
    /* Maps keycodes -> button/axes */
    uint8_t button_bind[KEY_MAX];
@@ -77,6 +86,7 @@ struct udev_joypad
 static struct udev *g_udev;
 static struct udev_monitor *g_udev_mon;
 static struct udev_joypad udev_pads[MAX_USERS];
+static input_evdev_thread_t *udev_joypad_thread;
 
 static INLINE int16_t udev_compute_axis(const struct input_absinfo *info, int value)
 {
@@ -90,7 +100,58 @@ static INLINE int16_t udev_compute_axis(const struct input_absinfo *info, int va
    return axis;
 }
 
-static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
+static void udev_handle_pad_event(struct udev_joypad *pad,
+      const struct input_event *event)
+{
+   int code = event->code;
+
+   switch (event->type)
+   {
+      case EV_KEY:
+         if (code >= BTN_MISC || (code >= KEY_UP && code <= KEY_DOWN))
+         {
+            if (event->value)
+               BIT64_SET(pad->live.buttons, pad->button_bind[code]);
+            else
+               BIT64_CLEAR(pad->live.buttons, pad->button_bind[code]);
+         }
+         break;
+
+      case EV_ABS:
+         if (code >= ABS_MISC)
+            break;
+
+         switch (code)
+         {
+            case ABS_HAT0X:
+            case ABS_HAT0Y:
+            case ABS_HAT1X:
+            case ABS_HAT1Y:
+            case ABS_HAT2X:
+            case ABS_HAT2Y:
+            case ABS_HAT3X:
+            case ABS_HAT3Y:
+            {
+               code                                 -= ABS_HAT0X;
+               pad->live.hats[code >> 1][code & 1]  = event->value;
+               break;
+            }
+
+            default:
+            {
+               unsigned axis        = pad->axes_bind[code];
+               pad->live.axes[axis] = udev_compute_axis(&pad->absinfo[axis], event->value);
+               break;
+            }
+         }
+         break;
+
+      default:
+         break;
+   }
+}
+
+static void udev_poll_pad(struct udev_joypad *pad, unsigned p, retro_time_t now)
 {
    int i, len;
    struct input_event events[32];
@@ -103,52 +164,27 @@ static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
       len /= sizeof(*events);
       for (i = 0; i < len; i++)
       {
-         int code = events[i].code;
-         switch (events[i].type)
-         {
-            case EV_KEY:
-               if (code >= BTN_MISC || (code >= KEY_UP && code <= KEY_DOWN))
-               {
-                  if (events[i].value)
-                     BIT64_SET(pad->buttons, pad->button_bind[code]);
-                  else
-                     BIT64_CLEAR(pad->buttons, pad->button_bind[code]);
-               }
-               break;
+         udev_handle_pad_event(pad, &events[i]);
+         input_evdev_latency(&events[i], now);
+      }
+   }
 
-            case EV_ABS:
-               if (code >= ABS_MISC)
-                  break;
-
-               switch (code)
-               {
-                  case ABS_HAT0X:
-                  case ABS_HAT0Y:
-                  case ABS_HAT1X:
-                  case ABS_HAT1Y:
-                  case ABS_HAT2X:
-                  case ABS_HAT2Y:
-                  case ABS_HAT3X:
-                  case ABS_HAT3Y:
-                  {
-                     code                           -= ABS_HAT0X;
-                     pad->hats[code >> 1][code & 1]  = events[i].value;
-                     break;
-                  }
-
-                  default:
-                  {
-                     unsigned axis   = pad->axes_bind[code];
-                     pad->axes[axis] = udev_compute_axis(&pad->absinfo[axis], events[i].value);
-                     break;
-                  }
-               }
-               break;
+   pad->state = pad->live;
+}
 
-            default:
-               break;
-         }
-      }
+/* Input thread event handler, see input_evdev_thread_new. */
+static void udev_joypad_thread_event(void *data, int fd,
+      const struct input_event *event)
+{
+   unsigned i;
+
+   for (i = 0; i < MAX_USERS; i++)
+   {
+      if (udev_pads[i].fd != fd)
+         continue;
+
+      udev_handle_pad_event(&udev_pads[i], event);
+      break;
    }
 }
 
@@ -273,8 +309,9 @@ static int udev_add_pad(struct udev_device *dev, unsigned p, int fd, const char
             continue;
          if (abs->maximum > abs->minimum)
          {
-            pad->axes[axes]   = udev_compute_axis(abs, abs->value);
-            pad->axes_bind[i] = axes++;
+            pad->live.axes[axes]  = udev_compute_axis(abs, abs->value);
+            pad->state.axes[axes] = pad->live.axes[axes];
+            pad->axes_bind[i]     = axes++;
          }
       }
    }
@@ -339,8 +376,20 @@ static void udev_check_device(struct udev_device *dev, const char *path, bool ho
    if (fd < 0)
       return;
 
+   input_evdev_open(fd);
+
+   if (udev_joypad_thread)
+      input_evdev_thread_lock(udev_joypad_thread);
+
    ret = udev_add_pad(dev, pad, fd, path);
 
+   if (ret >= 0 && udev_joypad_thread
+         && !input_evdev_thread_add(udev_joypad_thread, fd))
+      RARCH_ERR("[udev]: Failed to add pad to input thread: %s.\n", path);
+
+   if (udev_joypad_thread)
+      input_evdev_thread_unlock(udev_joypad_thread);
+
    switch (ret)
    {
       case -1:
@@ -366,6 +415,9 @@ static void udev_check_device(struct udev_device *dev, const char *path, bool ho
 
 static void udev_free_pad(unsigned pad)
 {
+   if (udev_joypad_thread)
+      input_evdev_thread_remove(udev_joypad_thread, udev_pads[pad].fd);
+
    if (udev_pads[pad].fd >= 0)
       close(udev_pads[pad].fd);
 
@@ -389,7 +441,12 @@ static void udev_joypad_remove_device(const char *path)
       if (udev_pads[i].path && !strcmp(udev_pads[i].path, path))
       {
          input_config_autoconfigure_disconnect(i, udev_pads[i].ident);
+
+         if (udev_joypad_thread)
+            input_evdev_thread_lock(udev_joypad_thread);
          udev_free_pad(i);
+         if (udev_joypad_thread)
+            input_evdev_thread_unlock(udev_joypad_thread);
          break;
       }
    }
@@ -399,6 +456,10 @@ static void udev_joypad_destroy(void)
 {
    unsigned i;
 
+   /* Stop reading before the pads are closed. */
+   input_evdev_thread_free(udev_joypad_thread);
+   udev_joypad_thread = NULL;
+
    for (i = 0; i < MAX_USERS; i++)
       udev_free_pad(i);
 
@@ -513,11 +574,27 @@ static bool udev_set_rumble(unsigned i, enum retro_rumble_effect effect, uint16_
 static void udev_joypad_poll(void)
 {
    unsigned i;
+   retro_time_t now;
+
    while (udev_hotplug_available())
       udev_joypad_handle_hotplug();
 
+   now = rarch_get_time_usec();
+
+   if (udev_joypad_thread)
+   {
+      input_evdev_thread_lock(udev_joypad_thread);
+      input_evdev_thread_latency(udev_joypad_thread, now);
+
+      for (i = 0; i < MAX_USERS; i++)
+         udev_pads[i].state = udev_pads[i].live;
+
+      input_evdev_thread_unlock(udev_joypad_thread);
+      return;
+   }
+
    for (i = 0; i < MAX_USERS; i++)
-      udev_poll_pad(&udev_pads[i], i);
+      udev_poll_pad(&udev_pads[i], i, now);
 }
 
 static bool udev_joypad_init(void *data)
@@ -537,6 +614,17 @@ static bool udev_joypad_init(void *data)
    if (!g_udev)
       return false;
 
+   if (settings->input.threaded)
+   {
+      udev_joypad_thread = input_evdev_thread_new(
+            udev_joypad_thread_event, NULL);
+
+      if (udev_joypad_thread)
+         RARCH_LOG("[udev]: Reading joypads on a separate thread.\n");
+      else
+         RARCH_WARN("[udev]: Failed to start input thread, reading joypads once per frame.\n");
+   }
+
    g_udev_mon = udev_monitor_new_from_netlink(g_udev, "udev");
    if (g_udev_mon)
    {
@@ -583,13 +671,13 @@ static bool udev_joypad_hat(const struct udev_joypad *pad, uint16_t hat)
    switch (GET_HAT_DIR(hat))
    {
       case HAT_LEFT_MASK:
-         return pad->hats[h][0] < 0;
+         return pad->state.hats[h][0] < 0;
       case HAT_RIGHT_MASK:
-         return pad->hats[h][0] > 0;
+         return pad->state.hats[h][0] > 0;
       case HAT_UP_MASK:
-         return pad->hats[h][1] < 0;
+         return pad->state.hats[h][1] < 0;
       case HAT_DOWN_MASK:
-         return pad->hats[h][1] > 0;
+         return pad->state.hats[h][1] > 0;
    }
 
    return 0;
@@ -601,7 +689,7 @@ static bool udev_joypad_button(unsigned port, uint16_t joykey)
 
    if (GET_HAT_DIR(joykey))
       return udev_joypad_hat(pad, joykey);
-   return joykey < UDEV_NUM_BUTTONS && BIT64_GET(pad->buttons, joykey);
+   return joykey < UDEV_NUM_BUTTONS && BIT64_GET(pad->state.buttons, joykey);
 }
 
 static uint64_t udev_joypad_get_buttons(unsigned port)
@@ -609,7 +697,7 @@ static uint64_t udev_joypad_get_buttons(unsigned port)
    const struct udev_joypad *pad = (const struct udev_joypad*)&udev_pads[port];
    if (!pad)
       return 0;
-   return pad->buttons;
+   return pad->state.buttons;
 }
 
 static int16_t udev_joypad_axis(unsigned port, uint32_t joyaxis)
@@ -623,13 +711,13 @@ static int16_t udev_joypad_axis(unsigned port, uint32_t joyaxis)
 
    if (AXIS_NEG_GET(joyaxis) < NUM_AXES)
    {
-      val = pad->axes[AXIS_NEG_GET(joyaxis)];
+      val = pad->state.axes[AXIS_NEG_GET(joyaxis)];
       if (val > 0)
          val = 0;
    }
    else if (AXIS_POS_GET(joyaxis) < NUM_AXES)
    {
-      val = pad->axes[AXIS_POS_GET(joyaxis)];
+      val = pad->state.axes[AXIS_POS_GET(joyaxis)];
       if (val < 0)
          val = 0;
    }
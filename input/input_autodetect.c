@@ -131,6 +131,7 @@ static void input_autoconfigure_joypad_add(
    settings->input.autoconfigured[params->idx] = true;
    input_autoconfigure_joypad_conf(conf,
          settings->input.autoconf_binds[params->idx]);
+   input_driver_invalidate_binds();
 
    if (!strcmp(device_type,"remote"))
    {
@@ -283,6 +284,7 @@ static bool input_config_autoconfigure_joypad_init(autoconfig_params_t *params)
       settings->input.autoconf_binds[params->idx][i].joyaxis_label[0] = '\0';
    }
    settings->input.autoconfigured[params->idx] = false;
+   input_driver_invalidate_binds();
 
    return true;
 }
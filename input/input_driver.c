@@ -171,6 +171,14 @@ void find_input_driver(void)
    }
 }
 
+/* Keys of user 1 bound to anything, see input_driver_compile_binds. */
+static retro_input_t input_driver_bound_keys;
+static bool input_driver_binds_compiled;
+
+/* Which joypad and analog D-Pad mode the bound keys are for. */
+static unsigned input_driver_binds_joypad;
+static unsigned input_driver_binds_dpad_mode;
+
 static const input_driver_t *input_get_ptr(driver_t *driver)
 {
    if (!driver)
@@ -199,35 +207,103 @@ bool input_driver_set_rumble_state(unsigned port,
    return false;
 }
 
+/**
+ * input_driver_compile_binds:
+ *
+ * Looks up the keys of user 1 bound to a keyboard key, joypad
+ * button or axis, either directly or through autoconfiguration.
+ * Drivers never report the other keys as pressed.
+ **/
+static void input_driver_compile_binds(void)
+{
+   unsigned key;
+   settings_t                   *settings = config_get_ptr();
+   const struct retro_keybind      *binds = settings->input.binds[0];
+   const struct retro_keybind *auto_binds = NULL;
+
+   input_driver_binds_joypad    = settings->input.joypad_map[0];
+   input_driver_binds_dpad_mode = settings->input.analog_dpad_mode[0];
+   input_driver_bound_keys      = 0;
+
+   if (input_driver_binds_joypad < MAX_USERS)
+      auto_binds = settings->input.autoconf_binds[input_driver_binds_joypad];
+
+   for (key = 0; key < RARCH_BIND_LIST_END; key++)
+   {
+      bool bound = false;
+
+      if (!binds[key].valid)
+         continue;
+
+      if (binds[key].key != RETROK_UNKNOWN
+            || binds[key].joykey != NO_BTN
+            || binds[key].joyaxis != AXIS_NONE)
+         bound = true;
+      else if (auto_binds && (auto_binds[key].joykey != NO_BTN
+               || auto_binds[key].joyaxis != AXIS_NONE))
+         bound = true;
+      /* Gets an analog stick axis with input_push_analog_dpad. */
+      else if (input_driver_binds_dpad_mode != ANALOG_DPAD_NONE
+            && key >= RETRO_DEVICE_ID_JOYPAD_UP
+            && key <= RETRO_DEVICE_ID_JOYPAD_RIGHT)
+         bound = true;
+
+      if (bound)
+         input_driver_bound_keys |= UINT64_C(1) << key;
+   }
+
+   input_driver_binds_compiled = true;
+}
+
+void input_driver_invalidate_binds(void)
+{
+   input_driver_binds_compiled = false;
+}
+
 retro_input_t input_driver_keys_pressed(void)
 {
    int key;
+   retro_input_t keys;
    retro_input_t                ret = 0;
    driver_t                 *driver = driver_get_ptr();
+   settings_t             *settings = config_get_ptr();
    const input_driver_t      *input = input_get_ptr(driver);
 
-   for (key = 0; key < RARCH_BIND_LIST_END; key++)
+   if (!input_driver_binds_compiled
+         || input_driver_binds_joypad != settings->input.joypad_map[0]
+         || input_driver_binds_dpad_mode != settings->input.analog_dpad_mode[0])
+      input_driver_compile_binds();
+
+   keys = input_driver_bound_keys;
+
+   if (driver->block_hotkey)
    {
-      bool state = false;
-      if ((!driver->block_libretro_input && ((key < RARCH_FIRST_META_KEY)))
-            || !driver->block_hotkey)
-         state = input->key_pressed(driver->input_data, key);
+      keys &= (UINT64_C(1) << RARCH_FIRST_META_KEY) - 1;
+      if (driver->block_libretro_input)
+         keys = 0;
+   }
 
-      if (key >= RARCH_FIRST_META_KEY)
-         state |= input->meta_key_pressed(driver->input_data, key);
+   for (key = 0; keys; key++, keys >>= 1)
+   {
+      if ((keys & 1) && input->key_pressed(driver->input_data, key))
+         ret |= (UINT64_C(1) << key);
+   }
+
+   for (key = RARCH_FIRST_META_KEY; key < RARCH_BIND_LIST_END; key++)
+   {
+      if (input->meta_key_pressed(driver->input_data, key))
+         ret |= (UINT64_C(1) << key);
+   }
 
 #ifdef HAVE_OVERLAY
-      state |= input_overlay_key_pressed(key);
+   ret |= input_overlay_keys_pressed();
 #endif
 
 #ifdef HAVE_COMMAND
-      if (driver->command)
-         state |= rarch_cmd_get(driver->command, key);
+   if (driver->command)
+      ret |= rarch_cmd_get_keys(driver->command);
 #endif
 
-      if (state)
-         ret |= (UINT64_C(1) << key);
-   }
    return ret;
 }
 
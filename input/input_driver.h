@@ -140,8 +140,24 @@ void find_input_driver(void);
 bool input_driver_set_rumble_state(unsigned port,
       enum retro_rumble_effect effect, uint16_t strength);
 
+/**
+ * input_driver_keys_pressed:
+ *
+ * Gets the state of the keys of user 1, including hotkeys.
+ * Only keys bound to something are read from the driver.
+ *
+ * Returns: bitmask of pressed keys, indexed by bind ID.
+ **/
 retro_input_t input_driver_keys_pressed(void);
 
+/**
+ * input_driver_invalidate_binds:
+ *
+ * Tells that binds have changed, so the keys bound to something
+ * are looked up again before reading them.
+ **/
+void input_driver_invalidate_binds(void);
+
 int16_t input_driver_state(const struct retro_keybind **retro_keybinds,
       unsigned port, unsigned device, unsigned index, unsigned id);
 
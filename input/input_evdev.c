@@ -0,0 +1,298 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#endif
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "input_evdev.h"
+#include "../frame_stats.h"
+#include "../general.h"
+
+/* Reports older than this are from a device not using
+ * the monotonic clock, and say nothing about latency. */
+#define INPUT_EVDEV_MAX_LATENCY 10000000
+
+/* Reports timed per poll, the rest is not sampled. */
+#define INPUT_EVDEV_MAX_REPORTS 256
+
+#define INPUT_EVDEV_MAX_DEVICES 64
+
+static retro_time_t input_evdev_time(const struct input_event *event)
+{
+   return (retro_time_t)event->time.tv_sec * 1000000 + event->time.tv_usec;
+}
+
+void input_evdev_open(int fd)
+{
+#ifdef EVIOCSCLOCKID
+   int clock = CLOCK_MONOTONIC;
+
+   ioctl(fd, EVIOCSCLOCKID, &clock);
+#endif
+}
+
+static void input_evdev_add_latency(retro_time_t time, retro_time_t now)
+{
+   if (time <= now && now - time < INPUT_EVDEV_MAX_LATENCY)
+      frame_stats_input_latency(now - time);
+}
+
+void input_evdev_latency(const struct input_event *event, retro_time_t now)
+{
+   if (event->type == EV_SYN && event->code == SYN_REPORT)
+      input_evdev_add_latency(input_evdev_time(event), now);
+}
+
+#ifdef HAVE_THREADS
+struct input_evdev_thread
+{
+   sthread_t *thread;
+   slock_t *lock;
+   int epfd;
+   /* Written to by input_evdev_thread_free to wake the thread up. */
+   int quit_pipe[2];
+   bool quit;
+
+   input_evdev_event_t cb;
+   void *data;
+
+   /* A fd returned by epoll_wait may have been removed and
+    * reused for another file by the time it is read. */
+   int fds[INPUT_EVDEV_MAX_DEVICES];
+   unsigned num_fds;
+
+   retro_time_t reports[INPUT_EVDEV_MAX_REPORTS];
+   unsigned num_reports;
+};
+
+static void input_evdev_thread_read(input_evdev_thread_t *thread, int fd)
+{
+   int i, len;
+   unsigned j;
+   struct input_event events[32];
+
+   for (j = 0; j < thread->num_fds; j++)
+      if (thread->fds[j] == fd)
+         break;
+
+   if (j == thread->num_fds)
+      return;
+
+   while ((len = read(fd, events, sizeof(events))) > 0)
+   {
+      len /= sizeof(*events);
+
+      for (i = 0; i < len; i++)
+      {
+         if (events[i].type == EV_SYN && events[i].code == SYN_REPORT
+               && thread->num_reports < INPUT_EVDEV_MAX_REPORTS)
+            thread->reports[thread->num_reports++] =
+               input_evdev_time(&events[i]);
+
+         thread->cb(thread->data, fd, &events[i]);
+      }
+   }
+}
+
+static void input_evdev_thread_loop(void *data)
+{
+   input_evdev_thread_t *thread = (input_evdev_thread_t*)data;
+
+   for (;;)
+   {
+      int i;
+      struct epoll_event events[32];
+      int ret = epoll_wait(thread->epfd, events, ARRAY_SIZE(events), -1);
+
+      if (ret < 0 && errno != EINTR)
+         break;
+
+      slock_lock(thread->lock);
+
+      for (i = 0; i < ret && !thread->quit; i++)
+         if (events[i].events & EPOLLIN)
+            input_evdev_thread_read(thread, events[i].data.fd);
+
+      if (thread->quit)
+      {
+         slock_unlock(thread->lock);
+         break;
+      }
+
+      slock_unlock(thread->lock);
+   }
+}
+
+input_evdev_thread_t *input_evdev_thread_new(input_evdev_event_t cb,
+      void *data)
+{
+   struct epoll_event event      = {0};
+   input_evdev_thread_t *thread  = (input_evdev_thread_t*)
+      calloc(1, sizeof(*thread));
+
+   if (!thread)
+      return NULL;
+
+   thread->cb           = cb;
+   thread->data         = data;
+   thread->quit_pipe[0] = -1;
+   thread->quit_pipe[1] = -1;
+
+   thread->epfd = epoll_create(32);
+   if (thread->epfd < 0)
+      goto error;
+
+   if (pipe(thread->quit_pipe) < 0)
+      goto error;
+
+   event.events  = EPOLLIN;
+   event.data.fd = thread->quit_pipe[0];
+   if (epoll_ctl(thread->epfd, EPOLL_CTL_ADD, thread->quit_pipe[0], &event) < 0)
+      goto error;
+
+   thread->lock = slock_new();
+   if (!thread->lock)
+      goto error;
+
+   thread->thread = sthread_create(input_evdev_thread_loop, thread);
+   if (!thread->thread)
+      goto error;
+
+   return thread;
+
+error:
+   input_evdev_thread_free(thread);
+   return NULL;
+}
+
+void input_evdev_thread_free(input_evdev_thread_t *thread)
+{
+   if (!thread)
+      return;
+
+   if (thread->thread)
+   {
+      char c = 0;
+
+      slock_lock(thread->lock);
+      thread->quit = true;
+      slock_unlock(thread->lock);
+
+      if (write(thread->quit_pipe[1], &c, 1) < 1)
+         RARCH_ERR("[evdev]: Failed to stop input thread.\n");
+
+      sthread_join(thread->thread);
+   }
+
+   if (thread->lock)
+      slock_free(thread->lock);
+   if (thread->quit_pipe[0] >= 0)
+      close(thread->quit_pipe[0]);
+   if (thread->quit_pipe[1] >= 0)
+      close(thread->quit_pipe[1]);
+   if (thread->epfd >= 0)
+      close(thread->epfd);
+   free(thread);
+}
+
+bool input_evdev_thread_add(input_evdev_thread_t *thread, int fd)
+{
+   struct epoll_event event = {0};
+
+   if (thread->num_fds >= INPUT_EVDEV_MAX_DEVICES)
+      return false;
+
+   event.events  = EPOLLIN;
+   event.data.fd = fd;
+
+   if (epoll_ctl(thread->epfd, EPOLL_CTL_ADD, fd, &event) < 0)
+      return false;
+
+   thread->fds[thread->num_fds++] = fd;
+   return true;
+}
+
+void input_evdev_thread_remove(input_evdev_thread_t *thread, int fd)
+{
+   unsigned i;
+   struct epoll_event event = {0};
+
+   for (i = 0; i < thread->num_fds; i++)
+   {
+      if (thread->fds[i] != fd)
+         continue;
+
+      epoll_ctl(thread->epfd, EPOLL_CTL_DEL, fd, &event);
+      thread->fds[i] = thread->fds[--thread->num_fds];
+      return;
+   }
+}
+
+void input_evdev_thread_lock(input_evdev_thread_t *thread)
+{
+   slock_lock(thread->lock);
+}
+
+void input_evdev_thread_unlock(input_evdev_thread_t *thread)
+{
+   slock_unlock(thread->lock);
+}
+
+void input_evdev_thread_latency(input_evdev_thread_t *thread,
+      retro_time_t now)
+{
+   unsigned i;
+
+   for (i = 0; i < thread->num_reports; i++)
+      input_evdev_add_latency(thread->reports[i], now);
+
+   thread->num_reports = 0;
+}
+#else
+input_evdev_thread_t *input_evdev_thread_new(input_evdev_event_t cb,
+      void *data)
+{
+   return NULL;
+}
+
+void input_evdev_thread_free(input_evdev_thread_t *thread) { }
+
+bool input_evdev_thread_add(input_evdev_thread_t *thread, int fd)
+{
+   return false;
+}
+
+void input_evdev_thread_remove(input_evdev_thread_t *thread, int fd) { }
+void input_evdev_thread_lock(input_evdev_thread_t *thread) { }
+void input_evdev_thread_unlock(input_evdev_thread_t *thread) { }
+
+void input_evdev_thread_latency(input_evdev_thread_t *thread,
+      retro_time_t now)
+{
+}
+#endif
@@ -0,0 +1,123 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INPUT_EVDEV_H__
+#define INPUT_EVDEV_H__
+
+#include <linux/input.h>
+
+#include <boolean.h>
+
+#include "../libretro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Reads evdev devices on a thread as soon as events arrive,
+ * so drivers only have to copy the resulting state when polled. */
+typedef struct input_evdev_thread input_evdev_thread_t;
+
+/* Called on the thread with the lock held, for each event
+ * read from @fd. */
+typedef void (*input_evdev_event_t)(void *data, int fd,
+      const struct input_event *event);
+
+/**
+ * input_evdev_open:
+ * @fd                  : Opened evdev device.
+ *
+ * Makes @fd timestamp its events with the monotonic clock
+ * used by rarch_get_time_usec.
+ **/
+void input_evdev_open(int fd);
+
+/**
+ * input_evdev_latency:
+ * @event               : Event just read.
+ * @now                 : Time of the poll handing @event over.
+ *
+ * Records the input to poll latency of @event, if it ends
+ * a report of the device.
+ **/
+void input_evdev_latency(const struct input_event *event, retro_time_t now);
+
+/**
+ * input_evdev_thread_new:
+ * @cb                  : Event handler.
+ * @data                : User data passed to @cb.
+ *
+ * Starts a thread reading the devices added to it.
+ *
+ * Returns: thread handle, or NULL if threads are not available.
+ **/
+input_evdev_thread_t *input_evdev_thread_new(input_evdev_event_t cb,
+      void *data);
+
+/**
+ * input_evdev_thread_free:
+ * @thread              : Thread handle.
+ *
+ * Stops the thread. Devices added to it are not closed.
+ **/
+void input_evdev_thread_free(input_evdev_thread_t *thread);
+
+/**
+ * input_evdev_thread_add:
+ * @thread              : Thread handle, locked.
+ * @fd                  : Opened evdev device.
+ *
+ * Starts reading @fd on the thread.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool input_evdev_thread_add(input_evdev_thread_t *thread, int fd);
+
+/**
+ * input_evdev_thread_remove:
+ * @thread              : Thread handle, locked.
+ * @fd                  : Device added with input_evdev_thread_add.
+ *
+ * Stops reading @fd, which can be closed afterwards.
+ **/
+void input_evdev_thread_remove(input_evdev_thread_t *thread, int fd);
+
+/**
+ * input_evdev_thread_lock:
+ * @thread              : Thread handle.
+ *
+ * Blocks event handling, so the state it updates can be
+ * copied or devices can be added and removed.
+ **/
+void input_evdev_thread_lock(input_evdev_thread_t *thread);
+
+void input_evdev_thread_unlock(input_evdev_thread_t *thread);
+
+/**
+ * input_evdev_thread_latency:
+ * @thread              : Thread handle, locked.
+ * @now                 : Time of the poll.
+ *
+ * Records the input to poll latency of the reports read
+ * since the last call.
+ **/
+void input_evdev_thread_latency(input_evdev_thread_t *thread,
+      retro_time_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -39,6 +39,19 @@
 #define KEY_ANALOG_LEFT  0x56b92e81U
 #define KEY_ANALOG_RIGHT 0x2e4dc654U
 
+/* Most cells per side of the grid over desc hitboxes. */
+#define OVERLAY_GRID_MAX_SIZE 32
+
+/* What the video driver was last given for an image,
+ * so unchanged geometry and alpha are not set again. */
+struct overlay_image_cache
+{
+   float x, y, w, h;
+   float alpha;
+   bool geom_valid;
+   bool alpha_valid;
+};
+
 struct overlay
 {
    struct overlay_desc *descs;
@@ -90,6 +103,19 @@ struct overlay
 
    struct texture_image *load_images;
    unsigned load_images_size;
+   struct overlay_image_cache *image_cache;
+
+   /* Uniform grid over the hitboxes of descs, so a touch is only
+    * tested against the descs of its cell. Each of the cols * rows
+    * cells lists its descs in grid.descs, from grid.cells[cell]
+    * to grid.cells[cell + 1], in increasing order. */
+   struct
+   {
+      float x, y, w, h;
+      unsigned cols, rows;
+      unsigned *cells;
+      unsigned *descs;
+   } grid;
 };
 
 struct overlay_desc
@@ -225,6 +251,77 @@ static void input_overlay_scale(struct overlay *ol, float scale)
    }
 }
 
+/**
+ * input_overlay_image_geom:
+ * @ol                    : Overlay handle.
+ * @image                 : Image index of the active overlay.
+ *
+ * Sets the vertex geometry of an image, unless the video
+ * driver already has it.
+ **/
+static void input_overlay_image_geom(input_overlay_t *ol, unsigned image,
+      float x, float y, float w, float h)
+{
+   struct overlay_image_cache *cache = NULL;
+
+   if (!ol->iface || !ol->iface->vertex_geom)
+      return;
+
+   if (!ol->active->image_cache || image >= ol->active->load_images_size)
+   {
+      ol->iface->vertex_geom(ol->iface_data, image, x, y, w, h);
+      return;
+   }
+
+   cache = &ol->active->image_cache[image];
+
+   if (cache->geom_valid && cache->x == x && cache->y == y
+         && cache->w == w && cache->h == h)
+      return;
+
+   ol->iface->vertex_geom(ol->iface_data, image, x, y, w, h);
+
+   cache->x          = x;
+   cache->y          = y;
+   cache->w          = w;
+   cache->h          = h;
+   cache->geom_valid = true;
+}
+
+/**
+ * input_overlay_image_alpha:
+ * @ol                    : Overlay handle.
+ * @image                 : Image index of the active overlay.
+ * @alpha                 : Alpha modulation.
+ *
+ * Sets the alpha modulation of an image, unless the video
+ * driver already has it.
+ **/
+static void input_overlay_image_alpha(input_overlay_t *ol, unsigned image,
+      float alpha)
+{
+   struct overlay_image_cache *cache = NULL;
+
+   if (!ol->iface || !ol->iface->set_alpha)
+      return;
+
+   if (!ol->active->image_cache || image >= ol->active->load_images_size)
+   {
+      ol->iface->set_alpha(ol->iface_data, image, alpha);
+      return;
+   }
+
+   cache = &ol->active->image_cache[image];
+
+   if (cache->alpha_valid && cache->alpha == alpha)
+      return;
+
+   ol->iface->set_alpha(ol->iface_data, image, alpha);
+
+   cache->alpha       = alpha;
+   cache->alpha_valid = true;
+}
+
 static void input_overlay_set_vertex_geom(void)
 {
    size_t i;
@@ -233,7 +330,7 @@ static void input_overlay_set_vertex_geom(void)
    if (!ol)
       return;
    if (ol->active->image.pixels)
-      ol->iface->vertex_geom(ol->iface_data, 0,
+      input_overlay_image_geom(ol, 0,
             ol->active->mod_x, ol->active->mod_y,
             ol->active->mod_w, ol->active->mod_h);
 
@@ -247,9 +344,8 @@ static void input_overlay_set_vertex_geom(void)
       if (!desc->image.pixels)
          continue;
 
-      if (ol->iface && ol->iface->vertex_geom)
-         ol->iface->vertex_geom(ol->iface_data, desc->image_index,
-               desc->mod_x, desc->mod_y, desc->mod_w, desc->mod_h);
+      input_overlay_image_geom(ol, desc->image_index,
+            desc->mod_x, desc->mod_y, desc->mod_w, desc->mod_h);
    }
 }
 
@@ -287,6 +383,15 @@ static void input_overlay_free_overlay(struct overlay *overlay)
    if (overlay->load_images)
       free(overlay->load_images);
    overlay->load_images = NULL;
+   if (overlay->image_cache)
+      free(overlay->image_cache);
+   overlay->image_cache = NULL;
+   if (overlay->grid.cells)
+      free(overlay->grid.cells);
+   overlay->grid.cells  = NULL;
+   if (overlay->grid.descs)
+      free(overlay->grid.descs);
+   overlay->grid.descs  = NULL;
    if (overlay->descs)
       free(overlay->descs);
    overlay->descs       = NULL;
@@ -616,6 +721,143 @@ static bool input_overlay_resolve_targets(struct overlay *ol,
    return true;
 }
 
+static unsigned input_overlay_grid_cell(float x, unsigned cells,
+      float start, float len)
+{
+   float cell = (x - start) / len * cells;
+
+   if (cell < 0.0f)
+      return 0;
+   if (cell >= (float)cells)
+      return cells - 1;
+   return (unsigned)cell;
+}
+
+/**
+ * input_overlay_desc_cells:
+ * @overlay               : Overlay with a grid.
+ * @desc                  : Desc of @overlay.
+ *
+ * Gets the range of cells covered by the hitbox of @desc, at its
+ * largest, when grown by range_mod.
+ **/
+static void input_overlay_desc_cells(const struct overlay *overlay,
+      const struct overlay_desc *desc,
+      unsigned *x0, unsigned *x1, unsigned *y0, unsigned *y1)
+{
+   float mod = (desc->range_mod > 1.0f) ? desc->range_mod : 1.0f;
+
+   *x0 = input_overlay_grid_cell(desc->x - desc->range_x * mod,
+         overlay->grid.cols, overlay->grid.x, overlay->grid.w);
+   *x1 = input_overlay_grid_cell(desc->x + desc->range_x * mod,
+         overlay->grid.cols, overlay->grid.x, overlay->grid.w);
+   *y0 = input_overlay_grid_cell(desc->y - desc->range_y * mod,
+         overlay->grid.rows, overlay->grid.y, overlay->grid.h);
+   *y1 = input_overlay_grid_cell(desc->y + desc->range_y * mod,
+         overlay->grid.rows, overlay->grid.y, overlay->grid.h);
+}
+
+/**
+ * input_overlay_build_grid:
+ * @overlay               : Overlay with all its descs loaded.
+ *
+ * Builds the grid over the hitboxes of the descs, in the same
+ * coordinates as desc positions, so it does not depend on scale.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool input_overlay_build_grid(struct overlay *overlay)
+{
+   size_t i;
+   unsigned cell, cells, cx, cy;
+   float min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
+   unsigned side = 1;
+
+   if (!overlay->size)
+      return true;
+
+   while (side * side < overlay->size && side < OVERLAY_GRID_MAX_SIZE)
+      side++;
+
+   for (i = 0; i < overlay->size; i++)
+   {
+      const struct overlay_desc *desc = &overlay->descs[i];
+      float mod = (desc->range_mod > 1.0f) ? desc->range_mod : 1.0f;
+      float x0  = desc->x - desc->range_x * mod;
+      float x1  = desc->x + desc->range_x * mod;
+      float y0  = desc->y - desc->range_y * mod;
+      float y1  = desc->y + desc->range_y * mod;
+
+      if (!i || x0 < min_x)
+         min_x = x0;
+      if (!i || x1 > max_x)
+         max_x = x1;
+      if (!i || y0 < min_y)
+         min_y = y0;
+      if (!i || y1 > max_y)
+         max_y = y1;
+   }
+
+   overlay->grid.x    = min_x;
+   overlay->grid.y    = min_y;
+   overlay->grid.w    = (max_x > min_x) ? max_x - min_x : 1.0f;
+   overlay->grid.h    = (max_y > min_y) ? max_y - min_y : 1.0f;
+   overlay->grid.cols = side;
+   overlay->grid.rows = side;
+
+   cells               = side * side;
+   overlay->grid.cells = (unsigned*)calloc(cells + 1, sizeof(unsigned));
+   if (!overlay->grid.cells)
+      return false;
+
+   /* First count the descs of each cell, then fill them in. */
+   for (i = 0; i < overlay->size; i++)
+   {
+      unsigned x0, x1, y0, y1;
+
+      input_overlay_desc_cells(overlay, &overlay->descs[i],
+            &x0, &x1, &y0, &y1);
+
+      for (cy = y0; cy <= y1; cy++)
+         for (cx = x0; cx <= x1; cx++)
+            overlay->grid.cells[cy * side + cx + 1]++;
+   }
+
+   for (cell = 0; cell < cells; cell++)
+      overlay->grid.cells[cell + 1] += overlay->grid.cells[cell];
+
+   overlay->grid.descs = (unsigned*)
+      malloc((overlay->grid.cells[cells] + 1) * sizeof(unsigned));
+   if (!overlay->grid.descs)
+      goto error;
+
+   for (i = 0; i < overlay->size; i++)
+   {
+      unsigned x0, x1, y0, y1;
+
+      input_overlay_desc_cells(overlay, &overlay->descs[i],
+            &x0, &x1, &y0, &y1);
+
+      /* Cell offsets are used as write positions, which leaves
+       * each one at the start of the next cell. */
+      for (cy = y0; cy <= y1; cy++)
+         for (cx = x0; cx <= x1; cx++)
+            overlay->grid.descs[overlay->grid.cells[cy * side + cx]++] =
+               (unsigned)i;
+   }
+
+   for (cell = cells; cell > 0; cell--)
+      overlay->grid.cells[cell] = overlay->grid.cells[cell - 1];
+   overlay->grid.cells[0] = 0;
+
+   return true;
+
+error:
+   free(overlay->grid.cells);
+   overlay->grid.cells = NULL;
+   return false;
+}
+
 static void input_overlay_load_active(float opacity)
 {
    input_overlay_t *ol = overlay_ptr;
@@ -626,6 +868,11 @@ static void input_overlay_load_active(float opacity)
       ol->iface->load(ol->iface_data, ol->active->load_images,
             ol->active->load_images_size);
 
+   /* Loading resets what the video driver had. */
+   if (ol->active->image_cache)
+      memset(ol->active->image_cache, 0,
+            ol->active->load_images_size * sizeof(*ol->active->image_cache));
+
    input_overlay_set_alpha_mod(opacity);
    input_overlay_set_vertex_geom();
 
@@ -780,6 +1027,10 @@ bool input_overlay_load_overlays_iterate(void)
          }
          break;
       case OVERLAY_IMAGE_TRANSFER_DESC_DONE:
+         /* Touches are tested against every desc without it. */
+         if (!input_overlay_build_grid(overlay))
+            RARCH_WARN("[Overlay]: Failed to build hitbox grid for overlay #%u.\n",
+                  (unsigned)ol->pos);
          if (ol->pos == 0)
             input_overlay_load_overlays_resolve_iterate();
          ol->pos += 1;
@@ -876,6 +1127,9 @@ bool input_overlay_load_overlays(void)
          goto error;
       }
 
+      overlay->image_cache = (struct overlay_image_cache*)
+         calloc(1 + overlay->size, sizeof(*overlay->image_cache));
+
       snprintf(overlay->config.paths.key, sizeof(overlay->config.paths.key),
             "overlay%u_overlay", ol->pos);
 
@@ -1096,6 +1350,69 @@ static bool inside_hitbox(const struct overlay_desc *desc, float x, float y)
    return false;
 }
 
+/**
+ * input_overlay_poll_desc:
+ * @ol                    : Overlay handle.
+ * @out                   : Polled output data.
+ * @desc                  : Desc of the active overlay.
+ * @x                     : X coordinate within the active overlay.
+ * @y                     : Y coordinate within the active overlay.
+ *
+ * Adds the input of @desc to @out if it is touched at @x, @y.
+ **/
+static void input_overlay_poll_desc(input_overlay_t *ol,
+      input_overlay_state_t *out, struct overlay_desc *desc,
+      float x, float y)
+{
+   float x_dist, y_dist;
+
+   if (!inside_hitbox(desc, x, y))
+      return;
+
+   desc->updated = true;
+   x_dist        = x - desc->x;
+   y_dist        = y - desc->y;
+
+   switch (desc->type)
+   {
+      case OVERLAY_TYPE_BUTTONS:
+         {
+            uint64_t mask = desc->key_mask;
+
+            out->buttons |= mask;
+
+            if (mask & (UINT64_C(1) << RARCH_OVERLAY_NEXT))
+               ol->next_index = desc->next_index;
+         }
+         break;
+      case OVERLAY_TYPE_KEYBOARD:
+         if (desc->key_mask < RETROK_LAST)
+            OVERLAY_SET_KEY(out, desc->key_mask);
+         break;
+      default:
+         {
+            float x_val     = x_dist / desc->range_x;
+            float y_val     = y_dist / desc->range_y;
+            float x_val_sat = x_val / desc->analog_saturate_pct;
+            float y_val_sat = y_val / desc->analog_saturate_pct;
+
+            unsigned int base = (desc->type == OVERLAY_TYPE_ANALOG_RIGHT) ? 2 : 0;
+
+            out->analog[base + 0] = clamp_float(x_val_sat, -1.0f, 1.0f) * 32767.0f;
+            out->analog[base + 1] = clamp_float(y_val_sat, -1.0f, 1.0f) * 32767.0f;
+         }
+         break;
+   }
+
+   if (desc->movable)
+   {
+      desc->delta_x = clamp_float(x_dist, -desc->range_x, desc->range_x)
+         * ol->active->mod_w;
+      desc->delta_y = clamp_float(y_dist, -desc->range_y, desc->range_y)
+         * ol->active->mod_h;
+   }
+}
+
 /**
  * input_overlay_poll:
  * @out                   : Polled output data.
@@ -1112,7 +1429,8 @@ static void input_overlay_poll(input_overlay_state_t *out,
 {
    size_t i;
    float x, y;
-   input_overlay_t *ol      = overlay_ptr;
+   input_overlay_t *ol            = overlay_ptr;
+   const struct overlay *active   = NULL;
 
    memset(out, 0, sizeof(*out));
 
@@ -1122,69 +1440,40 @@ static void input_overlay_poll(input_overlay_state_t *out,
       return;
    }
 
+   active = ol->active;
+
    /* norm_x and norm_y is in [-0x7fff, 0x7fff] range,
     * like RETRO_DEVICE_POINTER. */
    x = (float)(norm_x + 0x7fff) / 0xffff;
    y = (float)(norm_y + 0x7fff) / 0xffff;
 
-   x -= ol->active->mod_x;
-   y -= ol->active->mod_y;
-   x /= ol->active->mod_w;
-   y /= ol->active->mod_h;
+   x -= active->mod_x;
+   y -= active->mod_y;
+   x /= active->mod_w;
+   y /= active->mod_h;
 
-   for (i = 0; i < ol->active->size; i++)
+   if (active->grid.cells)
    {
-      float x_dist, y_dist;
-      struct overlay_desc *desc = &ol->active->descs[i];
-
-      if (!desc)
-         continue;
-      if (!inside_hitbox(desc, x, y))
-         continue;
-
-      desc->updated = true;
-      x_dist        = x - desc->x;
-      y_dist        = y - desc->y;
-
-      switch (desc->type)
-      {
-         case OVERLAY_TYPE_BUTTONS:
-            {
-               uint64_t mask = desc->key_mask;
-
-               out->buttons |= mask;
-
-               if (mask & (UINT64_C(1) << RARCH_OVERLAY_NEXT))
-                  ol->next_index = desc->next_index;
-            }
-            break;
-         case OVERLAY_TYPE_KEYBOARD:
-            if (desc->key_mask < RETROK_LAST)
-               OVERLAY_SET_KEY(out, desc->key_mask);
-            break;
-         default:
-            {
-               float x_val     = x_dist / desc->range_x;
-               float y_val     = y_dist / desc->range_y;
-               float x_val_sat = x_val / desc->analog_saturate_pct;
-               float y_val_sat = y_val / desc->analog_saturate_pct;
-
-               unsigned int base = (desc->type == OVERLAY_TYPE_ANALOG_RIGHT) ? 2 : 0;
-
-               out->analog[base + 0] = clamp_float(x_val_sat, -1.0f, 1.0f) * 32767.0f;
-               out->analog[base + 1] = clamp_float(y_val_sat, -1.0f, 1.0f) * 32767.0f;
-            }
-            break;
-      }
-
-      if (desc->movable)
+      /* No hitbox reaches outside of the grid. */
+      if (x >= active->grid.x && x <= active->grid.x + active->grid.w
+            && y >= active->grid.y && y <= active->grid.y + active->grid.h)
       {
-         desc->delta_x = clamp_float(x_dist, -desc->range_x, desc->range_x)
-            * ol->active->mod_w;
-         desc->delta_y = clamp_float(y_dist, -desc->range_y, desc->range_y)
-            * ol->active->mod_h;
+         unsigned cell = input_overlay_grid_cell(y, active->grid.rows,
+               active->grid.y, active->grid.h) * active->grid.cols
+            + input_overlay_grid_cell(x, active->grid.cols,
+               active->grid.x, active->grid.w);
+
+         for (i = active->grid.cells[cell];
+               i < active->grid.cells[cell + 1]; i++)
+            input_overlay_poll_desc(ol, out,
+                  &active->descs[active->grid.descs[i]], x, y);
       }
    }
+   else
+   {
+      for (i = 0; i < active->size; i++)
+         input_overlay_poll_desc(ol, out, &active->descs[i], x, y);
+   }
 
    if (!out->buttons)
       ol->blocked = false;
@@ -1207,10 +1496,9 @@ static void input_overlay_update_desc_geom(input_overlay_t *ol,
    if (!desc->movable)
       return;
 
-   if (ol->iface && ol->iface->vertex_geom)
-      ol->iface->vertex_geom(ol->iface_data, desc->image_index,
-            desc->mod_x + desc->delta_x, desc->mod_y + desc->delta_y,
-            desc->mod_w, desc->mod_h);
+   input_overlay_image_geom(ol, desc->image_index,
+         desc->mod_x + desc->delta_x, desc->mod_y + desc->delta_y,
+         desc->mod_w, desc->mod_h);
 
    desc->delta_x = 0.0f;
    desc->delta_y = 0.0f;
@@ -1231,7 +1519,8 @@ void input_overlay_post_poll(float opacity)
    if (!ol)
       return;
 
-   input_overlay_set_alpha_mod(opacity);
+   if (ol->active->image.pixels)
+      input_overlay_image_alpha(ol, 0, opacity);
 
    for (i = 0; i < ol->active->size; i++)
    {
@@ -1248,15 +1537,12 @@ void input_overlay_post_poll(float opacity)
          /* If pressed this frame, change the hitbox. */
          desc->range_x_mod *= desc->range_mod;
          desc->range_y_mod *= desc->range_mod;
-
-         if (desc->image.pixels)
-         {
-            if (ol->iface && ol->iface->set_alpha)
-               ol->iface->set_alpha(ol->iface_data, desc->image_index,
-                     desc->alpha_mod * opacity);
-         }
       }
 
+      if (desc->image.pixels)
+         input_overlay_image_alpha(ol, desc->image_index, desc->updated
+               ? desc->alpha_mod * opacity : opacity);
+
       input_overlay_update_desc_geom(ol, desc);
       desc->updated = false;
    }
@@ -1413,7 +1699,7 @@ void input_overlay_set_alpha_mod(float mod)
       return;
 
    for (i = 0; i < ol->active->load_images_size; i++)
-      ol->iface->set_alpha(ol->iface_data, i, mod);
+      input_overlay_image_alpha(ol, i, mod);
 }
 
 bool input_overlay_is_alive(void)
@@ -1442,6 +1728,16 @@ bool input_overlay_key_pressed(int key)
    return (ol_state->buttons & (UINT64_C(1) << key));
 }
 
+uint64_t input_overlay_keys_pressed(void)
+{
+   input_overlay_state_t *ol_state  = input_overlay_get_state_ptr();
+
+   if (!ol_state)
+      return 0;
+
+   return ol_state->buttons;
+}
+
 /*
  * input_poll_overlay:
  *
@@ -179,6 +179,14 @@ void input_state_overlay(int16_t *ret,
 
 bool input_overlay_key_pressed(int key);
 
+/**
+ * input_overlay_keys_pressed:
+ *
+ * Returns: bitmask of the keys pressed on the overlay,
+ * indexed by bind ID.
+ **/
+uint64_t input_overlay_keys_pressed(void);
+
 bool input_overlay_is_alive(void);
 
 #ifdef __cplusplus
@@ -56,6 +56,8 @@ const char *msg_hash_to_str_us(uint32_t hash)
          return "Taking screenshot.";
       case MSG_FAILED_TO_TAKE_SCREENSHOT:
          return "Failed to take screenshot.";
+      case MSG_SCREENSHOT_SAVED:
+         return "Screenshot saved.";
       case MSG_FAILED_TO_START_RECORDING:
          return "Failed to start recording.";
       case MSG_RECORDING_TERMINATED_DUE_TO_RESIZE:
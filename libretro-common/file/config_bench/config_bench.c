@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <file/config_file.h>
+#include <file/dir_list.h>
+#include <string/string_list.h>
+
+#define BENCH_KEYS   1000
+#define BENCH_ROUNDS 100
+#define BENCH_INFOS  300
+
+/* Keys a frontend reads out of every core info file. */
+static const char *info_keys[] = {
+   "display_name",
+   "corename",
+   "supported_extensions",
+   "authors",
+   "permissions",
+   "license",
+   "systemname",
+   "manufacturer",
+   "firmware_count",
+   "notes",
+   "database",
+   NULL
+};
+
+static double bench_seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static unsigned bench_info(config_file_t *conf)
+{
+   unsigned i, found = 0;
+   char buf[256];
+
+   for (i = 0; info_keys[i]; i++)
+      found += config_get_array(conf, info_keys[i], buf, sizeof(buf));
+
+   return found;
+}
+
+static void bench_info_dir(const char *dir)
+{
+   size_t i;
+   unsigned found = 0;
+   clock_t start  = clock();
+   struct string_list *list = dir_list_new(dir, "info", false, false);
+
+   if (!list)
+   {
+      printf("Could not open '%s'\n", dir);
+      return;
+   }
+
+   for (i = 0; i < list->size; i++)
+   {
+      config_file_t *conf = config_file_new(list->elems[i].data);
+
+      if (!conf)
+         continue;
+
+      found += bench_info(conf);
+      config_file_free(conf);
+   }
+
+   printf("%u info files:          %8.3f s (%u keys found)\n",
+         (unsigned)list->size, bench_seconds(start), found);
+   string_list_free(list);
+}
+
+/* Stand-in for a core info directory, without touching the disk. */
+static void bench_info_synthetic(void)
+{
+   unsigned i, j;
+   unsigned found = 0;
+   size_t size    = 0;
+   char *info     = (char*)malloc(64 * 1024);
+   clock_t start;
+
+   if (!info)
+      return;
+
+   for (j = 0; j < 40; j++)
+      size += snprintf(info + size, 64 * 1024 - size,
+            "firmware%u_desc = \"Firmware %u\"\n", j, j);
+   for (j = 0; info_keys[j]; j++)
+      size += snprintf(info + size, 64 * 1024 - size,
+            "%s = \"Value of %s\"\n", info_keys[j], info_keys[j]);
+
+   start = clock();
+   for (i = 0; i < BENCH_INFOS; i++)
+   {
+      config_file_t *conf = config_file_new_from_string(info);
+
+      if (!conf)
+         continue;
+
+      found += bench_info(conf);
+      config_file_free(conf);
+   }
+
+   printf("%u synthetic info files:%8.3f s (%u keys found)\n",
+         BENCH_INFOS, bench_seconds(start), found);
+   free(info);
+}
+
+static void bench_config(const char *path)
+{
+   unsigned i, round;
+   char key[64];
+   unsigned found = 0;
+   clock_t start  = clock();
+   config_file_t *conf = config_file_new(path);
+
+   if (!conf)
+   {
+      printf("Could not open '%s'\n", path);
+      return;
+   }
+   printf("load config:             %8.3f s\n", bench_seconds(start));
+
+   /* Lookups of keys that are there and keys that are not,
+    * like a settings refresh does. */
+   start = clock();
+   for (round = 0; round < BENCH_ROUNDS; round++)
+   {
+      for (i = 0; i < BENCH_KEYS; i++)
+      {
+         unsigned val;
+
+         snprintf(key, sizeof(key), "bench_key_%u", i * 2);
+         found += config_get_uint(conf, key, &val);
+      }
+   }
+   printf("%u lookups:          %8.3f s (%u found)\n",
+         BENCH_KEYS * BENCH_ROUNDS, bench_seconds(start), found);
+
+   start = clock();
+   for (i = 0; i < BENCH_KEYS * 2; i++)
+   {
+      snprintf(key, sizeof(key), "bench_key_%u", i);
+      config_set_int(conf, key, i + 1);
+   }
+   printf("%u sets:               %8.3f s\n",
+         BENCH_KEYS * 2, bench_seconds(start));
+
+   start = clock();
+   config_file_write(conf, path);
+   printf("write config:            %8.3f s\n", bench_seconds(start));
+
+   config_file_free(conf);
+}
+
+int main(int argc, char **argv)
+{
+   unsigned i;
+   const char *path = (argc > 2) ? argv[2] : "bench.cfg";
+   FILE *fp         = NULL;
+
+   if (argc > 1)
+      bench_info_dir(argv[1]);
+   else
+      bench_info_synthetic();
+
+   /* Without a config, write one the size of a full retroarch.cfg. */
+   if (argc <= 2)
+   {
+      fp = fopen(path, "w");
+      if (!fp)
+      {
+         printf("Could not create '%s'\n", path);
+         return 1;
+      }
+
+      for (i = 0; i < BENCH_KEYS; i++)
+         fprintf(fp, "bench_key_%u = \"%u\"\n", i, i);
+      fclose(fp);
+   }
+
+   bench_config(path);
+
+   if (argc <= 2)
+      remove(path);
+   return 0;
+}
@@ -48,9 +48,195 @@
 
 #define MAX_INCLUDE_DEPTH 16
 
+#define CONFIG_ARENA_BLOCK_SIZE 16384
+#define CONFIG_INDEX_MIN_SIZE   64
+
+struct config_arena_block
+{
+   struct config_arena_block *next;
+   size_t size;
+   size_t used;
+};
+
 static config_file_t *config_file_new_internal(const char *path, unsigned depth);
 void config_file_free(config_file_t *conf);
 
+static void *config_arena_alloc(config_file_t *conf, size_t size)
+{
+   struct config_arena_block *block = conf->arena;
+
+   size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+   if (!block || block->used + size > block->size)
+   {
+      size_t block_size = CONFIG_ARENA_BLOCK_SIZE;
+
+      if (size > block_size / 4)
+         block_size = size;
+
+      block = (struct config_arena_block*)
+         malloc(sizeof(*block) + block_size);
+
+      if (!block)
+         return NULL;
+
+      block->size = block_size;
+      block->used = 0;
+
+      /* Oversized blocks go behind the current one,
+       * which still has room for small allocations. */
+      if (conf->arena && block_size > CONFIG_ARENA_BLOCK_SIZE)
+      {
+         block->next       = conf->arena->next;
+         conf->arena->next = block;
+      }
+      else
+      {
+         block->next = conf->arena;
+         conf->arena = block;
+      }
+   }
+
+   block->used += size;
+   return (uint8_t*)(block + 1) + block->used - size;
+}
+
+static char *config_arena_strndup(config_file_t *conf,
+      const char *str, size_t len)
+{
+   char *ret = (char*)config_arena_alloc(conf, len + 1);
+
+   if (!ret)
+      return NULL;
+
+   memcpy(ret, str, len);
+   ret[len] = '\0';
+   return ret;
+}
+
+/* Moves all blocks of @child over to @parent, along with
+ * the entries allocated from them. */
+static void config_arena_take(config_file_t *parent, config_file_t *child)
+{
+   struct config_arena_block *tail = child->arena;
+
+   if (!tail)
+      return;
+
+   if (!parent->arena)
+   {
+      parent->arena = child->arena;
+      child->arena  = NULL;
+      return;
+   }
+
+   while (tail->next)
+      tail = tail->next;
+
+   tail->next          = parent->arena->next;
+   parent->arena->next = child->arena;
+   child->arena        = NULL;
+}
+
+static struct config_entry_list *config_index_find(const config_file_t *conf,
+      const char *key, uint32_t hash)
+{
+   size_t i, mask;
+
+   if (!conf->index)
+      return NULL;
+
+   mask = conf->index_size - 1;
+
+   for (i = hash & mask; conf->index[i]; i = (i + 1) & mask)
+   {
+      struct config_entry_list *entry = conf->index[i];
+
+      if (entry->key_hash == hash && !strcmp(entry->key, key))
+         return entry;
+   }
+
+   return NULL;
+}
+
+static bool config_index_grow(config_file_t *conf)
+{
+   size_t i;
+   size_t size = conf->index_size ?
+      conf->index_size * 2 : CONFIG_INDEX_MIN_SIZE;
+   struct config_entry_list **index = (struct config_entry_list**)
+      calloc(size, sizeof(*index));
+
+   if (!index)
+      return false;
+
+   for (i = 0; i < conf->index_size; i++)
+   {
+      size_t j;
+      struct config_entry_list *entry = conf->index[i];
+
+      if (!entry)
+         continue;
+
+      for (j = entry->key_hash & (size - 1); index[j]; j = (j + 1) & (size - 1));
+      index[j] = entry;
+   }
+
+   free(conf->index);
+   conf->index      = index;
+   conf->index_size = size;
+   return true;
+}
+
+/* Entries need to be indexed in list order,
+ * so lookups keep returning the first one of a key. */
+static void config_index_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   size_t i, mask;
+
+   /* Stay below 3/4 full. */
+   if ((conf->index_count + 1) * 4 > conf->index_size * 3
+         && !config_index_grow(conf))
+      return;
+
+   mask = conf->index_size - 1;
+
+   for (i = entry->key_hash & mask; conf->index[i]; i = (i + 1) & mask)
+   {
+      if (conf->index[i]->key_hash == entry->key_hash
+            && !strcmp(conf->index[i]->key, entry->key))
+         return;
+   }
+
+   conf->index[i] = entry;
+   conf->index_count++;
+}
+
+static void config_index_rebuild(config_file_t *conf)
+{
+   struct config_entry_list *entry = NULL;
+
+   if (conf->index)
+      memset(conf->index, 0, conf->index_size * sizeof(*conf->index));
+   conf->index_count = 0;
+
+   for (entry = conf->entries; entry; entry = entry->next)
+      config_index_add(conf, entry);
+}
+
+static void config_file_add_entry(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   if (conf->entries)
+      conf->tail->next = entry;
+   else
+      conf->entries = entry;
+
+   conf->tail = entry;
+   config_index_add(conf, entry);
+}
+
 static char *getaline(FILE *file)
 {
    char* newline = (char*)malloc(9);
@@ -85,10 +271,10 @@ static char *getaline(FILE *file)
    return newline; 
 }
 
+/* Returns the value in @line, terminated in place. */
 static char *extract_value(char *line, bool is_value)
 {
    char *save = NULL;
-   char *tok  = NULL;
 
    if (is_value)
    {
@@ -110,19 +296,13 @@ static char *extract_value(char *line, bool is_value)
    if (*line == '"')
    {
       line++;
-      tok = strtok_r(line, "\"", &save);
-      if (!tok)
-         return NULL;
-      return strdup(tok);
+      return strtok_r(line, "\"", &save);
    }
    else if (*line == '\0') /* Nothing */
       return NULL;
 
    /* We don't have that. Read until next space. */
-   tok = strtok_r(line, " \n\t\f\r\v", &save);
-   if (tok)
-      return strdup(tok);
-   return NULL;
+   return strtok_r(line, " \n\t\f\r\v", &save);
 }
 
 static void set_list_readonly(struct config_entry_list *list)
@@ -137,35 +317,26 @@ static void set_list_readonly(struct config_entry_list *list)
 /* Move semantics? */
 static void add_child_list(config_file_t *parent, config_file_t *child)
 {
-   if (parent->entries)
-   {
-      struct config_entry_list *head = parent->entries;
-      while (head->next)
-         head = head->next;
+   struct config_entry_list *entry = NULL;
 
-      set_list_readonly(child->entries);
-      head->next = child->entries;
-   }
+   set_list_readonly(child->entries);
+
+   if (parent->entries)
+      parent->tail->next = child->entries;
    else
+      parent->entries    = child->entries;
+
+   /* Anything the parent set before the #include wins. */
+   for (entry = child->entries; entry; entry = entry->next)
    {
-      set_list_readonly(child->entries);
-      parent->entries = child->entries;
+      config_index_add(parent, entry);
+      parent->tail = entry;
    }
 
-   child->entries = NULL;
-
-   /* Rebase tail. */
-   if (parent->entries)
-   {
-      struct config_entry_list *head = 
-         (struct config_entry_list*)parent->entries;
+   config_arena_take(parent, child);
 
-      while (head->next)
-         head = head->next;
-      parent->tail = head;
-   }
-   else
-      parent->tail = NULL;
+   child->entries = NULL;
+   child->tail    = NULL;
 }
 
 static void add_include_list(config_file_t *conf, const char *path)
@@ -220,15 +391,11 @@ static void add_sub_conf(config_file_t *conf, char *line)
    sub_conf = (config_file_t*)
       config_file_new_internal(real_path, conf->include_depth + 1);
    if (!sub_conf)
-   {
-      free(path);
       return;
-   }
 
    /* Pilfer internal list. */
    add_child_list(conf, sub_conf);
    config_file_free(sub_conf);
-   free(path);
 }
 
 static char *strip_comment(char *str)
@@ -270,23 +437,17 @@ static char *strip_comment(char *str)
    return str;
 }
 
-static bool parse_line(config_file_t *conf,
-      struct config_entry_list *list, char *line)
+static struct config_entry_list *parse_line(config_file_t *conf,
+      char *line)
 {
-   char *comment   = NULL;
-   char *key       = (char*)malloc(9);
-   char *key_tmp   = NULL;
-   size_t cur_size = 8;
-   size_t idx      = 0;
-
-   if (!key)
-      return false;
+   size_t key_len;
+   char *comment                   = NULL;
+   char *key                       = NULL;
+   char *value                     = NULL;
+   struct config_entry_list *entry = NULL;
 
    if (!line || !*line)
-   {
-      free(key);
-      return false;
-   }
+      return NULL;
 
    comment = strip_comment(line);
 
@@ -297,8 +458,7 @@ static bool parse_line(config_file_t *conf,
       if (strstr(comment, "include ") == comment)
       {
          add_sub_conf(conf, comment + strlen("include "));
-         free(key);
-         return false;
+         return NULL;
       }
    }
    else if (conf->include_depth >= MAX_INCLUDE_DEPTH)
@@ -310,37 +470,28 @@ static bool parse_line(config_file_t *conf,
    while (isspace(*line))
       line++;
 
+   key = line;
    while (isgraph(*line))
-   {
-      if (idx == cur_size)
-      {
-         cur_size *= 2;
-         key_tmp = (char*)realloc(key, cur_size + 1);
+      line++;
+   key_len = line - key;
 
-         if (!key_tmp)
-         {
-            free(key);
-            return false;
-         }
+   value = extract_value(line, true);
+   if (!value)
+      return NULL;
 
-         key = key_tmp;
-      }
+   entry = (struct config_entry_list*)config_arena_alloc(conf, sizeof(*entry));
+   if (!entry)
+      return NULL;
 
-      key[idx++] = *line++;
-   }
-   key[idx] = '\0';
-   list->key = key;
-   list->key_hash = djb2_calculate(key);
+   memset(entry, 0, sizeof(*entry));
+   entry->key   = config_arena_strndup(conf, key, key_len);
+   entry->value = config_arena_strndup(conf, value, strlen(value));
 
-   list->value = extract_value(line, true);
-   if (!list->value)
-   {
-      list->key = NULL;
-      free(key);
-      return false;
-   }
+   if (!entry->key || !entry->value)
+      return NULL;
 
-   return true;
+   entry->key_hash = djb2_calculate(entry->key);
+   return entry;
 }
 
 bool config_append_file(config_file_t *conf, const char *path)
@@ -353,7 +504,15 @@ bool config_append_file(config_file_t *conf, const char *path)
    {
       new_conf->tail->next = conf->entries;
       conf->entries        = new_conf->entries; /* Pilfer. */
+      if (!conf->tail)
+         conf->tail        = new_conf->tail;
       new_conf->entries    = NULL;
+      new_conf->tail       = NULL;
+
+      config_arena_take(conf, new_conf);
+
+      /* The new entries come first now. */
+      config_index_rebuild(conf);
    }
 
    config_file_free(new_conf);
@@ -397,41 +556,17 @@ static config_file_t *config_file_new_internal(
 
    while (!feof(file))
    {
-      struct config_entry_list *list = (struct config_entry_list*)
-         calloc(1, sizeof(*list));
-      char *line = NULL;
-
-      if (!list)
-      {
-         config_file_free(conf);
-         fclose(file);
-         return NULL;
-      }
-
-      line = getaline(file);
-
-      if (line)
-      {
-         if (parse_line(conf, list, line))
-         {
-            if (conf->entries)
-               conf->tail->next = list;
-            else
-               conf->entries = list;
-
-            conf->tail = list;
-         }
+      struct config_entry_list *entry = NULL;
+      char *line                      = getaline(file);
 
-         free(line);
-      }
-      else
-      {
-         free(list);
+      if (!line)
          continue;
-      }
 
-      if (list != conf->tail)
-         free(list);
+      entry = parse_line(conf, line);
+      if (entry)
+         config_file_add_entry(conf, entry);
+
+      free(line);
    }
    fclose(file);
 
@@ -458,32 +593,15 @@ config_file_t *config_file_new_from_string(const char *from_string)
 
    for (i = 0; i < lines->size; i++)
    {
-      struct config_entry_list *list = (struct config_entry_list*)
-         calloc(1, sizeof(*list));
-      char* line = lines->elems[i].data;
-
-      if (!list)
-      {
-         string_list_free(lines);
-         config_file_free(conf);
-         return NULL;
-      }
-
-      if (line)
-      {
-         if (parse_line(conf, list, line))
-         {
-            if (conf->entries)
-               conf->tail->next = list;
-            else
-               conf->entries = list;
+      struct config_entry_list *entry = NULL;
+      char *line                      = lines->elems[i].data;
 
-            conf->tail = list;
-         }
-      }
+      if (!line)
+         continue;
 
-      if (list != conf->tail)
-         free(list);
+      entry = parse_line(conf, line);
+      if (entry)
+         config_file_add_entry(conf, entry);
    }
 
    string_list_free(lines);
@@ -500,20 +618,27 @@ void config_file_free(config_file_t *conf)
 {
    struct config_include_list *inc_tmp = NULL;
    struct config_entry_list *tmp = NULL;
+   struct config_arena_block *block = NULL;
    if (!conf)
       return;
 
-   tmp = conf->entries;
-   while (tmp)
+   /* Everything else lives in the arena. */
+   for (tmp = conf->entries; tmp; tmp = tmp->next)
+   {
+      if (tmp->value_allocated)
+         free(tmp->value);
+   }
+
+   block = conf->arena;
+   while (block)
    {
-      struct config_entry_list *hold = NULL;
-      free(tmp->key);
-      free(tmp->value);
-      hold = tmp;
-      tmp = tmp->next;
+      struct config_arena_block *hold = block;
+      block = block->next;
       free(hold);
    }
 
+   free(conf->index);
+
    inc_tmp = (struct config_include_list*)conf->includes;
    while (inc_tmp)
    {
@@ -529,33 +654,14 @@ void config_file_free(config_file_t *conf)
 }
 
 static struct config_entry_list *config_get_entry(const config_file_t *conf,
-      const char *key, struct config_entry_list **prev)
+      const char *key)
 {
-   struct config_entry_list *entry;
-   struct config_entry_list *previous = NULL;
-
-   uint32_t hash = djb2_calculate(key);
-
-   if (prev)
-      previous = *prev;
-
-   for (entry = conf->entries; entry; entry = entry->next)
-   {
-      if (hash == entry->key_hash && !strcmp(key, entry->key))
-         return entry;
-
-      previous = entry;
-   }
-
-   if (prev)
-      *prev = previous;
-
-   return NULL;
+   return config_index_find(conf, key, djb2_calculate(key));
 }
 
 bool config_get_double(config_file_t *conf, const char *key, double *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       *in = strtod(entry->value, NULL);
@@ -565,7 +671,7 @@ bool config_get_double(config_file_t *conf, const char *key, double *in)
 
 bool config_get_float(config_file_t *conf, const char *key, float *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -578,7 +684,7 @@ bool config_get_float(config_file_t *conf, const char *key, float *in)
 
 bool config_get_int(config_file_t *conf, const char *key, int *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -594,7 +700,7 @@ bool config_get_int(config_file_t *conf, const char *key, int *in)
 
 bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -610,7 +716,7 @@ bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 
 bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -626,7 +732,7 @@ bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -642,7 +748,7 @@ bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_char(config_file_t *conf, const char *key, char *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -657,7 +763,7 @@ bool config_get_char(config_file_t *conf, const char *key, char *in)
 
 bool config_get_string(config_file_t *conf, const char *key, char **str)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       *str = strdup(entry->value);
@@ -668,7 +774,7 @@ bool config_get_string(config_file_t *conf, const char *key, char **str)
 bool config_get_array(config_file_t *conf, const char *key,
       char *buf, size_t size)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       return strlcpy(buf, entry->value, size) < size;
@@ -682,7 +788,7 @@ bool config_get_path(config_file_t *conf, const char *key,
 #if defined(RARCH_CONSOLE)
    return config_get_array(conf, key, buf, size);
 #else
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       fill_pathname_expand_special(buf, entry->value, size);
@@ -693,7 +799,7 @@ bool config_get_path(config_file_t *conf, const char *key,
 
 bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -714,28 +820,39 @@ bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 
 void config_set_string(config_file_t *conf, const char *key, const char *val)
 {
-   struct config_entry_list *last  = conf->entries;
-   struct config_entry_list *entry = config_get_entry(conf, key, &last);
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry && !entry->readonly)
    {
-      free(entry->value);
-      entry->value = strdup(val);
+      char *value = NULL;
+
+      if (!strcmp(entry->value, val))
+         return;
+
+      if (!(value = strdup(val)))
+         return;
+
+      if (entry->value_allocated)
+         free(entry->value);
+      entry->value           = value;
+      entry->value_allocated = true;
       return;
    }
 
-   entry = (struct config_entry_list*)calloc(1, sizeof(*entry));
+   entry = (struct config_entry_list*)config_arena_alloc(conf, sizeof(*entry));
 
    if (!entry)
       return;
 
-   entry->key   = strdup(key);
-   entry->value = strdup(val);
+   memset(entry, 0, sizeof(*entry));
+   entry->key      = config_arena_strndup(conf, key, strlen(key));
+   entry->value    = config_arena_strndup(conf, val, strlen(val));
 
-   if (last)
-      last->next = entry;
-   else
-      conf->entries = entry;
+   if (!entry->key || !entry->value)
+      return;
+
+   entry->key_hash = djb2_calculate(entry->key);
+   config_file_add_entry(conf, entry);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -846,16 +963,7 @@ void config_file_dump(config_file_t *conf, FILE *file)
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (!strcmp(entry, list->key))
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_get_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
@@ -314,6 +314,18 @@ void zlib_deflate_init(void *data, int level)
       deflateInit(stream, level);
 }
 
+bool zlib_deflate_init2(void *data, int level)
+{
+   z_stream *stream = (z_stream*)data;
+
+   if (!stream)
+      return false;
+   if (deflateInit2(stream, level, Z_DEFLATED, -MAX_WBITS,
+            8, Z_DEFAULT_STRATEGY) != Z_OK)
+      return false;
+   return true;
+}
+
 bool zlib_inflate_init(void *data)
 {
    z_stream *stream = (z_stream*)data;
@@ -398,6 +410,24 @@ int zlib_deflate_data_to_file(void *data)
    return 0;
 }
 
+int zlib_deflate_data_flush(void *data)
+{
+   int zstatus;
+   z_stream *stream = (z_stream*)data;
+
+   if (!stream)
+      return -1;
+
+   zstatus = deflate(stream, Z_SYNC_FLUSH);
+
+   /* Output is byte-aligned only once all input was consumed
+    * and the flush marker fit into the output buffer. */
+   if (zstatus == Z_OK && stream->avail_in == 0 && stream->avail_out != 0)
+      return 1;
+
+   return 0;
+}
+
 int zlib_inflate_data_to_file_iterate(void *data)
 {
    int zstatus;
@@ -422,6 +452,17 @@ uint32_t zlib_crc32_calculate(const uint8_t *data, size_t length)
    return crc32(0, data, length);
 }
 
+uint32_t zlib_adler32_calculate(const uint8_t *data, size_t length)
+{
+   return adler32(adler32(0, NULL, 0), data, length);
+}
+
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t length2)
+{
+   return adler32_combine(adler1, adler2, length2);
+}
+
 uint32_t zlib_crc32_adjust(uint32_t crc, uint8_t data)
 {
    /* zlib and nall have different assumptions on "sign" for this 
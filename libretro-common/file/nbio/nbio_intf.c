@@ -0,0 +1,124 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (nbio_intf.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#ifdef HAVE_CONFIG_H
+#include "../../../config.h"
+#endif
+
+#include <file/nbio.h>
+
+struct nbio_t
+{
+   const nbio_intf_t *intf;
+   void *data;
+};
+
+/* Preferred backends first. */
+static nbio_intf_t *nbio_intfs[] = {
+#if defined(__linux__) && defined(HAVE_IO_URING)
+   &nbio_io_uring,
+#endif
+#ifdef HAVE_THREADS
+   &nbio_thread,
+#endif
+   &nbio_stdio,
+   NULL
+};
+
+struct nbio_t* nbio_open(const char * filename, unsigned mode)
+{
+   unsigned i;
+   struct nbio_t* handle = (struct nbio_t*)calloc(1, sizeof(*handle));
+
+   if (!handle)
+      return NULL;
+
+   /* Blocking modes finish in a single nbio_iterate call anyway. */
+   if (mode == BIO_READ || mode == BIO_WRITE)
+   {
+      handle->intf = &nbio_stdio;
+      handle->data = nbio_stdio.open(filename, mode);
+   }
+
+   for (i = 0; !handle->data && nbio_intfs[i]; i++)
+   {
+      handle->intf = nbio_intfs[i];
+      handle->data = nbio_intfs[i]->open(filename, mode);
+   }
+
+   if (!handle->data)
+   {
+      free(handle);
+      return NULL;
+   }
+
+   return handle;
+}
+
+void nbio_begin_read(struct nbio_t* handle)
+{
+   if (handle)
+      handle->intf->begin_read(handle->data);
+}
+
+void nbio_begin_write(struct nbio_t* handle)
+{
+   if (handle)
+      handle->intf->begin_write(handle->data);
+}
+
+bool nbio_iterate(struct nbio_t* handle)
+{
+   if (!handle)
+      return false;
+   return handle->intf->iterate(handle->data);
+}
+
+void nbio_resize(struct nbio_t* handle, size_t len)
+{
+   if (handle)
+      handle->intf->resize(handle->data, len);
+}
+
+void* nbio_get_ptr(struct nbio_t* handle, size_t* len)
+{
+   if (!handle)
+      return NULL;
+   return handle->intf->get_ptr(handle->data, len);
+}
+
+void nbio_cancel(struct nbio_t* handle)
+{
+   if (handle)
+      handle->intf->cancel(handle->data);
+}
+
+void nbio_free(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   handle->intf->free(handle->data);
+   free(handle);
+}
@@ -0,0 +1,576 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (nbio_io_uring.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "../../../config.h"
+#endif
+
+#include <file/nbio.h>
+
+#if defined(__linux__) && defined(HAVE_IO_URING)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+/* Requests in flight per file. */
+#define NBIO_IO_URING_DEPTH 8
+
+/* Chunks and buffers are page aligned, as O_DIRECT requires. */
+#define NBIO_IO_URING_CHUNK (256 * 1024)
+#define NBIO_IO_URING_ALIGN 4096
+
+struct nbio_io_uring_request
+{
+   struct iovec iov;
+   size_t offset;
+   bool busy;
+};
+
+struct nbio_io_uring_t
+{
+   int fd;
+   int ring_fd;
+
+   void *sq_ptr;
+   void *cq_ptr;
+   size_t sq_size;
+   size_t cq_size;
+   struct io_uring_sqe *sqes;
+   size_t sqes_size;
+
+   unsigned *sq_head;
+   unsigned *sq_tail;
+   unsigned *sq_mask;
+   unsigned *sq_array;
+   unsigned *cq_head;
+   unsigned *cq_tail;
+   unsigned *cq_mask;
+   struct io_uring_cqe *cqes;
+
+   struct nbio_io_uring_request requests[NBIO_IO_URING_DEPTH];
+   unsigned inflight;
+
+   void *data;
+   size_t len;
+   /* Bytes handed to the kernel so far. */
+   size_t submitted;
+   bool error;
+   /* Same values as in nbio_stdio. */
+   signed char op;
+   signed char mode;
+};
+
+/* Set once the kernel turned io_uring down, to stop asking. */
+static bool nbio_io_uring_unsupported;
+
+static int nbio_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+   return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int nbio_io_uring_enter(int fd, unsigned to_submit,
+      unsigned min_complete, unsigned flags)
+{
+   return (int)syscall(__NR_io_uring_enter, fd, to_submit,
+         min_complete, flags, NULL, 0);
+}
+
+static void nbio_io_uring_ring_free(struct nbio_io_uring_t *handle)
+{
+   if (handle->sqes)
+      munmap(handle->sqes, handle->sqes_size);
+   if (handle->cq_ptr && handle->cq_ptr != handle->sq_ptr)
+      munmap(handle->cq_ptr, handle->cq_size);
+   if (handle->sq_ptr)
+      munmap(handle->sq_ptr, handle->sq_size);
+   if (handle->ring_fd >= 0)
+      close(handle->ring_fd);
+
+   handle->sqes    = NULL;
+   handle->cq_ptr  = NULL;
+   handle->sq_ptr  = NULL;
+   handle->ring_fd = -1;
+}
+
+static bool nbio_io_uring_ring_init(struct nbio_io_uring_t *handle)
+{
+   struct io_uring_params p;
+   uint8_t *sq, *cq;
+
+   memset(&p, 0, sizeof(p));
+
+   handle->ring_fd = nbio_io_uring_setup(NBIO_IO_URING_DEPTH, &p);
+   if (handle->ring_fd < 0)
+   {
+      if (errno == ENOSYS || errno == EPERM)
+         nbio_io_uring_unsupported = true;
+      return false;
+   }
+
+   handle->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+   handle->cq_size = p.cq_off.cqes +
+      p.cq_entries * sizeof(struct io_uring_cqe);
+
+#ifdef IORING_FEAT_SINGLE_MMAP
+   if (p.features & IORING_FEAT_SINGLE_MMAP)
+   {
+      if (handle->cq_size > handle->sq_size)
+         handle->sq_size = handle->cq_size;
+      handle->cq_size = handle->sq_size;
+   }
+#endif
+
+   handle->sq_ptr = mmap(NULL, handle->sq_size, PROT_READ | PROT_WRITE,
+         MAP_SHARED | MAP_POPULATE, handle->ring_fd, IORING_OFF_SQ_RING);
+   if (handle->sq_ptr == MAP_FAILED)
+   {
+      handle->sq_ptr = NULL;
+      goto error;
+   }
+
+#ifdef IORING_FEAT_SINGLE_MMAP
+   if (p.features & IORING_FEAT_SINGLE_MMAP)
+      handle->cq_ptr = handle->sq_ptr;
+   else
+#endif
+   {
+      handle->cq_ptr = mmap(NULL, handle->cq_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, handle->ring_fd, IORING_OFF_CQ_RING);
+      if (handle->cq_ptr == MAP_FAILED)
+      {
+         handle->cq_ptr = NULL;
+         goto error;
+      }
+   }
+
+   handle->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+   handle->sqes      = (struct io_uring_sqe*)mmap(NULL, handle->sqes_size,
+         PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+         handle->ring_fd, IORING_OFF_SQES);
+   if (handle->sqes == MAP_FAILED)
+   {
+      handle->sqes = NULL;
+      goto error;
+   }
+
+   sq                = (uint8_t*)handle->sq_ptr;
+   cq                = (uint8_t*)handle->cq_ptr;
+   handle->sq_head   = (unsigned*)(sq + p.sq_off.head);
+   handle->sq_tail   = (unsigned*)(sq + p.sq_off.tail);
+   handle->sq_mask   = (unsigned*)(sq + p.sq_off.ring_mask);
+   handle->sq_array  = (unsigned*)(sq + p.sq_off.array);
+   handle->cq_head   = (unsigned*)(cq + p.cq_off.head);
+   handle->cq_tail   = (unsigned*)(cq + p.cq_off.tail);
+   handle->cq_mask   = (unsigned*)(cq + p.cq_off.ring_mask);
+   handle->cqes      = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+   return true;
+
+error:
+   nbio_io_uring_ring_free(handle);
+   return false;
+}
+
+static void *nbio_io_uring_alloc(size_t len)
+{
+   void *ptr = NULL;
+   size_t size = (len + NBIO_IO_URING_ALIGN - 1)
+      & ~(size_t)(NBIO_IO_URING_ALIGN - 1);
+
+   if (posix_memalign(&ptr, NBIO_IO_URING_ALIGN,
+            size ? size : NBIO_IO_URING_ALIGN) != 0)
+      return NULL;
+   return ptr;
+}
+
+static void *nbio_io_uring_open(const char * filename, unsigned mode)
+{
+   struct stat st;
+   int flags                      = O_RDONLY;
+   struct nbio_io_uring_t *handle = NULL;
+
+   if (nbio_io_uring_unsupported)
+      return NULL;
+
+   handle = (struct nbio_io_uring_t*)calloc(1, sizeof(*handle));
+   if (!handle)
+      return NULL;
+
+   handle->ring_fd = -1;
+
+   switch (mode)
+   {
+      case NBIO_WRITE:
+      case BIO_WRITE:
+         flags = O_WRONLY | O_CREAT | O_TRUNC;
+         break;
+      case NBIO_UPDATE:
+         flags = O_RDWR;
+         break;
+   }
+
+   handle->fd = open(filename, flags, 0666);
+   if (handle->fd < 0)
+      goto error;
+
+   if (!nbio_io_uring_ring_init(handle))
+      goto error;
+
+   if (!(flags & O_TRUNC))
+   {
+      if (fstat(handle->fd, &st) != 0)
+         goto error;
+      handle->len = st.st_size;
+   }
+
+   handle->data = nbio_io_uring_alloc(handle->len);
+   if (!handle->data)
+      goto error;
+
+   handle->mode = mode;
+   handle->op   = -2;
+
+   return handle;
+
+error:
+   nbio_io_uring_ring_free(handle);
+   if (handle->fd >= 0)
+      close(handle->fd);
+   free(handle);
+   return NULL;
+}
+
+static void nbio_io_uring_queue(struct nbio_io_uring_t *handle,
+      unsigned id)
+{
+   unsigned tail                = *handle->sq_tail;
+   unsigned index               = tail & *handle->sq_mask;
+   struct io_uring_sqe *sqe     = &handle->sqes[index];
+   struct nbio_io_uring_request *req = &handle->requests[id];
+
+   memset(sqe, 0, sizeof(*sqe));
+   sqe->opcode    = (handle->op == NBIO_READ)
+      ? IORING_OP_READV : IORING_OP_WRITEV;
+   sqe->fd        = handle->fd;
+   sqe->addr      = (uint64_t)(uintptr_t)&req->iov;
+   sqe->len       = 1;
+   sqe->off       = req->offset;
+   sqe->user_data = id;
+
+   handle->sq_array[index] = index;
+   __atomic_store_n(handle->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * nbio_io_uring_submit:
+ * @handle              : nbio handle.
+ * @min_complete        : Completions to wait for.
+ *
+ * Hands the queued requests to the kernel. If it is busy,
+ * they stay queued for the next call. If that fails otherwise,
+ * the requests it did not take are dropped and the transfer
+ * fails.
+ **/
+static void nbio_io_uring_submit(struct nbio_io_uring_t *handle,
+      unsigned min_complete)
+{
+   unsigned head, tail;
+
+   for (;;)
+   {
+      unsigned pending = *handle->sq_tail
+         - __atomic_load_n(handle->sq_head, __ATOMIC_ACQUIRE);
+
+      if (!pending && !min_complete)
+         return;
+
+      if (nbio_io_uring_enter(handle->ring_fd, pending, min_complete,
+               min_complete ? IORING_ENTER_GETEVENTS : 0) >= 0)
+         return;
+
+      if (errno == EINTR)
+         continue;
+      if (errno == EAGAIN || errno == EBUSY)
+         return;
+      break;
+   }
+
+   head = __atomic_load_n(handle->sq_head, __ATOMIC_ACQUIRE);
+   tail = *handle->sq_tail;
+
+   for (; head != tail; head++)
+   {
+      unsigned index = head & *handle->sq_mask;
+      unsigned id    = (unsigned)handle->sqes[index].user_data;
+
+      handle->requests[id].busy = false;
+      handle->inflight--;
+   }
+
+   __atomic_store_n(handle->sq_tail, *handle->sq_head, __ATOMIC_RELEASE);
+   handle->error = true;
+}
+
+/**
+ * nbio_io_uring_reap:
+ * @handle              : nbio handle.
+ * @resubmit            : Whether partial transfers are continued.
+ *
+ * Processes the completed requests.
+ **/
+static void nbio_io_uring_reap(struct nbio_io_uring_t *handle,
+      bool resubmit)
+{
+   unsigned head = *handle->cq_head;
+
+   while (head != __atomic_load_n(handle->cq_tail, __ATOMIC_ACQUIRE))
+   {
+      struct io_uring_cqe *cqe = &handle->cqes[head & *handle->cq_mask];
+      unsigned id                       = (unsigned)cqe->user_data;
+      int res                           = cqe->res;
+      struct nbio_io_uring_request *req = &handle->requests[id];
+
+      head++;
+
+      if (res > 0 && (size_t)res < req->iov.iov_len)
+      {
+         req->iov.iov_base = (char*)req->iov.iov_base + res;
+         req->iov.iov_len -= res;
+         req->offset      += res;
+         res               = -EAGAIN;
+      }
+
+      if ((res == -EAGAIN || res == -EINTR) && resubmit && !handle->error)
+      {
+         nbio_io_uring_queue(handle, id);
+         continue;
+      }
+
+      /* A read returning 0 means the file shrunk under us. */
+      if (res <= 0)
+         handle->error = true;
+
+      req->busy = false;
+      handle->inflight--;
+   }
+
+   __atomic_store_n(handle->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static void nbio_io_uring_begin(struct nbio_io_uring_t *handle,
+      signed char op)
+{
+   handle->op        = op;
+   handle->submitted = 0;
+   handle->error     = false;
+}
+
+static void nbio_io_uring_begin_read(void *data)
+{
+   struct nbio_io_uring_t *handle = (struct nbio_io_uring_t*)data;
+
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file read operation while busy");
+      abort();
+   }
+
+   nbio_io_uring_begin(handle, NBIO_READ);
+}
+
+static void nbio_io_uring_begin_write(void *data)
+{
+   struct nbio_io_uring_t *handle = (struct nbio_io_uring_t*)data;
+
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file write operation while busy");
+      abort();
+   }
+
+   nbio_io_uring_begin(handle, NBIO_WRITE);
+}
+
+static bool nbio_io_uring_iterate(void *data)
+{
+   unsigned id;
+   struct nbio_io_uring_t *handle = (struct nbio_io_uring_t*)data;
+
+   if (!handle)
+      return false;
+
+   if (handle->op < 0)
+      return true;
+
+   nbio_io_uring_reap(handle, true);
+
+   for (id = 0; id < NBIO_IO_URING_DEPTH
+         && handle->submitted < handle->len && !handle->error; id++)
+   {
+      struct nbio_io_uring_request *req = &handle->requests[id];
+      size_t amount                     = handle->len - handle->submitted;
+
+      if (req->busy)
+         continue;
+
+      if (amount > NBIO_IO_URING_CHUNK)
+         amount = NBIO_IO_URING_CHUNK;
+
+      req->iov.iov_base = (char*)handle->data + handle->submitted;
+      req->iov.iov_len  = amount;
+      req->offset       = handle->submitted;
+      req->busy         = true;
+
+      handle->submitted += amount;
+      handle->inflight++;
+      nbio_io_uring_queue(handle, id);
+   }
+
+   /* Also hands over what an earlier busy kernel left queued. */
+   nbio_io_uring_submit(handle, 0);
+
+   if (handle->inflight)
+      return false;
+
+   if (handle->submitted < handle->len && !handle->error)
+      return false;
+
+   handle->op = -1;
+   return true;
+}
+
+static void nbio_io_uring_resize(void *data, size_t len)
+{
+   void *ptr                      = NULL;
+   struct nbio_io_uring_t *handle = (struct nbio_io_uring_t*)data;
+
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file resize operation while busy");
+      abort();
+   }
+   if (len < handle->len)
+   {
+      puts("ERROR - attempted file shrink operation, not implemented");
+      abort();
+   }
+
+   ptr = nbio_io_uring_alloc(len);
+   if (ptr)
+   {
+      memcpy(ptr, handle->data, handle->len);
+      free(handle->data);
+      handle->data = ptr;
+   }
+
+   handle->len  = len;
+   handle->op   = -1;
+}
+
+static void *nbio_io_uring_get_ptr(void *data, size_t* len)
+{
+   struct nbio_io_uring_t *handle = (struct nbio_io_uring_t*)data;
+
+   if (!handle)
+      return NULL;
+   if (len)
+      *len = handle->len;
+   if (handle->op == -1)
+      return handle->data;
+   return NULL;
+}
+
+static void nbio_io_uring_cancel(void *data)
+{
+   struct nbio_io_uring_t *handle = (struct nbio_io_uring_t*)data;
+
+   if (!handle)
+      return;
+
+   /* The kernel may still write to the buffer, wait for it. */
+   handle->error = true;
+   while (handle->inflight)
+   {
+      nbio_io_uring_submit(handle, 1);
+      nbio_io_uring_reap(handle, false);
+   }
+
+   handle->op = -1;
+}
+
+static void nbio_io_uring_free(void *data)
+{
+   struct nbio_io_uring_t *handle = (struct nbio_io_uring_t*)data;
+
+   if (!handle)
+      return;
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted free() while busy");
+      abort();
+   }
+
+   nbio_io_uring_ring_free(handle);
+   close(handle->fd);
+   free(handle->data);
+   free(handle);
+}
+
+nbio_intf_t nbio_io_uring = {
+   nbio_io_uring_open,
+   nbio_io_uring_begin_read,
+   nbio_io_uring_begin_write,
+   nbio_io_uring_iterate,
+   nbio_io_uring_resize,
+   nbio_io_uring_get_ptr,
+   nbio_io_uring_cancel,
+   nbio_io_uring_free,
+   "io_uring",
+};
+#endif
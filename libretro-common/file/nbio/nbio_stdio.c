@@ -3,7 +3,7 @@
 
 #include <file/nbio.h>
 
-struct nbio_t
+struct nbio_stdio_t
 {
    FILE* f;
    void* data;
@@ -21,14 +21,14 @@ struct nbio_t
 
 static const char * modes[]={ "rb", "wb", "r+b", "rb", "wb", "r+b" };
 
-struct nbio_t* nbio_open(const char * filename, unsigned mode)
+static void *nbio_stdio_open(const char * filename, unsigned mode)
 {
-   struct nbio_t* handle = NULL;
+   struct nbio_stdio_t* handle = NULL;
    FILE* f               = fopen(filename, modes[mode]);
    if (!f)
       return NULL;
 
-   handle                = (struct nbio_t*)malloc(sizeof(struct nbio_t));
+   handle                = (struct nbio_stdio_t*)malloc(sizeof(struct nbio_stdio_t));
 
    if (!handle)
       goto error;
@@ -71,8 +71,10 @@ error:
    return NULL;
 }
 
-void nbio_begin_read(struct nbio_t* handle)
+static void nbio_stdio_begin_read(void *data)
 {
+   struct nbio_stdio_t* handle = (struct nbio_stdio_t*)data;
+
    if (!handle)
       return;
 
@@ -88,8 +90,10 @@ void nbio_begin_read(struct nbio_t* handle)
    handle->progress = 0;
 }
 
-void nbio_begin_write(struct nbio_t* handle)
+static void nbio_stdio_begin_write(void *data)
 {
+   struct nbio_stdio_t* handle = (struct nbio_stdio_t*)data;
+
    if (!handle)
       return;
 
@@ -104,9 +108,10 @@ void nbio_begin_write(struct nbio_t* handle)
    handle->progress = 0;
 }
 
-bool nbio_iterate(struct nbio_t* handle)
+static bool nbio_stdio_iterate(void *data)
 {
-   size_t amount = 65536;
+   size_t amount               = 65536;
+   struct nbio_stdio_t* handle = (struct nbio_stdio_t*)data;
 
    if (!handle)
       return false;
@@ -146,8 +151,10 @@ bool nbio_iterate(struct nbio_t* handle)
    return (handle->op < 0);
 }
 
-void nbio_resize(struct nbio_t* handle, size_t len)
+static void nbio_stdio_resize(void *data, size_t len)
 {
+   struct nbio_stdio_t* handle = (struct nbio_stdio_t*)data;
+
    if (!handle)
       return;
 
@@ -168,8 +175,10 @@ void nbio_resize(struct nbio_t* handle, size_t len)
    handle->progress = handle->len;
 }
 
-void* nbio_get_ptr(struct nbio_t* handle, size_t* len)
+static void *nbio_stdio_get_ptr(void *data, size_t* len)
 {
+   struct nbio_stdio_t* handle = (struct nbio_stdio_t*)data;
+
    if (!handle)
       return NULL;
    if (len)
@@ -179,8 +188,10 @@ void* nbio_get_ptr(struct nbio_t* handle, size_t* len)
    return NULL;
 }
 
-void nbio_cancel(struct nbio_t* handle)
+static void nbio_stdio_cancel(void *data)
 {
+   struct nbio_stdio_t* handle = (struct nbio_stdio_t*)data;
+
    if (!handle)
       return;
 
@@ -188,8 +199,10 @@ void nbio_cancel(struct nbio_t* handle)
    handle->progress = handle->len;
 }
 
-void nbio_free(struct nbio_t* handle)
+static void nbio_stdio_free(void *data)
 {
+   struct nbio_stdio_t* handle = (struct nbio_stdio_t*)data;
+
    if (!handle)
       return;
    if (handle->op >= 0)
@@ -204,3 +217,15 @@ void nbio_free(struct nbio_t* handle)
    handle->data = NULL;
    free(handle);
 }
+
+nbio_intf_t nbio_stdio = {
+   nbio_stdio_open,
+   nbio_stdio_begin_read,
+   nbio_stdio_begin_write,
+   nbio_stdio_iterate,
+   nbio_stdio_resize,
+   nbio_stdio_get_ptr,
+   nbio_stdio_cancel,
+   nbio_stdio_free,
+   "stdio",
+};
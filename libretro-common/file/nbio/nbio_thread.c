@@ -0,0 +1,301 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (nbio_thread.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_CONFIG_H
+#include "../../../config.h"
+#endif
+
+#include <file/nbio.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+
+#define NBIO_THREAD_CHUNK (256 * 1024)
+
+struct nbio_thread_t
+{
+   FILE *f;
+   void *data;
+   size_t len;
+   sthread_t *thread;
+   /* Guards finished and cancel while the worker runs. */
+   slock_t *lock;
+   bool finished;
+   bool cancel;
+   /* Same values as in nbio_stdio. */
+   signed char op;
+   signed char mode;
+};
+
+static const char *nbio_thread_modes[] = { "rb", "wb", "r+b", "rb", "wb", "r+b" };
+
+static void nbio_thread_worker(void *data)
+{
+   size_t pos                   = 0;
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   while (pos < handle->len)
+   {
+      bool cancel;
+      size_t done;
+      size_t amount = handle->len - pos;
+
+      slock_lock(handle->lock);
+      cancel = handle->cancel;
+      slock_unlock(handle->lock);
+
+      if (cancel)
+         break;
+
+      if (amount > NBIO_THREAD_CHUNK)
+         amount = NBIO_THREAD_CHUNK;
+
+      if (handle->op == NBIO_READ)
+         done = fread((char*)handle->data + pos, 1, amount, handle->f);
+      else
+         done = fwrite((char*)handle->data + pos, 1, amount, handle->f);
+
+      if (done != amount)
+         break;
+
+      pos += amount;
+   }
+
+   if (handle->op == NBIO_WRITE)
+      fflush(handle->f);
+
+   slock_lock(handle->lock);
+   handle->finished = true;
+   slock_unlock(handle->lock);
+}
+
+static void *nbio_thread_open(const char * filename, unsigned mode)
+{
+   struct nbio_thread_t *handle = NULL;
+   FILE *f                      = fopen(filename, nbio_thread_modes[mode]);
+
+   if (!f)
+      return NULL;
+
+   handle = (struct nbio_thread_t*)calloc(1, sizeof(*handle));
+   if (!handle)
+      goto error;
+
+   handle->f    = f;
+   handle->lock = slock_new();
+   if (!handle->lock)
+      goto error;
+
+   switch (mode)
+   {
+      case NBIO_WRITE:
+      case BIO_WRITE:
+         break;
+      default:
+         fseek(handle->f, 0, SEEK_END);
+         handle->len = ftell(handle->f);
+         break;
+   }
+
+   handle->mode = mode;
+   handle->data = malloc(handle->len);
+
+   if (handle->len && !handle->data)
+      goto error;
+
+   handle->op   = -2;
+
+   return handle;
+
+error:
+   if (handle)
+   {
+      if (handle->lock)
+         slock_free(handle->lock);
+      free(handle->data);
+      free(handle);
+   }
+   fclose(f);
+   return NULL;
+}
+
+static void nbio_thread_begin(struct nbio_thread_t *handle, signed char op)
+{
+   fseek(handle->f, 0, SEEK_SET);
+
+   handle->op       = op;
+   handle->finished = false;
+   handle->cancel   = false;
+   handle->thread   = sthread_create(nbio_thread_worker, handle);
+
+   /* Without a worker, do the whole transfer right away. */
+   if (!handle->thread)
+      nbio_thread_worker(handle);
+}
+
+static void nbio_thread_begin_read(void *data)
+{
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file read operation while busy");
+      abort();
+   }
+
+   nbio_thread_begin(handle, NBIO_READ);
+}
+
+static void nbio_thread_begin_write(void *data)
+{
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file write operation while busy");
+      abort();
+   }
+
+   nbio_thread_begin(handle, NBIO_WRITE);
+}
+
+static bool nbio_thread_iterate(void *data)
+{
+   bool finished;
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   if (!handle)
+      return false;
+
+   if (handle->op < 0)
+      return true;
+
+   slock_lock(handle->lock);
+   finished = handle->finished;
+   slock_unlock(handle->lock);
+
+   if (!finished)
+      return false;
+
+   if (handle->thread)
+      sthread_join(handle->thread);
+
+   handle->thread = NULL;
+   handle->op     = -1;
+   return true;
+}
+
+static void nbio_thread_resize(void *data, size_t len)
+{
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file resize operation while busy");
+      abort();
+   }
+   if (len < handle->len)
+   {
+      puts("ERROR - attempted file shrink operation, not implemented");
+      abort();
+   }
+
+   handle->len  = len;
+   handle->data = realloc(handle->data, handle->len);
+   handle->op   = -1;
+}
+
+static void *nbio_thread_get_ptr(void *data, size_t* len)
+{
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   if (!handle)
+      return NULL;
+   if (len)
+      *len = handle->len;
+   if (handle->op == -1)
+      return handle->data;
+   return NULL;
+}
+
+static void nbio_thread_cancel(void *data)
+{
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   if (!handle)
+      return;
+
+   if (handle->thread)
+   {
+      slock_lock(handle->lock);
+      handle->cancel = true;
+      slock_unlock(handle->lock);
+
+      sthread_join(handle->thread);
+      handle->thread = NULL;
+   }
+
+   handle->op = -1;
+}
+
+static void nbio_thread_free(void *data)
+{
+   struct nbio_thread_t *handle = (struct nbio_thread_t*)data;
+
+   if (!handle)
+      return;
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted free() while busy");
+      abort();
+   }
+
+   fclose(handle->f);
+   slock_free(handle->lock);
+   free(handle->data);
+   free(handle);
+}
+
+nbio_intf_t nbio_thread = {
+   nbio_thread_open,
+   nbio_thread_begin_read,
+   nbio_thread_begin_write,
+   nbio_thread_iterate,
+   nbio_thread_resize,
+   nbio_thread_get_ptr,
+   nbio_thread_cancel,
+   nbio_thread_free,
+   "thread",
+};
+#endif
@@ -33,6 +33,23 @@
 #include <malloc.h>
 #endif
 
+#ifdef RPNG_NO_SIMD
+#undef __SSE2__
+#undef __SSSE3__
+#undef __ARM_NEON__
+#undef __ARM_NEON
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RPNG_NEON
+#endif
+
 enum png_chunk_type png_chunk_type(const struct png_chunk *chunk)
 {
    unsigned i;
@@ -125,14 +142,287 @@ end:
    return ret;
 }
 
+#if defined(__SSE2__) || defined(RPNG_NEON)
+/* Unaligned 4-byte accesses, one pixel of a 3 or 4 bpp
+ * scanline. For 3 bpp the fourth byte is don't-care. */
+static INLINE uint32_t png_load32(const uint8_t *p)
+{
+   uint32_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static INLINE void png_store32(uint8_t *p, uint32_t v)
+{
+   memcpy(p, &v, sizeof(v));
+}
+#endif
+
+#if defined(__SSE2__)
+static INLINE __m128i png_load32_sse2(const uint8_t *p)
+{
+   return _mm_cvtsi32_si128((int)png_load32(p));
+}
+
+static INLINE void png_store32_sse2(uint8_t *p, __m128i v)
+{
+   png_store32(p, (uint32_t)_mm_cvtsi128_si32(v));
+}
+
+static INLINE __m128i png_abs_epi16_sse2(__m128i x)
+{
+   return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static INLINE __m128i png_select_sse2(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#elif defined(RPNG_NEON)
+static INLINE uint8x8_t png_load32_neon(const uint8_t *p)
+{
+   return vreinterpret_u8_u32(vdup_n_u32(png_load32(p)));
+}
+
+static INLINE void png_store32_neon(uint8_t *p, uint8x8_t v)
+{
+   png_store32(p, vget_lane_u32(vreinterpret_u32_u8(v), 0));
+}
+
+static INLINE uint8x8_t png_paeth_neon(uint8x8_t a, uint8x8_t b, uint8x8_t c)
+{
+   uint16x8_t pa = vabdl_u8(b, c);
+   uint16x8_t pb = vabdl_u8(a, c);
+   uint16x8_t pc = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+   uint8x8_t  use_a = vmovn_u16(vandq_u16(vcleq_u16(pa, pb),
+            vcleq_u16(pa, pc)));
+   uint8x8_t  use_b = vmovn_u16(vcleq_u16(pb, pc));
+
+   return vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+}
+#endif
+
+/* Reverse filters for one scanline. @line holds the filtered
+ * bytes, @prev the previous reconstructed scanline (all zero
+ * for the first one) and @out receives the reconstructed bytes.
+ *
+ * The vectorized paths cover 3 and 4 byte pixels (8-bit RGB
+ * and RGBA), which is what wallpapers, thumbnails and overlays
+ * almost always are. Everything else takes the byte loops. */
+static void png_reverse_filter_sub(uint8_t *out, const uint8_t *line,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   if (bpp == 4)
+   {
+      __m128i a = _mm_setzero_si128();
+
+      /* Prefix sum of four pixels per iteration. */
+      for (; i + 16 <= pitch; i += 16)
+      {
+         __m128i x = _mm_loadu_si128((const __m128i*)(line + i));
+         x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+         x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+         x = _mm_add_epi8(x, a);
+         _mm_storeu_si128((__m128i*)(out + i), x);
+         a = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+      }
+   }
+   else if (bpp == 3)
+   {
+      __m128i a = _mm_setzero_si128();
+
+      for (; i + 4 <= pitch; i += 3)
+      {
+         a = _mm_add_epi8(a, png_load32_sse2(line + i));
+         png_store32_sse2(out + i, a);
+      }
+   }
+
+   if (i)
+   {
+      for (; i < pitch; i++)
+         out[i] = out[i - bpp] + line[i];
+      return;
+   }
+#elif defined(RPNG_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+
+      for (; i + 4 <= pitch; i += bpp)
+      {
+         a = vadd_u8(a, png_load32_neon(line + i));
+         png_store32_neon(out + i, a);
+      }
+
+      for (; i < pitch; i++)
+         out[i] = out[i - bpp] + line[i];
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = line[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = out[i - bpp] + line[i];
+}
+
+static void png_reverse_filter_up(uint8_t *out, const uint8_t *line,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
+   {
+      __m128i x = _mm_loadu_si128((const __m128i*)(line + i));
+      __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(x, b));
+   }
+#elif defined(RPNG_NEON)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(line + i), vld1q_u8(prev + i)));
+#endif
+
+   for (; i < pitch; i++)
+      out[i] = prev[i] + line[i];
+}
+
+static void png_reverse_filter_avg(uint8_t *out, const uint8_t *line,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      const __m128i one = _mm_set1_epi8(1);
+      __m128i a         = _mm_setzero_si128();
+
+      for (; i + 4 <= pitch; i += bpp)
+      {
+         __m128i b   = png_load32_sse2(prev + i);
+         /* _mm_avg_epu8 rounds up, PNG rounds down. */
+         __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+               _mm_and_si128(_mm_xor_si128(a, b), one));
+         a           = _mm_add_epi8(avg, png_load32_sse2(line + i));
+         png_store32_sse2(out + i, a);
+      }
+   }
+#elif defined(RPNG_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+
+      for (; i + 4 <= pitch; i += bpp)
+      {
+         a = vadd_u8(vhadd_u8(a, png_load32_neon(prev + i)),
+               png_load32_neon(line + i));
+         png_store32_neon(out + i, a);
+      }
+   }
+#endif
+
+   for (; i < bpp && i < pitch; i++)
+      out[i] = (prev[i] >> 1) + line[i];
+   for (; i < pitch; i++)
+      out[i] = ((out[i - bpp] + prev[i]) >> 1) + line[i];
+}
+
+static void png_reverse_filter_paeth(uint8_t *out, const uint8_t *line,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i a          = zero;
+      __m128i c          = zero;
+
+      for (; i + 4 <= pitch; i += bpp)
+      {
+         /* Widened to 16 bits, as p = a + b - c overflows. */
+         __m128i b        = _mm_unpacklo_epi8(png_load32_sse2(prev + i), zero);
+         __m128i pa       = png_abs_epi16_sse2(_mm_sub_epi16(b, c));
+         __m128i pb       = png_abs_epi16_sse2(_mm_sub_epi16(a, c));
+         __m128i pc       = png_abs_epi16_sse2(_mm_add_epi16(
+                  _mm_sub_epi16(b, c), _mm_sub_epi16(a, c)));
+         __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+         /* Ties favor a over b over c. */
+         __m128i pred     = png_select_sse2(_mm_cmpeq_epi16(smallest, pa), a,
+               png_select_sse2(_mm_cmpeq_epi16(smallest, pb), b, c));
+         __m128i x        = _mm_add_epi8(_mm_packus_epi16(pred, pred),
+               png_load32_sse2(line + i));
+
+         png_store32_sse2(out + i, x);
+         a = _mm_unpacklo_epi8(x, zero);
+         c = b;
+      }
+   }
+#elif defined(RPNG_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+      uint8x8_t c = vdup_n_u8(0);
+
+      for (; i + 4 <= pitch; i += bpp)
+      {
+         uint8x8_t b = png_load32_neon(prev + i);
+         a = vadd_u8(png_paeth_neon(a, b, c), png_load32_neon(line + i));
+         png_store32_neon(out + i, a);
+         c = b;
+      }
+   }
+#endif
+
+   for (; i < bpp && i < pitch; i++)
+      out[i] = paeth(0, prev[i], 0) + line[i];
+   for (; i < pitch; i++)
+      out[i] = paeth(out[i - bpp], prev[i], prev[i - bpp]) + line[i];
+}
+
 static void png_reverse_filter_copy_line_rgb(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+   if (bpp == 1)
+   {
+#if defined(__SSSE3__)
+      const __m128i shuf  = _mm_setr_epi8(
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+      const __m128i alpha = _mm_set1_epi32((int)0xff000000u);
+
+      /* Four pixels per iteration, 16 bytes must be readable. */
+      for (; i + 6 <= width; i += 4, decoded += 12)
+      {
+         __m128i x = _mm_loadu_si128((const __m128i*)decoded);
+         _mm_storeu_si128((__m128i*)(data + i),
+               _mm_or_si128(_mm_shuffle_epi8(x, shuf), alpha));
+      }
+#elif defined(RPNG_NEON)
+      for (; i + 8 <= width; i += 8, decoded += 24)
+      {
+         uint8x8x3_t rgb = vld3_u8(decoded);
+         uint8x8x4_t bgra;
+
+         bgra.val[0] = rgb.val[2];
+         bgra.val[1] = rgb.val[1];
+         bgra.val[2] = rgb.val[0];
+         bgra.val[3] = vdup_n_u8(0xff);
+         vst4_u8((uint8_t*)(data + i), bgra);
+      }
+#endif
+   }
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b;
 
@@ -149,11 +439,40 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+   if (bpp == 1)
+   {
+#if defined(__SSE2__)
+      const __m128i ga_mask = _mm_set1_epi32((int)0xff00ff00u);
+      const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+
+      /* RGBA bytes to ARGB words is a swap of R and B. */
+      for (; i + 4 <= width; i += 4, decoded += 16)
+      {
+         __m128i x  = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i rb = _mm_and_si128(x, rb_mask);
+         rb         = _mm_or_si128(_mm_slli_epi32(rb, 16),
+               _mm_srli_epi32(rb, 16));
+         _mm_storeu_si128((__m128i*)(data + i),
+               _mm_or_si128(_mm_and_si128(x, ga_mask), rb));
+      }
+#elif defined(RPNG_NEON)
+      for (; i + 8 <= width; i += 8, decoded += 32)
+      {
+         uint8x8x4_t rgba = vld4_u8(decoded);
+         uint8x8_t r      = rgba.val[0];
+
+         rgba.val[0] = rgba.val[2];
+         rgba.val[2] = r;
+         vst4_u8((uint8_t*)(data + i), rgba);
+      }
+#endif
+   }
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -394,41 +713,26 @@ error:
 static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
       struct rpng_process_t *pngp, unsigned filter)
 {
-   unsigned i;
-
    switch (filter)
    {
       case PNG_FILTER_NONE:
          memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
          break;
       case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+         png_reverse_filter_sub(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_reverse_filter_up(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->prev_scanline, pngp->pitch);
          break;
       case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
-         {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
+         png_reverse_filter_avg(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+         png_reverse_filter_paeth(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
 
       default:
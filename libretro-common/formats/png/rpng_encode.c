@@ -24,6 +24,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include "rpng_internal.h"
 
 #undef GOTO_END_ERROR
@@ -203,78 +207,87 @@ static unsigned filter_paeth(uint8_t *target,
    return count_sad(target, width);
 }
 
-static bool rpng_save_image(const char *path,
-      const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
-{
-   unsigned h;
-   bool ret = true;
-   struct png_ihdr ihdr = {0};
-
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
-   void *stream            = NULL;
-
-   FILE *file = fopen(path, "wb");
-   if (!file)
-      GOTO_END_ERROR();
-
-   if (fwrite(png_magic, 1, sizeof(png_magic), file) != sizeof(png_magic))
-      GOTO_END_ERROR();
+/* Rows handed to each encoder thread at minimum;
+ * smaller chunks cost more in flush overhead than
+ * they gain in parallelism. */
+#define RPNG_ENCODE_MIN_CHUNK_ROWS 32
 
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr(file, &ihdr))
-      GOTO_END_ERROR();
-
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
+struct rpng_encode_chunk
+{
+   const uint8_t *data;
+   /* Source row above the first row of this chunk, or NULL. */
+   const uint8_t *prev_data;
+   uint8_t *filtered;
+   size_t filtered_size;
+   uint8_t *deflated;
+   size_t deflated_size;
+   uint32_t adler;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   unsigned bpp;
+   int level;
+   bool last;
+   bool ret;
+};
+
+static void copy_line(uint8_t *dst, const uint8_t *src,
+      unsigned width, unsigned bpp)
+{
+   if (bpp == sizeof(uint32_t))
+      copy_argb_line(dst, (const uint32_t*)src, width);
+   else
+      copy_bgr24_line(dst, src, width);
+}
 
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
+/**
+ * png_filter_chunk:
+ * @chunk           : chunk of rows to filter
+ *
+ * Filters every row of @chunk into chunk->filtered.
+ * Rows only depend on the unfiltered row above, so
+ * chunks can be filtered independently.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool png_filter_chunk(struct rpng_encode_chunk *chunk)
+{
+   unsigned h;
+   bool ret                = true;
+   unsigned line_size      = chunk->width * chunk->bpp;
+   const uint8_t *data     = chunk->data;
+   uint8_t *encode_target  = chunk->filtered;
+   uint8_t *rgba_line      = (uint8_t*)malloc(line_size);
+   uint8_t *prev_encoded   = (uint8_t*)calloc(1, line_size);
+   uint8_t *up_filtered    = (uint8_t*)malloc(line_size);
+   uint8_t *sub_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *avg_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *paeth_filtered = (uint8_t*)malloc(line_size);
+
+   if (!rgba_line || !prev_encoded || !up_filtered
+         || !sub_filtered || !avg_filtered || !paeth_filtered)
       GOTO_END_ERROR();
 
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
+   if (chunk->prev_data)
+      copy_line(prev_encoded, chunk->prev_data, chunk->width, chunk->bpp);
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+   for (h = 0; h < chunk->height;
+         h++, encode_target += line_size, data += chunk->pitch)
    {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
-      else
-         copy_bgr24_line(rgba_line, data, width);
+      copy_line(rgba_line, data, chunk->width, chunk->bpp);
 
       /* Try every filtering method, and choose the method
        * which has most entries as zero.
        *
        * This is probably not very optimal, but it's very 
        * simple to implement.
+       *
+       * Low effort levels only try the cheap filters.
        */
       {
-         unsigned none_score  = count_sad(rgba_line, width * bpp);
-         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
-         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
+         unsigned none_score  = count_sad(rgba_line, line_size);
+         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, chunk->width, chunk->bpp);
+         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, chunk->width, chunk->bpp);
 
          uint8_t filter       = 0;
          unsigned min_sad     = none_score;
@@ -294,56 +307,251 @@ static bool rpng_save_image(const char *path,
             min_sad = up_score;
          }
 
-         if (avg_score < min_sad)
-         {
-            filter = 3;
-            chosen_filtered = avg_filtered;
-            min_sad = avg_score;
-         }
-
-         if (paeth_score < min_sad)
+         if (chunk->level > 3)
          {
-            filter = 4;
-            chosen_filtered = paeth_filtered;
-            min_sad = paeth_score;
+            unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, chunk->width, chunk->bpp);
+            unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, chunk->width, chunk->bpp);
+
+            if (avg_score < min_sad)
+            {
+               filter = 3;
+               chosen_filtered = avg_filtered;
+               min_sad = avg_score;
+            }
+
+            if (paeth_score < min_sad)
+            {
+               filter = 4;
+               chosen_filtered = paeth_filtered;
+               min_sad = paeth_score;
+            }
          }
 
          *encode_target++ = filter;
-         memcpy(encode_target, chosen_filtered, width * bpp);
+         memcpy(encode_target, chosen_filtered, line_size);
 
-         memcpy(prev_encoded, rgba_line, width * bpp);
+         memcpy(prev_encoded, rgba_line, line_size);
       }
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
-      GOTO_END_ERROR();
+end:
+   free(rgba_line);
+   free(prev_encoded);
+   free(up_filtered);
+   free(sub_filtered);
+   free(avg_filtered);
+   free(paeth_filtered);
+   return ret;
+}
+
+/**
+ * png_deflate_chunk:
+ * @chunk           : filtered chunk of rows
+ *
+ * Compresses chunk->filtered as raw deflate data. All chunks
+ * but the last are ended with a sync flush, so the outputs can
+ * simply be concatenated into one stream (like pigz does).
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool png_deflate_chunk(struct rpng_encode_chunk *chunk)
+{
+   bool ret         = true;
+   size_t bound     = chunk->filtered_size
+      + (chunk->filtered_size >> 10) + 64;
+   void *stream     = zlib_stream_new();
 
-   stream = zlib_stream_new();
+   chunk->deflated  = (uint8_t*)malloc(bound);
 
-   if (!stream)
+   if (!stream || !chunk->deflated)
+      GOTO_END_ERROR();
+
+   if (!zlib_deflate_init2(stream, chunk->level))
       GOTO_END_ERROR();
 
    zlib_set_stream(
          stream,
-         encode_buf_size,
-         encode_buf_size * 2,
-         encode_buf,
-         deflate_buf + 8);
+         chunk->filtered_size,
+         bound,
+         chunk->filtered,
+         chunk->deflated);
+
+   if (chunk->last)
+      ret = zlib_deflate_data_to_file(stream) == 1;
+   else
+      ret = zlib_deflate_data_flush(stream) == 1;
+
+   chunk->deflated_size = zlib_stream_get_total_out(stream);
+   zlib_stream_deflate_free(stream);
 
-   zlib_deflate_init(stream, 9);
+   if (!ret)
+      GOTO_END_ERROR();
+
+   chunk->adler = zlib_adler32_calculate(chunk->filtered,
+         chunk->filtered_size);
 
-   if (zlib_deflate_data_to_file(stream) != 1)
+end:
+   free(stream);
+   return ret;
+}
+
+static void png_encode_chunk(void *data)
+{
+   struct rpng_encode_chunk *chunk = (struct rpng_encode_chunk*)data;
+
+   chunk->ret = png_filter_chunk(chunk) && png_deflate_chunk(chunk);
+}
+
+static uint8_t png_zlib_header_flags(int level)
+{
+   /* FLEVEL as defined by RFC 1950, with FCHECK making
+    * the header a multiple of 31. */
+   if (level < 2)
+      return 0x01;
+   if (level < 6)
+      return 0x5e;
+   if (level == 6)
+      return 0x9c;
+   return 0xda;
+}
+
+static bool rpng_save_image(const char *path,
+      const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp,
+      const struct rpng_encode_opts *opts)
+{
+   unsigned i;
+   bool ret = true;
+   struct png_ihdr ihdr = {0};
+
+   size_t encode_buf_size  = 0;
+   size_t deflate_size     = 0;
+   uint32_t adler          = 1;
+   unsigned num_chunks     = 1;
+   int level               = 9;
+   uint8_t *encode_buf     = NULL;
+   uint8_t *deflate_buf    = NULL;
+   uint8_t *deflate_target = NULL;
+   struct rpng_encode_chunk *chunks = NULL;
+#ifdef HAVE_THREADS
+   sthread_t **threads     = NULL;
+#endif
+
+   FILE *file = fopen(path, "wb");
+   if (!file)
+      GOTO_END_ERROR();
+
+   if (fwrite(png_magic, 1, sizeof(png_magic), file) != sizeof(png_magic))
+      GOTO_END_ERROR();
+
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr(file, &ihdr))
+      GOTO_END_ERROR();
+
+   if (opts)
    {
-      zlib_stream_deflate_free(stream);
+      level = opts->level;
+      if (level < 1)
+         level = 1;
+      else if (level > 9)
+         level = 9;
+
+#ifdef HAVE_THREADS
+      if (opts->threads > 1)
+      {
+         num_chunks = opts->threads;
+         if (num_chunks > height / RPNG_ENCODE_MIN_CHUNK_ROWS)
+            num_chunks = height / RPNG_ENCODE_MIN_CHUNK_ROWS;
+         if (num_chunks < 1)
+            num_chunks = 1;
+      }
+#endif
+   }
+
+   encode_buf_size = (width * bpp + 1) * height;
+   encode_buf = (uint8_t*)malloc(encode_buf_size);
+   if (!encode_buf)
+      GOTO_END_ERROR();
+
+   chunks = (struct rpng_encode_chunk*)calloc(num_chunks, sizeof(*chunks));
+   if (!chunks)
       GOTO_END_ERROR();
+
+   for (i = 0; i < num_chunks; i++)
+   {
+      unsigned y = (uint64_t)height * i / num_chunks;
+
+      chunks[i].data          = data + y * pitch;
+      chunks[i].prev_data     = y ? data + (y - 1) * pitch : NULL;
+      chunks[i].height        = (uint64_t)height * (i + 1) / num_chunks - y;
+      chunks[i].filtered      = encode_buf + y * (width * bpp + 1);
+      chunks[i].filtered_size = chunks[i].height * (width * bpp + 1);
+      chunks[i].width         = width;
+      chunks[i].pitch         = pitch;
+      chunks[i].bpp           = bpp;
+      chunks[i].level         = level;
+      chunks[i].last          = i == num_chunks - 1;
    }
 
-   zlib_stream_deflate_free(stream);
+#ifdef HAVE_THREADS
+   /* The calling thread encodes the first chunk itself. */
+   if (num_chunks > 1)
+   {
+      threads = (sthread_t**)calloc(num_chunks, sizeof(*threads));
+      if (!threads)
+         GOTO_END_ERROR();
+
+      for (i = 1; i < num_chunks; i++)
+         threads[i] = sthread_create(png_encode_chunk, &chunks[i]);
+   }
+
+   png_encode_chunk(&chunks[0]);
+
+   for (i = 1; i < num_chunks; i++)
+   {
+      if (threads[i])
+         sthread_join(threads[i]);
+      else
+         png_encode_chunk(&chunks[i]);
+   }
+#else
+   png_encode_chunk(&chunks[0]);
+#endif
+
+   for (i = 0; i < num_chunks; i++)
+   {
+      if (!chunks[i].ret)
+         GOTO_END_ERROR();
+
+      deflate_size += chunks[i].deflated_size;
+      adler         = zlib_adler32_combine(adler,
+            chunks[i].adler, chunks[i].filtered_size);
+   }
+
+   /* IDAT length + type, zlib header, chunks, Adler-32 trailer. */
+   deflate_buf = (uint8_t*)malloc(8 + 2 + deflate_size + 4);
+   if (!deflate_buf)
+      GOTO_END_ERROR();
+
+   deflate_target    = deflate_buf + 8;
+   *deflate_target++ = 0x78;
+   *deflate_target++ = png_zlib_header_flags(level);
+
+   for (i = 0; i < num_chunks; i++)
+   {
+      memcpy(deflate_target, chunks[i].deflated, chunks[i].deflated_size);
+      deflate_target += chunks[i].deflated_size;
+   }
+
+   dword_write_be(deflate_target, adler);
+   deflate_size += 2 + 4;
 
    memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0, zlib_stream_get_total_out(stream));
-   if (!png_write_idat(file, deflate_buf, zlib_stream_get_total_out(stream) + 8))
+   dword_write_be(deflate_buf + 0, deflate_size);
+   if (!png_write_idat(file, deflate_buf, deflate_size + 8))
       GOTO_END_ERROR();
 
    if (!png_write_iend(file))
@@ -352,16 +560,17 @@ static bool rpng_save_image(const char *path,
 end:
    if (file)
       fclose(file);
+   if (chunks)
+   {
+      for (i = 0; i < num_chunks; i++)
+         free(chunks[i].deflated);
+   }
+#ifdef HAVE_THREADS
+   free(threads);
+#endif
+   free(chunks);
    free(encode_buf);
    free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
-
-   zlib_stream_free(stream);
    return ret;
 }
 
@@ -369,14 +578,30 @@ bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, sizeof(uint32_t));
+         width, height, pitch, sizeof(uint32_t), NULL);
 }
 
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, 3);
+         width, height, pitch, 3, NULL);
+}
+
+bool rpng_save_image_argb_opts(const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch,
+      const struct rpng_encode_opts *opts)
+{
+   return rpng_save_image(path, (const uint8_t*)data,
+         width, height, pitch, sizeof(uint32_t), opts);
+}
+
+bool rpng_save_image_bgr24_opts(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch,
+      const struct rpng_encode_opts *opts)
+{
+   return rpng_save_image(path, (const uint8_t*)data,
+         width, height, pitch, 3, opts);
 }
 
 #endif
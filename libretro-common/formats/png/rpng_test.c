@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #ifdef HAVE_IMLIB2
 #include <Imlib2.h>
 #endif
@@ -267,13 +268,95 @@ static int test_blocking_rpng(const char *in_path)
    return 0;
 }
 
+#define RPNG_BENCH_ITERATIONS 20
+
+static long bench_file_size(const char *path)
+{
+   long len;
+   FILE *file = fopen(path, "rb");
+
+   if (!file)
+      return -1;
+
+   fseek(file, 0, SEEK_END);
+   len = ftell(file);
+   fclose(file);
+
+   return len;
+}
+
+/* Decodes every file in @paths several times and
+ * reports throughput, both in compressed input and
+ * in decoded ARGB output. */
+static int bench_rpng(char *paths[], int num_paths)
+{
+   int i;
+   double total_secs     = 0.0;
+   double total_in       = 0.0;
+   double total_out      = 0.0;
+
+   for (i = 0; i < num_paths; i++)
+   {
+      unsigned j;
+      double secs        = 0.0;
+      double in_bytes    = 0.0;
+      double out_bytes   = 0.0;
+      long file_len      = bench_file_size(paths[i]);
+
+      if (file_len < 0)
+      {
+         fprintf(stderr, "Could not open %s.\n", paths[i]);
+         return 1;
+      }
+
+      for (j = 0; j < RPNG_BENCH_ITERATIONS; j++)
+      {
+         uint32_t *data  = NULL;
+         unsigned width  = 0;
+         unsigned height = 0;
+         clock_t start   = clock();
+
+         if (!rpng_load_image_argb(paths[i], &data, &width, &height))
+         {
+            fprintf(stderr, "Failed to decode %s.\n", paths[i]);
+            return 2;
+         }
+
+         secs      += (double)(clock() - start) / CLOCKS_PER_SEC;
+         in_bytes  += file_len;
+         out_bytes += (double)width * height * sizeof(uint32_t);
+         free(data);
+      }
+
+      if (secs > 0.0)
+         fprintf(stderr, "%s: %.2f MB/s in, %.2f MB/s out.\n", paths[i],
+               in_bytes / secs / 1e6, out_bytes / secs / 1e6);
+
+      total_secs += secs;
+      total_in   += in_bytes;
+      total_out  += out_bytes;
+   }
+
+   if (total_secs > 0.0)
+      fprintf(stderr, "Total (%d files, %d runs each): %.2f MB/s in, %.2f MB/s out.\n",
+            num_paths, RPNG_BENCH_ITERATIONS,
+            total_in / total_secs / 1e6, total_out / total_secs / 1e6);
+
+   return 0;
+}
+
 int main(int argc, char *argv[])
 {
    const char *in_path = "/tmp/test.png";
 
+   if (argc > 2 && !strcmp(argv[1], "--bench"))
+      return bench_rpng(argv + 2, argc - 2);
+
    if (argc > 2)
    {
       fprintf(stderr, "Usage: %s <png file>\n", argv[0]);
+      fprintf(stderr, "       %s --bench <png files...>\n", argv[0]);
+      fprintf(stderr, "Benchmark with a build at the default OPT=-O2.\n");
       return 1;
    }
 
@@ -38,6 +38,8 @@ struct config_entry_list
    /* If we got this from an #include,
     * do not allow overwrite. */
    bool readonly;
+   /* Value was set after loading and is not part of the arena. */
+   bool value_allocated;
    char *key;
    char *value;
    uint32_t key_hash;
@@ -51,6 +53,8 @@ struct config_include_list
    struct config_include_list *next;
 };
 
+struct config_arena_block;
+
 struct config_file
 {
    char *path;
@@ -59,6 +63,15 @@ struct config_file
    unsigned include_depth;
 
    struct config_include_list *includes;
+
+   /* Open addressing hash table over entries, holding the
+    * first entry of each key in list order. */
+   struct config_entry_list **index;
+   size_t index_size;
+   size_t index_count;
+
+   /* Entries, keys and values get carved out of these blocks. */
+   struct config_arena_block *arena;
 };
 
 typedef struct config_file config_file_t;
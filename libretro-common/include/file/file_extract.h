@@ -63,6 +63,11 @@ uint32_t zlib_crc32_calculate(const uint8_t *data, size_t length);
 
 uint32_t zlib_crc32_adjust(uint32_t crc, uint8_t data);
 
+uint32_t zlib_adler32_calculate(const uint8_t *data, size_t length);
+
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t length2);
+
 /**
  * zlib_parse_file:
  * @file                        : filename path of archive
@@ -147,6 +152,14 @@ void zlib_deflate_init(void *data, int level);
 
 int zlib_deflate_data_to_file(void *data);
 
+/* Raw deflate (no zlib header/trailer), for callers
+ * assembling a stream out of several chunks. */
+bool zlib_deflate_init2(void *data, int level);
+
+/* Compresses all input with Z_SYNC_FLUSH, leaving the
+ * output byte-aligned so another raw chunk may follow. */
+int zlib_deflate_data_flush(void *data);
+
 void zlib_stream_deflate_free(void *data);
 
 bool zlib_inflate_init(void *data);
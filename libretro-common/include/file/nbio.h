@@ -48,6 +48,32 @@
 
 struct nbio_t;
 
+/*
+ * Backend behind the nbio_* functions. nbio_open tries the
+ * asynchronous backends first and falls back to nbio_stdio.
+ */
+typedef struct nbio_intf
+{
+   void *(*open)(const char *filename, unsigned mode);
+   void (*begin_read)(void *data);
+   void (*begin_write)(void *data);
+   bool (*iterate)(void *data);
+   void (*resize)(void *data, size_t len);
+   void *(*get_ptr)(void *data, size_t *len);
+   void (*cancel)(void *data);
+   void (*free)(void *data);
+   const char *ident;
+} nbio_intf_t;
+
+/* Reads and writes in chunks on the calling thread. */
+extern nbio_intf_t nbio_stdio;
+
+/* Queues several aligned chunks at once through io_uring. */
+extern nbio_intf_t nbio_io_uring;
+
+/* Reads and writes on a worker thread. */
+extern nbio_intf_t nbio_thread;
+
 /*
  * Creates an nbio structure for performing the given operation on the given file.
  */
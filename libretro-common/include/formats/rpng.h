@@ -56,10 +56,29 @@ int rpng_nbio_load_image_argb_process(struct rpng_t *rpng,
 bool rpng_nbio_load_image_argb_start(struct rpng_t *rpng);
 
 #ifdef HAVE_ZLIB_DEFLATE
+/* Encoder speed/size tradeoff. */
+struct rpng_encode_opts
+{
+   /* Deflate level, 1 (fastest) to 9 (smallest).
+    * Levels 3 and below only try the None, Sub and
+    * Up filters on each row. */
+   int level;
+   /* Number of threads filtering and deflating rows.
+    * The image is split into one independently deflated
+    * chunk per thread. Ignored without HAVE_THREADS. */
+   unsigned threads;
+};
+
 bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch);
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch);
+bool rpng_save_image_argb_opts(const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch,
+      const struct rpng_encode_opts *opts);
+bool rpng_save_image_bgr24_opts(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch,
+      const struct rpng_encode_opts *opts);
 #endif
 
 #ifdef __cplusplus
@@ -1,3 +1,7 @@
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#endif
+
 #include "libretrodb.h"
 
 #include <sys/types.h>
@@ -11,21 +15,32 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#if defined(HAVE_MMAP) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 
 #include <stdio.h>
 
 #include "rmsgpack_dom.h"
 #include "rmsgpack.h"
-#include "bintree.h"
 #include "libretrodb_endian.h"
 #include "query.h"
 
-struct node_iter_ctx
+/* Index entries are stored as fixed-stride records, sorted by key:
+ * the key, zero padded to key_size, then the item offset. */
+#define INDEX_STRIDE(idx) ((idx)->key_size + sizeof(uint64_t))
+
+struct index_entry
 {
-   libretrodb_t *db;
-   libretrodb_index_t *idx;
+   /* Points into the database image, or NULL for integer keys. */
+   const uint8_t *key;
+   uint8_t num[8];
+   uint32_t len;
+   uint64_t offset;
 };
 
+#define INDEX_ENTRY_KEY(e) ((e)->key ? (e)->key : (e)->num)
+
 static struct rmsgpack_dom_value sentinal;
 
 static INLINE off_t flseek(FILE *fp, int offset, int whence)
@@ -125,24 +140,123 @@ clean:
    return rv;
 }
 
-static int libretrodb_read_index_header(FILE *fp, libretrodb_index_t *idx)
+static int libretrodb_read_index_header(const libretrodb_t *db,
+      const uint8_t **ptr, libretrodb_index_t *idx)
 {
-   uint64_t name_len = 50;
-   return rmsgpack_dom_read_into(fp,
-         "name", idx->name, &name_len,
-         "key_size", &idx->key_size,
-         "next", &idx->next, NULL);
+   struct rmsgpack_view header, value;
+   const uint8_t *end = db->data + db->size;
+
+   if (rmsgpack_view_read(ptr, end, &header) < 0)
+      return -EINVAL;
+
+   if (rmsgpack_view_map_find(&header, "name", &value) < 0
+         || value.type != RDT_STRING
+         || value.len >= sizeof(idx->name))
+      return -EINVAL;
+   memcpy(idx->name, value.data, value.len);
+   idx->name[value.len] = '\0';
+
+   idx->field[0] = '\0';
+   if (rmsgpack_view_map_find(&header, "field", &value) == 0
+         && value.type == RDT_STRING
+         && value.len < sizeof(idx->field))
+   {
+      memcpy(idx->field, value.data, value.len);
+      idx->field[value.len] = '\0';
+   }
+
+   /* Small integers are stored as fixints, which read back signed. */
+   if (rmsgpack_view_map_find(&header, "key_size", &value) < 0
+         || (value.type != RDT_UINT && value.type != RDT_INT))
+      return -EINVAL;
+   idx->key_size = value.val.uint_;
+
+   if (rmsgpack_view_map_find(&header, "next", &value) < 0
+         || (value.type != RDT_UINT && value.type != RDT_INT))
+      return -EINVAL;
+   idx->next = value.val.uint_;
+
+   /* Indexes from before integer and string keys are binary. */
+   idx->type = RDT_BINARY;
+   if (rmsgpack_view_map_find(&header, "type", &value) == 0
+         && (value.type == RDT_UINT || value.type == RDT_INT))
+      idx->type = (enum rmsgpack_dom_type)value.val.uint_;
+
+   if (idx->key_size == 0 || idx->next > (uint64_t)(end - *ptr))
+      return -EINVAL;
+
+   idx->entries = *ptr;
+   idx->count   = idx->next / INDEX_STRIDE(idx);
+   return 0;
 }
 
 static void libretrodb_write_index_header(FILE *fp, libretrodb_index_t * idx)
 {
-   rmsgpack_write_map_header(fp, 3);
+   rmsgpack_write_map_header(fp, 5);
    rmsgpack_write_string(fp, "name", strlen("name"));
    rmsgpack_write_string(fp, idx->name, strlen(idx->name));
+   rmsgpack_write_string(fp, "field", strlen("field"));
+   rmsgpack_write_string(fp, idx->field, strlen(idx->field));
    rmsgpack_write_string(fp, "key_size", strlen("key_size"));
    rmsgpack_write_uint(fp, idx->key_size);
    rmsgpack_write_string(fp, "next", strlen("next"));
    rmsgpack_write_uint(fp, idx->next);
+   rmsgpack_write_string(fp, "type", strlen("type"));
+   rmsgpack_write_uint(fp, idx->type);
+}
+
+/* Items are decoded straight out of an image of the whole file,
+ * instead of with one fread per field. */
+static int libretrodb_load_image(libretrodb_t *db, FILE *fp)
+{
+   long size;
+   void *data = NULL;
+
+   if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) <= 0)
+      return -EINVAL;
+
+#if defined(HAVE_MMAP) && !defined(_WIN32)
+   data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+
+   if (data != MAP_FAILED)
+   {
+      db->data   = (const uint8_t*)data;
+      db->size   = size;
+      db->mapped = 1;
+      return 0;
+   }
+#endif
+
+   data = malloc(size);
+
+   if (!data)
+      return -ENOMEM;
+
+   rewind(fp);
+
+   if (fread(data, 1, size, fp) != (size_t)size)
+   {
+      free(data);
+      return -EINVAL;
+   }
+
+   db->data   = (const uint8_t*)data;
+   db->size   = size;
+   db->mapped = 0;
+   return 0;
+}
+
+static void libretrodb_free_image(libretrodb_t *db)
+{
+#if defined(HAVE_MMAP) && !defined(_WIN32)
+   if (db->mapped)
+      munmap((void*)db->data, db->size);
+   else
+#endif
+      free((void*)db->data);
+
+   db->data = NULL;
+   db->size = 0;
 }
 
 void libretrodb_close(libretrodb_t *db)
@@ -150,8 +264,10 @@ void libretrodb_close(libretrodb_t *db)
    if (!db)
       return;
 
+   libretrodb_free_image(db);
+
    fclose(db->fp);
-   db->fp = NULL;
+   db->fp   = NULL;
 }
 
 int libretrodb_open(const char *path, libretrodb_t *db)
@@ -173,7 +289,7 @@ int libretrodb_open(const char *path, libretrodb_t *db)
       goto error;
    }
 
-   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+   if (memcmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)-1) != 0)
    {
       rv = -EINVAL;
       goto error;
@@ -190,6 +306,11 @@ int libretrodb_open(const char *path, libretrodb_t *db)
 
    db->count              = md.count;
    db->first_index_offset = flseek(fp, 0, SEEK_CUR);
+
+   if ((rv = libretrodb_load_image(db, fp)) < 0)
+      goto error;
+
+   flseek(fp, (int)db->first_index_offset, SEEK_SET);
    db->fp                 = fp;
    return 0;
 error:
@@ -197,92 +318,213 @@ error:
    return rv;
 }
 
-static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
+/**
+ * libretrodb_index_open:
+ * @db                  : Handle to database.
+ * @index_name          : Name of the index.
+ * @idx                 : Index found in @db.
+ *
+ * Looks up an index created by libretrodb_create_index. Its entries
+ * are read straight from the database image.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_index_open(libretrodb_t *db, const char *index_name,
       libretrodb_index_t *idx)
 {
-   off_t eof    = flseek(db->fp, 0, SEEK_END);
-   off_t offset = flseek(db->fp, (int)db->first_index_offset, SEEK_SET);
+   const uint8_t *ptr = db->data + db->first_index_offset;
+
+   if (!db->data)
+      return -EINVAL;
 
-   while (offset < eof)
+   while (ptr < db->data + db->size)
    {
-      libretrodb_read_index_header(db->fp, idx);
+      if (libretrodb_read_index_header(db, &ptr, idx) < 0)
+         return -EINVAL;
 
-      if (strncmp(index_name, idx->name, strlen(idx->name)) == 0)
+      if (strcmp(index_name, idx->name) == 0)
          return 0;
 
-      offset = flseek(db->fp, (int)idx->next, SEEK_CUR);
+      ptr += idx->next;
    }
 
    return -1;
 }
 
-static int node_compare(const void * a, const void * b, void * ctx)
+int libretrodb_index_open_field(libretrodb_t *db, const char *field_name,
+      libretrodb_index_t *idx)
 {
-   return memcmp(a, b, *(uint8_t *)ctx);
-}
+   const uint8_t *ptr = db->data + db->first_index_offset;
 
-static int binsearch(const void * buff, const void * item,
-      uint64_t count, uint8_t field_size, uint64_t * offset)
-{
-   int mid            = count / 2;
-   int item_size      = field_size + sizeof(uint64_t);
-   uint64_t * current = (uint64_t *)buff + (mid * item_size);
-   int rv             = node_compare(current, item, &field_size);
+   if (!db->data)
+      return -EINVAL;
 
-   if (rv == 0)
+   while (ptr < db->data + db->size)
    {
-      *offset = *(uint64_t *)(current + field_size);
-      return 0;
-   }
+      if (libretrodb_read_index_header(db, &ptr, idx) < 0)
+         return -EINVAL;
 
-   if (count == 0)
-      return -1;
+      if (strcmp(field_name, idx->field) == 0)
+         return 0;
 
-   if (rv > 0)
-      return binsearch(buff, item, mid, field_size, offset);
+      ptr += idx->next;
+   }
 
-   return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+   return -1;
 }
 
-int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
-      const void *key, struct rmsgpack_dom_value *out)
+/* Compares the first @len bytes of entry @i with @key. */
+static int libretrodb_index_cmp(const libretrodb_index_t *idx,
+      uint64_t i, const void *key, size_t len)
 {
-   libretrodb_index_t idx;
-   int rv;
-   uint64_t offset;
-   void *buff = NULL;
-   ssize_t bufflen, nread = 0;
+   if (len > idx->key_size)
+      len = idx->key_size;
+   return memcmp(idx->entries + i * INDEX_STRIDE(idx), key, len);
+}
 
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
-      return -1;
+/**
+ * libretrodb_index_lower_bound:
+ * @idx                 : Index opened by libretrodb_index_open.
+ * @key                 : Key, or key prefix.
+ * @len                 : Length of @key.
+ *
+ * Returns: position of the first entry whose first @len bytes
+ * are not less than @key, idx->count if there is none.
+ **/
+uint64_t libretrodb_index_lower_bound(const libretrodb_index_t *idx,
+      const void *key, size_t len)
+{
+   uint64_t first = 0;
+   uint64_t count = idx->count;
 
-   bufflen = idx.next;
-   buff    = malloc(bufflen);
+   while (count > 0)
+   {
+      uint64_t step = count / 2;
 
-   if (!buff)
-      return -ENOMEM;
+      if (libretrodb_index_cmp(idx, first + step, key, len) < 0)
+      {
+         first += step + 1;
+         count -= step + 1;
+      }
+      else
+         count  = step;
+   }
+
+   return first;
+}
 
-   while (nread < bufflen)
+/**
+ * libretrodb_index_upper_bound:
+ * @idx                 : Index opened by libretrodb_index_open.
+ * @key                 : Key, or key prefix.
+ * @len                 : Length of @key.
+ *
+ * Entries in [lower_bound, upper_bound) share the prefix @key,
+ * entries in [lower_bound(a), upper_bound(b)) lie between a and b.
+ *
+ * Returns: position of the first entry whose first @len bytes
+ * are greater than @key, idx->count if there is none.
+ **/
+uint64_t libretrodb_index_upper_bound(const libretrodb_index_t *idx,
+      const void *key, size_t len)
+{
+   uint64_t first = 0;
+   uint64_t count = idx->count;
+
+   while (count > 0)
    {
-      void *buff_ = (uint64_t *)buff + nread;
-      rv = fread(buff_, 1, bufflen - nread, db->fp);
+      uint64_t step = count / 2;
 
-      if (rv <= 0)
+      if (libretrodb_index_cmp(idx, first + step, key, len) <= 0)
       {
-         free(buff);
-         return -errno;
+         first += step + 1;
+         count -= step + 1;
       }
-      nread += rv;
+      else
+         count  = step;
    }
 
-   rv = binsearch(buff, key, db->count, (uint8_t)idx.key_size, &offset);
-   free(buff);
+   return first;
+}
+
+/**
+ * libretrodb_index_int_key:
+ * @value               : Integer field value.
+ * @key                 : 8 byte key of @value.
+ *
+ * Encodes @value big endian with the sign bit flipped, which maps
+ * INT64_MIN..INT64_MAX onto 0..UINT64_MAX in order, so that memcmp
+ * of two keys sorts them like the values they were made from.
+ **/
+void libretrodb_index_int_key(int64_t value, uint8_t *key)
+{
+   unsigned i;
+   uint64_t v = (uint64_t)value ^ ((uint64_t)1 << 63);
+
+   for (i = 0; i < 8; i++)
+      key[i] = (uint8_t)(v >> (56 - i * 8));
+}
 
-   if (rv == 0)
-      flseek(db->fp, (int)offset, SEEK_SET);
+/**
+ * libretrodb_index_item_offset:
+ * @idx                 : Index opened by libretrodb_index_open.
+ * @i                   : Entry position.
+ *
+ * Returns: offset of the item of entry @i, to be used with
+ * libretrodb_read_item_view_at.
+ **/
+uint64_t libretrodb_index_item_offset(const libretrodb_index_t *idx,
+      uint64_t i)
+{
+   uint64_t offset;
 
-   return rmsgpack_dom_read(db->fp, out);
+   /* Entries are not aligned. */
+   memcpy(&offset, idx->entries + i * INDEX_STRIDE(idx) + idx->key_size,
+         sizeof(offset));
+   return offset;
+}
+
+/**
+ * libretrodb_read_item_view_at:
+ * @db                  : Handle to database.
+ * @offset              : Item offset from libretrodb_index_item_offset.
+ * @out                 : Item, decoded in place.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_read_item_view_at(libretrodb_t *db, uint64_t offset,
+      struct rmsgpack_view *out)
+{
+   const uint8_t *ptr = db->data + offset;
+
+   if (!db->data || offset >= db->size)
+      return -EINVAL;
+
+   return rmsgpack_view_read(&ptr, db->data + db->size, out);
+}
+
+int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
+      const void *key, struct rmsgpack_dom_value *out)
+{
+   int rv;
+   uint64_t pos;
+   libretrodb_index_t idx;
+   struct rmsgpack_view item;
+
+   if (libretrodb_index_open(db, index_name, &idx) < 0)
+      return -1;
+
+   pos = libretrodb_index_lower_bound(&idx, key, idx.key_size);
+
+   if (pos == idx.count
+         || libretrodb_index_cmp(&idx, pos, key, idx.key_size) != 0)
+      return -1;
+
+   if ((rv = libretrodb_read_item_view_at(db,
+               libretrodb_index_item_offset(&idx, pos), &item)) < 0)
+      return rv;
+
+   return rmsgpack_dom_read_view(&item, out);
 }
 
 /**
@@ -291,35 +533,66 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
  *
  * Resets cursor.
  *
- * Returns: ???.
+ * Returns: 0.
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
-   cursor->eof = 0;
-   return flseek(cursor->fp,
-         (int)cursor->db->root + sizeof(libretrodb_header_t),
-         SEEK_SET);
+   cursor->eof    = 0;
+   cursor->pos    = 0;
+   cursor->offset = cursor->db->root + sizeof(libretrodb_header_t);
+   return 0;
 }
 
-int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
-      struct rmsgpack_dom_value * out)
+static int libretrodb_cursor_next(libretrodb_cursor_t *cursor,
+      struct rmsgpack_view *out)
 {
    int rv;
+   const uint8_t *ptr = cursor->db->data + cursor->offset;
 
    if (cursor->eof)
       return EOF;
 
-retry:
-   rv = rmsgpack_dom_read(cursor->fp, out);
+   if (cursor->plan.type != LIBRETRODB_PLAN_SCAN)
+   {
+      if (cursor->pos == cursor->plan.count)
+      {
+         cursor->eof = 1;
+         return EOF;
+      }
+
+      cursor->offset = cursor->plan.offsets[cursor->pos++];
+      return libretrodb_read_item_view_at(cursor->db, cursor->offset, out);
+   }
+
+   rv = rmsgpack_view_read(&ptr,
+         cursor->db->data + cursor->db->size, out);
    if (rv < 0)
       return rv;
 
+   cursor->offset = ptr - cursor->db->data;
+
    if (out->type == RDT_NULL)
    {
       cursor->eof = 1;
       return EOF;
    }
 
+   return 0;
+}
+
+int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value * out)
+{
+   int rv;
+   struct rmsgpack_view view;
+
+retry:
+   if ((rv = libretrodb_cursor_next(cursor, &view)) != 0)
+      return rv;
+
+   if ((rv = rmsgpack_dom_read_view(&view, out)) < 0)
+      return rv;
+
    if (cursor->query)
    {
       if (!libretrodb_query_filter(cursor->query, out))
@@ -332,6 +605,46 @@ retry:
    return 0;
 }
 
+/**
+ * libretrodb_cursor_read_item_view:
+ * @cursor              : Handle to database cursor.
+ * @out                 : Next item, decoded in place.
+ *
+ * Like libretrodb_cursor_read_item, but without copying the item
+ * out of the database. @out stays valid until the database is
+ * closed, use rmsgpack_view_map_find to get at single fields.
+ *
+ * Returns: 0 if successful, EOF at the end of the database,
+ * otherwise negative.
+ **/
+int libretrodb_cursor_read_item_view(libretrodb_cursor_t *cursor,
+      struct rmsgpack_view *out)
+{
+   int rv;
+
+retry:
+   if ((rv = libretrodb_cursor_next(cursor, out)) != 0)
+      return rv;
+
+   /* Queries still need a DOM copy of each item. */
+   if (cursor->query)
+   {
+      struct rmsgpack_dom_value item;
+      int matches;
+
+      if ((rv = rmsgpack_dom_read_view(out, &item)) < 0)
+         return rv;
+
+      matches = libretrodb_query_filter(cursor->query, &item);
+      rmsgpack_dom_value_free(&item);
+
+      if (!matches)
+         goto retry;
+   }
+
+   return 0;
+}
+
 /**
  * libretrodb_cursor_close:
  * @cursor              : Handle to database cursor.
@@ -343,13 +656,12 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (!cursor)
       return;
 
-   fclose(cursor->fp);
-
    if (cursor->query)
       libretrodb_query_free(cursor->query);
+   libretrodb_plan_free(&cursor->plan);
 
    cursor->is_valid = 0;
-   cursor->fp       = NULL;
+   cursor->offset   = 0;
    cursor->eof      = 1;
    cursor->db       = NULL;
    cursor->query    = NULL;
@@ -361,17 +673,21 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
  * @cursor              : Handle to database cursor.
  * @q                   : Query to execute.
  *
- * Opens cursor to database based on query @q.
+ * Opens cursor to database based on query @q. If @q can be
+ * answered from an index, only the candidates it yields are read.
  *
  * Returns: 0 if successful, otherwise negative.
  **/
 int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
       libretrodb_query_t *q)
 {
-   cursor->fp = fopen(db->path, "rb");
+   int rv;
 
-   if (cursor->fp == NULL)
-      return -errno;
+   if (!db->data)
+      return -EINVAL;
+
+   if ((rv = libretrodb_query_plan(q, db, &cursor->plan)) < 0)
+      return rv;
 
    cursor->db       = db;
    cursor->is_valid = 1;
@@ -386,55 +702,71 @@ int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
    return 0;
 }
 
-static int node_iter(void * value, void * ctx)
+/* Keys shorter than the index key size are zero padded. */
+static int index_entry_cmp(const void *a_, const void *b_)
 {
-   struct node_iter_ctx *nictx = (struct node_iter_ctx*)ctx;
-   size_t size = nictx->idx->key_size + sizeof(uint64_t);
-
-   if (fwrite(value, 1, size, nictx->db->fp) == size)
-      return 0;
+   uint32_t i;
+   const struct index_entry *a = (const struct index_entry*)a_;
+   const struct index_entry *b = (const struct index_entry*)b_;
+   const struct index_entry *longer = (a->len > b->len) ? a : b;
+   uint32_t len = (a->len < b->len) ? a->len : b->len;
+   int rv       = memcmp(INDEX_ENTRY_KEY(a), INDEX_ENTRY_KEY(b), len);
+
+   if (rv != 0)
+      return rv;
 
-   return -1;
-}
+   for (i = len; i < longer->len; i++)
+      if (INDEX_ENTRY_KEY(longer)[i])
+         return (longer == a) ? 1 : -1;
 
-static uint64_t libretrodb_tell(libretrodb_t *db)
-{
-   return (uint64_t)ftell(db->fp);
+   return 0;
 }
 
+/**
+ * libretrodb_create_index:
+ * @db                  : Handle to database.
+ * @name                : Name of the new index.
+ * @field_name          : Field to index.
+ *
+ * Appends a sorted, fixed-stride index over @field_name to the
+ * database. Binary fields need to be of the same size in every item,
+ * string fields are zero padded to the longest one, integer fields
+ * use libretrodb_index_int_key. Items without the field are left
+ * out, several items may share a key.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
 int libretrodb_create_index(libretrodb_t *db,
       const char *name, const char *field_name)
 {
    int rv;
-   struct node_iter_ctx nictx;
-   struct rmsgpack_dom_value key;
+   uint64_t i;
    libretrodb_index_t idx;
-   struct rmsgpack_dom_value item;
-   struct rmsgpack_dom_value *field;
-   struct bintree tree;
-   libretrodb_cursor_t cur    = {0};
-   void *buff                 = NULL;
-   uint64_t *buff_u64         = NULL;
-   uint64_t idx_header_offset = 0;
-   uint8_t field_size         = 0;
-   uint64_t item_loc          = libretrodb_tell(db);
-
-   bintree_new(&tree, node_compare, &field_size);
-
-   if (libretrodb_cursor_open(db, &cur, NULL) != 0)
-   {
-      rv = -1;
+   struct rmsgpack_view item, field;
+   FILE *fp                      = NULL;
+   uint8_t *buff                 = NULL;
+   struct index_entry *entries   = NULL;
+   uint64_t count                = 0;
+   uint64_t capacity             = 0;
+   uint32_t field_size           = 0;
+   enum rmsgpack_dom_type type   = RDT_NULL;
+   libretrodb_cursor_t cur       = {0};
+
+   if ((rv = libretrodb_cursor_open(db, &cur, NULL)) != 0)
       goto clean;
-   }
 
-   key.type        = RDT_STRING;
-   key.val.string.len  = strlen(field_name);
+   for (;;)
+   {
+      uint64_t item_loc = cur.offset;
 
-   /* We know we aren't going to change it */
-   key.val.string.buff = (char*)field_name;
+      if ((rv = libretrodb_cursor_read_item_view(&cur, &item)) != 0)
+      {
+         if (rv != EOF)
+            goto clean;
+         rv = 0;
+         break;
+      }
 
-   while (libretrodb_cursor_read_item(&cur, &item) == 0)
-   {
       if (item.type != RDT_MAP)
       {
          rv = -EINVAL;
@@ -442,84 +774,131 @@ int libretrodb_create_index(libretrodb_t *db,
          goto clean;
       }
 
-      field = rmsgpack_dom_value_map_value(&item, &key);
+      if (rmsgpack_view_map_find(&item, field_name, &field) != 0)
+         continue;
 
-      if (!field)
-      {
-         rv = -EINVAL;
-         printf("field not found in item\n");
-         goto clean;
-      }
+      /* Signed and unsigned integers share one key space. */
+      if (field.type == RDT_UINT)
+         field.type = RDT_INT;
 
-      if (field->type != RDT_BINARY)
+      if (field.type == RDT_INT)
+         field.len = 8;
+      else if (field.type != RDT_BINARY && field.type != RDT_STRING)
       {
          rv = -EINVAL;
-         printf("field is not binary\n");
+         printf("field is not binary, string or integer\n");
          goto clean;
       }
 
-      if (field->val.binary.len == 0)
+      if (field.len == 0)
       {
          rv = -EINVAL;
          printf("field is empty\n");
          goto clean;
       }
 
-      if (field_size == 0)
-         field_size = field->val.binary.len;
-      else if (field->val.binary.len != field_size)
+      if (type == RDT_NULL)
+      {
+         type       = field.type;
+         field_size = field.len;
+      }
+      else if (field.type != type
+            || (type == RDT_BINARY && field.len != field_size))
       {
          rv = -EINVAL;
          printf("field is not of correct size\n");
          goto clean;
       }
+      else if (field.len > field_size)
+         field_size = field.len;
 
-      buff = malloc(field_size + sizeof(uint64_t));
-      if (!buff)
+      if (count == capacity)
       {
-         rv = -ENOMEM;
-         goto clean;
-      }
+         struct index_entry *tmp = NULL;
 
-      memcpy(buff, field->val.binary.buff, field_size);
+         capacity = capacity ? capacity * 2 : 1024;
+         tmp      = (struct index_entry*)realloc(entries,
+               capacity * sizeof(*entries));
 
-      buff_u64 = (uint64_t *)buff + field_size;
+         if (!tmp)
+         {
+            rv = -ENOMEM;
+            goto clean;
+         }
 
-      memcpy(buff_u64, &item_loc, sizeof(uint64_t));
+         entries = tmp;
+      }
 
-      if (bintree_insert(&tree, buff) != 0)
+      /* Keys point into the database image, nothing is copied
+       * until the index gets written. */
+      entries[count].key    = field.data;
+      entries[count].len    = field.len;
+      if (field.type == RDT_INT)
       {
-         printf("Value is not unique: ");
-         rmsgpack_dom_value_print(field);
-         printf("\n");
-         rv = -EINVAL;
-         goto clean;
+         entries[count].key = NULL;
+         libretrodb_index_int_key(field.val.int_, entries[count].num);
       }
-      buff = NULL;
-      rmsgpack_dom_value_free(&item);
-      item_loc = libretrodb_tell(db);
+      entries[count].offset = item_loc;
+      count++;
    }
 
-   (void)rv;
-   (void)idx_header_offset;
+   /* Items usually come sorted already, e.g. from dat_converter. */
+   for (i = 1; i < count; i++)
+      if (index_entry_cmp(&entries[i - 1], &entries[i]) > 0)
+         break;
 
-   idx_header_offset = flseek(db->fp, 0, SEEK_END);
-   strncpy(idx.name, name, 50);
+   if (i < count)
+      qsort(entries, (size_t)count, sizeof(*entries), index_entry_cmp);
 
+   strncpy(idx.name, name, 50);
    idx.name[49] = '\0';
+   strncpy(idx.field, field_name, 50);
+   idx.field[49] = '\0';
    idx.key_size = field_size;
-   idx.next     = db->count * (field_size + sizeof(uint64_t));
-   libretrodb_write_index_header(db->fp, &idx);
+   idx.type     = type;
+   idx.next     = count * INDEX_STRIDE(&idx);
+
+   buff = (uint8_t*)calloc(1, (size_t)idx.next + 1);
+
+   if (!buff)
+   {
+      rv = -ENOMEM;
+      goto clean;
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      uint8_t *entry = buff + i * INDEX_STRIDE(&idx);
+
+      memcpy(entry, INDEX_ENTRY_KEY(&entries[i]), entries[i].len);
+      memcpy(entry + field_size, &entries[i].offset, sizeof(uint64_t));
+   }
+
+   /* The database handle itself is opened read-only. */
+   fp = fopen(db->path, "ab");
+
+   if (!fp)
+   {
+      rv = -errno;
+      goto clean;
+   }
+
+   libretrodb_write_index_header(fp, &idx);
+
+   if (fwrite(buff, 1, (size_t)idx.next, fp) != idx.next)
+      rv = -EIO;
+
+   fclose(fp);
+
+   /* Reload the image so the new index can be used right away. */
+   libretrodb_free_image(db);
+   if (libretrodb_load_image(db, db->fp) < 0 && rv == 0)
+      rv = -EIO;
 
-   nictx.db     = db;
-   nictx.idx    = &idx;
-   bintree_iterate(&tree, node_iter, &nictx);
-   bintree_free(&tree);
 clean:
-   rmsgpack_dom_value_free(&item);
-   if (buff)
-      free(buff);
+   free(entries);
+   free(buff);
    if (cur.is_valid)
       libretrodb_cursor_close(&cur);
-   return 0;
+   return rv;
 }
@@ -9,6 +9,7 @@
 #include <unistd.h>
 #endif
 #include "rmsgpack_dom.h"
+#include "rmsgpack.h"
 
 #define MAGIC_NUMBER "RARCHDB"
 
@@ -21,6 +22,10 @@ typedef struct libretrodb_query libretrodb_query_t;
 typedef struct libretrodb
 {
 	FILE *fp;
+	/* Read-only image of the whole file, mapped if possible. */
+	const uint8_t *data;
+	uint64_t size;
+	int mapped;
 	uint64_t root;
 	uint64_t count;
 	uint64_t first_index_offset;
@@ -30,8 +35,16 @@ typedef struct libretrodb
 typedef struct libretrodb_index
 {
 	char name[50];
+	/* Field the index is over, empty for indexes written
+	 * before it was stored. */
+	char field[50];
 	uint64_t key_size;
 	uint64_t next;
+	/* RDT_BINARY, RDT_STRING or RDT_INT for integer fields. */
+	enum rmsgpack_dom_type type;
+	/* Sorted entries of key_size bytes and an item offset each. */
+	const uint8_t *entries;
+	uint64_t count;
 } libretrodb_index_t;
 
 typedef struct libretrodb_metadata
@@ -45,13 +58,33 @@ typedef struct libretrodb_header
 	uint64_t metadata_offset;
 } libretrodb_header_t;
 
+enum libretrodb_plan_type
+{
+	LIBRETRODB_PLAN_SCAN = 0,
+	LIBRETRODB_PLAN_INDEX_EQUALS,
+	LIBRETRODB_PLAN_INDEX_BETWEEN
+};
+
+typedef struct libretrodb_plan
+{
+	enum libretrodb_plan_type type;
+	/* Index and field the candidates were looked up in. */
+	char index[50];
+	/* Candidate item offsets in file order. Candidates still
+	 * go through the query filter. */
+	uint64_t *offsets;
+	uint64_t count;
+} libretrodb_plan_t;
+
 typedef struct libretrodb_cursor
 {
 	int is_valid;
-	FILE *fp;
+	uint64_t offset;
 	int eof;
 	libretrodb_query_t * query;
 	libretrodb_t * db;
+	libretrodb_plan_t plan;
+	uint64_t pos;
 } libretrodb_cursor_t;
 
 typedef int (* libretrodb_value_provider)(void * ctx,
@@ -64,9 +97,60 @@ void libretrodb_close(libretrodb_t * db);
 
 int libretrodb_open(const char * path, libretrodb_t * db);
 
+/**
+ * libretrodb_create_index:
+ * @db                  : Handle to database.
+ * @name                : Name of the new index.
+ * @field_name          : Field to index.
+ *
+ * Appends a sorted, fixed-stride index over @field_name to the
+ * database. Binary fields need to be of the same size in every item,
+ * string fields are zero padded to the longest one. Items without
+ * the field are left out, several items may share a key.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
 int libretrodb_create_index(libretrodb_t * db, const char *name,
       const char *field_name);
 
+int libretrodb_index_open(libretrodb_t *db, const char *index_name,
+      libretrodb_index_t *idx);
+
+/**
+ * libretrodb_index_open_field:
+ * @db                  : Handle to database.
+ * @field_name          : Indexed field.
+ * @idx                 : Index found in @db.
+ *
+ * Looks up an index over @field_name, whatever it is named.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_index_open_field(libretrodb_t *db, const char *field_name,
+      libretrodb_index_t *idx);
+
+uint64_t libretrodb_index_lower_bound(const libretrodb_index_t *idx,
+      const void *key, size_t len);
+
+uint64_t libretrodb_index_upper_bound(const libretrodb_index_t *idx,
+      const void *key, size_t len);
+
+/**
+ * libretrodb_index_int_key:
+ * @value               : Integer field value.
+ * @key                 : 8 byte key of @value.
+ *
+ * Integer fields are indexed as big endian keys with the sign bit
+ * flipped, so memcmp sorts them by value.
+ **/
+void libretrodb_index_int_key(int64_t value, uint8_t *key);
+
+uint64_t libretrodb_index_item_offset(const libretrodb_index_t *idx,
+      uint64_t i);
+
+int libretrodb_read_item_view_at(libretrodb_t *db, uint64_t offset,
+      struct rmsgpack_view *out);
+
 int libretrodb_find_entry(
         libretrodb_t * db,
         const char * index_name,
@@ -117,9 +201,42 @@ void *libretrodb_query_compile(
 
 void libretrodb_query_free(void *q);
 
+/**
+ * libretrodb_query_plan:
+ * @q                   : Compiled query, or NULL.
+ * @db                  : Handle to database.
+ * @plan                : How to find the items matching @q.
+ *
+ * Looks for equality and between() predicates that every match has
+ * to satisfy on a field with an index over it, and picks
+ * the one with the fewest candidates. Anything else, e.g. glob(),
+ * is left to a full scan.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_query_plan(libretrodb_query_t *q, libretrodb_t *db,
+      libretrodb_plan_t *plan);
+
+void libretrodb_plan_free(libretrodb_plan_t *plan);
+
 int libretrodb_cursor_read_item(libretrodb_cursor_t * cursor,
       struct rmsgpack_dom_value * out);
 
+/**
+ * libretrodb_cursor_read_item_view:
+ * @cursor              : Handle to database cursor.
+ * @out                 : Next item, decoded in place.
+ *
+ * Like libretrodb_cursor_read_item, but without copying the item
+ * out of the database. @out stays valid until the database is
+ * closed, use rmsgpack_view_map_find to get at single fields.
+ *
+ * Returns: 0 if successful, EOF at the end of the database,
+ * otherwise negative.
+ **/
+int libretrodb_cursor_read_item_view(libretrodb_cursor_t * cursor,
+      struct rmsgpack_view * out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libretrodb.h"
+#include "rmsgpack_dom.h"
+
+#define BENCH_RECORDS 100000
+#define BENCH_FIELDS  4
+
+struct bench_ctx
+{
+   unsigned next;
+   unsigned count;
+};
+
+/* Serials come out sorted, CRCs in random order. */
+static uint32_t bench_crc(unsigned i)
+{
+   return (uint32_t)(i * 2654435761u);
+}
+
+static void bench_set_key(struct rmsgpack_dom_value *key, const char *name)
+{
+   key->type            = RDT_STRING;
+   key->val.string.len  = strlen(name);
+   key->val.string.buff = strdup(name);
+}
+
+static void bench_set_string(struct rmsgpack_dom_value *value,
+      const char *str)
+{
+   value->type            = RDT_STRING;
+   value->val.string.len  = strlen(str);
+   value->val.string.buff = strdup(str);
+}
+
+static int bench_value_provider(void *data, struct rmsgpack_dom_value *out)
+{
+   char buff[64];
+   uint32_t crc;
+   struct bench_ctx *ctx          = (struct bench_ctx*)data;
+   struct rmsgpack_dom_pair *items = NULL;
+
+   if (ctx->next == ctx->count)
+      return 1;
+
+   items = (struct rmsgpack_dom_pair*)calloc(BENCH_FIELDS, sizeof(*items));
+   if (!items)
+      return -1;
+
+   out->type          = RDT_MAP;
+   out->val.map.len   = BENCH_FIELDS;
+   out->val.map.items = items;
+
+   snprintf(buff, sizeof(buff), "Game %u (USA)", ctx->next);
+   bench_set_key(&items[0].key, "name");
+   bench_set_string(&items[0].value, buff);
+
+   snprintf(buff, sizeof(buff), "SLUS-%06u", ctx->next);
+   bench_set_key(&items[1].key, "serial");
+   bench_set_string(&items[1].value, buff);
+
+   bench_set_key(&items[2].key, "crc");
+   crc = bench_crc(ctx->next);
+   items[2].value.type            = RDT_BINARY;
+   items[2].value.val.binary.len  = sizeof(crc);
+   items[2].value.val.binary.buff = (char*)malloc(sizeof(crc));
+   memcpy(items[2].value.val.binary.buff, &crc, sizeof(crc));
+
+   bench_set_key(&items[3].key, "releaseyear");
+   items[3].value.type      = RDT_UINT;
+   items[3].value.val.uint_ = 1980 + ctx->next % 30;
+
+   ctx->next++;
+   return 0;
+}
+
+static double bench_seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+   unsigned i;
+   clock_t start;
+   FILE *fp;
+   libretrodb_t db;
+   libretrodb_index_t idx;
+   char serial[64];
+   unsigned found       = 0;
+   uint64_t matches     = 0;
+   struct bench_ctx ctx = {0, BENCH_RECORDS};
+   const char *path     = (argc > 1) ? argv[1] : "bench.rdb";
+
+   if (argc > 2)
+      ctx.count = strtoul(argv[2], NULL, 0);
+
+   fp = fopen(path, "wb");
+   if (!fp)
+   {
+      printf("Could not create '%s'\n", path);
+      return 1;
+   }
+
+   start = clock();
+   if (libretrodb_create(fp, bench_value_provider, &ctx) < 0)
+   {
+      printf("Could not create database\n");
+      fclose(fp);
+      return 1;
+   }
+   fclose(fp);
+   printf("create %u records:     %8.3f s\n", ctx.count, bench_seconds(start));
+
+   if (libretrodb_open(path, &db) != 0)
+   {
+      printf("Could not open '%s'\n", path);
+      return 1;
+   }
+
+   start = clock();
+   if (libretrodb_create_index(&db, "crc", "crc") != 0)
+      return 1;
+   printf("index crc (unsorted):    %8.3f s\n", bench_seconds(start));
+
+   start = clock();
+   if (libretrodb_create_index(&db, "serial", "serial") != 0)
+      return 1;
+   printf("index serial (sorted):   %8.3f s\n", bench_seconds(start));
+
+   if (libretrodb_index_open(&db, "crc", &idx) != 0)
+      return 1;
+
+   start = clock();
+   for (i = 0; i < ctx.count; i++)
+   {
+      uint32_t crc = bench_crc(i);
+      uint64_t pos = libretrodb_index_lower_bound(&idx, &crc, sizeof(crc));
+
+      if (pos < idx.count && libretrodb_index_upper_bound(
+               &idx, &crc, sizeof(crc)) == pos + 1)
+         found++;
+   }
+   printf("crc lookups:             %8.3f s (%u/%u found)\n",
+         bench_seconds(start), found, ctx.count);
+
+   if (libretrodb_index_open(&db, "serial", &idx) != 0)
+      return 1;
+
+   start = clock();
+   for (i = 0; i < 1000; i++)
+   {
+      snprintf(serial, sizeof(serial), "SLUS-%04u", i % 1000);
+      matches += libretrodb_index_upper_bound(&idx, serial, strlen(serial))
+         - libretrodb_index_lower_bound(&idx, serial, strlen(serial));
+   }
+   printf("serial prefix scans:     %8.3f s (%llu matches)\n",
+         bench_seconds(start), (unsigned long long)matches);
+
+   libretrodb_close(&db);
+   remove(path);
+   return 0;
+}
@@ -20,6 +20,7 @@ int main(int argc, char ** argv)
       printf("\tlist\n");
       printf("\tcreate-index <index name> <field name>\n");
       printf("\tfind <query expression>\n");
+      printf("\texplain <query expression>\n");
       return 1;
    }
 
@@ -83,6 +84,62 @@ int main(int argc, char ** argv)
          rmsgpack_dom_value_free(&item);
       }
    }
+   else if (!strcmp(command, "explain"))
+   {
+      libretrodb_plan_t plan;
+      uint64_t matches = 0;
+
+      if (argc != 4)
+      {
+         printf("Usage: %s <db file> explain <query expression>\n", argv[0]);
+         return 1;
+      }
+
+      query_exp = argv[3];
+      error = NULL;
+      q = libretrodb_query_compile(&db, query_exp, strlen(query_exp), &error);
+
+      if (error)
+      {
+         printf("%s\n", error);
+         return 1;
+      }
+
+      if ((rv = libretrodb_query_plan(q, &db, &plan)) != 0)
+      {
+         printf("Could not plan query: %s\n", strerror(-rv));
+         return 1;
+      }
+
+      switch (plan.type)
+      {
+         case LIBRETRODB_PLAN_INDEX_EQUALS:
+         case LIBRETRODB_PLAN_INDEX_BETWEEN:
+            printf("index '%s' (%s): %llu of %llu items\n", plan.index,
+                  plan.type == LIBRETRODB_PLAN_INDEX_EQUALS
+                  ? "equals" : "between",
+                  (unsigned long long)plan.count,
+                  (unsigned long long)db.count);
+            break;
+         default:
+            printf("scan: %llu items\n", (unsigned long long)db.count);
+            break;
+      }
+      libretrodb_plan_free(&plan);
+
+      if ((rv = libretrodb_cursor_open(&db, &cur, q)) != 0)
+      {
+         printf("Could not open cursor: %s\n", strerror(-rv));
+         return 1;
+      }
+
+      while (libretrodb_cursor_read_item(&cur, &item) == 0)
+      {
+         rmsgpack_dom_value_free(&item);
+         matches++;
+      }
+      printf("matches: %llu\n", (unsigned long long)matches);
+   }
    else if (!strcmp(command, "create-index"))
    {
       const char * index_name, * field_name;
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <errno.h>
 
 #include "libretrodb.h"
 
@@ -954,3 +955,203 @@ int libretrodb_query_filter(libretrodb_query_t *q,
    struct rmsgpack_dom_value res = inv.func(*v, inv.argc, inv.argv);
    return (res.type == RDT_BOOL && res.val.bool_);
 }
+
+struct plan_state
+{
+   libretrodb_t *db;
+   enum libretrodb_plan_type type;
+   libretrodb_index_t idx;
+   uint64_t first;
+   uint64_t last;
+};
+
+/* Finds the index entries that can satisfy @field == @arg or
+ * between(lo, hi) on @field. Returns 0 if the predicate can not
+ * be answered from @idx. */
+static int plan_predicate(const libretrodb_index_t *idx,
+      const struct argument *arg, enum libretrodb_plan_type *type,
+      uint64_t *first, uint64_t *last)
+{
+   uint8_t lo[8], hi[8];
+
+   if (arg->type == AT_FUNCTION)
+   {
+      const struct invocation *inv = &arg->a.invocation;
+
+      if (inv->func != between || inv->argc != 2
+            || idx->type != RDT_INT
+            || inv->argv[0].type != AT_VALUE
+            || inv->argv[1].type != AT_VALUE
+            || inv->argv[0].a.value.type != RDT_INT
+            || inv->argv[1].a.value.type != RDT_INT)
+         return 0;
+
+      libretrodb_index_int_key(inv->argv[0].a.value.val.int_, lo);
+      libretrodb_index_int_key(inv->argv[1].a.value.val.int_, hi);
+
+      *type  = LIBRETRODB_PLAN_INDEX_BETWEEN;
+      *first = libretrodb_index_lower_bound(idx, lo, sizeof(lo));
+      *last  = libretrodb_index_upper_bound(idx, hi, sizeof(hi));
+      if (*last < *first)
+         *last = *first;
+      return 1;
+   }
+
+   *type = LIBRETRODB_PLAN_INDEX_EQUALS;
+
+   switch (arg->a.value.type)
+   {
+      case RDT_INT:
+         if (idx->type != RDT_INT)
+            return 0;
+         libretrodb_index_int_key(arg->a.value.val.int_, lo);
+         *first = libretrodb_index_lower_bound(idx, lo, sizeof(lo));
+         *last  = libretrodb_index_upper_bound(idx, lo, sizeof(lo));
+         return 1;
+      case RDT_BINARY:
+         if (idx->type != RDT_BINARY
+               || arg->a.value.val.binary.len != idx->key_size)
+            return 0;
+         *first = libretrodb_index_lower_bound(idx,
+               arg->a.value.val.binary.buff, idx->key_size);
+         *last  = libretrodb_index_upper_bound(idx,
+               arg->a.value.val.binary.buff, idx->key_size);
+         return 1;
+      case RDT_STRING:
+         {
+            char *key = NULL;
+
+            if (idx->type != RDT_STRING)
+               return 0;
+
+            /* No indexed string is longer than the key size. */
+            if (arg->a.value.val.string.len > idx->key_size)
+            {
+               *first = *last = 0;
+               return 1;
+            }
+
+            /* Index keys are zero padded. */
+            if (!(key = (char*)calloc(1, (size_t)idx->key_size)))
+               return 0;
+            memcpy(key, arg->a.value.val.string.buff,
+                  arg->a.value.val.string.len);
+
+            *first = libretrodb_index_lower_bound(idx, key, idx->key_size);
+            *last  = libretrodb_index_upper_bound(idx, key, idx->key_size);
+            free(key);
+         }
+         return 1;
+      default:
+         break;
+   }
+
+   return 0;
+}
+
+/* Every field of a table has to match, so any of them will do. */
+static void plan_table(struct plan_state *state,
+      const struct invocation *table)
+{
+   unsigned i;
+
+   for (i = 0; i + 1 < table->argc; i += 2)
+   {
+      uint64_t first, last;
+      libretrodb_index_t idx;
+      enum libretrodb_plan_type type;
+      const struct rmsgpack_dom_value *field = &table->argv[i].a.value;
+
+      if (table->argv[i].type != AT_VALUE || field->type != RDT_STRING
+            || field->val.string.len >= sizeof(idx.field))
+         continue;
+
+      /* Index names say nothing about the field indexed. */
+      if (libretrodb_index_open_field(state->db,
+               field->val.string.buff, &idx) != 0)
+         continue;
+
+      if (!plan_predicate(&idx, &table->argv[i + 1],
+               &type, &first, &last))
+         continue;
+
+      if (state->type == LIBRETRODB_PLAN_SCAN
+            || last - first < state->last - state->first)
+      {
+         state->type  = type;
+         state->idx   = idx;
+         state->first = first;
+         state->last  = last;
+      }
+   }
+}
+
+static int plan_offset_cmp(const void *a_, const void *b_)
+{
+   uint64_t a = *(const uint64_t*)a_;
+   uint64_t b = *(const uint64_t*)b_;
+
+   return (a > b) - (a < b);
+}
+
+int libretrodb_query_plan(libretrodb_query_t *q, libretrodb_t *db,
+      libretrodb_plan_t *plan)
+{
+   uint64_t i;
+   struct plan_state state;
+   const struct invocation *root = NULL;
+
+   memset(plan, 0, sizeof(*plan));
+
+   if (!q)
+      return 0;
+
+   memset(&state, 0, sizeof(state));
+   state.db = db;
+   root     = &((struct query*)q)->root;
+
+   if (root->func == all_map)
+      plan_table(&state, root);
+   else if (root->func == operator_and)
+   {
+      for (i = 0; i < root->argc; i++)
+         if (root->argv[i].type == AT_FUNCTION
+               && root->argv[i].a.invocation.func == all_map)
+            plan_table(&state, &root->argv[i].a.invocation);
+   }
+
+   if (state.type == LIBRETRODB_PLAN_SCAN)
+      return 0;
+
+   plan->count = state.last - state.first;
+
+   if (plan->count)
+   {
+      plan->offsets = (uint64_t*)malloc(
+            (size_t)plan->count * sizeof(uint64_t));
+
+      if (!plan->offsets)
+      {
+         plan->count = 0;
+         return -ENOMEM;
+      }
+
+      for (i = 0; i < plan->count; i++)
+         plan->offsets[i] = libretrodb_index_item_offset(
+               &state.idx, state.first + i);
+
+      /* Keep the order a scan would return items in. */
+      qsort(plan->offsets, (size_t)plan->count,
+            sizeof(uint64_t), plan_offset_cmp);
+   }
+
+   plan->type = state.type;
+   strlcpy(plan->index, state.idx.name, sizeof(plan->index));
+   return 0;
+}
+
+void libretrodb_plan_free(libretrodb_plan_t *plan)
+{
+   free(plan->offsets);
+   memset(plan, 0, sizeof(*plan));
+}
@@ -585,3 +585,233 @@ int rmsgpack_read(FILE *fp,
 
    return 0;
 }
+
+static uint64_t view_read_be(const uint8_t *p, size_t size)
+{
+   size_t i;
+   uint64_t value = 0;
+
+   for (i = 0; i < size; i++)
+      value = (value << 8) | p[i];
+
+   return value;
+}
+
+/* Decodes the header of the value at *ptr. Scalars, strings and
+ * binaries are consumed entirely, for maps and arrays *ptr is
+ * left at their first item. */
+static int view_read_header(const uint8_t **ptr, const uint8_t *end,
+      struct rmsgpack_view *out)
+{
+   size_t size;
+   uint64_t tmp_len = 0;
+   const uint8_t *p = *ptr;
+   uint8_t type;
+
+   if (p >= end)
+      return -EINVAL;
+
+   type     = *p++;
+   out->end = end;
+   out->len = 0;
+
+   if (type < MPF_FIXMAP)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = type;
+      goto scalar;
+   }
+   else if (type < MPF_FIXARRAY)
+   {
+      out->type = RDT_MAP;
+      out->len  = type - MPF_FIXMAP;
+      goto container;
+   }
+   else if (type < MPF_FIXSTR)
+   {
+      out->type = RDT_ARRAY;
+      out->len  = type - MPF_FIXARRAY;
+      goto container;
+   }
+   else if (type < MPF_NIL)
+   {
+      out->type = RDT_STRING;
+      tmp_len   = type - MPF_FIXSTR;
+      goto buffer;
+   }
+   else if (type > MPF_MAP32)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = (int8_t)type;
+      goto scalar;
+   }
+
+   switch (type)
+   {
+      case 0xc0:
+         out->type = RDT_NULL;
+         goto scalar;
+      case 0xc2:
+      case 0xc3:
+         out->type      = RDT_BOOL;
+         out->val.bool_ = type == 0xc3;
+         goto scalar;
+      case 0xc4:
+      case 0xc5:
+      case 0xc6:
+      case 0xd9:
+      case 0xda:
+      case 0xdb:
+         out->type = (type <= 0xc6) ? RDT_BINARY : RDT_STRING;
+         size      = 1 << (type - ((type <= 0xc6) ? 0xc4 : 0xd9));
+         if ((size_t)(end - p) < size)
+            return -EINVAL;
+         tmp_len = view_read_be(p, size);
+         p      += size;
+         goto buffer;
+      case 0xcc:
+      case 0xcd:
+      case 0xce:
+      case 0xcf:
+         size = 1 << (type - 0xcc);
+         if ((size_t)(end - p) < size)
+            return -EINVAL;
+         out->type      = RDT_UINT;
+         out->val.uint_ = view_read_be(p, size);
+         p             += size;
+         goto scalar;
+      case 0xd0:
+      case 0xd1:
+      case 0xd2:
+      case 0xd3:
+         size = 1 << (type - 0xd0);
+         if ((size_t)(end - p) < size)
+            return -EINVAL;
+         out->type = RDT_INT;
+         tmp_len   = view_read_be(p, size);
+         p        += size;
+
+         /* Sign extend. */
+         if (size < 8 && (tmp_len >> (size * 8 - 1)))
+            tmp_len |= ~UINT64_C(0) << (size * 8);
+         out->val.int_ = (int64_t)tmp_len;
+         goto scalar;
+      case 0xdc:
+      case 0xdd:
+      case 0xde:
+      case 0xdf:
+         size = 2 << (type & 1);
+         if ((size_t)(end - p) < size)
+            return -EINVAL;
+         out->type = (type <= 0xdd) ? RDT_ARRAY : RDT_MAP;
+         out->len  = (uint32_t)view_read_be(p, size);
+         p        += size;
+         goto container;
+   }
+
+   /* Floats and extension types are not supported. */
+   return -EINVAL;
+
+buffer:
+   if ((uint64_t)(end - p) < tmp_len)
+      return -EINVAL;
+   out->len  = (uint32_t)tmp_len;
+   out->data = p;
+   *ptr      = p + tmp_len;
+   return 0;
+
+container:
+   out->data = p;
+   *ptr      = p;
+   return 0;
+
+scalar:
+   out->data = NULL;
+   *ptr      = p;
+   return 0;
+}
+
+/**
+ * rmsgpack_view_read:
+ * @ptr                 : Position in the encoded buffer.
+ * @end                 : End of the encoded buffer.
+ * @out                 : Decoded value.
+ *
+ * Decodes the value at @ptr in place, without allocating
+ * anything, and advances @ptr past it. Nested values of
+ * maps and arrays are skipped, they can be decoded starting
+ * at @out->data.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_view_read(const uint8_t **ptr, const uint8_t *end,
+      struct rmsgpack_view *out)
+{
+   int rv;
+   uint64_t pending;
+   const uint8_t *p = *ptr;
+
+   if ((rv = view_read_header(&p, end, out)) < 0)
+      return rv;
+
+   pending = out->len;
+   if (out->type == RDT_MAP)
+      pending *= 2;
+   else if (out->type != RDT_ARRAY)
+      pending = 0;
+
+   /* Skip nested values without recursing. */
+   while (pending)
+   {
+      struct rmsgpack_view nested;
+
+      if ((rv = view_read_header(&p, end, &nested)) < 0)
+         return rv;
+
+      pending--;
+      if (nested.type == RDT_MAP)
+         pending += (uint64_t)nested.len * 2;
+      else if (nested.type == RDT_ARRAY)
+         pending += nested.len;
+   }
+
+   *ptr = p;
+   return 0;
+}
+
+/**
+ * rmsgpack_view_map_find:
+ * @map                 : Map decoded by rmsgpack_view_read.
+ * @key                 : String key to look for.
+ * @out                 : Value stored under @key.
+ *
+ * Looks up a string key in @map, only decoding as much of
+ * the map as needed to find it.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int rmsgpack_view_map_find(const struct rmsgpack_view *map,
+      const char *key, struct rmsgpack_view *out)
+{
+   uint32_t i;
+   struct rmsgpack_view k;
+   size_t key_len   = strlen(key);
+   const uint8_t *p = map->data;
+
+   if (map->type != RDT_MAP)
+      return -EINVAL;
+
+   for (i = 0; i < map->len; i++)
+   {
+      if (rmsgpack_view_read(&p, map->end, &k) < 0)
+         return -EINVAL;
+      if (rmsgpack_view_read(&p, map->end, out) < 0)
+         return -EINVAL;
+
+      if (k.type == RDT_STRING && k.len == key_len
+            && memcmp(k.data, key, key_len) == 0)
+         return 0;
+   }
+
+   return -1;
+}
@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include "rmsgpack_dom.h"
+
 struct rmsgpack_read_callbacks {
 	int (* read_nil)(void *);
 	int (* read_bool)(
@@ -77,5 +79,34 @@ int rmsgpack_read(
         void * data
 );
 
+/* Value decoded in place from an encoded buffer, e.g. a mapped
+ * database. Strings and binaries point into the buffer and are
+ * not NUL terminated. */
+struct rmsgpack_view {
+	enum rmsgpack_dom_type type;
+	/* Bytes of strings and binaries, first item of maps and arrays. */
+	const uint8_t * data;
+	const uint8_t * end;
+	/* Bytes, map pairs or array items. */
+	uint32_t len;
+	union {
+		uint64_t uint_;
+		int64_t int_;
+		int bool_;
+	} val;
+};
+
+int rmsgpack_view_read(
+        const uint8_t ** ptr,
+        const uint8_t * end,
+        struct rmsgpack_view * out
+);
+
+int rmsgpack_view_map_find(
+        const struct rmsgpack_view * map,
+        const char * key,
+        struct rmsgpack_view * out
+);
+
 #endif
 
@@ -449,6 +449,108 @@ int rmsgpack_dom_read(FILE *fp, struct rmsgpack_dom_value *out)
    return rv;
 }
 
+static int dom_read_view(const struct rmsgpack_view *view,
+      struct rmsgpack_dom_value *out, unsigned depth)
+{
+   int rv;
+   uint32_t i;
+   const uint8_t *p = view->data;
+
+   memset(out, 0, sizeof(*out));
+   out->type = view->type;
+
+   if (depth == MAX_DEPTH)
+      return -ENOMEM;
+
+   switch (view->type)
+   {
+      case RDT_NULL:
+         break;
+      case RDT_BOOL:
+         out->val.bool_ = view->val.bool_;
+         break;
+      case RDT_INT:
+         out->val.int_ = view->val.int_;
+         break;
+      case RDT_UINT:
+         out->val.uint_ = view->val.uint_;
+         break;
+      case RDT_STRING:
+      case RDT_BINARY:
+         /* string and binary share their layout. */
+         out->val.string.buff = (char *)calloc(view->len + 1, sizeof(char));
+         if (!out->val.string.buff)
+            return -ENOMEM;
+         memcpy(out->val.string.buff, view->data, view->len);
+         out->val.string.len = view->len;
+         break;
+      case RDT_MAP:
+         out->val.map.items = (struct rmsgpack_dom_pair *)calloc(
+               view->len, sizeof(struct rmsgpack_dom_pair));
+         if (!out->val.map.items)
+            return view->len ? -ENOMEM : 0;
+         out->val.map.len = view->len;
+
+         for (i = 0; i < view->len; i++)
+         {
+            struct rmsgpack_view key, value;
+
+            if ((rv = rmsgpack_view_read(&p, view->end, &key)) < 0)
+               return rv;
+            if ((rv = dom_read_view(&key,
+                        &out->val.map.items[i].key, depth + 1)) < 0)
+               return rv;
+            if ((rv = rmsgpack_view_read(&p, view->end, &value)) < 0)
+               return rv;
+            if ((rv = dom_read_view(&value,
+                        &out->val.map.items[i].value, depth + 1)) < 0)
+               return rv;
+         }
+         break;
+      case RDT_ARRAY:
+         out->val.array.items = (struct rmsgpack_dom_value *)calloc(
+               view->len, sizeof(struct rmsgpack_dom_value));
+         if (!out->val.array.items)
+            return view->len ? -ENOMEM : 0;
+         out->val.array.len = view->len;
+
+         for (i = 0; i < view->len; i++)
+         {
+            struct rmsgpack_view item;
+
+            if ((rv = rmsgpack_view_read(&p, view->end, &item)) < 0)
+               return rv;
+            if ((rv = dom_read_view(&item,
+                        &out->val.array.items[i], depth + 1)) < 0)
+               return rv;
+         }
+         break;
+   }
+
+   return 0;
+}
+
+/**
+ * rmsgpack_dom_read_view:
+ * @view                : Value decoded by rmsgpack_view_read.
+ * @out                 : DOM copy of @view.
+ *
+ * Builds a DOM value out of an in place decoded value, so that
+ * it no longer depends on the encoded buffer.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_dom_read_view(const struct rmsgpack_view *view,
+      struct rmsgpack_dom_value *out)
+{
+   int rv = dom_read_view(view, out, 0);
+
+   if (rv < 0)
+      rmsgpack_dom_value_free(out);
+
+   return rv;
+}
+
 int rmsgpack_dom_read_into(FILE *fp, ...)
 {
    va_list ap;
@@ -78,6 +78,13 @@ int rmsgpack_dom_write(
         const struct rmsgpack_dom_value * obj
 );
 
+struct rmsgpack_view;
+
+int rmsgpack_dom_read_view(
+        const struct rmsgpack_view * view,
+        struct rmsgpack_dom_value * out
+);
+
 int rmsgpack_dom_read_into(FILE *fp, ...);
 
 #ifdef __cplusplus
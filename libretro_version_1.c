@@ -33,6 +33,8 @@
 #include "runloop_data.h"
 #include "retroarch.h"
 #include "performance.h"
+#include "frame_stats.h"
+#include "replay_hash.h"
 #include "input/keyboard_line.h"
 #include "input/input_remapping.h"
 #include "audio/audio_driver.h"
@@ -44,6 +46,12 @@
 #include "netplay.h"
 #endif
 
+/* Set when the core asked for input to be polled, but the poll
+ * is left to its first input_state call, see input_poll. */
+static bool input_poll_pending;
+
+static void input_poll_devices(void);
+
 /**
  * video_frame:
  * @data                 : pointer to data of the video frame.
@@ -70,6 +78,8 @@ static void video_frame(const void *data, unsigned width,
    if (!driver->video_active)
       return;
 
+   frame_stats_mark(FRAME_STATS_VIDEO_FRAME);
+
    if (video_pixel_frame_scale(data, width, height, pitch))
    {
       video_pixel_scaler_t *scaler = scaler_get_ptr();
@@ -139,6 +149,9 @@ static int16_t input_state(unsigned port, unsigned device,
    const input_driver_t *input     = driver ? 
       (const input_driver_t*)driver->input : NULL;
    
+   if (input_poll_pending)
+      input_poll_devices();
+
    for (i = 0; i < MAX_USERS; i++)
       libretro_input_binds[i] = settings->input.binds[i];
 
@@ -148,7 +161,19 @@ static int16_t input_state(unsigned port, unsigned device,
    {
       int16_t ret;
       if (bsv_movie_get_input(global->bsv.movie, &ret))
+      {
+         if (global->bsv.convert)
+            bsv_movie_set_input(global->bsv.convert, ret);
          return ret;
+      }
+
+      /* The frame the movie ended in is not converted. */
+      if (global->bsv.convert)
+      {
+         bsv_movie_free(global->bsv.convert);
+         global->bsv.convert = NULL;
+         RARCH_LOG("Converted movie to \"%s\".\n", global->bsv.convert_path);
+      }
 
       global->bsv.movie_end = true;
    }
@@ -198,11 +223,11 @@ static int16_t input_state(unsigned port, unsigned device,
 }
 
 /**
- * input_poll:
+ * input_poll_devices:
  *
- * Input polling callback function.
+ * Polls input devices for the core.
  **/
-static void input_poll(void)
+static void input_poll_devices(void)
 {
    driver_t *driver               = driver_get_ptr();
    settings_t *settings           = config_get_ptr();
@@ -211,6 +236,10 @@ static void input_poll(void)
 
    (void)settings;
 
+   input_poll_pending = false;
+
+   frame_stats_mark(FRAME_STATS_INPUT_POLL);
+
    input->poll(driver->input_data);
 
 #ifdef HAVE_OVERLAY
@@ -223,6 +252,57 @@ static void input_poll(void)
 #endif
 }
 
+/**
+ * input_poll:
+ *
+ * Input polling callback function.
+ *
+ * With input_poll_late, devices are only polled once the core
+ * reads input, which is as late as possible within the frame.
+ * Netplay reads input before running the frame, so it always
+ * polls right away.
+ **/
+static void input_poll(void)
+{
+   settings_t *settings = config_get_ptr();
+#ifdef HAVE_NETPLAY
+   driver_t *driver     = driver_get_ptr();
+
+   if (settings->input.poll_late && !driver->netplay_data)
+#else
+   if (settings->input.poll_late)
+#endif
+   {
+      input_poll_pending = true;
+      return;
+   }
+
+   input_poll_devices();
+}
+
+/**
+ * retro_poll_input:
+ *
+ * Polls input devices right away, for input read while the
+ * core does not run, e.g. in the menu or while paused.
+ **/
+void retro_poll_input(void)
+{
+   input_poll_devices();
+}
+
+/**
+ * retro_flush_input_poll:
+ *
+ * Polls input devices if the core asked for a poll during the
+ * frame but never read input afterwards, so hotkeys keep working.
+ **/
+void retro_flush_input_poll(void)
+{
+   if (input_poll_pending)
+      input_poll_devices();
+}
+
 /**
  * retro_set_default_callbacks:
  * @data           : pointer to retro_callbacks object
@@ -270,6 +350,13 @@ void retro_init_libretro_cbs(void *data)
 
    retro_set_default_callbacks(cbs);
 
+   /* Movies being hashed are not presented. */
+   if (replay_hash_active())
+   {
+      replay_hash_set_callbacks();
+      return;
+   }
+
 #ifdef HAVE_NETPLAY
    if (!driver->netplay_data)
       return;
@@ -301,6 +388,9 @@ void retro_set_rewind_callbacks(void)
 {
    global_t *global = global_get_ptr();
 
+   if (replay_hash_active())
+      return;
+
    if (global->rewind.frame_is_reverse)
    {
       pretro_set_audio_sample(audio_driver_sample_rewind);
@@ -58,6 +58,22 @@ void retro_set_default_callbacks(void *data);
  **/
 void retro_set_rewind_callbacks(void);
 
+/**
+ * retro_poll_input:
+ *
+ * Polls input devices right away, for input read while the
+ * core does not run, e.g. in the menu or while paused.
+ **/
+void retro_poll_input(void);
+
+/**
+ * retro_flush_input_poll:
+ *
+ * Polls input devices if the core asked for a poll during the
+ * frame but never read input afterwards, so hotkeys keep working.
+ **/
+void retro_flush_input_poll(void);
+
 /**
  * retro_flush_audio:
  * @data                 : pointer to audio buffer.
@@ -959,10 +959,7 @@ static int action_ok_core_deferred_set(const char *path,
    idx = rdb_entry_start_game_selection_ptr;
 
    content_playlist_update(menu->playlist, idx,
-         menu->playlist->entries[idx].path, menu->playlist->entries[idx].label,
-         path , core_display_name,
-         menu->playlist->entries[idx].crc32,
-         menu->playlist->entries[idx].db_name);
+         NULL, NULL, path, core_display_name, NULL, NULL);
 
    content_playlist_write_file(menu->playlist);
 
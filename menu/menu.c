@@ -196,6 +196,11 @@ void menu_free(menu_handle_t *menu)
    if (menu->playlist)
       content_playlist_free(menu->playlist);
    menu->playlist = NULL;
+
+#ifdef HAVE_LIBRETRODB
+   database_catalog_free(menu->db_catalog);
+   menu->db_catalog = NULL;
+#endif
   
    menu_shader_free(menu);
 
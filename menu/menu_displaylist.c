@@ -258,7 +258,7 @@ static int menu_displaylist_parse_core_info(menu_displaylist_info_t *info)
    global_t *global          = global_get_ptr();
    core_info_t *core_info    = global ? (core_info_t*)global->core_info.current : NULL;
 
-   if (!core_info || !core_info->data)
+   if (!core_info || !core_info->has_info)
    {
       menu_list_push(info->list,
             menu_hash_to_str(MENU_LABEL_VALUE_NO_CORE_INFORMATION_AVAILABLE),
@@ -1121,10 +1121,45 @@ static int create_string_list_rdb_entry_int(const char *desc, const char *label,
 }
 #endif
 
+#ifdef HAVE_LIBRETRODB
+/* Searches by one of the fields the database catalog indexes
+ * are answered from the catalog, anything else still opens
+ * @path and runs @query over all of it. */
+static database_info_list_t *menu_database_list_new(const char *path,
+      const char *label, const char *value, const char *query)
+{
+   database_info_list_t *list = NULL;
+   menu_handle_t *menu        = menu_driver_get_ptr();
+   settings_t *settings       = config_get_ptr();
+   const char *field          = (query && label) ?
+      database_info_query_field(label) : NULL;
+
+   if (menu && settings && (!query || field))
+   {
+      if (menu->db_catalog && database_catalog_is_stale(
+               menu->db_catalog, settings->content_database))
+      {
+         database_catalog_free(menu->db_catalog);
+         menu->db_catalog = NULL;
+      }
+
+      if (!menu->db_catalog)
+         menu->db_catalog = database_catalog_new(settings->content_database);
+
+      list = database_catalog_find(menu->db_catalog, path, field, value);
+   }
+
+   if (!list)
+      list = database_info_list_new(path, query);
+   return list;
+}
+#endif
+
 static int menu_displaylist_parse_database_entry(menu_displaylist_info_t *info)
 {
 #ifdef HAVE_LIBRETRODB
-   unsigned i, j, k;
+   unsigned i, k;
+   size_t j;
    content_playlist_t *playlist        = NULL;
    database_info_list_t *db_info       = NULL;
    char path_playlist[PATH_MAX_LENGTH] = {0};
@@ -1137,7 +1172,8 @@ static int menu_displaylist_parse_database_entry(menu_displaylist_info_t *info)
 
    database_info_build_query(query, sizeof(query), "displaylist_parse_database_entry", info->path_b);
 
-   if (!(db_info = database_info_list_new(info->path, query)))
+   if (!(db_info = menu_database_list_new(info->path,
+               "displaylist_parse_database_entry", info->path_b, query)))
       goto error;
 
    fill_short_pathname_representation(path_base, info->path,
@@ -1169,48 +1205,13 @@ static int menu_displaylist_parse_database_entry(menu_displaylist_info_t *info)
 
       if (playlist)
       {
-         for (j = 0; j < playlist->size; j++)
-         {
-            char elem0[PATH_MAX_LENGTH]      = {0};
-            char elem1[PATH_MAX_LENGTH]      = {0};
-            bool match_found                 = false;
-            struct string_list *tmp_str_list = string_split(
-                  playlist->entries[j].crc32, "|");
-            uint32_t hash_value              = 0;
-
-            if (!tmp_str_list)
-               continue;
-
-            if (tmp_str_list->size > 0)
-               strlcpy(elem0, tmp_str_list->elems[0].data, sizeof(elem0));
-            if (tmp_str_list->size > 1)
-               strlcpy(elem1, tmp_str_list->elems[1].data, sizeof(elem1));
-
-            hash_value = menu_hash_calculate(elem1);
-
-            switch (hash_value)
-            {
-               case MENU_VALUE_CRC:
-                  if (!strcmp(crc_str, elem0))
-                     match_found = true;
-                  break;
-               case MENU_VALUE_SHA1:
-                  if (!strcmp(db_info_entry->sha1, elem0))
-                     match_found = true;
-                  break;
-               case MENU_VALUE_MD5:
-                  if (!strcmp(db_info_entry->md5, elem0))
-                     match_found = true;
-                  break;
-            }
-
-            string_list_free(tmp_str_list);
-
-            if (!match_found)
-               continue;
-
+         /* Playlist entries store their checksum as "value|type". */
+         if (content_playlist_find_by_crc32(playlist, crc_str, &j)
+               || (db_info_entry->sha1 && content_playlist_find_by_crc32(
+                     playlist, db_info_entry->sha1, &j))
+               || (db_info_entry->md5 && content_playlist_find_by_crc32(
+                     playlist, db_info_entry->md5, &j)))
             rdb_entry_start_game_selection_ptr = j;
-         }
       }
 
       if (db_info_entry->name)
@@ -1452,11 +1453,12 @@ error:
 }
 
 static int menu_database_parse_query(file_list_t *list, const char *path,
-      const char *query)
+      const char *label, const char *value, const char *query)
 {
 #ifdef HAVE_LIBRETRODB
    unsigned i;
-   database_info_list_t *db_list = database_info_list_new(path, query);
+   database_info_list_t *db_list = menu_database_list_new(path,
+         label, value, query);
 
    if (!db_list)
       return -1;
@@ -2541,7 +2543,8 @@ int menu_displaylist_push_list(menu_displaylist_info_t *info, unsigned type)
          break;
       case DISPLAYLIST_DATABASE_QUERY:
          ret = menu_database_parse_query(info->list,
-               info->path, (info->path_c[0] == '\0') ? NULL : info->path_c);
+               info->path, info->label, info->path_b,
+               (info->path_c[0] == '\0') ? NULL : info->path_c);
          strlcpy(info->path, info->path_b, sizeof(info->path));
 
          need_sort    = true;
@@ -31,6 +31,9 @@
 #include "menu_setting.h"
 #include "../libretro.h"
 #include "../playlist.h"
+#ifdef HAVE_LIBRETRODB
+#include "../database_catalog.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -114,6 +117,10 @@ typedef struct
 
    content_playlist_t *playlist;
    char db_playlist_file[PATH_MAX_LENGTH];
+#ifdef HAVE_LIBRETRODB
+   /* All databases, loaded on the first database query. */
+   database_catalog_t *db_catalog;
+#endif
 } menu_handle_t;
 
 typedef struct menu_ctx_driver
@@ -955,7 +955,7 @@ unsigned menu_input_frame(retro_input_t input, retro_input_t trigger_input)
    if (!menu || !driver || !nav || !menu_input)
       return 0;
 
-   driver->retro_ctx.poll_cb();
+   retro_poll_input();
 
    /* don't run anything first frame, only capture held inputs
     * for old_input_state. */
@@ -1,7 +1,7 @@
 /*  RetroArch - A frontend for libretro.
  *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
  *  Copyright (C) 2011-2015 - Daniel De Matteis
- * 
+ *
  *  RetroArch is free software: you can redistribute it and/or modify it under the terms
  *  of the GNU General Public License as published by the Free Software Found-
  *  ation, either version 3 of the License, or (at your option) any later version.
@@ -19,14 +19,88 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_ZLIB
+#include <file/file_extract.h>
+#endif
+
 #include "general.h"
+#include "content.h"
 #include "dynamic.h"
 
+/* BSV2 movies store the input in blocks of frames, compressed
+ * separately, and a save state every so often as a keyframe to
+ * seek to. Magic numbers and tags are big-endian so they show up
+ * as text in a hex editor, all other fields are little-endian.
+ *
+ * header  : magic, 0, content CRC, state size,
+ *           frames per block, frames per keyframe, 0, 0
+ * chunk   : tag, flags, first frame (low, high), frames,
+ *           size, stored size, followed by the stored data
+ * trailer : index magic, entries, index chunk offset (low, high)
+ *
+ * Input blocks hold, for each frame, the number of inputs queried
+ * as a uint16_t followed by the int16_t inputs. Chunks of frames
+ * rewound over while recording are left in place, the chunks
+ * written afterwards supersede them. The index chunk lists the
+ * chunks in use when the movie is closed, movies that were not
+ * closed are indexed by reading all chunks in order. */
+#define BSV2_MAGIC                 0x42535632
+#define BSV2_INDEX_MAGIC           0x42535658
+
+#define BSV2_HEADER_SIZE           8
+#define BSV2_BLOCK_FRAMES_INDEX    4
+#define BSV2_KEYFRAME_FRAMES_INDEX 5
+
+#define BSV2_CHUNK_TAG             0
+#define BSV2_CHUNK_FLAGS           1
+#define BSV2_CHUNK_FRAME_LOW       2
+#define BSV2_CHUNK_FRAME_HIGH      3
+#define BSV2_CHUNK_FRAMES          4
+#define BSV2_CHUNK_SIZE            5
+#define BSV2_CHUNK_STORED_SIZE     6
+#define BSV2_CHUNK_HEADER_SIZE     7
+
+#define BSV2_INDEX_ENTRY_SIZE      6
+#define BSV2_TRAILER_SIZE          4
+
+#define BSV2_CHUNK_INPUT           0x494e5054 /* INPT */
+#define BSV2_CHUNK_STATE           0x53544154 /* STAT */
+#define BSV2_CHUNK_INDEX           0x494e4458 /* INDX */
+
+#define BSV2_CHUNK_DEFLATE         (1 << 0)
+
+#define BSV2_BLOCK_FRAMES          1024
+#define BSV2_KEYFRAME_FRAMES       (4 * BSV2_BLOCK_FRAMES)
+
+#define BSV2_INPUT_LEVEL           6
+#define BSV2_STATE_LEVEL           1
+
+struct bsv2_entry
+{
+   uint64_t frame;
+   uint64_t offset;
+   unsigned frames;
+};
+
+/* Chunks in use, sorted by frame. */
+struct bsv2_list
+{
+   struct bsv2_entry *entries;
+   size_t size;
+   size_t capacity;
+};
+
 struct bsv_movie
 {
    FILE *file;
+   unsigned version;
 
-   /* A ring buffer keeping track of positions
+   /* BSV1: A ring buffer keeping track of positions
     * in the file for each frame. */
    size_t *frame_pos;
    size_t frame_mask;
@@ -40,13 +114,601 @@ struct bsv_movie
    bool playback;
    bool first_rewind;
    bool did_rewind;
+
+   /* Frame being played back or recorded. */
+   uint64_t frame;
+
+   /* BSV2 */
+   struct bsv2_list blocks;
+   struct bsv2_list keyframes;
+   uint64_t length;
+   long write_pos;
+
+   /* Block holding the current frame, with the offset of
+    * each of its frames and of the end of the last one. */
+   uint8_t *block;
+   size_t block_size;
+   size_t block_capacity;
+   size_t block_pos[BSV2_BLOCK_FRAMES + 1];
+   unsigned block_frames;
+   uint64_t block_first;
+
+   /* Inputs of the current frame left to play back. */
+   bool frame_started;
+   size_t frame_cursor;
+   size_t frame_limit;
 };
 
+static bool bsv2_list_push(struct bsv2_list *list,
+      uint64_t frame, uint64_t offset, unsigned frames)
+{
+   struct bsv2_entry *entry = NULL;
+
+   /* A chunk written after rewinding supersedes
+    * the chunks of the frames rewound over. */
+   while (list->size && list->entries[list->size - 1].frame >= frame)
+      list->size--;
+
+   if (list->size == list->capacity)
+   {
+      size_t capacity             = list->capacity ? list->capacity * 2 : 64;
+      struct bsv2_entry *entries  = (struct bsv2_entry*)
+         realloc(list->entries, capacity * sizeof(*entries));
+
+      if (!entries)
+         return false;
+
+      list->entries  = entries;
+      list->capacity = capacity;
+   }
+
+   entry         = &list->entries[list->size++];
+   entry->frame  = frame;
+   entry->offset = offset;
+   entry->frames = frames;
+   return true;
+}
+
+/**
+ * bsv2_list_find:
+ * @list                : Chunks to search.
+ * @frame               : Frame to look for.
+ *
+ * Returns: last chunk starting at or before @frame,
+ * or NULL if there is none.
+ **/
+static const struct bsv2_entry *bsv2_list_find(
+      const struct bsv2_list *list, uint64_t frame)
+{
+   size_t lo = 0;
+   size_t hi = list->size;
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (list->entries[mid].frame <= frame)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return lo ? &list->entries[lo - 1] : NULL;
+}
+
+#ifdef HAVE_ZLIB_DEFLATE
+static uint8_t *bsv2_deflate(const uint8_t *data, size_t size,
+      int level, size_t *out_size)
+{
+   bool ret     = false;
+   size_t bound = size + (size >> 10) + 64;
+   void *stream = zlib_stream_new();
+   uint8_t *out = (uint8_t*)malloc(bound);
+
+   if (!stream || !out)
+      goto end;
+
+   if (!zlib_deflate_init2(stream, level))
+      goto end;
+
+   zlib_set_stream(stream, size, bound, data, out);
+
+   ret       = zlib_deflate_data_to_file(stream) == 1;
+   *out_size = zlib_stream_get_total_out(stream);
+   zlib_stream_deflate_free(stream);
+
+end:
+   free(stream);
+   if (!ret)
+   {
+      free(out);
+      return NULL;
+   }
+   return out;
+}
+#endif
+
+#ifdef HAVE_ZLIB
+static uint8_t *bsv2_inflate(const uint8_t *data, size_t size,
+      size_t out_size)
+{
+   bool ret     = false;
+   void *stream = zlib_stream_new();
+   uint8_t *out = (uint8_t*)malloc(out_size ? out_size : 1);
+
+   if (!stream || !out)
+      goto end;
+
+   if (!zlib_inflate_init2(stream))
+      goto end;
+
+   zlib_set_stream(stream, size, out_size, data, out);
+
+   ret = zlib_inflate_data_to_file_iterate(stream) == 1
+      && zlib_stream_get_total_out(stream) == out_size;
+   zlib_stream_free(stream);
+
+end:
+   free(stream);
+   if (!ret)
+   {
+      free(out);
+      return NULL;
+   }
+   return out;
+}
+#endif
+
+static bool bsv2_write_chunk(bsv_movie_t *handle, uint32_t tag,
+      uint64_t frame, unsigned frames,
+      const void *data, size_t size, int level)
+{
+   bool ret                                = false;
+   uint32_t header[BSV2_CHUNK_HEADER_SIZE] = {0};
+   const uint8_t *stored                   = (const uint8_t*)data;
+   size_t stored_size                      = size;
+   uint8_t *deflated                       = NULL;
+   long offset                             = handle->write_pos;
+
+#ifdef HAVE_ZLIB_DEFLATE
+   if (size && level)
+   {
+      size_t deflated_size = 0;
+
+      deflated = bsv2_deflate(stored, size, level, &deflated_size);
+
+      if (deflated && deflated_size < size)
+      {
+         stored                    = deflated;
+         stored_size               = deflated_size;
+         header[BSV2_CHUNK_FLAGS] |= BSV2_CHUNK_DEFLATE;
+      }
+   }
+#endif
+
+   header[BSV2_CHUNK_TAG]         = swap_if_little32(tag);
+   header[BSV2_CHUNK_FLAGS]       = swap_if_big32(header[BSV2_CHUNK_FLAGS]);
+   header[BSV2_CHUNK_FRAME_LOW]   = swap_if_big32((uint32_t)frame);
+   header[BSV2_CHUNK_FRAME_HIGH]  = swap_if_big32((uint32_t)(frame >> 32));
+   header[BSV2_CHUNK_FRAMES]      = swap_if_big32(frames);
+   header[BSV2_CHUNK_SIZE]        = swap_if_big32(size);
+   header[BSV2_CHUNK_STORED_SIZE] = swap_if_big32(stored_size);
+
+   if (fseek(handle->file, offset, SEEK_SET) == 0
+         && fwrite(header, sizeof(uint32_t), BSV2_CHUNK_HEADER_SIZE,
+            handle->file) == BSV2_CHUNK_HEADER_SIZE
+         && fwrite(stored, 1, stored_size, handle->file) == stored_size)
+      ret = true;
+
+   free(deflated);
+
+   if (!ret)
+   {
+      RARCH_ERR("Couldn't write to movie.\n");
+      return false;
+   }
+
+   handle->write_pos = ftell(handle->file);
+
+   if (tag == BSV2_CHUNK_INPUT)
+      return bsv2_list_push(&handle->blocks, frame, offset, frames);
+   if (tag == BSV2_CHUNK_STATE)
+      return bsv2_list_push(&handle->keyframes, frame, offset, frames);
+   return true;
+}
+
+static bool bsv2_read_chunk_header(bsv_movie_t *handle,
+      uint64_t offset, uint32_t *header)
+{
+   unsigned i;
+
+   if (fseek(handle->file, (long)offset, SEEK_SET) != 0)
+      return false;
+   if (fread(header, sizeof(uint32_t), BSV2_CHUNK_HEADER_SIZE,
+            handle->file) != BSV2_CHUNK_HEADER_SIZE)
+      return false;
+
+   header[BSV2_CHUNK_TAG] = swap_if_little32(header[BSV2_CHUNK_TAG]);
+   for (i = 1; i < BSV2_CHUNK_HEADER_SIZE; i++)
+      header[i] = swap_if_big32(header[i]);
+
+   return true;
+}
+
+static uint64_t bsv2_chunk_frame(const uint32_t *header)
+{
+   return header[BSV2_CHUNK_FRAME_LOW] |
+      ((uint64_t)header[BSV2_CHUNK_FRAME_HIGH] << 32);
+}
+
+/**
+ * bsv2_read_chunk:
+ * @handle              : Movie handle.
+ * @offset              : Offset of the chunk in the movie.
+ * @tag                 : Expected chunk tag.
+ * @size                : Size of the chunk data.
+ *
+ * Reads and decompresses the data of a chunk.
+ *
+ * Returns: chunk data, to be freed by the caller,
+ * or NULL if the chunk could not be read.
+ **/
+static uint8_t *bsv2_read_chunk(bsv_movie_t *handle,
+      uint64_t offset, uint32_t tag, size_t *size)
+{
+   uint32_t header[BSV2_CHUNK_HEADER_SIZE];
+   size_t stored_size;
+   uint8_t *stored = NULL;
+   uint8_t *data   = NULL;
+
+   if (!bsv2_read_chunk_header(handle, offset, header)
+         || header[BSV2_CHUNK_TAG] != tag)
+      return NULL;
+
+   *size       = header[BSV2_CHUNK_SIZE];
+   stored_size = header[BSV2_CHUNK_STORED_SIZE];
+   stored      = (uint8_t*)malloc(stored_size ? stored_size : 1);
+
+   if (!stored)
+      return NULL;
+
+   if (fread(stored, 1, stored_size, handle->file) != stored_size)
+      goto error;
+
+   if (!(header[BSV2_CHUNK_FLAGS] & BSV2_CHUNK_DEFLATE))
+   {
+      if (stored_size != *size)
+         goto error;
+      return stored;
+   }
+
+#ifdef HAVE_ZLIB
+   data = bsv2_inflate(stored, stored_size, *size);
+#endif
+
+error:
+   free(stored);
+   return data;
+}
+
+/**
+ * bsv2_parse_block:
+ * @handle              : Movie handle.
+ *
+ * Finds the frames of the block just loaded.
+ *
+ * Returns: true (1) if the block holds exactly its frames,
+ * otherwise false (0).
+ **/
+static bool bsv2_parse_block(bsv_movie_t *handle)
+{
+   unsigned i;
+   size_t pos = 0;
+
+   for (i = 0; i < handle->block_frames; i++)
+   {
+      uint16_t count;
+
+      handle->block_pos[i] = pos;
+
+      if (pos + sizeof(count) > handle->block_size)
+         return false;
+
+      memcpy(&count, handle->block + pos, sizeof(count));
+      pos += sizeof(count) + swap_if_big16(count) * sizeof(int16_t);
+   }
+
+   handle->block_pos[i] = pos;
+   return pos == handle->block_size;
+}
+
+static bool bsv2_load_block(bsv_movie_t *handle,
+      const struct bsv2_entry *entry)
+{
+   size_t size   = 0;
+   uint8_t *data = NULL;
+
+   if (entry->frames <= BSV2_BLOCK_FRAMES)
+      data = bsv2_read_chunk(handle, entry->offset,
+            BSV2_CHUNK_INPUT, &size);
+
+   if (!data)
+      goto error;
+
+   free(handle->block);
+   handle->block          = data;
+   handle->block_size     = size;
+   handle->block_capacity = size;
+   handle->block_first    = entry->frame;
+   handle->block_frames   = entry->frames;
+
+   if (!bsv2_parse_block(handle))
+   {
+      handle->block_frames = 0;
+      goto error;
+   }
+
+   return true;
+
+error:
+   RARCH_ERR("Couldn't read input of movie frame %llu.\n",
+         (unsigned long long)entry->frame);
+   return false;
+}
+
+static bool bsv2_block_append(bsv_movie_t *handle, uint16_t value)
+{
+   if (handle->block_size + sizeof(value) > handle->block_capacity)
+   {
+      size_t capacity = handle->block_capacity ?
+         handle->block_capacity * 2 : 4096;
+      uint8_t *block  = (uint8_t*)realloc(handle->block, capacity);
+
+      if (!block)
+         return false;
+
+      handle->block          = block;
+      handle->block_capacity = capacity;
+   }
+
+   value = swap_if_big16(value);
+   memcpy(handle->block + handle->block_size, &value, sizeof(value));
+   handle->block_size += sizeof(value);
+   return true;
+}
+
+static bool bsv2_flush_block(bsv_movie_t *handle)
+{
+   bool ret = true;
+
+   if (handle->block_frames)
+      ret = bsv2_write_chunk(handle, BSV2_CHUNK_INPUT,
+            handle->block_first, handle->block_frames,
+            handle->block, handle->block_pos[handle->block_frames],
+            BSV2_INPUT_LEVEL);
+
+   handle->block_first  += handle->block_frames;
+   handle->block_frames  = 0;
+   handle->block_size    = 0;
+   handle->block_pos[0]  = 0;
+   return ret;
+}
+
+static bool bsv2_write_keyframe(bsv_movie_t *handle)
+{
+   if (handle->state_size &&
+         !pretro_serialize(handle->state, handle->state_size))
+   {
+      RARCH_WARN("Couldn't save state of movie frame %llu.\n",
+            (unsigned long long)handle->frame);
+      return false;
+   }
+
+   return bsv2_write_chunk(handle, BSV2_CHUNK_STATE, handle->frame, 0,
+         handle->state, handle->state_size, BSV2_STATE_LEVEL);
+}
+
+static bool bsv2_write_index(bsv_movie_t *handle)
+{
+   size_t i, j;
+   uint32_t trailer[BSV2_TRAILER_SIZE];
+   const struct bsv2_list *lists[2];
+   static const uint32_t tags[2] = { BSV2_CHUNK_INPUT, BSV2_CHUNK_STATE };
+   bool ret        = false;
+   size_t count    = handle->blocks.size + handle->keyframes.size;
+   uint64_t offset = handle->write_pos;
+   uint32_t *index = (uint32_t*)
+      malloc((count ? count : 1) * BSV2_INDEX_ENTRY_SIZE * sizeof(uint32_t));
+   uint32_t *entry = index;
+
+   if (!index)
+      return false;
+
+   lists[0] = &handle->blocks;
+   lists[1] = &handle->keyframes;
+
+   for (i = 0; i < 2; i++)
+   {
+      for (j = 0; j < lists[i]->size; j++)
+      {
+         const struct bsv2_entry *e = &lists[i]->entries[j];
+
+         entry[0] = swap_if_little32(tags[i]);
+         entry[1] = swap_if_big32((uint32_t)e->frame);
+         entry[2] = swap_if_big32((uint32_t)(e->frame >> 32));
+         entry[3] = swap_if_big32((uint32_t)e->offset);
+         entry[4] = swap_if_big32((uint32_t)(e->offset >> 32));
+         entry[5] = swap_if_big32(e->frames);
+         entry   += BSV2_INDEX_ENTRY_SIZE;
+      }
+   }
+
+   if (!bsv2_write_chunk(handle, BSV2_CHUNK_INDEX, 0, count, index,
+            count * BSV2_INDEX_ENTRY_SIZE * sizeof(uint32_t), 0))
+      goto end;
+
+   trailer[0] = swap_if_little32(BSV2_INDEX_MAGIC);
+   trailer[1] = swap_if_big32(count);
+   trailer[2] = swap_if_big32((uint32_t)offset);
+   trailer[3] = swap_if_big32((uint32_t)(offset >> 32));
+
+   ret = fwrite(trailer, sizeof(uint32_t), BSV2_TRAILER_SIZE,
+         handle->file) == BSV2_TRAILER_SIZE;
+
+end:
+   free(index);
+   return ret;
+}
+
+static bool bsv2_read_index(bsv_movie_t *handle)
+{
+   size_t i;
+   uint32_t trailer[BSV2_TRAILER_SIZE];
+   uint64_t offset;
+   size_t size     = 0;
+   bool ret        = true;
+   uint8_t *index  = NULL;
+
+   if (fseek(handle->file, -(long)sizeof(trailer), SEEK_END) != 0)
+      return false;
+   if (fread(trailer, sizeof(uint32_t), BSV2_TRAILER_SIZE,
+            handle->file) != BSV2_TRAILER_SIZE)
+      return false;
+   if (swap_if_little32(trailer[0]) != BSV2_INDEX_MAGIC)
+      return false;
+
+   offset = swap_if_big32(trailer[2]) |
+      ((uint64_t)swap_if_big32(trailer[3]) << 32);
+   index  = bsv2_read_chunk(handle, offset, BSV2_CHUNK_INDEX, &size);
+
+   if (!index)
+      return false;
+
+   for (i = 0; ret && i + BSV2_INDEX_ENTRY_SIZE * sizeof(uint32_t) <= size;
+         i += BSV2_INDEX_ENTRY_SIZE * sizeof(uint32_t))
+   {
+      uint32_t entry[BSV2_INDEX_ENTRY_SIZE];
+      struct bsv2_list *list = NULL;
+
+      memcpy(entry, index + i, sizeof(entry));
+
+      switch (swap_if_little32(entry[0]))
+      {
+         case BSV2_CHUNK_INPUT:
+            list = &handle->blocks;
+            break;
+         case BSV2_CHUNK_STATE:
+            list = &handle->keyframes;
+            break;
+         default:
+            ret = false;
+            continue;
+      }
+
+      ret = bsv2_list_push(list,
+            swap_if_big32(entry[1]) | ((uint64_t)swap_if_big32(entry[2]) << 32),
+            swap_if_big32(entry[3]) | ((uint64_t)swap_if_big32(entry[4]) << 32),
+            swap_if_big32(entry[5]));
+   }
+
+   free(index);
+   return ret;
+}
+
+static void bsv2_scan_chunks(bsv_movie_t *handle)
+{
+   long file_size;
+   uint32_t header[BSV2_CHUNK_HEADER_SIZE];
+   long offset = BSV2_HEADER_SIZE * sizeof(uint32_t);
+
+   handle->blocks.size    = 0;
+   handle->keyframes.size = 0;
+
+   if (fseek(handle->file, 0, SEEK_END) != 0)
+      return;
+   file_size = ftell(handle->file);
+
+   while (offset + (long)sizeof(header) <= file_size
+         && bsv2_read_chunk_header(handle, offset, header))
+   {
+      uint64_t frame = bsv2_chunk_frame(header);
+
+      if (header[BSV2_CHUNK_STORED_SIZE] >
+            (uint64_t)(file_size - offset - (long)sizeof(header)))
+         break;
+
+      if (header[BSV2_CHUNK_TAG] == BSV2_CHUNK_INPUT)
+         bsv2_list_push(&handle->blocks, frame, offset,
+               header[BSV2_CHUNK_FRAMES]);
+      else if (header[BSV2_CHUNK_TAG] == BSV2_CHUNK_STATE)
+         bsv2_list_push(&handle->keyframes, frame, offset, 0);
+      else if (header[BSV2_CHUNK_TAG] != BSV2_CHUNK_INDEX)
+         break;
+
+      offset += sizeof(header) + header[BSV2_CHUNK_STORED_SIZE];
+   }
+}
+
+static bool bsv2_init_playback(bsv_movie_t *handle)
+{
+   uint32_t header[BSV2_HEADER_SIZE - 4];
+   const struct bsv2_entry *entry = NULL;
+
+   if (fread(header, sizeof(uint32_t), BSV2_HEADER_SIZE - 4,
+            handle->file) != BSV2_HEADER_SIZE - 4)
+   {
+      RARCH_ERR("Couldn't read movie header.\n");
+      return false;
+   }
+
+   if (!bsv2_read_index(handle))
+   {
+      RARCH_WARN("Movie was not closed properly, reading all of it.\n");
+      bsv2_scan_chunks(handle);
+   }
+
+   if (handle->blocks.size)
+   {
+      entry          = &handle->blocks.entries[handle->blocks.size - 1];
+      handle->length = entry->frame + entry->frames;
+   }
+
+   entry = bsv2_list_find(&handle->keyframes, 0);
+   if (entry && entry->frame == 0)
+   {
+      size_t size    = 0;
+      uint8_t *state = bsv2_read_chunk(handle, entry->offset,
+            BSV2_CHUNK_STATE, &size);
+
+      if (!state)
+      {
+         RARCH_ERR("Couldn't read state from movie.\n");
+         return false;
+      }
+
+      if (size)
+      {
+         if (pretro_serialize_size() == size)
+            pretro_unserialize(state, size);
+         else
+            RARCH_WARN("Movie format seems to have a different serializer version. Will most likely fail.\n");
+      }
+
+      free(state);
+   }
+   else
+      RARCH_WARN("Movie has no starting state. Will most likely fail.\n");
+
+   handle->state_size = pretro_serialize_size();
+
+   RARCH_LOG("Movie has %llu frames.\n", (unsigned long long)handle->length);
+   return true;
+}
+
 static bool init_playback(bsv_movie_t *handle, const char *path)
 {
    uint32_t state_size;
    uint32_t header[4] = {0};
-   global_t *global   = global_get_ptr();
 
    handle->playback   = true;
    handle->file       = fopen(path, "rb");
@@ -63,19 +725,26 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
       return false;
    }
 
+   if (swap_if_big32(header[CRC_INDEX]) != content_get_crc())
+      RARCH_WARN("CRC32 checksum mismatch between content file and saved content checksum in replay file header; replay highly likely to desync on playback.\n");
+
+   if (swap_if_little32(header[MAGIC_INDEX]) == BSV2_MAGIC)
+   {
+      handle->version = 2;
+      return bsv2_init_playback(handle);
+   }
+
    /* Compatibility with old implementation that
     * used incorrect documentation. */
    if (swap_if_little32(header[MAGIC_INDEX]) != BSV_MAGIC
          && swap_if_big32(header[MAGIC_INDEX]) != BSV_MAGIC)
    {
-      RARCH_ERR("Movie file is not a valid BSV1 file.\n");
+      RARCH_ERR("Movie file is not a valid BSV1 or BSV2 file.\n");
       return false;
    }
 
-   if (swap_if_big32(header[CRC_INDEX]) != global->content_crc)
-      RARCH_WARN("CRC32 checksum mismatch between content file and saved content checksum in replay file header; replay highly likely to desync on playback.\n");
-
-   state_size = swap_if_big32(header[STATE_SIZE_INDEX]);
+   handle->version = 1;
+   state_size      = swap_if_big32(header[STATE_SIZE_INDEX]);
 
    if (state_size)
    {
@@ -98,16 +767,24 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
 
    handle->min_file_pos = sizeof(header) + state_size;
 
+   /* Just pick something really large
+    * ~1 million frames rewind should do the trick. */
+   if (!(handle->frame_pos = (size_t*)calloc((1 << 20), sizeof(size_t))))
+      return false;
+
+   handle->frame_pos[0]    = handle->min_file_pos;
+   handle->frame_mask      = (1 << 20) - 1;
+
    return true;
 }
 
 static bool init_record(bsv_movie_t *handle, const char *path)
 {
    uint32_t state_size;
-   uint32_t header[4] = {0};
-   global_t *global   = global_get_ptr();
+   uint32_t header[BSV2_HEADER_SIZE] = {0};
 
-   handle->file       = fopen(path, "wb");
+   handle->version    = 2;
+   handle->file       = fopen(path, "w+b");
    if (!handle->file)
    {
       RARCH_ERR("Couldn't open BSV \"%s\" for recording.\n", path);
@@ -115,28 +792,32 @@ static bool init_record(bsv_movie_t *handle, const char *path)
    }
 
    /* This value is supposed to show up as
-    * BSV1 in a HEX editor, big-endian. */
-   header[MAGIC_INDEX]      = swap_if_little32(BSV_MAGIC);
-   header[CRC_INDEX]        = swap_if_big32(global->content_crc);
-   state_size               = pretro_serialize_size();
-   header[STATE_SIZE_INDEX] = swap_if_big32(state_size);
+    * BSV2 in a HEX editor, big-endian. */
+   header[MAGIC_INDEX]                = swap_if_little32(BSV2_MAGIC);
+   header[CRC_INDEX]                  = swap_if_big32(content_get_crc());
+   state_size                         = pretro_serialize_size();
+   header[STATE_SIZE_INDEX]           = swap_if_big32(state_size);
+   header[BSV2_BLOCK_FRAMES_INDEX]    = swap_if_big32(BSV2_BLOCK_FRAMES);
+   header[BSV2_KEYFRAME_FRAMES_INDEX] = swap_if_big32(BSV2_KEYFRAME_FRAMES);
 
-   fwrite(header, 4, sizeof(uint32_t), handle->file);
+   if (fwrite(header, sizeof(uint32_t), BSV2_HEADER_SIZE,
+            handle->file) != BSV2_HEADER_SIZE)
+   {
+      RARCH_ERR("Couldn't write movie header.\n");
+      return false;
+   }
 
-   handle->min_file_pos     = sizeof(header) + state_size;
-   handle->state_size       = state_size;
+   handle->write_pos  = sizeof(header);
+   handle->state_size = state_size;
 
    if (state_size)
    {
       handle->state = (uint8_t*)malloc(state_size);
       if (!handle->state)
          return false;
-
-      pretro_serialize(handle->state, state_size);
-      fwrite(handle->state, 1, state_size, handle->file);
    }
 
-   return true;
+   return bsv2_write_keyframe(handle);
 }
 
 void bsv_movie_free(bsv_movie_t *handle)
@@ -144,16 +825,149 @@ void bsv_movie_free(bsv_movie_t *handle)
    if (!handle)
       return;
 
+   /* A frame left open was not run to the end, and is dropped. */
+   if (handle->version == 2 && !handle->playback && handle->file)
+   {
+      if (!bsv2_flush_block(handle) || !bsv2_write_index(handle))
+         RARCH_ERR("Couldn't finish writing movie.\n");
+   }
+
    if (handle->file)
       fclose(handle->file);
    free(handle->state);
    free(handle->frame_pos);
+   free(handle->blocks.entries);
+   free(handle->keyframes.entries);
+   free(handle->block);
    free(handle);
 }
 
+static void bsv2_frame_start(bsv_movie_t *handle)
+{
+   uint64_t frame = handle->frame;
+
+   if (handle->frame_started)
+      return;
+   handle->frame_started = true;
+
+   if (!handle->playback)
+   {
+      if (handle->block_frames == BSV2_BLOCK_FRAMES)
+         bsv2_flush_block(handle);
+
+      if (handle->state_size && (frame % BSV2_KEYFRAME_FRAMES) == 0
+            && (!handle->keyframes.size ||
+               handle->keyframes.entries[handle->keyframes.size - 1].frame
+               < frame))
+         bsv2_write_keyframe(handle);
+
+      /* Number of inputs, filled in at the end of the frame. */
+      bsv2_block_append(handle, 0);
+      return;
+   }
+
+   handle->frame_cursor = 0;
+   handle->frame_limit  = 0;
+
+   if (frame >= handle->length)
+      return;
+
+   if (frame < handle->block_first ||
+         frame >= handle->block_first + handle->block_frames)
+   {
+      const struct bsv2_entry *entry = bsv2_list_find(&handle->blocks, frame);
+
+      if (!entry || !bsv2_load_block(handle, entry)
+            || frame >= handle->block_first + handle->block_frames)
+      {
+         /* End the movie at the frames that could not be read. */
+         handle->length = frame;
+         return;
+      }
+   }
+
+   frame                -= handle->block_first;
+   handle->frame_cursor  = handle->block_pos[frame] + sizeof(uint16_t);
+   handle->frame_limit   = handle->block_pos[frame + 1];
+}
+
+static void bsv2_frame_end(bsv_movie_t *handle)
+{
+   bsv2_frame_start(handle);
+
+   if (!handle->playback)
+   {
+      size_t pos     = handle->block_pos[handle->block_frames];
+      uint16_t count = swap_if_big16((uint16_t)((handle->block_size - pos
+                  - sizeof(count)) / sizeof(int16_t)));
+
+      if (handle->block_size >= pos + sizeof(count))
+      {
+         memcpy(handle->block + pos, &count, sizeof(count));
+         handle->block_pos[++handle->block_frames] = handle->block_size;
+      }
+   }
+
+   handle->frame_started = false;
+   handle->frame++;
+}
+
+/**
+ * bsv2_goto_frame:
+ * @handle              : Movie handle.
+ * @frame               : Frame to play back or record next.
+ *
+ * When recording, drops all frames from @frame on, reloading
+ * the block holding @frame if it was written already.
+ **/
+static void bsv2_goto_frame(bsv_movie_t *handle, uint64_t frame)
+{
+   handle->frame_started = false;
+
+   if (handle->playback)
+   {
+      handle->frame = frame;
+      return;
+   }
+
+   if (frame < handle->block_first)
+   {
+      const struct bsv2_entry *entry = bsv2_list_find(&handle->blocks, frame);
+
+      if (entry && bsv2_load_block(handle, entry))
+         handle->blocks.size = entry - handle->blocks.entries;
+      else
+         frame = handle->block_first;
+   }
+
+   handle->frame        = frame;
+   handle->block_frames = frame - handle->block_first;
+   handle->block_size   = handle->block_pos[handle->block_frames];
+
+   while (handle->keyframes.size &&
+         handle->keyframes.entries[handle->keyframes.size - 1].frame > frame)
+      handle->keyframes.size--;
+}
+
 bool bsv_movie_get_input(bsv_movie_t *handle, int16_t *input)
 {
-   if (fread(input, sizeof(int16_t), 1, handle->file) != 1)
+   if (handle->version == 2)
+   {
+      bsv2_frame_start(handle);
+
+      if (handle->frame >= handle->length)
+         return false;
+
+      /* Cores may query more inputs than they did
+       * when recording, those are not pressed. */
+      *input = 0;
+      if (handle->frame_cursor + sizeof(*input) <= handle->frame_limit)
+      {
+         memcpy(input, handle->block + handle->frame_cursor, sizeof(*input));
+         handle->frame_cursor += sizeof(*input);
+      }
+   }
+   else if (fread(input, sizeof(int16_t), 1, handle->file) != 1)
       return false;
 
    *input = swap_if_big16(*input);
@@ -162,8 +976,13 @@ bool bsv_movie_get_input(bsv_movie_t *handle, int16_t *input)
 
 void bsv_movie_set_input(bsv_movie_t *handle, int16_t input)
 {
-   input = swap_if_big16(input);
-   fwrite(&input, sizeof(int16_t), 1, handle->file);
+   bsv2_frame_start(handle);
+
+   if (handle->block_size - handle->block_pos[handle->block_frames]
+         - sizeof(uint16_t) >= 0xffff * sizeof(int16_t))
+      return;
+
+   bsv2_block_append(handle, (uint16_t)input);
 }
 
 bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
@@ -180,14 +999,6 @@ bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
    else if (!init_record(handle, path))
       goto error;
 
-   /* Just pick something really large 
-    * ~1 million frames rewind should do the trick. */
-   if (!(handle->frame_pos = (size_t*)calloc((1 << 20), sizeof(size_t))))
-      goto error; 
-
-   handle->frame_pos[0]    = handle->min_file_pos;
-   handle->frame_mask      = (1 << 20) - 1;
-
    return handle;
 
 error:
@@ -199,7 +1010,11 @@ void bsv_movie_set_frame_start(bsv_movie_t *handle)
 {
    if (!handle)
       return;
-   handle->frame_pos[handle->frame_ptr] = ftell(handle->file);
+
+   if (handle->version == 2)
+      bsv2_frame_start(handle);
+   else
+      handle->frame_pos[handle->frame_ptr] = ftell(handle->file);
 }
 
 void bsv_movie_set_frame_end(bsv_movie_t *handle)
@@ -207,7 +1022,13 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle)
    if (!handle)
       return;
 
-   handle->frame_ptr    = (handle->frame_ptr + 1) & handle->frame_mask;
+   if (handle->version == 2)
+      bsv2_frame_end(handle);
+   else
+   {
+      handle->frame_ptr = (handle->frame_ptr + 1) & handle->frame_mask;
+      handle->frame++;
+   }
 
    handle->first_rewind = !handle->did_rewind;
    handle->did_rewind   = false;
@@ -215,41 +1036,92 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle)
 
 void bsv_movie_frame_rewind(bsv_movie_t *handle)
 {
+   /* First time rewind is performed, the old frame is simply replayed.
+    * However, playing back that frame caused us to read data, and push
+    * data to the ring buffer.
+    *
+    * Sucessively rewinding frames, we need to rewind past the read data,
+    * plus another. */
+   unsigned back = handle->first_rewind ? 1 : 2;
+
    handle->did_rewind = true;
 
+   if (handle->version == 2)
+   {
+      bsv2_goto_frame(handle,
+            handle->frame > back ? handle->frame - back : 0);
+
+      /* If recording and we rewound past the beginning,
+       * we simply reset the starting point. */
+      if (!handle->frame && !handle->playback)
+         bsv2_write_keyframe(handle);
+      return;
+   }
+
    if ((handle->frame_ptr <= 1) && (handle->frame_pos[0] == handle->min_file_pos))
    {
       /* If we're at the beginning... */
       handle->frame_ptr = 0;
+      handle->frame     = 0;
       fseek(handle->file, handle->min_file_pos, SEEK_SET);
    }
    else
    {
-      /* First time rewind is performed, the old frame is simply replayed.
-       * However, playing back that frame caused us to read data, and push
-       * data to the ring buffer.
-       *
-       * Sucessively rewinding frames, we need to rewind past the read data,
-       * plus another. */
-      handle->frame_ptr = (handle->frame_ptr -
-            (handle->first_rewind ? 1 : 2)) & handle->frame_mask;
+      handle->frame_ptr = (handle->frame_ptr - back) & handle->frame_mask;
+      handle->frame     = handle->frame > back ? handle->frame - back : 0;
       fseek(handle->file, handle->frame_pos[handle->frame_ptr], SEEK_SET);
    }
 
+   /* We rewound past the beginning. */
    if (ftell(handle->file) <= (long)handle->min_file_pos)
-   {
-      /* We rewound past the beginning. */
+      fseek(handle->file, handle->min_file_pos, SEEK_SET);
+}
 
-      if (!handle->playback)
-      {
-         /* If recording, we simply reset
-          * the starting point. Nice and easy. */
-         fseek(handle->file, 4 * sizeof(uint32_t), SEEK_SET);
-         pretro_serialize(handle->state, handle->state_size);
-         fwrite(handle->state, 1, handle->state_size, handle->file);
-      }
-      else
-         fseek(handle->file, handle->min_file_pos, SEEK_SET);
-   }
+bool bsv_movie_seek(bsv_movie_t *handle, uint64_t frame, uint64_t *reached)
+{
+   bool ret                       = false;
+   size_t size                    = 0;
+   uint8_t *state                 = NULL;
+   const struct bsv2_entry *entry = NULL;
+
+   if (!handle || handle->version != 2 || !handle->playback)
+      return false;
+
+   if (frame > handle->length)
+      frame = handle->length;
+
+   entry = bsv2_list_find(&handle->keyframes, frame);
+   if (!entry)
+      return false;
+
+   state = bsv2_read_chunk(handle, entry->offset, BSV2_CHUNK_STATE, &size);
+   if (!state)
+      return false;
+
+   if (size && size == handle->state_size)
+      ret = pretro_unserialize(state, size);
+   free(state);
+
+   if (!ret)
+      return false;
+
+   bsv2_goto_frame(handle, entry->frame);
+   handle->first_rewind = true;
+   handle->did_rewind   = false;
+
+   if (reached)
+      *reached = entry->frame;
+   return true;
 }
 
+uint64_t bsv_movie_get_frame(bsv_movie_t *handle)
+{
+   return handle ? handle->frame : 0;
+}
+
+uint64_t bsv_movie_get_length(bsv_movie_t *handle)
+{
+   if (!handle || handle->version != 2)
+      return 0;
+   return handle->playback ? handle->length : handle->frame;
+}
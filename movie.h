@@ -55,6 +55,25 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle);
 
 void bsv_movie_frame_rewind(bsv_movie_t *handle);
 
+/**
+ * bsv_movie_seek:
+ * @handle              : Movie being played back.
+ * @frame               : Frame to seek to.
+ * @reached             : Frame actually reached.
+ *
+ * Loads the last keyframe of a BSV2 movie at or before @frame.
+ * The caller runs the core until @frame from there.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool bsv_movie_seek(bsv_movie_t *handle, uint64_t frame, uint64_t *reached);
+
+/* Frame being played back or recorded. */
+uint64_t bsv_movie_get_frame(bsv_movie_t *handle);
+
+/* Number of frames of a BSV2 movie, or 0 if unknown. */
+uint64_t bsv_movie_get_length(bsv_movie_t *handle);
+
 void bsv_movie_free(bsv_movie_t *handle);
 
 #ifdef __cplusplus
@@ -24,6 +24,7 @@
 #include "netplay.h"
 #include "general.h"
 #include "autosave.h"
+#include "content.h"
 #include "dynamic.h"
 #include "msg_hash.h"
 #include "system.h"
@@ -891,9 +892,8 @@ static bool send_info(netplay_t *netplay)
    char msg[512]      = {0};
    void *sram         = NULL;
    uint32_t header[3] = {0};
-   global_t *global   = global_get_ptr();
    
-   header[0] = htonl(global->content_crc);
+   header[0] = htonl(content_get_crc());
    header[1] = htonl(implementation_magic_value());
    header[2] = htonl(pretro_get_memory_size(RETRO_MEMORY_SAVE_RAM));
 
@@ -934,7 +934,6 @@ static bool get_info(netplay_t *netplay)
    unsigned sram_size;
    uint32_t header[3];
    const void *sram = NULL;
-   global_t *global = global_get_ptr();
 
    if (!socket_receive_all_blocking(netplay->fd, header, sizeof(header)))
    {
@@ -942,7 +941,7 @@ static bool get_info(netplay_t *netplay)
       return false;
    }
 
-   if (global->content_crc != ntohl(header[0]))
+   if (content_get_crc() != ntohl(header[0]))
    {
       RARCH_ERR("Content CRC32s differ. Cannot use different games.\n");
       return false;
@@ -994,7 +993,6 @@ static uint32_t *bsv_header_generate(size_t *size, uint32_t magic)
    uint32_t *header, bsv_header[4] = {0};
    size_t serialize_size = pretro_serialize_size();
    size_t header_size = sizeof(bsv_header) + serialize_size;
-   global_t *global = global_get_ptr();
 
    *size = header_size;
 
@@ -1004,7 +1002,7 @@ static uint32_t *bsv_header_generate(size_t *size, uint32_t magic)
 
    bsv_header[MAGIC_INDEX]      = swap_if_little32(BSV_MAGIC);
    bsv_header[SERIALIZER_INDEX] = swap_if_big32(magic);
-   bsv_header[CRC_INDEX]        = swap_if_big32(global->content_crc);
+   bsv_header[CRC_INDEX]        = swap_if_big32(content_get_crc());
    bsv_header[STATE_SIZE_INDEX] = swap_if_big32(serialize_size);
 
    if (serialize_size && !pretro_serialize(header + 4, serialize_size))
@@ -1021,7 +1019,6 @@ static bool bsv_parse_header(const uint32_t *header, uint32_t magic)
 {
    uint32_t in_crc, in_magic, in_state_size;
    uint32_t in_bsv = swap_if_little32(header[MAGIC_INDEX]);
-   global_t *global = global_get_ptr();
 
    if (in_bsv != BSV_MAGIC)
    {
@@ -1038,10 +1035,10 @@ static bool bsv_parse_header(const uint32_t *header, uint32_t magic)
    }
 
    in_crc = swap_if_big32(header[CRC_INDEX]);
-   if (in_crc != global->content_crc)
+   if (in_crc != content_get_crc())
    {
       RARCH_ERR("CRC32 mismatch, got 0x%x, expected 0x%x.\n", in_crc,
-            global->content_crc);
+            content_get_crc());
       return false;
    }
 
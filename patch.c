@@ -26,11 +26,75 @@
 #include <compat/msvc.h>
 #include <file/file_path.h>
 #include <file/file_extract.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "patch.h"
 #include "file_ops.h"
 #include "general.h"
 
+typedef patch_error_t (*patch_size_func_t)(const uint8_t*, size_t,
+      size_t, size_t*);
+
+/* Source and patch checksums only depend on the input buffers,
+ * so they are computed on a worker thread while the patch is
+ * being applied. The target checksum is computed over the
+ * whole output once it has been written. */
+struct patch_crc_job
+{
+   const uint8_t *source_data, *patch_data;
+   size_t source_length, patch_length;
+   uint32_t source_checksum, patch_checksum;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+#endif
+};
+
+static uint32_t patch_crc32(const uint8_t *data, size_t length)
+{
+#ifdef HAVE_ZLIB
+   return zlib_crc32_calculate(data, length);
+#else
+   return 0;
+#endif
+}
+
+static void patch_crc_job_func(void *data)
+{
+   struct patch_crc_job *job = (struct patch_crc_job*)data;
+
+   job->source_checksum = patch_crc32(job->source_data, job->source_length);
+   job->patch_checksum  = patch_crc32(job->patch_data, job->patch_length);
+}
+
+static void patch_crc_job_start(struct patch_crc_job *job,
+      const uint8_t *source_data, size_t source_length,
+      const uint8_t *patch_data, size_t patch_length)
+{
+   job->source_data   = source_data;
+   job->source_length = source_length;
+   job->patch_data    = patch_data;
+   job->patch_length  = patch_length;
+
+#ifdef HAVE_THREADS
+   job->thread = sthread_create(patch_crc_job_func, job);
+   if (job->thread)
+      return;
+#endif
+
+   patch_crc_job_func(job);
+}
+
+static void patch_crc_job_wait(struct patch_crc_job *job)
+{
+#ifdef HAVE_THREADS
+   if (job->thread)
+      sthread_join(job->thread);
+   job->thread = NULL;
+#endif
+}
+
 enum bps_mode
 {
    SOURCE_READ = 0,
@@ -45,25 +109,22 @@ struct bps_data
    uint8_t *target_data;
    size_t modify_length, source_length, target_length;
    size_t modify_offset, source_offset, target_offset;
-   uint32_t modify_checksum, source_checksum, target_checksum;
 
    size_t source_relative_offset, target_relative_offset, output_offset;
 };
 
 static uint8_t bps_read(struct bps_data *bps)
 {
-   uint8_t data = bps->modify_data[bps->modify_offset++];
-#ifdef HAVE_ZLIB
-   bps->modify_checksum = zlib_crc32_adjust(bps->modify_checksum, data);
-#endif
-   return data;
+   if (bps->modify_offset >= bps->modify_length)
+      return 0;
+   return bps->modify_data[bps->modify_offset++];
 }
 
 static uint64_t bps_decode(struct bps_data *bps)
 {
    uint64_t data = 0, shift = 1;
 
-   for (;;)
+   while (bps->modify_offset < bps->modify_length)
    {
       uint8_t x = bps_read(bps);
       data += (x & 0x7f) * shift;
@@ -76,15 +137,43 @@ static uint64_t bps_decode(struct bps_data *bps)
    return data;
 }
 
-static void bps_write(struct bps_data *bps, uint8_t data)
+static patch_error_t bps_read_header(struct bps_data *bps,
+      size_t *source_size, size_t *target_size)
 {
-   if (!bps)
-      return;
+   size_t markup_size;
 
-   bps->target_data[bps->output_offset++] = data;
-#ifdef HAVE_ZLIB
-   bps->target_checksum = zlib_crc32_adjust(bps->target_checksum, data);
-#endif
+   if (bps->modify_length < 19)
+      return PATCH_PATCH_TOO_SMALL;
+
+   if ((bps_read(bps) != 'B') || (bps_read(bps) != 'P') ||
+         (bps_read(bps) != 'S') || (bps_read(bps) != '1'))
+      return PATCH_PATCH_INVALID_HEADER;
+
+   *source_size = bps_decode(bps);
+   *target_size = bps_decode(bps);
+   markup_size  = bps_decode(bps);
+
+   if (bps->modify_offset > bps->modify_length - 12
+         || markup_size > bps->modify_length - 12 - bps->modify_offset)
+      return PATCH_PATCH_INVALID;
+   bps->modify_offset += markup_size;
+
+   return PATCH_SUCCESS;
+}
+
+static patch_error_t bps_target_size(
+      const uint8_t *modify_data, size_t modify_length,
+      size_t source_length, size_t *target_length)
+{
+   size_t modify_source_size;
+   struct bps_data bps = {0};
+
+   (void)source_length;
+
+   bps.modify_data   = modify_data;
+   bps.modify_length = modify_length;
+
+   return bps_read_header(&bps, &modify_source_size, target_length);
 }
 
 patch_error_t bps_apply_patch(
@@ -93,14 +182,12 @@ patch_error_t bps_apply_patch(
       uint8_t *target_data, size_t *target_length)
 {
    size_t i;
-   size_t modify_source_size, modify_target_size,
-          modify_markup_size;
+   size_t modify_source_size, modify_target_size;
+   struct patch_crc_job job;
    struct bps_data bps = {0};
    uint32_t modify_source_checksum = 0, modify_target_checksum = 0,
-            modify_modify_checksum = 0, checksum;
-
-   if (modify_length < 19)
-      return PATCH_PATCH_TOO_SMALL;
+            modify_modify_checksum = 0, target_checksum;
+   patch_error_t err;
 
    bps.modify_data = modify_data;
    bps.modify_length = modify_length;
@@ -108,24 +195,24 @@ patch_error_t bps_apply_patch(
    bps.target_length = *target_length;
    bps.source_data = source_data;
    bps.source_length = source_length;
-   bps.modify_checksum = ~0;
-   bps.target_checksum = ~0;
 
-   if ((bps_read(&bps) != 'B') || (bps_read(&bps) != 'P') ||
-         (bps_read(&bps) != 'S') || (bps_read(&bps) != '1'))
-      return PATCH_PATCH_INVALID_HEADER;
-
-   modify_source_size = bps_decode(&bps);
-   modify_target_size = bps_decode(&bps);
-   modify_markup_size = bps_decode(&bps);
-   for (i = 0; i < modify_markup_size; i++)
-      bps_read(&bps);
+   err = bps_read_header(&bps, &modify_source_size, &modify_target_size);
+   if (err != PATCH_SUCCESS)
+      return err;
 
    if (modify_source_size > bps.source_length)
       return PATCH_SOURCE_TOO_SMALL;
    if (modify_target_size > bps.target_length)
       return PATCH_TARGET_TOO_SMALL;
 
+   bps.target_length = modify_target_size;
+
+   /* The patch checksum covers everything but itself. */
+   patch_crc_job_start(&job, bps.source_data, bps.source_length,
+         bps.modify_data, bps.modify_length - 4);
+
+   err = PATCH_PATCH_INVALID;
+
    while (bps.modify_offset < bps.modify_length - 12)
    {
       size_t length = bps_decode(&bps);
@@ -133,16 +220,26 @@ patch_error_t bps_apply_patch(
 
       length = (length >> 2) + 1;
 
+      if (length > bps.target_length - bps.output_offset)
+         goto end;
+
       switch (mode)
       {
          case SOURCE_READ:
-            while (length--)
-               bps_write(&bps, bps.source_data[bps.output_offset]);
+            if (bps.output_offset + length > bps.source_length)
+               goto end;
+            memcpy(bps.target_data + bps.output_offset,
+                  bps.source_data + bps.output_offset, length);
+            bps.output_offset += length;
             break;
 
          case TARGET_READ:
-            while (length--)
-               bps_write(&bps, bps_read(&bps));
+            if (length > bps.modify_length - bps.modify_offset)
+               goto end;
+            memcpy(bps.target_data + bps.output_offset,
+                  bps.modify_data + bps.modify_offset, length);
+            bps.modify_offset += length;
+            bps.output_offset += length;
             break;
 
          case SOURCE_COPY:
@@ -159,49 +256,66 @@ patch_error_t bps_apply_patch(
             if (mode == SOURCE_COPY)
             {
                bps.source_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.source_data[bps.source_offset++]);
+               if (bps.source_offset > bps.source_length
+                     || length > bps.source_length - bps.source_offset)
+                  goto end;
+
+               memcpy(bps.target_data + bps.output_offset,
+                     bps.source_data + bps.source_offset, length);
+               bps.source_offset += length;
+               bps.output_offset += length;
             }
             else
             {
                bps.target_offset += offset;
+               if (bps.target_offset >= bps.output_offset)
+                  goto end;
+
+               /* May overlap the output, which is used to
+                * repeat patterns, so copy byte by byte. */
                while (length--)
-                  bps_write(&bps, bps.target_data[bps.target_offset++]);
-               break;
+                  bps.target_data[bps.output_offset++] =
+                     bps.target_data[bps.target_offset++];
             }
             break;
          }
       }
    }
 
+   if (bps.modify_offset != bps.modify_length - 12)
+      goto end;
 
    for (i = 0; i < 32; i += 8)
       modify_source_checksum |= bps_read(&bps) << i;
    for (i = 0; i < 32; i += 8)
       modify_target_checksum |= bps_read(&bps) << i;
-
-   checksum = ~bps.modify_checksum;
    for (i = 0; i < 32; i += 8)
       modify_modify_checksum |= bps_read(&bps) << i;
 
-#ifdef HAVE_ZLIB
-   bps.source_checksum = zlib_crc32_calculate(bps.source_data, bps.source_length);
-#else
-   return PATCH_PATCH_CHECKSUM_INVALID;
-#endif
+   target_checksum = patch_crc32(bps.target_data, bps.output_offset);
 
-   bps.target_checksum = ~bps.target_checksum;
+   patch_crc_job_wait(&job);
 
-   if (bps.source_checksum != modify_source_checksum)
-      return PATCH_SOURCE_CHECKSUM_INVALID;
-   if (bps.target_checksum != modify_target_checksum)
-      return PATCH_TARGET_CHECKSUM_INVALID;
-   if (checksum != modify_modify_checksum)
-      return PATCH_PATCH_CHECKSUM_INVALID;
+#ifndef HAVE_ZLIB
+   err = PATCH_PATCH_CHECKSUM_INVALID;
+   goto end;
+#endif
 
-   *target_length = modify_target_size;
+   if (job.source_checksum != modify_source_checksum)
+      err = PATCH_SOURCE_CHECKSUM_INVALID;
+   else if (target_checksum != modify_target_checksum)
+      err = PATCH_TARGET_CHECKSUM_INVALID;
+   else if (job.patch_checksum != modify_modify_checksum)
+      err = PATCH_PATCH_CHECKSUM_INVALID;
+   else
+   {
+      *target_length = modify_target_size;
+      err = PATCH_SUCCESS;
+   }
 
-   return PATCH_SUCCESS;
+end:
+   patch_crc_job_wait(&job);
+   return err;
 }
 
 struct ups_data
@@ -210,44 +324,26 @@ struct ups_data
    uint8_t *target_data;
    unsigned patch_length, source_length, target_length;
    unsigned patch_offset, source_offset, target_offset;
-   unsigned patch_checksum, source_checksum, target_checksum;
 };
 
 static uint8_t ups_patch_read(struct ups_data *data) 
 {
    if (data && data->patch_offset < data->patch_length) 
-   {
-      uint8_t n = data->patch_data[data->patch_offset++];
-#ifdef HAVE_ZLIB
-      data->patch_checksum = zlib_crc32_adjust(data->patch_checksum, n);
-#endif
-      return n;
-   }
+      return data->patch_data[data->patch_offset++];
    return 0x00;
 }
 
 static uint8_t ups_source_read(struct ups_data *data) 
 {
    if (data && data->source_offset < data->source_length) 
-   {
-      uint8_t n = data->source_data[data->source_offset++];
-#ifdef HAVE_ZLIB
-      data->source_checksum = zlib_crc32_adjust(data->source_checksum, n);
-#endif
-      return n;
-   }
+      return data->source_data[data->source_offset++];
    return 0x00;
 }
 
 static void ups_target_write(struct ups_data *data, uint8_t n) 
 {
    if (data && data->target_offset < data->target_length) 
-   {
       data->target_data[data->target_offset] = n;
-#ifdef HAVE_ZLIB
-      data->target_checksum = zlib_crc32_adjust(data->target_checksum, n);
-#endif
-   }
 
    if (data)
       data->target_offset++;
@@ -256,7 +352,7 @@ static void ups_target_write(struct ups_data *data, uint8_t n)
 static uint64_t ups_decode(struct ups_data *data) 
 {
    uint64_t offset = 0, shift = 1;
-   while (true) 
+   while (data->patch_offset < data->patch_length) 
    {
       uint8_t x = ups_patch_read(data);
       offset   += (x & 0x7f) * shift;
@@ -269,6 +365,48 @@ static uint64_t ups_decode(struct ups_data *data)
    return offset;
 }
 
+static patch_error_t ups_read_header(struct ups_data *data,
+      unsigned *source_read_length, unsigned *target_read_length,
+      size_t *targetlength)
+{
+   if (data->patch_length < 18) 
+      return PATCH_PATCH_INVALID;
+   if (ups_patch_read(data) != 'U') 
+      return PATCH_PATCH_INVALID;
+   if (ups_patch_read(data) != 'P') 
+      return PATCH_PATCH_INVALID;
+   if (ups_patch_read(data) != 'S') 
+      return PATCH_PATCH_INVALID;
+   if (ups_patch_read(data) != '1') 
+      return PATCH_PATCH_INVALID;
+
+   *source_read_length = ups_decode(data);
+   *target_read_length = ups_decode(data);
+
+   if (data->source_length != *source_read_length
+         && data->source_length != *target_read_length) 
+      return PATCH_SOURCE_INVALID;
+   *targetlength = (data->source_length == *source_read_length ?
+         *target_read_length : *source_read_length);
+
+   return PATCH_SUCCESS;
+}
+
+static patch_error_t ups_target_size(
+      const uint8_t *patchdata, size_t patchlength,
+      size_t sourcelength, size_t *targetlength)
+{
+   unsigned source_read_length, target_read_length;
+   struct ups_data data = {0};
+
+   data.patch_data    = patchdata;
+   data.patch_length  = patchlength;
+   data.source_length = sourcelength;
+
+   return ups_read_header(&data, &source_read_length,
+         &target_read_length, targetlength);
+}
+
 patch_error_t ups_apply_patch(
       const uint8_t *patchdata, size_t patchlength,
       const uint8_t *sourcedata, size_t sourcelength,
@@ -277,42 +415,31 @@ patch_error_t ups_apply_patch(
    size_t i;
    unsigned source_read_length, target_read_length;
    uint32_t patch_read_checksum = 0, source_read_checksum = 0,
-            target_read_checksum = 0, patch_result_checksum;
+            target_read_checksum = 0, target_checksum;
+   struct patch_crc_job job;
    struct ups_data data = {0};
+   size_t target_capacity = *targetlength;
+   patch_error_t err;
 
    data.patch_data      = patchdata;
    data.source_data     = sourcedata;
    data.target_data     = targetdata;
    data.patch_length    = patchlength;
    data.source_length   = sourcelength;
-   data.target_length   = *targetlength;
-   data.patch_checksum  = ~0;
-   data.source_checksum = ~0;
-   data.target_checksum = ~0;
 
-   if (data.patch_length < 18) 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'U') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'P') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'S') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != '1') 
-      return PATCH_PATCH_INVALID;
-
-   source_read_length = ups_decode(&data);
-   target_read_length = ups_decode(&data);
-
-   if (data.source_length != source_read_length
-         && data.source_length != target_read_length) 
-      return PATCH_SOURCE_INVALID;
-   *targetlength = (data.source_length == source_read_length ?
-         target_read_length : source_read_length);
-   if (data.target_length < *targetlength) 
+   err = ups_read_header(&data, &source_read_length,
+         &target_read_length, targetlength);
+   if (err != PATCH_SUCCESS)
+      return err;
+   if (target_capacity < *targetlength) 
       return PATCH_TARGET_TOO_SMALL;
    data.target_length = *targetlength;
 
+   /* The whole source is always read, the patch
+    * checksum covers everything but itself. */
+   patch_crc_job_start(&job, data.source_data, data.source_length,
+         data.patch_data, data.patch_length - 4);
+
    while (data.patch_offset < data.patch_length - 12) 
    {
       unsigned length = ups_decode(&data);
@@ -332,46 +459,69 @@ patch_error_t ups_apply_patch(
    while (data.target_offset < data.target_length) 
       ups_target_write(&data, ups_source_read(&data));
 
+   err = PATCH_PATCH_INVALID;
+
+   if (data.patch_offset != data.patch_length - 12)
+      goto end;
 
    for (i = 0; i < 4; i++) 
       source_read_checksum |= ups_patch_read(&data) << (i * 8);
    for (i = 0; i < 4; i++) 
       target_read_checksum |= ups_patch_read(&data) << (i * 8);
-
-   patch_result_checksum = ~data.patch_checksum;
-   data.source_checksum  = ~data.source_checksum;
-   data.target_checksum  = ~data.target_checksum;
-
    for (i = 0; i < 4; i++) 
       patch_read_checksum |= ups_patch_read(&data) << (i * 8);
 
-   if (patch_result_checksum != patch_read_checksum) 
-      return PATCH_PATCH_INVALID;
+   target_checksum = patch_crc32(data.target_data, data.target_length);
+
+   patch_crc_job_wait(&job);
 
-   if (data.source_checksum == source_read_checksum
+   if (job.patch_checksum != patch_read_checksum) 
+      goto end;
+
+   err = PATCH_SOURCE_INVALID;
+
+   if (job.source_checksum == source_read_checksum
          && data.source_length == source_read_length) 
    {
-      if (data.target_checksum == target_read_checksum
+      if (target_checksum == target_read_checksum
             && data.target_length == target_read_length) 
-         return PATCH_SUCCESS;
-      return PATCH_TARGET_INVALID;
+         err = PATCH_SUCCESS;
+      else
+         err = PATCH_TARGET_INVALID;
    } 
-   else if (data.source_checksum == target_read_checksum
+   else if (job.source_checksum == target_read_checksum
          && data.source_length == target_read_length) 
    {
-      if (data.target_checksum == source_read_checksum
+      if (target_checksum == source_read_checksum
             && data.target_length == source_read_length) 
-         return PATCH_SUCCESS;
-      return PATCH_TARGET_INVALID;
+         err = PATCH_SUCCESS;
+      else
+         err = PATCH_TARGET_INVALID;
    } 
 
-   return PATCH_SOURCE_INVALID;
+end:
+   patch_crc_job_wait(&job);
+   return err;
 }
 
-patch_error_t ips_apply_patch(
+/**
+ * ips_parse:
+ * @patchdata    : IPS patch.
+ * @patchlen     : size of @patchdata.
+ * @targetdata   : target to apply the patch to, or NULL to only
+ *                 validate the patch.
+ * @capacity     : size of @targetdata.
+ * @targetlength : size of the unpatched content on entry,
+ *                 size of the patched content on success.
+ * @required     : set to the size @targetdata needs to have.
+ *
+ * IPS records are applied on top of the unpatched content,
+ * so the target may be the content buffer itself.
+ **/
+static patch_error_t ips_parse(
       const uint8_t *patchdata, size_t patchlen,
-      const uint8_t *sourcedata, size_t sourcelength,
-      uint8_t *targetdata, size_t *targetlength)
+      uint8_t *targetdata, size_t capacity,
+      size_t *targetlength, size_t *required)
 {
    uint32_t offset = 5;
 
@@ -383,9 +533,7 @@ patch_error_t ips_apply_patch(
          patchdata[4] != 'H')
       return PATCH_PATCH_INVALID;
 
-   memcpy(targetdata, sourcedata, sourcelength);
-
-   *targetlength = sourcelength;
+   *required = *targetlength;
 
    for (;;)
    {
@@ -409,6 +557,8 @@ patch_error_t ips_apply_patch(
             size |= patchdata[offset++] << 8;
             size |= patchdata[offset++] << 0;
             *targetlength = size;
+            if (size > *required)
+               *required = size;
             return PATCH_SUCCESS;
          }
       }
@@ -424,8 +574,15 @@ patch_error_t ips_apply_patch(
          if (offset > patchlen - length)
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset++];
+         if (targetdata)
+         {
+            if (address + length > capacity)
+               return PATCH_TARGET_TOO_SMALL;
+            memcpy(targetdata + address, patchdata + offset, length);
+         }
+
+         address += length;
+         offset  += length;
       }
       else /* RLE */
       {
@@ -438,84 +595,160 @@ patch_error_t ips_apply_patch(
          if (length == 0) /* Illegal */
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset];
+         if (targetdata)
+         {
+            if (address + length > capacity)
+               return PATCH_TARGET_TOO_SMALL;
+            memset(targetdata + address, patchdata[offset], length);
+         }
 
+         address += length;
          offset++;
       }
 
       if (address > *targetlength)
          *targetlength = address;
+      if (address > *required)
+         *required = address;
    }
 
    return PATCH_PATCH_INVALID;
 }
 
+static patch_error_t ips_target_size(
+      const uint8_t *patchdata, size_t patchlen,
+      size_t sourcelength, size_t *targetlength)
+{
+   size_t length = sourcelength;
+   return ips_parse(patchdata, patchlen, NULL, 0, &length, targetlength);
+}
+
+patch_error_t ips_apply_patch(
+      const uint8_t *patchdata, size_t patchlen,
+      const uint8_t *sourcedata, size_t sourcelength,
+      uint8_t *targetdata, size_t *targetlength)
+{
+   size_t required;
+   size_t capacity = *targetlength;
+
+   if (capacity < sourcelength)
+      return PATCH_TARGET_TOO_SMALL;
+
+   if (targetdata != sourcedata)
+      memcpy(targetdata, sourcedata, sourcelength);
+
+   *targetlength = sourcelength;
+
+   return ips_parse(patchdata, patchlen, targetdata, capacity,
+         targetlength, &required);
+}
+
+/**
+ * apply_patch_content:
+ * @buf          : buffer of the content file.
+ * @size         : size   of the content file.
+ * @mapped       : @buf is a read-only mapping, see patch_content.
+ * @patch_desc   : name of the patch format.
+ * @patch_path   : path of the patch file.
+ * @func         : applies the patch.
+ * @size_func    : validates the patch header and returns the
+ *                 size of the target buffer @func needs.
+ * @in_place     : @func can patch the content buffer directly.
+ *                 Only for formats whose @size_func checks the
+ *                 whole patch, so that @func can't fail halfway.
+ *
+ * The target is allocated with its exact size. Content read into
+ * memory is patched in place where the format allows it, mapped
+ * content is only read from while the patched copy is built.
+ *
+ * Returns: true if the content was patched, otherwise false.
+ **/
 static bool apply_patch_content(uint8_t **buf,
-      ssize_t *size, const char *patch_desc, const char *patch_path,
-      patch_func_t func)
+      ssize_t *size, bool *mapped,
+      const char *patch_desc, const char *patch_path,
+      patch_func_t func, patch_size_func_t size_func, bool in_place)
 {
    size_t target_size;
    ssize_t patch_size;
    void *patch_data         = NULL;
+   bool patch_mapped        = false;
    patch_error_t err        = PATCH_UNKNOWN;
-   bool success             = false;
    uint8_t *patched_content = NULL;
    ssize_t ret_size         = *size;
    uint8_t *ret_buf         = *buf;
-   
-   if (!read_file(patch_path, &patch_data, &patch_size))
-      return false;
-   if (patch_size < 0)
-      return false;
 
    if (!path_file_exists(patch_path))
       return false;
 
+   if (map_file(patch_path, &patch_data, &patch_size))
+      patch_mapped = true;
+   else if (!read_file(patch_path, &patch_data, &patch_size))
+      return false;
+   if (patch_size < 0)
+      goto end;
+
    RARCH_LOG("Found %s file in \"%s\", attempting to patch ...\n",
          patch_desc, patch_path);
 
-   target_size = ret_size * 4; /* Just to be sure. */
+   err = size_func((const uint8_t*)patch_data, patch_size,
+         ret_size, &target_size);
+   if (err != PATCH_SUCCESS)
+      goto end;
 
-   patched_content = (uint8_t*)malloc(target_size);
+   in_place = in_place && !*mapped;
+
+   if (!in_place)
+      patched_content = (uint8_t*)malloc(target_size ? target_size : 1);
+   else if (target_size > (size_t)ret_size)
+      patched_content = (uint8_t*)realloc(ret_buf, target_size);
+   else
+      patched_content = ret_buf;
 
    if (!patched_content)
    {
       RARCH_ERR("Failed to allocate memory for patched content ...\n");
-      goto error;
+      err = PATCH_UNKNOWN;
+      goto end;
    }
 
+   if (in_place)
+      ret_buf = *buf = patched_content;
+
    err = func((const uint8_t*)patch_data, patch_size, ret_buf,
          ret_size, patched_content, &target_size);
 
    if (err == PATCH_SUCCESS)
    {
-      RARCH_LOG("Content patched successfully (%s).\n", patch_desc);
-      success = true;
+      if (!in_place)
+      {
+         if (*mapped)
+            unmap_file(ret_buf, ret_size);
+         else
+            free(ret_buf);
+      }
+
+      *buf    = patched_content;
+      *size   = target_size;
+      *mapped = false;
    }
+   else if (!in_place)
+      free(patched_content);
+
+end:
+   if (err == PATCH_SUCCESS)
+      RARCH_LOG("Content patched successfully (%s).\n", patch_desc);
    else
       RARCH_ERR("Failed to patch %s: Error #%u\n", patch_desc,
             (unsigned)err);
 
-   if (success)
-   {
-      free(ret_buf);
-      *buf = patched_content;
-      *size = target_size;
-   }
-
-   free(patch_data);
-   return true;
-
-error:
-   *buf = ret_buf;
-   *size = ret_size;
-   free(patch_data);
-
-   return false;
+   if (patch_mapped)
+      unmap_file(patch_data, patch_size);
+   else
+      free(patch_data);
+   return err == PATCH_SUCCESS;
 }
 
-static bool try_bps_patch(uint8_t **buf, ssize_t *size)
+static bool try_bps_patch(uint8_t **buf, ssize_t *size, bool *mapped)
 {
    global_t *global = global_get_ptr();
    bool allow_bps   = !global->patch.ups_pref && !global->patch.ips_pref;
@@ -525,11 +758,11 @@ static bool try_bps_patch(uint8_t **buf, ssize_t *size)
    if (global->name.bps[0] == '\0')
       return false;
 
-   return apply_patch_content(buf, size, "BPS", global->name.bps,
-         bps_apply_patch);
+   return apply_patch_content(buf, size, mapped, "BPS", global->name.bps,
+         bps_apply_patch, bps_target_size, false);
 }
 
-static bool try_ups_patch(uint8_t **buf, ssize_t *size)
+static bool try_ups_patch(uint8_t **buf, ssize_t *size, bool *mapped)
 {
    global_t *global = global_get_ptr();
    bool allow_ups   = !global->patch.bps_pref && !global->patch.ips_pref;
@@ -539,11 +772,11 @@ static bool try_ups_patch(uint8_t **buf, ssize_t *size)
    if (global->name.ups[0] == '\0')
       return false;
 
-   return apply_patch_content(buf, size, "UPS", global->name.ups,
-         ups_apply_patch);
+   return apply_patch_content(buf, size, mapped, "UPS", global->name.ups,
+         ups_apply_patch, ups_target_size, false);
 }
 
-static bool try_ips_patch(uint8_t **buf, ssize_t *size)
+static bool try_ips_patch(uint8_t **buf, ssize_t *size, bool *mapped)
 {
    global_t *global = global_get_ptr();
    bool allow_ips   = !global->patch.ups_pref && !global->patch.bps_pref;
@@ -553,19 +786,24 @@ static bool try_ips_patch(uint8_t **buf, ssize_t *size)
    if (global->name.ips[0] == '\0')
       return false;
 
-   return apply_patch_content(buf, size, "IPS", global->name.ips,
-         ips_apply_patch);
+   /* ips_target_size runs through the whole patch, so it
+    * can be applied in place. */
+   return apply_patch_content(buf, size, mapped, "IPS", global->name.ips,
+         ips_apply_patch, ips_target_size, true);
 }
 
 /**
  * patch_content:
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
+ * @mapped       : true if @buf is a read-only mapping created
+ *                 by map_file. Set to false if @buf is replaced
+ *                 by the patched content.
  *
  * Apply patch to the content file in-memory.
  *
  **/
-void patch_content(uint8_t **buf, ssize_t *size)
+void patch_content(uint8_t **buf, ssize_t *size, bool *mapped)
 {
    global_t *global = global_get_ptr();
 
@@ -575,7 +813,9 @@ void patch_content(uint8_t **buf, ssize_t *size)
       return;
    }
 
-   if (!try_ips_patch(buf, size) && !try_bps_patch(buf, size) && !try_ups_patch(buf, size))
+   if (!try_ips_patch(buf, size, mapped)
+         && !try_bps_patch(buf, size, mapped)
+         && !try_ups_patch(buf, size, mapped))
    {
       RARCH_LOG("Did not find a valid content patch.\n");
    }
@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <boolean.h>
 
 /* BPS/UPS/IPS implementation from bSNES (nall::).
  * Modified for RetroArch. */
@@ -62,10 +63,13 @@ patch_error_t ips_apply_patch(
  * patch_content:
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
+ * @mapped       : true if @buf is a read-only mapping created
+ *                 by map_file. Set to false if @buf is replaced
+ *                 by the patched content.
  *
  * Apply patch to the content file in-memory.
  *
  **/
-void patch_content(uint8_t **buf, ssize_t *size);
+void patch_content(uint8_t **buf, ssize_t *size, bool *mapped);
 
 #endif
@@ -17,13 +17,886 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <boolean.h>
 #include <compat/posix_string.h>
 #include <retro_log.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
 
 #include "playlist.h"
+#include "file_ops.h"
+
+/* Binary playlist files start with a header, followed by entry
+ * records and a table holding the offset and size of every record
+ * in playlist order. Changes are written by appending the new
+ * records and a new table, then rewriting the header, so a write
+ * that does not complete leaves the previous playlist intact.
+ * Superseded records and tables are dropped once they take up
+ * more space than the playlist itself and the file is rewritten.
+ *
+ * Integers are 32-bit little endian. A record holds the entry
+ * strings in the order of the text format, each one stored as its
+ * length plus one (0 if not set), the characters and a NUL. */
+
+#define PLAYLIST_MAGIC        "RPLB"
+#define PLAYLIST_VERSION      1
+#define PLAYLIST_HEADER_SIZE  24
+#define PLAYLIST_TABLE_STRIDE 8
+#define PLAYLIST_SLACK        (64 * 1024)
+
+#ifndef PLAYLIST_ENTRIES
+#define PLAYLIST_ENTRIES 6
+#endif
+
+enum content_playlist_field
+{
+   PLAYLIST_FIELD_PATH = 0,
+   PLAYLIST_FIELD_LABEL,
+   PLAYLIST_FIELD_CORE_PATH,
+   PLAYLIST_FIELD_CORE_NAME,
+   PLAYLIST_FIELD_CRC32,
+   PLAYLIST_FIELD_DB_NAME
+};
+
+static const size_t content_playlist_fields[PLAYLIST_ENTRIES] = {
+   offsetof(content_playlist_entry_t, path),
+   offsetof(content_playlist_entry_t, label),
+   offsetof(content_playlist_entry_t, core_path),
+   offsetof(content_playlist_entry_t, core_name),
+   offsetof(content_playlist_entry_t, crc32),
+   offsetof(content_playlist_entry_t, db_name),
+};
+
+#define PLAYLIST_FIELD(entry, i) \
+   (*(char**)((char*)(entry) + content_playlist_fields[i]))
+
+/* Entries are stored bottom up, so pushing to the top appends. */
+#define PLAYLIST_ENTRY_AT(playlist, idx) \
+   (&(playlist)->entries[(playlist)->size - 1 - (idx)])
+
+static uint32_t content_playlist_read_u32(const uint8_t *ptr)
+{
+   return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+}
+
+static void content_playlist_write_u32(uint8_t *ptr, uint32_t val)
+{
+   ptr[0] = val & 0xff;
+   ptr[1] = (val >> 8) & 0xff;
+   ptr[2] = (val >> 16) & 0xff;
+   ptr[3] = (val >> 24) & 0xff;
+}
+
+/**
+ * content_playlist_record_string:
+ * @playlist        	   : Playlist handle.
+ * @entry               : Entry stored in the playlist file.
+ * @field               : String to look up.
+ *
+ * Returns: pointer to the string inside the playlist file,
+ * NULL if it is not set or the record is invalid.
+ **/
+static const char *content_playlist_record_string(
+      const content_playlist_t *playlist,
+      const content_playlist_entry_t *entry, unsigned field)
+{
+   unsigned i;
+   const uint8_t *ptr = NULL;
+   const uint8_t *end = NULL;
+
+   if (!entry->record_size || !playlist->data ||
+         (uint64_t)entry->offset + entry->record_size >
+         (uint64_t)playlist->data_len)
+      return NULL;
+
+   ptr = playlist->data + entry->offset;
+   end = ptr + entry->record_size;
+
+   for (i = 0; i <= field; i++)
+   {
+      uint32_t len;
+
+      if (end - ptr < 4)
+         return NULL;
+
+      len  = content_playlist_read_u32(ptr);
+      ptr += 4;
+
+      if (!len)
+      {
+         if (i == field)
+            return NULL;
+         continue;
+      }
+
+      if ((uint32_t)(end - ptr) < len || ptr[len - 1] != '\0')
+         return NULL;
+      if (i == field)
+         return (const char*)ptr;
+
+      ptr += len;
+   }
+
+   return NULL;
+}
+
+/**
+ * content_playlist_entry_get:
+ * @playlist        	   : Playlist handle.
+ * @entry               : Playlist entry handle.
+ * @field               : String to look up.
+ *
+ * Looks up a string of @entry without loading it.
+ *
+ * Returns: the string, NULL if it is not set.
+ **/
+static const char *content_playlist_entry_get(
+      const content_playlist_t *playlist,
+      const content_playlist_entry_t *entry, unsigned field)
+{
+   if (entry->loaded)
+      return PLAYLIST_FIELD(entry, field);
+   return content_playlist_record_string(playlist, entry, field);
+}
+
+/**
+ * content_playlist_entry_load:
+ * @playlist        	   : Playlist handle.
+ * @entry               : Playlist entry handle.
+ *
+ * Copies the strings of @entry out of the playlist file.
+ **/
+static void content_playlist_entry_load(content_playlist_t *playlist,
+      content_playlist_entry_t *entry)
+{
+   unsigned i;
+
+   if (entry->loaded)
+      return;
+
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+   {
+      const char *str = content_playlist_record_string(playlist, entry, i);
+      PLAYLIST_FIELD(entry, i) = str ? strdup(str) : NULL;
+   }
+
+   entry->loaded = true;
+}
+
+static size_t content_playlist_record_size(
+      const content_playlist_t *playlist,
+      const content_playlist_entry_t *entry)
+{
+   unsigned i;
+   size_t size = 0;
+
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+   {
+      const char *str = content_playlist_entry_get(playlist, entry, i);
+      size += 4 + (str ? strlen(str) + 1 : 0);
+   }
+
+   return size;
+}
+
+static size_t content_playlist_record_fill(
+      const content_playlist_t *playlist,
+      const content_playlist_entry_t *entry, uint8_t *out)
+{
+   unsigned i;
+   uint8_t *ptr = out;
+
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+   {
+      const char *str = content_playlist_entry_get(playlist, entry, i);
+      size_t len      = str ? strlen(str) + 1 : 0;
+
+      content_playlist_write_u32(ptr, len);
+      if (len)
+         memcpy(ptr + 4, str, len);
+      ptr += 4 + len;
+   }
+
+   return ptr - out;
+}
+
+static void content_playlist_header_fill(const content_playlist_t *playlist,
+      uint8_t *header, uint32_t table_offset, uint32_t file_size,
+      uint32_t generation)
+{
+   memcpy(header, PLAYLIST_MAGIC, 4);
+   content_playlist_write_u32(header + 4,  PLAYLIST_VERSION);
+   content_playlist_write_u32(header + 8,  playlist->size);
+   content_playlist_write_u32(header + 12, table_offset);
+   content_playlist_write_u32(header + 16, file_size);
+   content_playlist_write_u32(header + 20, generation);
+}
+
+static bool content_playlist_reserve(content_playlist_t *playlist,
+      size_t size)
+{
+   size_t allocated = playlist->allocated ? playlist->allocated : 16;
+   content_playlist_entry_t *entries = NULL;
+
+   if (size <= playlist->allocated)
+      return true;
+
+   while (allocated < size)
+      allocated *= 2;
+
+   entries = (content_playlist_entry_t*)realloc(playlist->entries,
+         allocated * sizeof(*entries));
+   if (!entries)
+      return false;
+
+   memset(entries + playlist->allocated, 0,
+         (allocated - playlist->allocated) * sizeof(*entries));
+
+   playlist->entries   = entries;
+   playlist->allocated = allocated;
+   return true;
+}
+
+static bool content_playlist_map(const char *path,
+      uint8_t **data, ssize_t *len, bool *mapped)
+{
+   void *buf = NULL;
+
+   *mapped   = false;
+
+   if (map_file(path, &buf, len))
+      *mapped = true;
+   else if (!read_file(path, &buf, len))
+      return false;
+
+   *data = (uint8_t*)buf;
+   return true;
+}
+
+static void content_playlist_unmap(content_playlist_t *playlist)
+{
+   if (playlist->data_mapped)
+      unmap_file(playlist->data, playlist->data_len);
+   else
+      free(playlist->data);
+
+   playlist->data        = NULL;
+   playlist->data_len    = 0;
+   playlist->data_mapped = false;
+}
+
+/* The index keeps two hash tables, keyed by entry path and CRC,
+ * and a trigram table over the entry labels for searching.
+ *
+ * Hash table slots refer to entries by their place in the entry
+ * array, which pushing a new entry does not change for the other
+ * entries. Moving, dropping or sorting entries invalidates the
+ * tables, they are rebuilt from the cached entry hashes on the
+ * next lookup.
+ *
+ * The trigram table is rebuilt on the first search after any
+ * change. Each bucket lists, in playlist order, the entries
+ * containing a trigram hashing to it. */
+
+#define PLAYLIST_TRIGRAM_BITS    16
+#define PLAYLIST_TRIGRAM_BUCKETS (1 << PLAYLIST_TRIGRAM_BITS)
+
+typedef struct
+{
+   uint32_t hash; /* 0 if the slot is empty. */
+   uint32_t entry;
+} content_playlist_slot_t;
+
+typedef struct
+{
+   content_playlist_slot_t *slots;
+   size_t size;
+   size_t count;
+} content_playlist_table_t;
+
+struct content_playlist_index
+{
+   bool valid;
+   content_playlist_table_t path;
+   content_playlist_table_t crc32;
+
+   bool search_valid;
+   char *labels;
+   uint32_t *label_offsets;
+   uint32_t *buckets;
+   uint32_t *postings;
+};
+
+static uint32_t content_playlist_hash(const char *str, size_t len)
+{
+   size_t i;
+   uint32_t hash = 5381;
+
+   for (i = 0; i < len; i++)
+      hash = (hash << 5) + hash + (unsigned char)str[i];
+
+   /* 0 marks empty slots. */
+   return hash ? hash : 1;
+}
+
+static size_t content_playlist_crc32_len(const char *crc32)
+{
+   const char *delim = strchr(crc32, '|');
+   return delim ? (size_t)(delim - crc32) : strlen(crc32);
+}
+
+static void content_playlist_entry_hash(const content_playlist_t *playlist,
+      content_playlist_entry_t *entry)
+{
+   const char *path  = content_playlist_entry_get(playlist, entry,
+         PLAYLIST_FIELD_PATH);
+   const char *crc32 = content_playlist_entry_get(playlist, entry,
+         PLAYLIST_FIELD_CRC32);
+
+   if (entry->hashed)
+      return;
+
+   entry->path_hash  = content_playlist_hash(path ? path : "",
+         path ? strlen(path) : 0);
+   entry->crc32_hash = crc32 ? content_playlist_hash(crc32,
+         content_playlist_crc32_len(crc32)) : 0;
+   entry->hashed     = true;
+}
+
+static size_t content_playlist_slot_home(const content_playlist_table_t *table,
+      uint32_t hash)
+{
+   return (hash * 2654435761u) & (table->size - 1);
+}
+
+static bool content_playlist_table_insert(content_playlist_table_t *table,
+      uint32_t hash, uint32_t entry)
+{
+   size_t i;
+
+   if (!hash)
+      return true;
+
+   /* Keep the table at most half full. */
+   if ((table->count + 1) * 2 > table->size)
+   {
+      content_playlist_table_t grown;
+
+      grown.size  = table->size ? table->size * 2 : 64;
+      grown.count = 0;
+      grown.slots = (content_playlist_slot_t*)
+         calloc(grown.size, sizeof(*grown.slots));
+
+      if (!grown.slots)
+         return false;
+
+      for (i = 0; i < table->size; i++)
+         if (table->slots[i].hash)
+            content_playlist_table_insert(&grown,
+                  table->slots[i].hash, table->slots[i].entry);
+
+      free(table->slots);
+      *table = grown;
+   }
+
+   for (i = content_playlist_slot_home(table, hash);
+         table->slots[i].hash; i = (i + 1) & (table->size - 1));
+
+   table->slots[i].hash  = hash;
+   table->slots[i].entry = entry;
+   table->count++;
+   return true;
+}
+
+static void content_playlist_table_remove(content_playlist_table_t *table,
+      uint32_t hash, uint32_t entry)
+{
+   size_t i, j;
+   size_t mask = table->size - 1;
+
+   if (!hash || !table->size)
+      return;
+
+   for (i = content_playlist_slot_home(table, hash); ; i = (i + 1) & mask)
+   {
+      if (!table->slots[i].hash)
+         return;
+      if (table->slots[i].hash == hash && table->slots[i].entry == entry)
+         break;
+   }
+
+   /* Move later slots of the probe sequence into the gap. */
+   for (j = (i + 1) & mask; table->slots[j].hash; j = (j + 1) & mask)
+   {
+      size_t home = content_playlist_slot_home(table, table->slots[j].hash);
+
+      if ((j > i && (home <= i || home > j)) ||
+            (j < i && (home <= i && home > j)))
+      {
+         table->slots[i] = table->slots[j];
+         i               = j;
+      }
+   }
+
+   table->slots[i].hash = 0;
+   table->count--;
+}
+
+static void content_playlist_table_renumber(content_playlist_table_t *table,
+      uint32_t hash, uint32_t entry, uint32_t new_entry)
+{
+   size_t i;
+
+   if (!hash || !table->size)
+      return;
+
+   for (i = content_playlist_slot_home(table, hash); table->slots[i].hash;
+         i = (i + 1) & (table->size - 1))
+   {
+      if (table->slots[i].hash == hash && table->slots[i].entry == entry)
+      {
+         table->slots[i].entry = new_entry;
+         return;
+      }
+   }
+}
+
+static void content_playlist_table_clear(content_playlist_table_t *table)
+{
+   if (table->slots)
+      memset(table->slots, 0, table->size * sizeof(*table->slots));
+   table->count = 0;
+}
+
+static void content_playlist_index_invalidate(content_playlist_t *playlist)
+{
+   if (!playlist->index)
+      return;
+
+   playlist->index->valid        = false;
+   playlist->index->search_valid = false;
+}
+
+static void content_playlist_index_free(content_playlist_t *playlist)
+{
+   struct content_playlist_index *index = playlist->index;
+
+   if (!index)
+      return;
+
+   free(index->path.slots);
+   free(index->crc32.slots);
+   free(index->labels);
+   free(index->label_offsets);
+   free(index->buckets);
+   free(index->postings);
+   free(index);
+
+   playlist->index = NULL;
+}
+
+static bool content_playlist_index_add(content_playlist_t *playlist,
+      size_t i)
+{
+   struct content_playlist_index *index = playlist->index;
+   content_playlist_entry_t *entry      = &playlist->entries[i];
+
+   content_playlist_entry_hash(playlist, entry);
+
+   return content_playlist_table_insert(&index->path, entry->path_hash, i)
+      && content_playlist_table_insert(&index->crc32, entry->crc32_hash, i);
+}
+
+static void content_playlist_index_remove(content_playlist_t *playlist,
+      size_t i)
+{
+   struct content_playlist_index *index = playlist->index;
+   content_playlist_entry_t *entry      = &playlist->entries[i];
+
+   content_playlist_table_remove(&index->path, entry->path_hash, i);
+   content_playlist_table_remove(&index->crc32, entry->crc32_hash, i);
+}
+
+/**
+ * content_playlist_index_shift:
+ * @playlist        	   : Playlist handle.
+ * @start               : First storage index to shift.
+ *
+ * Renumbers the entries from @start to the end of the storage
+ * before they are moved down by one. The entry at @start - 1
+ * has to be removed from the index first.
+ **/
+static void content_playlist_index_shift(content_playlist_t *playlist,
+      size_t start)
+{
+   size_t i;
+   struct content_playlist_index *index = playlist->index;
+
+   if (!index || !index->valid)
+      return;
+
+   for (i = start; i < playlist->size; i++)
+   {
+      content_playlist_entry_t *entry = &playlist->entries[i];
+
+      content_playlist_table_renumber(&index->path,
+            entry->path_hash, i, i - 1);
+      content_playlist_table_renumber(&index->crc32,
+            entry->crc32_hash, i, i - 1);
+   }
+
+   index->search_valid = false;
+}
+
+/**
+ * content_playlist_index_get:
+ * @playlist        	   : Playlist handle.
+ *
+ * Returns: the path and CRC index of @playlist, NULL if it
+ * could not be built.
+ **/
+static struct content_playlist_index *content_playlist_index_get(
+      content_playlist_t *playlist)
+{
+   size_t i;
+   struct content_playlist_index *index = playlist->index;
+
+   if (!index)
+   {
+      index = (struct content_playlist_index*)calloc(1, sizeof(*index));
+      if (!index)
+         return NULL;
+      playlist->index = index;
+   }
+
+   if (index->valid)
+      return index;
+
+   content_playlist_table_clear(&index->path);
+   content_playlist_table_clear(&index->crc32);
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      if (!content_playlist_index_add(playlist, i))
+         return NULL;
+   }
+
+   index->valid = true;
+   return index;
+}
+
+/**
+ * content_playlist_index_find:
+ * @playlist        	   : Playlist handle.
+ * @path                : Path to look for, NULL for entries without one.
+ * @core_path           : Core path the entry must have, or NULL.
+ * @idx                 : Index of the first match.
+ *
+ * Returns: true if an entry was found, otherwise false.
+ **/
+static bool content_playlist_index_find(content_playlist_t *playlist,
+      const char *path, const char *core_path, size_t *idx)
+{
+   size_t i;
+   bool found                           = false;
+   uint32_t hash                        = content_playlist_hash(
+         path ? path : "", path ? strlen(path) : 0);
+   struct content_playlist_index *index = content_playlist_index_get(playlist);
+   content_playlist_table_t *table      = index ? &index->path : NULL;
+
+   if (!table || !table->size)
+      return false;
+
+   for (i = content_playlist_slot_home(table, hash); table->slots[i].hash;
+         i = (i + 1) & (table->size - 1))
+   {
+      const char *entry_path          = NULL;
+      content_playlist_entry_t *entry = &playlist->entries[
+         table->slots[i].entry];
+      size_t pos                      = playlist->size - 1
+         - table->slots[i].entry;
+
+      if (table->slots[i].hash != hash || (found && pos > *idx))
+         continue;
+
+      entry_path = content_playlist_entry_get(playlist, entry,
+            PLAYLIST_FIELD_PATH);
+
+      if (path ? (!entry_path || strcmp(entry_path, path)) : !!entry_path)
+         continue;
+
+      if (core_path)
+      {
+         const char *entry_core_path = content_playlist_entry_get(playlist,
+               entry, PLAYLIST_FIELD_CORE_PATH);
+
+         if (!entry_core_path || strcmp(entry_core_path, core_path))
+            continue;
+      }
+
+      *idx  = pos;
+      found = true;
+   }
+
+   return found;
+}
+
+bool content_playlist_find_by_path(content_playlist_t *playlist,
+      const char *path, size_t *idx)
+{
+   if (!playlist || !path)
+      return false;
+   return content_playlist_index_find(playlist, path, NULL, idx);
+}
+
+bool content_playlist_find_by_crc32(content_playlist_t *playlist,
+      const char *crc32, size_t *idx)
+{
+   size_t i, len;
+   uint32_t hash;
+   bool found                           = false;
+   struct content_playlist_index *index = NULL;
+   content_playlist_table_t *table      = NULL;
+
+   if (!playlist || !crc32)
+      return false;
+
+   index = content_playlist_index_get(playlist);
+   table = index ? &index->crc32 : NULL;
+
+   if (!table || !table->size)
+      return false;
+
+   len  = content_playlist_crc32_len(crc32);
+   hash = content_playlist_hash(crc32, len);
+
+   for (i = content_playlist_slot_home(table, hash); table->slots[i].hash;
+         i = (i + 1) & (table->size - 1))
+   {
+      const char *entry_crc32         = NULL;
+      content_playlist_entry_t *entry = &playlist->entries[
+         table->slots[i].entry];
+      size_t pos                      = playlist->size - 1
+         - table->slots[i].entry;
+
+      if (table->slots[i].hash != hash || (found && pos > *idx))
+         continue;
+
+      entry_crc32 = content_playlist_entry_get(playlist, entry,
+            PLAYLIST_FIELD_CRC32);
+
+      if (!entry_crc32 || content_playlist_crc32_len(entry_crc32) != len
+            || strncmp(entry_crc32, crc32, len))
+         continue;
+
+      *idx  = pos;
+      found = true;
+   }
+
+   return found;
+}
+
+static uint32_t content_playlist_trigram(const char *str)
+{
+   uint32_t trigram = ((unsigned char)str[0] << 16)
+      | ((unsigned char)str[1] << 8) | (unsigned char)str[2];
+   return (trigram * 2654435761u) >> (32 - PLAYLIST_TRIGRAM_BITS);
+}
+
+static void content_playlist_lowercase(char *s, const char *str, size_t len)
+{
+   size_t i;
+
+   for (i = 0; i < len; i++)
+      s[i] = (str[i] >= 'A' && str[i] <= 'Z') ? str[i] - 'A' + 'a' : str[i];
+   s[len] = '\0';
+}
+
+/**
+ * content_playlist_search_build:
+ * @playlist        	   : Playlist handle.
+ * @index               : Index of @playlist.
+ *
+ * Builds the lower case label table and the trigram buckets.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool content_playlist_search_build(content_playlist_t *playlist,
+      struct content_playlist_index *index)
+{
+   size_t i, j;
+   size_t labels_len = 0;
+   uint32_t *fill    = NULL;
+
+   free(index->labels);
+   free(index->label_offsets);
+   free(index->postings);
+   index->labels        = NULL;
+   index->label_offsets = NULL;
+   index->postings      = NULL;
+
+   if (!index->buckets)
+      index->buckets = (uint32_t*)malloc(
+            (PLAYLIST_TRIGRAM_BUCKETS + 1) * sizeof(*index->buckets));
+   index->label_offsets = (uint32_t*)malloc(
+         (playlist->size + 1) * sizeof(*index->label_offsets));
+   fill = (uint32_t*)calloc(PLAYLIST_TRIGRAM_BUCKETS, sizeof(*fill));
+
+   if (!index->buckets || !index->label_offsets || !fill)
+      goto error;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      const char *label = content_playlist_entry_get(playlist,
+            PLAYLIST_ENTRY_AT(playlist, i), PLAYLIST_FIELD_LABEL);
+
+      if (!label || !*label)
+         label = content_playlist_entry_get(playlist,
+               PLAYLIST_ENTRY_AT(playlist, i), PLAYLIST_FIELD_PATH);
+
+      index->label_offsets[i] = labels_len;
+      labels_len             += (label ? strlen(label) : 0) + 1;
+   }
+   index->label_offsets[playlist->size] = labels_len;
+
+   index->labels = (char*)malloc(labels_len ? labels_len : 1);
+   if (!index->labels)
+      goto error;
+
+   /* Lower case the labels and count trigrams per bucket. */
+   for (i = 0; i < playlist->size; i++)
+   {
+      char *s           = index->labels + index->label_offsets[i];
+      size_t len        = index->label_offsets[i + 1]
+         - index->label_offsets[i] - 1;
+      const char *label = content_playlist_entry_get(playlist,
+            PLAYLIST_ENTRY_AT(playlist, i), PLAYLIST_FIELD_LABEL);
+
+      if (!label || !*label)
+         label = content_playlist_entry_get(playlist,
+               PLAYLIST_ENTRY_AT(playlist, i), PLAYLIST_FIELD_PATH);
+
+      content_playlist_lowercase(s, label ? label : "", len);
+
+      for (j = 0; j + 3 <= len; j++)
+         fill[content_playlist_trigram(s + j)]++;
+   }
+
+   index->buckets[0] = 0;
+   for (i = 0; i < PLAYLIST_TRIGRAM_BUCKETS; i++)
+   {
+      index->buckets[i + 1] = index->buckets[i] + fill[i];
+      fill[i]               = index->buckets[i];
+   }
+
+   index->postings = (uint32_t*)malloc(
+         (index->buckets[PLAYLIST_TRIGRAM_BUCKETS] + 1) *
+         sizeof(*index->postings));
+   if (!index->postings)
+      goto error;
+
+   /* Entries are added in order, a trigram occuring several
+    * times in a label only adds it once. Unused space at the
+    * end of a bucket is filled with the last entry. */
+   for (i = 0; i < playlist->size; i++)
+   {
+      const char *s = index->labels + index->label_offsets[i];
+      size_t len    = index->label_offsets[i + 1]
+         - index->label_offsets[i] - 1;
+
+      for (j = 0; j + 3 <= len; j++)
+      {
+         uint32_t bucket = content_playlist_trigram(s + j);
+
+         if (fill[bucket] > index->buckets[bucket]
+               && index->postings[fill[bucket] - 1] == i)
+            continue;
+         index->postings[fill[bucket]++] = i;
+      }
+   }
+
+   for (i = 0; i < PLAYLIST_TRIGRAM_BUCKETS; i++)
+      for (j = fill[i]; j < index->buckets[i + 1]; j++)
+         index->postings[j] = index->postings[j - 1];
+
+   free(fill);
+   index->search_valid = true;
+   return true;
+
+error:
+   free(fill);
+   return false;
+}
+
+size_t content_playlist_search(content_playlist_t *playlist,
+      const char *query, size_t *idx, size_t max)
+{
+   size_t i, len;
+   size_t count                         = 0;
+   char q[PATH_MAX_LENGTH]              = {0};
+   struct content_playlist_index *index = NULL;
+
+   if (!playlist || !query || !max)
+      return 0;
+
+   if (!playlist->index)
+   {
+      playlist->index = (struct content_playlist_index*)
+         calloc(1, sizeof(*playlist->index));
+      if (!playlist->index)
+         return 0;
+   }
+
+   index = playlist->index;
+
+   if (!index->search_valid && !content_playlist_search_build(playlist, index))
+      return 0;
+
+   len = strlen(query);
+   if (len >= sizeof(q))
+      len = sizeof(q) - 1;
+   content_playlist_lowercase(q, query, len);
+
+   if (len < 3)
+   {
+      /* Too short for trigrams, check every label. */
+      for (i = 0; i < playlist->size && count < max; i++)
+         if (strstr(index->labels + index->label_offsets[i], q))
+            idx[count++] = i;
+   }
+   else
+   {
+      /* Check the entries of the smallest bucket. */
+      uint32_t bucket = content_playlist_trigram(q);
+      uint32_t last   = UINT32_MAX;
+
+      for (i = 1; i + 3 <= len; i++)
+      {
+         uint32_t b = content_playlist_trigram(q + i);
+         if (index->buckets[b + 1] - index->buckets[b] <
+               index->buckets[bucket + 1] - index->buckets[bucket])
+            bucket = b;
+      }
+
+      for (i = index->buckets[bucket];
+            i < index->buckets[bucket + 1] && count < max; i++)
+      {
+         uint32_t pos = index->postings[i];
+
+         if (pos == last)
+            continue;
+         last = pos;
+
+         if (strstr(index->labels + index->label_offsets[pos], q))
+            idx[count++] = pos;
+      }
+   }
+
+   return count;
+}
 
 /**
  * content_playlist_get_index:
@@ -42,21 +915,26 @@ void content_playlist_get_index(content_playlist_t *playlist,
       const char **crc32,
       const char **db_name)
 {
-   if (!playlist)
+   content_playlist_entry_t *entry = NULL;
+
+   if (!playlist || idx >= playlist->size)
       return;
 
+   entry = PLAYLIST_ENTRY_AT(playlist, idx);
+   content_playlist_entry_load(playlist, entry);
+
    if (path)
-      *path      = playlist->entries[idx].path;
+      *path      = entry->path;
    if (label)
-      *label     = playlist->entries[idx].label;
+      *label     = entry->label;
    if (core_path)
-      *core_path = playlist->entries[idx].core_path;
+      *core_path = entry->core_path;
    if (core_name)
-      *core_name = playlist->entries[idx].core_name;
+      *core_name = entry->core_name;
    if (db_name)
-      *db_name = playlist->entries[idx].db_name;
+      *db_name   = entry->db_name;
    if (crc32)
-      *crc32     = playlist->entries[idx].crc32;
+      *crc32     = entry->crc32;
 }
 
 void content_playlist_get_index_by_path(content_playlist_t *playlist,
@@ -67,29 +945,29 @@ void content_playlist_get_index_by_path(content_playlist_t *playlist,
       char **db_name)
 {
    size_t i;
-   if (!playlist)
-      return;
+   content_playlist_entry_t *entry = NULL;
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (strcmp(playlist->entries[i].path, search_path) != 0)
-         continue;
+   if (!playlist)
+      return;
 
-      if (path)
-         *path      = playlist->entries[i].path;
-      if (label)
-         *label     = playlist->entries[i].label;
-      if (core_path)
-         *core_path = playlist->entries[i].core_path;
-      if (core_name)
-         *core_name = playlist->entries[i].core_name;
-      if (db_name)
-         *db_name   = playlist->entries[i].db_name;
-      if (crc32)
-         *crc32     = playlist->entries[i].crc32;
-      break;
-   }
+   if (!content_playlist_find_by_path(playlist, search_path, &i))
+      return;
 
+   entry = PLAYLIST_ENTRY_AT(playlist, i);
+   content_playlist_entry_load(playlist, entry);
+
+   if (path)
+      *path      = entry->path;
+   if (label)
+      *label     = entry->label;
+   if (core_path)
+      *core_path = entry->core_path;
+   if (core_name)
+      *core_name = entry->core_name;
+   if (db_name)
+      *db_name   = entry->db_name;
+   if (crc32)
+      *crc32     = entry->crc32;
 }
 
 /**
@@ -100,32 +978,13 @@ void content_playlist_get_index_by_path(content_playlist_t *playlist,
  **/
 static void content_playlist_free_entry(content_playlist_entry_t *entry)
 {
+   unsigned i;
+
    if (!entry)
       return;
 
-   if (entry->path)
-      free(entry->path);
-   entry->path = NULL;
-
-   if (entry->label)
-      free(entry->label);
-   entry->label = NULL;
-
-   if (entry->core_path)
-      free(entry->core_path);
-   entry->core_path = NULL;
-
-   if (entry->core_name)
-      free(entry->core_name);
-   entry->core_name = NULL;
-
-   if (entry->db_name)
-      free(entry->db_name);
-   entry->core_name = NULL;
-
-   if (entry->crc32)
-      free(entry->crc32);
-   entry->crc32 = NULL;
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+      free(PLAYLIST_FIELD(entry, i));
 
    memset(entry, 0, sizeof(*entry));
 }
@@ -136,23 +995,55 @@ void content_playlist_update(content_playlist_t *playlist, size_t idx,
       const char *crc32,
       const char *db_name)
 {
+   unsigned i;
+   size_t entry_idx;
+   const char *values[PLAYLIST_ENTRIES];
    content_playlist_entry_t *entry = NULL;
+
    if (!playlist)
       return;
-   if (idx > playlist->size)
+   if (idx >= playlist->size)
       return;
 
-   entry = &playlist->entries[idx];
-   
-   if (!entry)
+   entry_idx = playlist->size - 1 - idx;
+   entry     = &playlist->entries[entry_idx];
+
+   content_playlist_entry_load(playlist, entry);
+
+   if (playlist->index && playlist->index->valid)
+      content_playlist_index_remove(playlist, entry_idx);
+
+   values[PLAYLIST_FIELD_PATH]      = path;
+   values[PLAYLIST_FIELD_LABEL]     = label;
+   values[PLAYLIST_FIELD_CORE_PATH] = core_path;
+   values[PLAYLIST_FIELD_CORE_NAME] = core_name;
+   values[PLAYLIST_FIELD_CRC32]     = crc32;
+   values[PLAYLIST_FIELD_DB_NAME]   = db_name;
+
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+   {
+      char *str = NULL;
+
+      /* Values can point to the current strings of the entry. */
+      if (!values[i] || values[i] == PLAYLIST_FIELD(entry, i))
+         continue;
+
+      str = strdup(values[i]);
+      free(PLAYLIST_FIELD(entry, i));
+      PLAYLIST_FIELD(entry, i) = str;
+   }
+
+   entry->record_size = 0;
+   entry->hashed      = false;
+   playlist->modified = true;
+
+   if (!playlist->index)
       return;
 
-   entry->path      = path ?  strdup(path)          : entry->path;
-   entry->label     = label ? strdup(label)         : entry->label;
-   entry->core_path = core_path ? strdup(core_path) : entry->core_path;
-   entry->core_name = core_name ? strdup(core_name) : entry->core_name;
-   entry->db_name   = db_name ? strdup(db_name)     : entry->db_name;
-   entry->crc32     = crc32 ? strdup(crc32)         : entry->crc32;
+   playlist->index->search_valid = false;
+   if (playlist->index->valid
+         && !content_playlist_index_add(playlist, entry_idx))
+      playlist->index->valid = false;
 }
 
 /**
@@ -171,8 +1062,10 @@ void content_playlist_push(content_playlist_t *playlist,
       const char *db_name)
 {
    size_t i;
+   content_playlist_entry_t *entry      = NULL;
+   struct content_playlist_index *index = NULL;
 
-   if (!playlist)
+   if (!playlist || !playlist->cap)
       return;
 
    if (!core_path || !*core_path || !core_name || !*core_name)
@@ -184,20 +1077,10 @@ void content_playlist_push(content_playlist_t *playlist,
    if (path && !*path)
       path = NULL;
 
-   for (i = 0; i < playlist->size; i++)
+   if (content_playlist_index_find(playlist, path, core_path, &i))
    {
       content_playlist_entry_t tmp;
-      bool equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-          !strcmp(path,playlist->entries[i].path));
-
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (strcmp(playlist->entries[i].core_path, core_path))
-         continue;
+      size_t entry_idx = playlist->size - 1 - i;
 
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
@@ -205,56 +1088,322 @@ void content_playlist_push(content_playlist_t *playlist,
          return;
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-		      i * sizeof(content_playlist_entry_t));
-      playlist->entries[0] = tmp;
-
+      content_playlist_index_remove(playlist, entry_idx);
+      content_playlist_index_shift(playlist, entry_idx + 1);
+
+      tmp = playlist->entries[entry_idx];
+      memmove(playlist->entries + entry_idx,
+            playlist->entries + entry_idx + 1,
+            i * sizeof(content_playlist_entry_t));
+      playlist->entries[playlist->size - 1] = tmp;
+      playlist->modified = true;
+
+      if (!content_playlist_index_add(playlist, playlist->size - 1))
+         content_playlist_index_invalidate(playlist);
       return;
    }
 
+   index = playlist->index;
+
+   if (!content_playlist_reserve(playlist, playlist->size + 1))
+      return;
+
    if (playlist->size == playlist->cap)
    {
-      content_playlist_free_entry(&playlist->entries[playlist->cap - 1]);
+      if (index && index->valid)
+         content_playlist_index_remove(playlist, 0);
+      content_playlist_index_shift(playlist, 1);
+
+      content_playlist_free_entry(&playlist->entries[0]);
+      memmove(playlist->entries, playlist->entries + 1,
+            (playlist->size - 1) * sizeof(content_playlist_entry_t));
       playlist->size--;
    }
 
-   memmove(playlist->entries + 1, playlist->entries,
-         (playlist->cap - 1) * sizeof(content_playlist_entry_t));
+   entry = &playlist->entries[playlist->size];
+   memset(entry, 0, sizeof(*entry));
 
-   playlist->entries[0].path      = path ? strdup(path) : NULL;
-   playlist->entries[0].label     = label ? strdup(label) : NULL;
-   playlist->entries[0].core_path = core_path ? strdup(core_path) : NULL;
-   playlist->entries[0].core_name = core_name ? strdup(core_name) : NULL;
-   playlist->entries[0].db_name   = db_name ? strdup(db_name) : NULL;
-   playlist->entries[0].crc32     = crc32 ? strdup(crc32) : NULL;
+   entry->path      = path ? strdup(path) : NULL;
+   entry->label     = label ? strdup(label) : NULL;
+   entry->core_path = core_path ? strdup(core_path) : NULL;
+   entry->core_name = core_name ? strdup(core_name) : NULL;
+   entry->db_name   = db_name ? strdup(db_name) : NULL;
+   entry->crc32     = crc32 ? strdup(crc32) : NULL;
+   entry->loaded    = true;
    playlist->size++;
+   playlist->modified = true;
+
+   if (!index)
+      return;
+
+   index->search_valid = false;
+   if (index->valid
+         && !content_playlist_index_add(playlist, playlist->size - 1))
+      index->valid = false;
 }
 
-void content_playlist_write_file(content_playlist_t *playlist)
+/**
+ * content_playlist_needs_rewrite:
+ * @playlist        	   : Playlist handle.
+ *
+ * Returns: true if superseded records and tables take up
+ * more space than the playlist itself.
+ **/
+static bool content_playlist_needs_rewrite(
+      const content_playlist_t *playlist)
 {
    size_t i;
-   FILE *file = NULL;
+   uint64_t live = PLAYLIST_HEADER_SIZE +
+      (uint64_t)playlist->size * PLAYLIST_TABLE_STRIDE;
 
-   if (!playlist)
-      return;
+   for (i = 0; i < playlist->size; i++)
+      live += playlist->entries[i].record_size;
+
+   return playlist->file_size > 2 * live + PLAYLIST_SLACK;
+}
 
-   file = fopen(playlist->conf_path, "w");
+/**
+ * content_playlist_append:
+ * @playlist        	   : Playlist handle.
+ *
+ * Appends entries that are not in the playlist file yet and a
+ * new table to the file, then points the header to them.
+ *
+ * Returns: true if successful, false if the file has to be
+ * rewritten instead.
+ **/
+static bool content_playlist_append(content_playlist_t *playlist)
+{
+   size_t i;
+   uint8_t header[PLAYLIST_HEADER_SIZE];
+   size_t size      = playlist->size * PLAYLIST_TABLE_STRIDE;
+   uint32_t pos     = playlist->file_size;
+   uint8_t *buf     = NULL;
+   uint8_t *ptr     = NULL;
+   bool ret         = false;
+   FILE *file       = fopen(playlist->conf_path, "r+b");
 
    if (!file)
-      return;
+      return false;
+
+   /* Only append to the file this playlist was read from, if
+    * anything else wrote it since, the file gets replaced. */
+   content_playlist_header_fill(playlist, header, 0,
+         playlist->file_size, playlist->generation);
+   {
+      uint8_t disk[PLAYLIST_HEADER_SIZE];
+
+      if (fread(disk, 1, sizeof(disk), file) != sizeof(disk)
+            || memcmp(disk, header, 8) != 0
+            || memcmp(disk + 16, header + 16, 8) != 0)
+         goto end;
+   }
+
+   for (i = 0; i < playlist->size; i++)
+      if (!playlist->entries[i].record_size)
+         size += content_playlist_record_size(playlist,
+               &playlist->entries[i]);
+
+   if ((uint64_t)pos + size > UINT32_MAX)
+      goto end;
+
+   buf = (uint8_t*)malloc(size);
+   if (!buf)
+      goto end;
+   ptr = buf;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      content_playlist_entry_t *entry = &playlist->entries[i];
+
+      if (entry->record_size)
+         continue;
+
+      entry->offset      = pos + (ptr - buf);
+      entry->record_size = content_playlist_record_fill(playlist,
+            entry, ptr);
+      ptr               += entry->record_size;
+   }
+
+   content_playlist_header_fill(playlist, header, pos + (ptr - buf),
+         pos + size, playlist->generation + 1);
+
+   for (i = 0; i < playlist->size; i++, ptr += PLAYLIST_TABLE_STRIDE)
+   {
+      const content_playlist_entry_t *entry = PLAYLIST_ENTRY_AT(playlist, i);
+
+      content_playlist_write_u32(ptr, entry->offset);
+      content_playlist_write_u32(ptr + 4, entry->record_size);
+   }
+
+   if (fseek(file, pos, SEEK_SET) != 0
+         || fwrite(buf, 1, size, file) != size
+         || fflush(file) != 0
+         || fseek(file, 0, SEEK_SET) != 0
+         || fwrite(header, 1, sizeof(header), file) != sizeof(header))
+      goto end;
+
+   ret = true;
+
+end:
+   if (fclose(file) != 0)
+      ret = false;
+
+   if (ret)
+   {
+      playlist->file_size = pos + size;
+      playlist->generation++;
+   }
+   else if (buf)
+   {
+      /* Entries appended just now are not in the file. */
+      for (i = 0; i < playlist->size; i++)
+         if (playlist->entries[i].offset >= pos)
+            playlist->entries[i].record_size = 0;
+   }
+
+   free(buf);
+   return ret;
+}
+
+/**
+ * content_playlist_rewrite:
+ * @playlist        	   : Playlist handle.
+ *
+ * Writes the whole playlist to a new file which then
+ * replaces the playlist file.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool content_playlist_rewrite(content_playlist_t *playlist)
+{
+   size_t i;
+   char tmp_path[PATH_MAX_LENGTH] = {0};
+   size_t size                    = PLAYLIST_HEADER_SIZE +
+      playlist->size * PLAYLIST_TABLE_STRIDE;
+   uint8_t *data                  = NULL;
+   ssize_t data_len               = 0;
+   bool data_mapped               = false;
+   uint8_t *buf                   = NULL;
+   uint8_t *ptr                   = NULL;
+   uint8_t *table                 = NULL;
+
+   for (i = 0; i < playlist->size; i++)
+      size += content_playlist_record_size(playlist, &playlist->entries[i]);
+
+   if (size > UINT32_MAX)
+      return false;
+
+   buf = (uint8_t*)malloc(size);
+   if (!buf)
+      return false;
+
+   ptr = buf + PLAYLIST_HEADER_SIZE;
+
+   for (i = 0; i < playlist->size; i++)
+      ptr += content_playlist_record_fill(playlist,
+            PLAYLIST_ENTRY_AT(playlist, i), ptr);
+
+   content_playlist_header_fill(playlist, buf, ptr - buf, size,
+         playlist->generation + 1);
+
+   table = ptr;
+   ptr   = buf + PLAYLIST_HEADER_SIZE;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      size_t record_size = content_playlist_record_size(playlist,
+            PLAYLIST_ENTRY_AT(playlist, i));
+
+      content_playlist_write_u32(table + i * PLAYLIST_TABLE_STRIDE,
+            ptr - buf);
+      content_playlist_write_u32(table + i * PLAYLIST_TABLE_STRIDE + 4,
+            record_size);
+      ptr += record_size;
+   }
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", playlist->conf_path);
+
+   if (!write_file(tmp_path, buf, size))
+      goto error;
+
+#ifdef _WIN32
+   remove(playlist->conf_path);
+#endif
+   if (rename(tmp_path, playlist->conf_path) != 0)
+   {
+      remove(tmp_path);
+      goto error;
+   }
+
+   /* Entries not loaded yet have to be read from the new file. */
+   if (!content_playlist_map(playlist->conf_path,
+            &data, &data_len, &data_mapped) || data_len != (ssize_t)size)
+   {
+      if (data_mapped)
+         unmap_file(data, data_len);
+      else
+         free(data);
+
+      for (i = 0; i < playlist->size; i++)
+         content_playlist_entry_load(playlist, &playlist->entries[i]);
+
+      data        = NULL;
+      data_len    = 0;
+      data_mapped = false;
+   }
+
+   content_playlist_unmap(playlist);
 
    for (i = 0; i < playlist->size; i++)
-      fprintf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
-            playlist->entries[i].path  ? playlist->entries[i].path : "",
-            playlist->entries[i].label ? playlist->entries[i].label : "",
-            playlist->entries[i].core_path,
-            playlist->entries[i].core_name,
-            playlist->entries[i].crc32 ? playlist->entries[i].crc32 : "",
-            playlist->entries[i].db_name ? playlist->entries[i].db_name : ""
-            );
+   {
+      const uint8_t *slot             = table + i * PLAYLIST_TABLE_STRIDE;
+      content_playlist_entry_t *entry = PLAYLIST_ENTRY_AT(playlist, i);
+
+      entry->offset      = content_playlist_read_u32(slot);
+      entry->record_size = content_playlist_read_u32(slot + 4);
+   }
+
+   playlist->data        = data;
+   playlist->data_len    = data_len;
+   playlist->data_mapped = data_mapped;
+   playlist->binary      = true;
+   playlist->file_size   = size;
+   playlist->generation++;
+
+   free(buf);
+   return true;
+
+error:
+   free(buf);
+   return false;
+}
+
+void content_playlist_write_file(content_playlist_t *playlist)
+{
+   if (!playlist)
+      return;
+
+   if (playlist->binary)
+   {
+      if (!playlist->modified)
+         return;
+
+      if (!content_playlist_needs_rewrite(playlist)
+            && content_playlist_append(playlist))
+      {
+         playlist->modified = false;
+         return;
+      }
+   }
+
+   if (!content_playlist_rewrite(playlist))
+   {
+      RARCH_ERR("Failed to write playlist: %s.\n", playlist->conf_path);
+      return;
+   }
 
-   fclose(file);
+   playlist->modified = false;
 }
 
 /**
@@ -275,12 +1424,15 @@ void content_playlist_free(content_playlist_t *playlist)
 
    playlist->conf_path = NULL;
 
-   for (i = 0; i < playlist->cap; i++)
+   for (i = 0; i < playlist->size; i++)
       content_playlist_free_entry(&playlist->entries[i]);
 
    free(playlist->entries);
    playlist->entries = NULL;
 
+   content_playlist_unmap(playlist);
+   content_playlist_index_free(playlist);
+
    free(playlist);
 }
 
@@ -296,9 +1448,11 @@ void content_playlist_clear(content_playlist_t *playlist)
    if (!playlist)
       return;
 
-   for (i = 0; i < playlist->cap; i++)
+   for (i = 0; i < playlist->size; i++)
       content_playlist_free_entry(&playlist->entries[i]);
-   playlist->size = 0;
+   playlist->size     = 0;
+   playlist->modified = true;
+   content_playlist_index_invalidate(playlist);
 }
 
 /**
@@ -315,59 +1469,181 @@ size_t content_playlist_size(content_playlist_t *playlist)
    return playlist->size;
 }
 
-#ifndef PLAYLIST_ENTRIES
-#define PLAYLIST_ENTRIES 6
-#endif
+/**
+ * content_playlist_read_binary:
+ * @playlist        	   : Playlist handle.
+ *
+ * Reads the table of a binary playlist file, entries
+ * are loaded from the file when they are accessed.
+ *
+ * Returns: true if successful, false if the file is invalid.
+ **/
+static bool content_playlist_read_binary(content_playlist_t *playlist)
+{
+   size_t i;
+   uint32_t count, table_offset, file_size;
+   const uint8_t *data = playlist->data;
 
-static bool content_playlist_read_file(
-      content_playlist_t *playlist, const char *path)
+   if (content_playlist_read_u32(data + 4) != PLAYLIST_VERSION)
+      return false;
+
+   count        = content_playlist_read_u32(data + 8);
+   table_offset = content_playlist_read_u32(data + 12);
+   file_size    = content_playlist_read_u32(data + 16);
+
+   if (file_size > (uint64_t)playlist->data_len
+         || table_offset < PLAYLIST_HEADER_SIZE
+         || table_offset + (uint64_t)count * PLAYLIST_TABLE_STRIDE
+         > file_size)
+      return false;
+
+   /* Entries beyond the capacity are dropped on the next write. */
+   if (count > playlist->cap)
+   {
+      count              = playlist->cap;
+      playlist->modified = true;
+   }
+
+   if (!content_playlist_reserve(playlist, count))
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      const uint8_t *slot = data + table_offset + i * PLAYLIST_TABLE_STRIDE;
+      content_playlist_entry_t *entry = &playlist->entries[playlist->size];
+
+      entry->offset      = content_playlist_read_u32(slot);
+      entry->record_size = content_playlist_read_u32(slot + 4);
+
+      if (entry->offset < PLAYLIST_HEADER_SIZE || !entry->record_size
+            || (uint64_t)entry->offset + entry->record_size > table_offset)
+      {
+         memset(entry, 0, sizeof(*entry));
+         playlist->modified = true;
+         continue;
+      }
+
+      playlist->size++;
+   }
+
+   playlist->binary     = true;
+   playlist->file_size  = file_size;
+   playlist->generation = content_playlist_read_u32(data + 20);
+   return true;
+}
+
+static char *content_playlist_strndup(const char *str, size_t len)
 {
-   unsigned i;
-   char buf[PLAYLIST_ENTRIES][1024] = {{0}};
-   content_playlist_entry_t *entry  = NULL;
-   char *last                       = NULL;
-   FILE *file                       = fopen(path, "r");
+   char *out = (char*)malloc(len + 1);
 
-   /* If playlist file does not exist,
-    * create an empty playlist instead.
-    */
-   if (!file)
-      return true;
+   if (!out)
+      return NULL;
+
+   memcpy(out, str, len);
+   out[len] = '\0';
+   return out;
+}
+
+/**
+ * content_playlist_read_text:
+ * @playlist        	   : Playlist handle.
+ *
+ * Reads a playlist file in the text format, one line per
+ * entry string. It is converted on the next write.
+ **/
+static void content_playlist_read_text(content_playlist_t *playlist)
+{
+   unsigned i;
+   const char *ptr = (const char*)playlist->data;
+   const char *end = ptr + playlist->data_len;
 
-   for (playlist->size = 0; playlist->size < playlist->cap; )
+   while (playlist->size < playlist->cap)
    {
+      const char *lines[PLAYLIST_ENTRIES];
+      size_t lens[PLAYLIST_ENTRIES];
+      content_playlist_entry_t *entry = NULL;
+
       for (i = 0; i < PLAYLIST_ENTRIES; i++)
       {
-         *buf[i] = '\0';
+         const char *last = NULL;
 
-         if (!fgets(buf[i], sizeof(buf[i]), file))
-            goto end;
+         if (ptr >= end)
+            return;
 
-         last = strrchr(buf[i], '\n');
-         if (last)
-            *last = '\0';
+         last     = (const char*)memchr(ptr, '\n', end - ptr);
+         lines[i] = ptr;
+         lens[i]  = (last ? last : end) - ptr;
+         ptr      = last ? last + 1 : end;
       }
 
-      entry = &playlist->entries[playlist->size];
-
-      if (!*buf[2] || !*buf[3])
+      if (!lens[PLAYLIST_FIELD_CORE_PATH] || !lens[PLAYLIST_FIELD_CORE_NAME])
          continue;
 
-      if (*buf[0])
-         entry->path      = strdup(buf[0]);
-      if (*buf[1])
-         entry->label     = strdup(buf[1]);
-      entry->core_path    = strdup(buf[2]);
-      entry->core_name    = strdup(buf[3]);
-      if (*buf[4])
-         entry->crc32     = strdup(buf[4]);
-      if (*buf[5])
-         entry->db_name   = strdup(buf[5]);
-      playlist->size++;
+      if (!content_playlist_reserve(playlist, playlist->size + 1))
+         return;
+
+      entry = &playlist->entries[playlist->size++];
+
+      for (i = 0; i < PLAYLIST_ENTRIES; i++)
+         if (lens[i])
+            PLAYLIST_FIELD(entry, i) = content_playlist_strndup(
+                  lines[i], lens[i]);
+
+      entry->loaded = true;
    }
+}
 
-end:
-   fclose(file);
+/**
+ * content_playlist_reverse:
+ * @playlist        	   : Playlist handle.
+ *
+ * Converts entries filled in playlist order to the
+ * bottom-up storage order, and back.
+ **/
+static void content_playlist_reverse(content_playlist_t *playlist)
+{
+   size_t i;
+
+   for (i = 0; i < playlist->size / 2; i++)
+   {
+      content_playlist_entry_t tmp = playlist->entries[i];
+      playlist->entries[i] = playlist->entries[playlist->size - 1 - i];
+      playlist->entries[playlist->size - 1 - i] = tmp;
+   }
+}
+
+static bool content_playlist_read_file(
+      content_playlist_t *playlist, const char *path)
+{
+   /* If playlist file does not exist,
+    * create an empty playlist instead.
+    */
+   if (!path_file_exists(path))
+      return true;
+
+   if (!content_playlist_map(path, &playlist->data,
+            &playlist->data_len, &playlist->data_mapped))
+      return false;
+
+   if (playlist->data_len >= PLAYLIST_HEADER_SIZE
+         && !memcmp(playlist->data, PLAYLIST_MAGIC, 4))
+   {
+      if (content_playlist_read_binary(playlist))
+      {
+         content_playlist_reverse(playlist);
+         return true;
+      }
+
+      RARCH_WARN("Ignoring invalid playlist: %s.\n", path);
+      playlist->size = 0;
+   }
+   else
+      content_playlist_read_text(playlist);
+
+   content_playlist_reverse(playlist);
+
+   /* Entries of text playlists are all loaded. */
+   content_playlist_unmap(playlist);
    return true;
 }
 
@@ -387,16 +1663,14 @@ content_playlist_t *content_playlist_init(const char *path, size_t size)
    if (!playlist)
       return NULL;
 
-   playlist->entries = (content_playlist_entry_t*)calloc(size,
-         sizeof(*playlist->entries));
-   if (!playlist->entries)
-      goto error;
-
    playlist->cap = size;
 
    content_playlist_read_file(playlist, path);
 
    playlist->conf_path = strdup(path);
+   if (!playlist->conf_path)
+      goto error;
+
    return playlist;
 
 error:
@@ -406,6 +1680,17 @@ error:
 
 void content_playlist_qsort(content_playlist_t *playlist, content_playlist_sort_fun_t *fn)
 {
+   size_t i;
+
+   if (!playlist)
+      return;
+
+   for (i = 0; i < playlist->size; i++)
+      content_playlist_entry_load(playlist, &playlist->entries[i]);
+
    qsort(playlist->entries, playlist->size, sizeof(content_playlist_entry_t),
          (int (*)(const void *, const void *))fn);
+   content_playlist_reverse(playlist);
+   playlist->modified = true;
+   content_playlist_index_invalidate(playlist);
 }
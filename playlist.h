@@ -19,6 +19,10 @@
 #define CONTENT_HISTORY_H__
 
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <boolean.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +36,19 @@ typedef struct content_playlist_entry
    char *core_name;
    char *db_name;
    char *crc32;
+
+   /* Strings above are only set once the entry was loaded,
+    * until then they are read from the playlist file. */
+   bool loaded;
+   /* Location of the entry in the playlist file,
+    * record_size is 0 if it still has to be written. */
+   uint32_t offset;
+   uint32_t record_size;
+
+   /* Keys of the entry in the playlist index. */
+   bool hashed;
+   uint32_t path_hash;
+   uint32_t crc32_hash;
 } content_playlist_entry_t;
 
 typedef struct content_playlist
@@ -39,8 +56,26 @@ typedef struct content_playlist
    struct content_playlist_entry *entries;
    size_t size;
    size_t cap;
+   size_t allocated;
 
    char *conf_path;
+
+   /* Contents of conf_path, mapped if possible. */
+   uint8_t *data;
+   ssize_t data_len;
+   bool data_mapped;
+
+   /* Whether conf_path is in the binary format, and
+    * how many bytes of it are in use if so. */
+   bool binary;
+   uint32_t file_size;
+   uint32_t generation;
+
+   /* Entries changed since the file was last read or written. */
+   bool modified;
+
+   /* Path, CRC and label lookup, built on first use. */
+   struct content_playlist_index *index;
 } content_playlist_t;
 
 typedef int (content_playlist_sort_fun_t)(const content_playlist_entry_t *a,
@@ -127,6 +162,46 @@ void content_playlist_get_index_by_path(content_playlist_t *playlist,
       char **db_name,
       char **crc32);
 
+/**
+ * content_playlist_find_by_path:
+ * @playlist        	   : Playlist handle.
+ * @path                : Content path to look for.
+ * @idx                 : Index of the first entry with @path.
+ *
+ * Returns: true if an entry was found, otherwise false.
+ **/
+bool content_playlist_find_by_path(content_playlist_t *playlist,
+      const char *path, size_t *idx);
+
+/**
+ * content_playlist_find_by_crc32:
+ * @playlist        	   : Playlist handle.
+ * @crc32               : Checksum to look for, compared to the
+ *                        part of the entry CRC before the '|'.
+ * @idx                 : Index of the first entry with @crc32.
+ *
+ * Returns: true if an entry was found, otherwise false.
+ **/
+bool content_playlist_find_by_crc32(content_playlist_t *playlist,
+      const char *crc32, size_t *idx);
+
+/**
+ * content_playlist_search:
+ * @playlist        	   : Playlist handle.
+ * @query               : Text to look for.
+ * @idx                 : Array receiving the indices of matching entries.
+ * @max                 : Size of @idx.
+ *
+ * Finds entries whose label, or path if they have none, contains
+ * @query, ignoring case. Cheap enough to be called on every
+ * keystroke of a search field, the index is only rebuilt after
+ * the playlist changed.
+ *
+ * Returns: number of matches stored in @idx, in playlist order.
+ **/
+size_t content_playlist_search(content_playlist_t *playlist,
+      const char *query, size_t *idx, size_t max);
+
 void content_playlist_write_file(content_playlist_t *playlist);
 
 void content_playlist_qsort(content_playlist_t *playlist, content_playlist_sort_fun_t *fn);
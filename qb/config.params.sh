@@ -57,4 +57,5 @@ HAVE_PRESERVE_DYLIB=no  # Disable dlclose() for Valgrind support
 HAVE_PARPORT=auto       # Parallel port joypad support
 HAVE_IMAGEVIEWER=yes    # Built-in image viewer support.
 HAVE_MMAP=auto          # MMAP support
+HAVE_IO_URING=auto      # Asynchronous file loading through io_uring (Linux)
 HAVE_QT=no              # QT companion support
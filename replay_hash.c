@@ -0,0 +1,321 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "replay_hash.h"
+#include "libretro.h"
+#include "dynamic.h"
+#include "general.h"
+#include "performance.h"
+#include "gfx/video_driver.h"
+
+/* 64-bit FNV-1a, taking in 8 bytes at a time. Pixels and samples
+ * are hashed as they are in memory, so logs only compare between
+ * hosts of the same endianness. */
+#define REPLAY_HASH_BASIS 0xcbf29ce484222325ULL
+#define REPLAY_HASH_PRIME 0x100000001b3ULL
+
+struct replay_hash
+{
+   bool active;
+   bool diverged;
+
+   FILE *log;
+   FILE *golden;
+   bool golden_end;
+
+   uint64_t video;
+   uint64_t audio;
+
+   uint64_t start_frame;
+   uint64_t frames;
+   uint64_t diverged_frames;
+   retro_time_t start_time;
+   retro_time_t end_time;
+};
+
+static struct replay_hash replay_hash_st;
+
+static uint64_t replay_hash_data(uint64_t hash,
+      const void *data, size_t size)
+{
+   const uint8_t *bytes = (const uint8_t*)data;
+
+   for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t))
+   {
+      uint64_t word;
+
+      memcpy(&word, bytes, sizeof(word));
+      hash   = (hash ^ word) * REPLAY_HASH_PRIME;
+      bytes += sizeof(word);
+   }
+
+   while (size--)
+      hash = (hash ^ *bytes++) * REPLAY_HASH_PRIME;
+
+   return hash;
+}
+
+/* Spreads the changes of high bits, which the multiplications
+ * above only carry upwards, to the whole hash. */
+static uint64_t replay_hash_finish(uint64_t hash)
+{
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+   hash *= 0xc4ceb9fe1a85ec53ULL;
+   hash ^= hash >> 33;
+   return hash;
+}
+
+static void replay_hash_video_frame(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   unsigned y;
+   uint32_t size[2];
+   size_t line     = width * (video_driver_get_pixel_format()
+         == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2);
+   uint64_t *count = video_driver_get_frame_count();
+   uint64_t hash   = REPLAY_HASH_BASIS;
+
+   *count = *count + 1;
+
+   /* A duped frame shows the same picture as the last one. */
+   if (!data)
+      return;
+
+   size[0] = width;
+   size[1] = height;
+   hash    = replay_hash_data(hash, size, sizeof(size));
+
+   /* Hardware rendered frames stay on the GPU. */
+   if (data != RETRO_HW_FRAME_BUFFER_VALID)
+   {
+      for (y = 0; y < height; y++)
+         hash = replay_hash_data(hash,
+               (const uint8_t*)data + y * pitch, line);
+   }
+
+   replay_hash_st.video = replay_hash_finish(hash);
+}
+
+static void replay_hash_audio_sample(int16_t left, int16_t right)
+{
+   int16_t samples[2];
+
+   samples[0]           = left;
+   samples[1]           = right;
+   replay_hash_st.audio = replay_hash_data(replay_hash_st.audio,
+         samples, sizeof(samples));
+}
+
+static size_t replay_hash_audio_sample_batch(const int16_t *data,
+      size_t frames)
+{
+   replay_hash_st.audio = replay_hash_data(replay_hash_st.audio,
+         data, frames * 2 * sizeof(int16_t));
+   return frames;
+}
+
+static bool replay_hash_read_golden(uint64_t *frame,
+      uint64_t *video, uint64_t *audio)
+{
+   char line[128];
+   unsigned long long values[3];
+
+   if (replay_hash_st.golden_end)
+      return false;
+
+   if (!fgets(line, sizeof(line), replay_hash_st.golden)
+         || sscanf(line, "%llu %llx %llx",
+            &values[0], &values[1], &values[2]) != 3)
+   {
+      replay_hash_st.golden_end = true;
+      return false;
+   }
+
+   *frame = values[0];
+   *video = values[1];
+   *audio = values[2];
+   return true;
+}
+
+static void replay_hash_check(uint64_t frame, uint64_t video, uint64_t audio)
+{
+   bool read;
+   uint64_t golden_frame, golden_video, golden_audio;
+
+   read = replay_hash_read_golden(&golden_frame, &golden_video, &golden_audio);
+
+   /* After seeking, the golden log may start at an earlier frame. */
+   while (read && !replay_hash_st.frames && golden_frame < frame)
+      read = replay_hash_read_golden(&golden_frame,
+            &golden_video, &golden_audio);
+
+   if (!read)
+   {
+      if (!replay_hash_st.diverged)
+         RARCH_ERR("Replay diverged at frame %llu: golden log ends before it.\n",
+               (unsigned long long)frame);
+      goto diverged;
+   }
+
+   if (golden_frame == frame && golden_video == video && golden_audio == audio)
+      return;
+
+   if (!replay_hash_st.diverged)
+   {
+      if (golden_frame != frame)
+         RARCH_ERR("Replay diverged at frame %llu: golden log has frame %llu instead.\n",
+               (unsigned long long)frame, (unsigned long long)golden_frame);
+      else
+         RARCH_ERR("Replay diverged at frame %llu in its %s%s%s, "
+               "got %016llx %016llx, expected %016llx %016llx.\n",
+               (unsigned long long)frame,
+               golden_video != video ? "video" : "",
+               golden_video != video && golden_audio != audio ? " and " : "",
+               golden_audio != audio ? "audio" : "",
+               (unsigned long long)video, (unsigned long long)audio,
+               (unsigned long long)golden_video,
+               (unsigned long long)golden_audio);
+   }
+
+diverged:
+   replay_hash_st.diverged = true;
+   replay_hash_st.diverged_frames++;
+}
+
+bool replay_hash_init(const char *log_path, const char *golden_path,
+      uint64_t start_frame)
+{
+   replay_hash_deinit();
+   memset(&replay_hash_st, 0, sizeof(replay_hash_st));
+
+   if (log_path && *log_path
+         && !(replay_hash_st.log = fopen(log_path, "w")))
+   {
+      RARCH_ERR("Couldn't open hash log \"%s\".\n", log_path);
+      goto error;
+   }
+
+   if (golden_path && *golden_path
+         && !(replay_hash_st.golden = fopen(golden_path, "r")))
+   {
+      RARCH_ERR("Couldn't open golden hash log \"%s\".\n", golden_path);
+      goto error;
+   }
+
+   replay_hash_st.active      = true;
+   replay_hash_st.start_frame = start_frame;
+   replay_hash_st.video       = replay_hash_finish(REPLAY_HASH_BASIS);
+   replay_hash_st.audio       = REPLAY_HASH_BASIS;
+   replay_hash_st.start_time  = rarch_get_time_usec();
+   replay_hash_st.end_time    = replay_hash_st.start_time;
+   return true;
+
+error:
+   replay_hash_deinit();
+   return false;
+}
+
+void replay_hash_deinit(void)
+{
+   uint64_t frame, video, audio;
+   retro_time_t time;
+
+   if (!replay_hash_st.active)
+      goto end;
+
+   time = replay_hash_st.end_time - replay_hash_st.start_time;
+   RARCH_LOG("Replayed %llu frames in %.3f s, %.1f frames per second.\n",
+         (unsigned long long)replay_hash_st.frames, time / 1000000.0,
+         time ? replay_hash_st.frames * 1000000.0 / time : 0.0);
+
+   if (!replay_hash_st.golden)
+      goto end;
+
+   if (replay_hash_read_golden(&frame, &video, &audio))
+   {
+      if (!replay_hash_st.diverged)
+         RARCH_ERR("Replay diverged at frame %llu: it ended before the golden log.\n",
+               (unsigned long long)frame);
+      replay_hash_st.diverged = true;
+   }
+
+   if (replay_hash_st.diverged)
+      RARCH_ERR("Replay does not match golden log, %llu frames differ.\n",
+            (unsigned long long)replay_hash_st.diverged_frames);
+   else
+      RARCH_LOG("Replay matches golden log.\n");
+
+end:
+   if (replay_hash_st.log)
+      fclose(replay_hash_st.log);
+   if (replay_hash_st.golden)
+      fclose(replay_hash_st.golden);
+
+   replay_hash_st.log    = NULL;
+   replay_hash_st.golden = NULL;
+   replay_hash_st.active = false;
+}
+
+bool replay_hash_active(void)
+{
+   return replay_hash_st.active;
+}
+
+void replay_hash_set_callbacks(void)
+{
+   if (!replay_hash_st.active)
+      return;
+
+   pretro_set_video_refresh(replay_hash_video_frame);
+   pretro_set_audio_sample(replay_hash_audio_sample);
+   pretro_set_audio_sample_batch(replay_hash_audio_sample_batch);
+}
+
+void replay_hash_frame_end(uint64_t frame)
+{
+   uint64_t audio;
+
+   if (!replay_hash_st.active)
+      return;
+
+   audio                 = replay_hash_finish(replay_hash_st.audio);
+   replay_hash_st.audio  = REPLAY_HASH_BASIS;
+
+   if (frame < replay_hash_st.start_frame)
+      return;
+
+   if (replay_hash_st.log)
+      fprintf(replay_hash_st.log, "%llu %016llx %016llx\n",
+            (unsigned long long)frame,
+            (unsigned long long)replay_hash_st.video,
+            (unsigned long long)audio);
+
+   if (replay_hash_st.golden)
+      replay_hash_check(frame, replay_hash_st.video, audio);
+
+   replay_hash_st.frames++;
+   replay_hash_st.end_time = rarch_get_time_usec();
+}
+
+bool replay_hash_diverged(void)
+{
+   return replay_hash_st.diverged;
+}
@@ -0,0 +1,85 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RARCH_REPLAY_HASH_H
+#define _RARCH_REPLAY_HASH_H
+
+#include <stdint.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * replay_hash_init:
+ * @log_path            : Hash log to write, or NULL.
+ * @golden_path         : Hash log to compare against, or NULL.
+ * @start_frame         : First movie frame to hash.
+ *
+ * Starts hashing the video and audio output of every frame of
+ * the movie being played back, instead of presenting it. Frames
+ * then run as fast as the core allows.
+ *
+ * Each line of a hash log holds the movie frame number, the hash
+ * of its video frame and the hash of its audio samples. Frames
+ * before @start_frame, played after seeking to a keyframe, are not
+ * logged and are skipped in the golden log.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool replay_hash_init(const char *log_path, const char *golden_path,
+      uint64_t start_frame);
+
+/**
+ * replay_hash_deinit:
+ *
+ * Reports the number of frames replayed, how fast they ran and
+ * whether they matched the golden log, then stops hashing.
+ **/
+void replay_hash_deinit(void);
+
+bool replay_hash_active(void);
+
+/**
+ * replay_hash_set_callbacks:
+ *
+ * Sets the libretro video and audio callbacks to the hashing ones,
+ * if hashing.
+ **/
+void replay_hash_set_callbacks(void);
+
+/**
+ * replay_hash_frame_end:
+ * @frame               : Movie frame just run.
+ *
+ * Logs the hashes of @frame, and compares them to the golden log.
+ **/
+void replay_hash_frame_end(uint64_t frame);
+
+/**
+ * replay_hash_diverged:
+ *
+ * Returns: true (1) if the last replay did not match its
+ * golden log, otherwise false (0).
+ **/
+bool replay_hash_diverged(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -46,6 +46,8 @@
 #include "runloop_data.h"
 #include "performance.h"
 #include "cheats.h"
+#include "content.h"
+#include "screenshot.h"
 #include "system.h"
 
 #include "git_version.h"
@@ -81,7 +83,11 @@ enum {
    RA_OPT_VERSION,
    RA_OPT_EOF_EXIT,
    RA_OPT_LOG_FILE,
-   RA_OPT_MAX_FRAMES
+   RA_OPT_MAX_FRAMES,
+   RA_OPT_BSV_CONVERT,
+   RA_OPT_HASH_LOG,
+   RA_OPT_HASH_CHECK,
+   RA_OPT_BSV_SEEK
 };
 
 #include "config.features.h"
@@ -210,6 +216,13 @@ static void print_help(const char *arg0)
    puts("  -P, --bsvplay=FILE    Playback a BSV movie file.");
    puts("  -R, --bsvrecord=FILE  Start recording a BSV movie file from the beginning.");
    puts("      --eof-exit        Exit upon reaching the end of the BSV movie file.");
+   puts("      --bsvconvert=FILE Record the movie played back with -P to FILE in the BSV2 format, then exit.");
+   puts("      --hashlog=FILE    Play back the movie given with -P as fast as possible without presenting it,\n"
+        "                        writing hashes of the video and audio of each frame to FILE, then exit.");
+   puts("      --hashcheck=FILE  Like --hashlog, comparing the hashes to those in FILE. Exits with status 1\n"
+        "                        if they differ.");
+   puts("      --bsvseek=FRAME   Start playing back the BSV2 movie given with -P from its last keyframe before FRAME.\n"
+        "                        --hashlog and --hashcheck only hash the frames from FRAME on.");
    puts("  -M, --sram-mode=MODE  SRAM handling mode. MODE can be 'noload-nosave',\n"
         "                        'noload-save', 'load-nosave' or 'load-save'.\n"
         "                        Note: 'noload-save' implies that save files *WILL BE OVERWRITTEN*.");
@@ -549,6 +562,10 @@ static void parse_input(int argc, char *argv[])
       { "subsystem",    1, NULL, RA_OPT_SUBSYSTEM },
       { "max-frames",   1, NULL, RA_OPT_MAX_FRAMES },
       { "eof-exit",     0, NULL, RA_OPT_EOF_EXIT },
+      { "bsvconvert",   1, NULL, RA_OPT_BSV_CONVERT },
+      { "hashlog",      1, NULL, RA_OPT_HASH_LOG },
+      { "hashcheck",    1, NULL, RA_OPT_HASH_CHECK },
+      { "bsvseek",      1, NULL, RA_OPT_BSV_SEEK },
       { "version",      0, NULL, RA_OPT_VERSION },
 #ifdef HAVE_FILE_LOGGER
       { "log-file",     1, NULL, RA_OPT_LOG_FILE },
@@ -853,6 +870,28 @@ static void parse_input(int argc, char *argv[])
             global->bsv.eof_exit = true;
             break;
 
+         case RA_OPT_BSV_CONVERT:
+            strlcpy(global->bsv.convert_path, optarg,
+                  sizeof(global->bsv.convert_path));
+            global->bsv.eof_exit = true;
+            break;
+
+         case RA_OPT_HASH_LOG:
+            strlcpy(global->bsv.hash_log_path, optarg,
+                  sizeof(global->bsv.hash_log_path));
+            global->bsv.eof_exit = true;
+            break;
+
+         case RA_OPT_HASH_CHECK:
+            strlcpy(global->bsv.hash_check_path, optarg,
+                  sizeof(global->bsv.hash_check_path));
+            global->bsv.eof_exit = true;
+            break;
+
+         case RA_OPT_BSV_SEEK:
+            global->bsv.start_frame = strtoull(optarg, NULL, 10);
+            break;
+
          case RA_OPT_VERSION:
             print_version();
             exit(0);
@@ -1478,6 +1517,10 @@ void rarch_main_deinit(void)
    event_command(EVENT_CMD_RECORD_DEINIT);
    event_command(EVENT_CMD_SAVEFILES);
 
+   /* Flush screenshots still being encoded. */
+   screenshot_deinit();
+   content_deinit();
+
    event_command(EVENT_CMD_REWIND_DEINIT);
    event_command(EVENT_CMD_CHEATS_DEINIT);
    event_command(EVENT_CMD_BSV_MOVIE_DEINIT);
@@ -0,0 +1,513 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <retro_log.h>
+
+#include "runahead.h"
+#include "libretro_version_1.h"
+#include "dynamic.h"
+#include "content.h"
+#include "file_ops.h"
+#include "frame_stats.h"
+#include "general.h"
+#include "gfx/video_driver.h"
+
+#if defined(HAVE_DYNAMIC) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_DYNAMIC
+/* Second copy of the core, loaded from a copy of its library
+ * so that it does not share any state with the first one. */
+typedef struct runahead_instance
+{
+   dylib_t lib;
+   /* Copy of the core library, and the private directory
+    * holding it outside of Windows. */
+   char path[PATH_MAX_LENGTH];
+   char dir[PATH_MAX_LENGTH];
+   bool inited;
+   bool game_loaded;
+
+   void (*retro_init)(void);
+   void (*retro_deinit)(void);
+   void (*retro_set_environment)(retro_environment_t);
+   void (*retro_set_video_refresh)(retro_video_refresh_t);
+   void (*retro_set_audio_sample)(retro_audio_sample_t);
+   void (*retro_set_audio_sample_batch)(retro_audio_sample_batch_t);
+   void (*retro_set_input_poll)(retro_input_poll_t);
+   void (*retro_set_input_state)(retro_input_state_t);
+   void (*retro_set_controller_port_device)(unsigned, unsigned);
+   void (*retro_run)(void);
+   bool (*retro_unserialize)(const void*, size_t);
+   bool (*retro_load_game)(const struct retro_game_info*);
+   bool (*retro_load_game_special)(unsigned,
+         const struct retro_game_info*, size_t);
+   void (*retro_unload_game)(void);
+} runahead_instance_t;
+#endif
+
+static struct
+{
+   void *state;
+   size_t state_size;
+   /* Size of the last state saved, within state_size. */
+   size_t saved_size;
+   /* Set once running ahead failed, until the core is unloaded. */
+   bool unsupported;
+   bool secondary_unsupported;
+#ifdef HAVE_DYNAMIC
+   runahead_instance_t *secondary;
+#endif
+} runahead;
+
+static void runahead_video_frame_null(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+}
+
+static void runahead_audio_sample_null(int16_t left, int16_t right)
+{
+}
+
+static size_t runahead_audio_sample_batch_null(const int16_t *data,
+      size_t frames)
+{
+   return frames;
+}
+
+static void runahead_input_poll_null(void)
+{
+}
+
+#ifdef HAVE_DYNAMIC
+/**
+ * runahead_environment_cb:
+ * @cmd                          : Identifier of command.
+ * @data                         : Pointer to data.
+ *
+ * Environment callback of the second instance. Only answers
+ * queries, anything registering callbacks or data with the
+ * frontend belongs to the first instance.
+ **/
+static bool runahead_environment_cb(unsigned cmd, void *data)
+{
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         *(bool*)data = false;
+         return true;
+      case RETRO_ENVIRONMENT_GET_OVERSCAN:
+      case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      /* Same format as the first instance asked for. */
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+      case RETRO_ENVIRONMENT_GET_VARIABLE:
+      case RETRO_ENVIRONMENT_GET_INPUT_DEVICE_CAPABILITIES:
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_LIBRETRO_PATH:
+      case RETRO_ENVIRONMENT_GET_CORE_ASSETS_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_USERNAME:
+      case RETRO_ENVIRONMENT_GET_LANGUAGE:
+         return rarch_environment_cb(cmd, data);
+      default:
+         break;
+   }
+
+   return false;
+}
+
+static void runahead_secondary_remove_copy(runahead_instance_t *inst)
+{
+   if (*inst->path)
+      remove(inst->path);
+#ifndef _WIN32
+   if (*inst->dir)
+      rmdir(inst->dir);
+#endif
+
+   *inst->path = '\0';
+   *inst->dir  = '\0';
+}
+
+static void runahead_secondary_free(runahead_instance_t *inst)
+{
+   if (inst->game_loaded)
+      inst->retro_unload_game();
+   if (inst->inited)
+      inst->retro_deinit();
+   if (inst->lib)
+      dylib_close(inst->lib);
+   runahead_secondary_remove_copy(inst);
+   free(inst);
+}
+
+/**
+ * runahead_secondary_copy_core:
+ * @inst                         : Second instance.
+ * @core                         : Path of the core library.
+ *
+ * Copies the core library to a temporary file, since loading
+ * the same file twice would only return the loaded library.
+ *
+ * Outside of Windows, the copy is created in a new directory only
+ * the user can access, so that nobody can replace it before it is
+ * loaded. On Windows, %TEMP% is already private to the user.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool runahead_secondary_copy_core(runahead_instance_t *inst,
+      const char *core)
+{
+   ssize_t len;
+   bool ret             = false;
+   void *buf            = NULL;
+   const char *dir      = NULL;
+   settings_t *settings = config_get_ptr();
+#ifdef _WIN32
+   char name[PATH_MAX_LENGTH] = {0};
+   const char *tmp      = getenv("TEMP");
+#else
+   int fd               = -1;
+   FILE *file           = NULL;
+   const char *tmp      = getenv("TMPDIR");
+
+   if (!tmp || !*tmp)
+      tmp = "/tmp";
+#endif
+
+   if (*settings->extraction_directory)
+      dir = settings->extraction_directory;
+   else if (tmp && *tmp)
+      dir = tmp;
+
+   if (!read_file(core, &buf, &len))
+      return false;
+
+#ifdef _WIN32
+   snprintf(name, sizeof(name), "retroarch_run_ahead_%s",
+         path_basename(core));
+
+   if (dir)
+      fill_pathname_join(inst->path, dir, name, sizeof(inst->path));
+   else
+      fill_pathname_resolve_relative(inst->path, core, name,
+            sizeof(inst->path));
+
+   ret = write_file(inst->path, buf, len);
+#else
+   /* Created with mode 0700. */
+   fill_pathname_join(inst->dir, dir, "retroarch_run_ahead_XXXXXX",
+         sizeof(inst->dir));
+
+   if (!mkdtemp(inst->dir))
+   {
+      RARCH_ERR("Run-ahead: could not create directory \"%s\".\n",
+            inst->dir);
+      *inst->dir = '\0';
+      free(buf);
+      return false;
+   }
+
+   fill_pathname_join(inst->path, inst->dir, path_basename(core),
+         sizeof(inst->path));
+
+   fd = open(inst->path, O_WRONLY | O_CREAT | O_EXCL, 0700);
+   if (fd >= 0 && (file = fdopen(fd, "wb")))
+   {
+      ret = fwrite(buf, 1, len, file) == (size_t)len;
+      if (fclose(file) != 0)
+         ret = false;
+   }
+   else if (fd >= 0)
+      close(fd);
+#endif
+
+   free(buf);
+
+   if (!ret)
+   {
+      RARCH_ERR("Run-ahead: could not copy core to \"%s\".\n", inst->path);
+      runahead_secondary_remove_copy(inst);
+   }
+
+   return ret;
+}
+
+#define RUNAHEAD_SYM(x) do { \
+   function_t func = dylib_proc(inst->lib, #x); \
+   memcpy(&inst->x, &func, sizeof(func)); \
+   if (!inst->x) goto error; \
+} while (0)
+
+/**
+ * runahead_secondary_init:
+ *
+ * Loads the core a second time, with the same content.
+ *
+ * Returns: second instance, or NULL if it cannot be loaded.
+ **/
+static runahead_instance_t *runahead_secondary_init(void)
+{
+   unsigned i;
+   runahead_instance_t *inst           = NULL;
+   driver_t *driver                    = driver_get_ptr();
+   settings_t *settings                = config_get_ptr();
+   global_t *global                    = global_get_ptr();
+   rarch_system_info_t *system         = rarch_system_info_get_ptr();
+   struct retro_hw_render_callback *hw = video_driver_callback();
+
+   if (global->inited.core.type != CORE_TYPE_PLAIN)
+      return NULL;
+
+   /* The second instance cannot share the rendering context. */
+   if (hw && hw->context_type != RETRO_HW_CONTEXT_NONE)
+   {
+      RARCH_WARN("Run-ahead: second instance does not support hardware rendered cores.\n");
+      return NULL;
+   }
+
+   inst = (runahead_instance_t*)calloc(1, sizeof(*inst));
+   if (!inst)
+      return NULL;
+
+   if (!runahead_secondary_copy_core(inst, settings->libretro))
+      goto error;
+
+   inst->lib = dylib_load(inst->path);
+
+#ifndef _WIN32
+   /* The loaded library stays mapped. */
+   runahead_secondary_remove_copy(inst);
+#endif
+
+   if (!inst->lib)
+   {
+      RARCH_ERR("Run-ahead: failed to load core copy: %s\n", dylib_error());
+      goto error;
+   }
+
+   RUNAHEAD_SYM(retro_init);
+   RUNAHEAD_SYM(retro_deinit);
+   RUNAHEAD_SYM(retro_set_environment);
+   RUNAHEAD_SYM(retro_set_video_refresh);
+   RUNAHEAD_SYM(retro_set_audio_sample);
+   RUNAHEAD_SYM(retro_set_audio_sample_batch);
+   RUNAHEAD_SYM(retro_set_input_poll);
+   RUNAHEAD_SYM(retro_set_input_state);
+   RUNAHEAD_SYM(retro_set_controller_port_device);
+   RUNAHEAD_SYM(retro_run);
+   RUNAHEAD_SYM(retro_unserialize);
+   RUNAHEAD_SYM(retro_load_game);
+   RUNAHEAD_SYM(retro_load_game_special);
+   RUNAHEAD_SYM(retro_unload_game);
+
+   inst->retro_set_environment(runahead_environment_cb);
+   inst->retro_init();
+   inst->inited = true;
+
+   /* Its audio is never heard, and input is polled by the first one. */
+   inst->retro_set_video_refresh(runahead_video_frame_null);
+   inst->retro_set_audio_sample(runahead_audio_sample_null);
+   inst->retro_set_audio_sample_batch(runahead_audio_sample_batch_null);
+   inst->retro_set_input_poll(runahead_input_poll_null);
+   inst->retro_set_input_state(driver->retro_ctx.state_cb);
+
+   if (!content_reload(inst->retro_load_game, inst->retro_load_game_special))
+   {
+      RARCH_ERR("Run-ahead: second instance failed to load content.\n");
+      goto error;
+   }
+   inst->game_loaded = true;
+
+   for (i = 0; i < MAX_USERS; i++)
+   {
+      unsigned device = settings->input.libretro_device[i];
+
+      if (device == RETRO_DEVICE_JOYPAD)
+         continue;
+      if (device != RETRO_DEVICE_NONE && (i >= system->num_ports
+               || !libretro_find_controller_description(
+                  &system->ports[i], device)))
+         continue;
+
+      inst->retro_set_controller_port_device(i, device);
+   }
+
+   RARCH_LOG("Run-ahead: loaded second instance of the core.\n");
+
+   return inst;
+
+error:
+   runahead_secondary_free(inst);
+   return NULL;
+}
+#endif
+
+/**
+ * runahead_save:
+ *
+ * Saves the state of the first instance.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool runahead_save(void)
+{
+   size_t size = pretro_serialize_size();
+
+   if (size > runahead.state_size)
+   {
+      void *state = realloc(runahead.state, size);
+
+      if (!state)
+         return false;
+
+      runahead.state      = state;
+      runahead.state_size = size;
+   }
+
+   runahead.saved_size = size;
+
+   return size && pretro_serialize(runahead.state, size);
+}
+
+/**
+ * runahead_run_secondary:
+ * @frames              : Number of frames to run ahead.
+ *
+ * Runs @frames frames in the second instance, from the
+ * saved state of the first one.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool runahead_run_secondary(unsigned frames)
+{
+#ifdef HAVE_DYNAMIC
+   unsigned i;
+   runahead_instance_t *inst = NULL;
+   driver_t *driver          = driver_get_ptr();
+
+   if (runahead.secondary_unsupported)
+      return false;
+
+   if (!runahead.secondary)
+      runahead.secondary = runahead_secondary_init();
+
+   inst = runahead.secondary;
+
+   if (!inst || !inst->retro_unserialize(runahead.state,
+            runahead.saved_size))
+   {
+      RARCH_WARN("Run-ahead: running ahead in the first instance instead.\n");
+      if (inst)
+         runahead_secondary_free(inst);
+      runahead.secondary             = NULL;
+      runahead.secondary_unsupported = true;
+      return false;
+   }
+
+   for (i = 1; i <= frames; i++)
+   {
+      inst->retro_set_video_refresh((i == frames)
+            ? driver->retro_ctx.frame_cb : runahead_video_frame_null);
+      inst->retro_run();
+   }
+
+   return true;
+#else
+   if (!runahead.secondary_unsupported)
+      RARCH_WARN("Run-ahead: second instance requires a dynamically loaded core.\n");
+   runahead.secondary_unsupported = true;
+   return false;
+#endif
+}
+
+void runahead_run(unsigned frames, bool secondary_instance)
+{
+   unsigned i;
+   driver_t *driver = driver_get_ptr();
+
+#ifdef HAVE_DYNAMIC
+   if (!secondary_instance && runahead.secondary)
+   {
+      runahead_secondary_free(runahead.secondary);
+      runahead.secondary = NULL;
+   }
+#endif
+
+   if (!frames || runahead.unsupported)
+   {
+      pretro_run();
+      return;
+   }
+
+   /* The frame everything else continues from, heard but not shown. */
+   pretro_set_video_refresh(runahead_video_frame_null);
+   pretro_run();
+   pretro_set_video_refresh(driver->retro_ctx.frame_cb);
+
+   frame_stats_mark(FRAME_STATS_RUN_AHEAD);
+
+   if (!runahead_save())
+   {
+      RARCH_WARN("Run-ahead: core cannot save states, disabling run-ahead.\n");
+      runahead.unsupported = true;
+      return;
+   }
+
+   if (secondary_instance && runahead_run_secondary(frames))
+      return;
+
+   pretro_set_audio_sample(runahead_audio_sample_null);
+   pretro_set_audio_sample_batch(runahead_audio_sample_batch_null);
+   pretro_set_input_poll(runahead_input_poll_null);
+
+   for (i = 1; i <= frames; i++)
+   {
+      pretro_set_video_refresh((i == frames)
+            ? driver->retro_ctx.frame_cb : runahead_video_frame_null);
+      pretro_run();
+   }
+
+   if (!pretro_unserialize(runahead.state, runahead.saved_size))
+   {
+      RARCH_WARN("Run-ahead: core cannot load states, disabling run-ahead.\n");
+      runahead.unsupported = true;
+   }
+
+   pretro_set_video_refresh(driver->retro_ctx.frame_cb);
+   pretro_set_input_poll(driver->retro_ctx.poll_cb);
+   retro_set_rewind_callbacks();
+}
+
+void runahead_deinit(void)
+{
+#ifdef HAVE_DYNAMIC
+   if (runahead.secondary)
+      runahead_secondary_free(runahead.secondary);
+#endif
+
+   free(runahead.state);
+   memset(&runahead, 0, sizeof(runahead));
+}
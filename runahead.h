@@ -0,0 +1,51 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RARCH_RUNAHEAD_H
+#define _RARCH_RUNAHEAD_H
+
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * runahead_run:
+ * @frames              : Number of frames to run ahead.
+ * @secondary_instance  : Run ahead in a second instance of the core.
+ *
+ * Runs libretro for one frame, then @frames more frames with the
+ * same input, showing only the last one. Audio comes from the
+ * first frame only, whose state is restored afterwards.
+ *
+ * Falls back to a plain retro_run if the core cannot save states.
+ **/
+void runahead_run(unsigned frames, bool secondary_instance);
+
+/**
+ * runahead_deinit:
+ *
+ * Frees the state buffer and the second instance of the core,
+ * before the core is unloaded.
+ **/
+void runahead_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -24,6 +24,9 @@
 
 #include "configuration.h"
 #include "dynamic.h"
+#include "frame_stats.h"
+#include "runahead.h"
+#include "replay_hash.h"
 #include "performance.h"
 #include "retroarch.h"
 #include "runloop.h"
@@ -54,6 +57,15 @@ static unsigned main_max_frames;
 static retro_time_t frame_limit_last_time;
 static retro_time_t frame_limit_minimum_time;
 
+/* Frames the auto frame delay looks at before raising it. */
+#define FRAME_DELAY_AUTO_WINDOW 60
+/* Time in microseconds left free for frames slower than the window's. */
+#define FRAME_DELAY_AUTO_MARGIN 2000
+
+static unsigned frame_delay_tuned;
+static unsigned frame_delay_tuned_frames;
+static retro_time_t frame_delay_tuned_busy;
+
 /**
  * check_pause:
  * @pressed              : was libretro pause key pressed?
@@ -199,6 +211,8 @@ static void check_rewind(settings_t *settings,
 
          if (global->bsv.movie)
             bsv_movie_frame_rewind(global->bsv.movie);
+         if (global->bsv.convert)
+            bsv_movie_frame_rewind(global->bsv.convert);
       }
       else
          rarch_main_msg_queue_push_new(MSG_REWIND_REACHED_END,
@@ -637,7 +651,7 @@ static void rarch_update_frame_time(driver_t *driver, float slowmotion_ratio,
    retro_time_t current     = rarch_get_time_usec();
    retro_time_t delta       = current - system->frame_time_last;
    bool is_locked_fps       = (main_is_paused || driver->nonblock_state) | 
-      !!driver->recording_data;
+      !!driver->recording_data | replay_hash_active();
 
    if (!system->frame_time_last || is_locked_fps)
       delta = system->frame_time.reference;
@@ -657,7 +671,7 @@ static int rarch_limit_frame_time(float fastforward_ratio, unsigned *sleep_ms)
 {
    retro_time_t current, target, to_sleep_ms;
 
-   if (!fastforward_ratio)
+   if (!fastforward_ratio || replay_hash_active())
       return 0;
 
    current                        = rarch_get_time_usec();
@@ -677,6 +691,59 @@ static int rarch_limit_frame_time(float fastforward_ratio, unsigned *sleep_ms)
    return 0;
 }
 
+/**
+ * rarch_update_frame_delay:
+ * @interval             : Time in microseconds between vsyncs.
+ *
+ * Adapts the automatic frame delay to the frame just run. The delay
+ * is set to what is left of @interval after the slowest frame of a
+ * window. It is raised by at most 1 ms per window, but lowered right
+ * away, and lowered by 2 ms more after a missed vsync.
+ **/
+static void rarch_update_frame_delay(retro_time_t interval)
+{
+   retro_time_t busy, target;
+   bool missed_vsync = false;
+   unsigned delay    = frame_delay_tuned;
+
+   if (!frame_stats_last_frame(&busy, &missed_vsync) || !interval)
+      return;
+
+   if (missed_vsync)
+   {
+      delay                    = (delay > 2) ? delay - 2 : 0;
+      frame_delay_tuned_frames = 0;
+      frame_delay_tuned_busy   = 0;
+   }
+   else
+   {
+      if (busy > frame_delay_tuned_busy)
+         frame_delay_tuned_busy = busy;
+
+      target = (interval - frame_delay_tuned_busy
+            - FRAME_DELAY_AUTO_MARGIN) / 1000;
+      if (target < 0)
+         target = 0;
+      if (target > 15)
+         target = 15;
+
+      if (target < delay)
+         delay = (unsigned)target;
+      else if (++frame_delay_tuned_frames >= FRAME_DELAY_AUTO_WINDOW)
+      {
+         if (target > delay)
+            delay++;
+         frame_delay_tuned_frames = 0;
+         frame_delay_tuned_busy   = 0;
+      }
+   }
+
+   if (delay != frame_delay_tuned)
+      RARCH_LOG("Auto frame delay: %u ms.\n", delay);
+
+   frame_delay_tuned = delay;
+}
+
 /**
  * check_block_hotkey:
  * @enable_hotkey        : Is hotkey enable key enabled?
@@ -746,14 +813,23 @@ static INLINE retro_input_t input_keys_pressed(driver_t *driver,
          settings, driver->input->key_pressed(
             driver->input_data, RARCH_ENABLE_HOTKEY));
 
+#ifdef HAVE_MENU
+   /* Binds are edited in the menu without telling anyone. */
+   if (menu_driver_alive())
+      input_driver_invalidate_binds();
+#endif
+
    for (i = 0; i < settings->input.max_users; i++)
    {
+      global->turbo.frame_enable[i] = 0;
+
+      if (!settings->input.analog_dpad_mode[i])
+         continue;
+
       input_push_analog_dpad(settings->input.binds[i],
             settings->input.analog_dpad_mode[i]);
       input_push_analog_dpad(settings->input.autoconf_binds[i],
             settings->input.analog_dpad_mode[i]);
-
-      global->turbo.frame_enable[i] = 0;
    }
 
    if (!driver->block_libretro_input)
@@ -767,6 +843,9 @@ static INLINE retro_input_t input_keys_pressed(driver_t *driver,
 
    for (i = 0; i < settings->input.max_users; i++)
    {
+      if (!settings->input.analog_dpad_mode[i])
+         continue;
+
       input_pop_analog_dpad(settings->input.binds[i]);
       input_pop_analog_dpad(settings->input.autoconf_binds[i]);
    }
@@ -1004,7 +1083,8 @@ static void rarch_main_cmd_get_state(driver_t *driver,
  **/
 int rarch_main_iterate(unsigned *sleep_ms)
 {
-   unsigned i;
+   unsigned i, frame_delay;
+   retro_time_t frame_interval;
    retro_input_t trigger_input;
    event_cmd_state_t    cmd;
    bool do_quit                    = false;
@@ -1085,6 +1165,8 @@ int rarch_main_iterate(unsigned *sleep_ms)
          if (menu_iterate(true, menu_input_frame(input, trigger_input)) == -1)
             rarch_main_set_state(RARCH_ACTION_STATE_MENU_RUNNING_FINISHED);
 
+      frame_stats_break();
+
       if (!input && settings->menu.pause_libretro)
         return 1;
       return rarch_limit_frame_time(settings->fastforward_ratio, sleep_ms);
@@ -1094,7 +1176,8 @@ int rarch_main_iterate(unsigned *sleep_ms)
    if (do_state_checks(driver, settings, global, &cmd))
    {
       /* RetroArch has been paused. */
-      driver->retro_ctx.poll_cb();
+      frame_stats_break();
+      retro_poll_input();
       *sleep_ms = 10;
       return 1;
    }
@@ -1110,6 +1193,11 @@ int rarch_main_iterate(unsigned *sleep_ms)
 
    if (global->bsv.movie)
       bsv_movie_set_frame_start(global->bsv.movie);
+   if (global->bsv.convert)
+      bsv_movie_set_frame_start(global->bsv.convert);
+
+   frame_interval = settings->video.vsync
+      ? (retro_time_t)(1000000.0f / settings->video.refresh_rate) : 0;
 
    if (system->camera_callback.caps)
       driver_camera_poll();
@@ -1126,11 +1214,38 @@ int rarch_main_iterate(unsigned *sleep_ms)
             settings->input.analog_dpad_mode[i]);
    }
 
-   if ((settings->video.frame_delay > 0) && !driver->nonblock_state)
-      rarch_sleep(settings->video.frame_delay);
+   frame_delay = settings->video.frame_delay_auto
+      ? frame_delay_tuned : settings->video.frame_delay;
+
+   if ((frame_delay > 0) && !driver->nonblock_state && !replay_hash_active())
+      rarch_sleep(frame_delay);
 
-   /* Run libretro for one frame. */
-   pretro_run();
+   /* Fast-forwarded frames say nothing about pacing. */
+   if (driver->nonblock_state)
+      frame_stats_break();
+   else
+      frame_stats_frame_begin(frame_interval);
+
+   /* Run libretro for one frame. Running ahead would replay
+    * recorded or networked input out of order. */
+   if (settings->run_ahead_frames && !global->bsv.movie
+         && !global->rewind.frame_is_reverse
+#ifdef HAVE_NETPLAY
+         && !driver->netplay_data
+#endif
+      )
+      runahead_run(settings->run_ahead_frames,
+            settings->run_ahead_secondary_instance);
+   else
+      pretro_run();
+
+   frame_stats_frame_end();
+
+   /* Hotkeys need input polled, even if the core read none. */
+   retro_flush_input_poll();
+
+   if (settings->video.frame_delay_auto)
+      rarch_update_frame_delay(frame_interval);
 
    for (i = 0; i < settings->input.max_users; i++)
    {
@@ -1141,8 +1256,13 @@ int rarch_main_iterate(unsigned *sleep_ms)
       input_pop_analog_dpad(settings->input.autoconf_binds[i]);
    }
 
+   if (global->bsv.movie && !global->bsv.movie_end)
+      replay_hash_frame_end(bsv_movie_get_frame(global->bsv.movie));
+
    if (global->bsv.movie)
       bsv_movie_set_frame_end(global->bsv.movie);
+   if (global->bsv.convert)
+      bsv_movie_set_frame_end(global->bsv.convert);
 
 #ifdef HAVE_NETPLAY
    if (driver->netplay_data)
@@ -173,6 +173,17 @@ typedef struct global
       bool movie_start_recording;
       bool movie_start_playback;
       bool movie_end;
+
+      /* BSV2 recording of the movie played back. */
+      bsv_movie_t *convert;
+      char convert_path[PATH_MAX_LENGTH];
+
+      /* Hash logs of the movie played back. */
+      char hash_log_path[PATH_MAX_LENGTH];
+      char hash_check_path[PATH_MAX_LENGTH];
+
+      /* Frame to seek the movie played back to. */
+      uint64_t start_frame;
    } bsv;
 
    struct
@@ -29,6 +29,9 @@
 #include <retro_log.h>
 #include <file/file_path.h>
 #include <compat/strl.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
 #include <formats/rpng.h>
@@ -46,6 +49,58 @@
 #include "config.h"
 #endif
 
+#if defined(HAVE_THREADS) && !defined(_XBOX1)
+#define HAVE_SCREENSHOT_THREAD
+
+/* Maximum number of screenshots queued or being
+ * encoded at once. Further requests are rejected
+ * until the worker catches up. */
+#define SCREENSHOT_QUEUE_MAX 4
+#endif
+
+/* Savestate thumbnails are downscaled to fit these. */
+#define THUMBNAIL_MAX_WIDTH  320
+#define THUMBNAIL_MAX_HEIGHT 240
+
+struct screenshot_job
+{
+   char filename[PATH_MAX_LENGTH];
+   /* Frame data, bottom-up (see screenshot_dump). */
+   const uint8_t *frame;
+   /* Owned copy of the frame, if any. */
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   /* Size of the written image, smaller for thumbnails. */
+   unsigned out_width;
+   unsigned out_height;
+   int pitch;
+   bool bgr24;
+   enum retro_pixel_format pix_fmt;
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
+   struct rpng_encode_opts png_opts;
+#endif
+   screenshot_cb_t cb;
+   void *userdata;
+   struct screenshot_job *next;
+};
+
+#ifdef HAVE_SCREENSHOT_THREAD
+struct screenshot_queue
+{
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   struct screenshot_job *head;
+   struct screenshot_job *tail;
+   /* Jobs queued plus the one being encoded. */
+   unsigned pending;
+   bool quit;
+};
+
+static struct screenshot_queue *screenshot_queue;
+#endif
+
 #if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
 #define IMG_EXT "png"
 #else
@@ -83,15 +138,6 @@ static bool write_header_bmp(FILE *file, unsigned width, unsigned height)
    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
 }
 
-static void dump_lines_file(FILE *file, uint8_t **lines,
-      size_t line_size, unsigned height)
-{
-   unsigned i;
-
-   for (i = 0; i < height; i++)
-      fwrite(lines[i], 1, line_size, file);
-}
-
 static void dump_line_bgr(uint8_t *line, const uint8_t *src, unsigned width)
 {
    memcpy(line, src, width * 3);
@@ -127,148 +173,541 @@ static void dump_line_32(uint8_t *line, const uint32_t *src, unsigned width)
 }
 
 static void dump_content(FILE *file, const void *frame,
-      int width, int height, int pitch, bool bgr24)
+      int width, int height, int pitch, bool bgr24,
+      enum retro_pixel_format pix_fmt)
 {
    size_t line_size;
-   int i, j;
+   int j;
    union
    {
       const uint8_t *u8;
       const uint16_t *u16;
       const uint32_t *u32;
    } u;
-   uint8_t **lines = (uint8_t**)calloc(height, sizeof(uint8_t*));
-
-   if (!lines)
-      return;
+   uint8_t *line = NULL;
 
    u.u8      = (const uint8_t*)frame;
    line_size = (width * 3 + 3) & ~3;
 
-   for (i = 0; i < height; i++)
+   /* Lines are converted and written one at a time,
+    * so a single scratch line (with its padding zeroed)
+    * is all that is needed. */
+   line = (uint8_t*)calloc(1, line_size);
+   if (!line)
+      return;
+
+   for (j = 0; j < height; j++, u.u8 += pitch)
    {
-      lines[i] = (uint8_t*)calloc(1, line_size);
-      if (!lines[i])
-         goto end;
+      if (bgr24) /* BGR24 byte order. Can directly copy. */
+         dump_line_bgr(line, u.u8, width);
+      else if (pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
+         dump_line_32(line, u.u32, width);
+      else /* RGB565 */
+         dump_line_16(line, u.u16, width);
+
+      fwrite(line, 1, line_size, file);
    }
 
-   if (bgr24) /* BGR24 byte order. Can directly copy. */
+   free(line);
+}
+#endif
+
+/**
+ * screenshot_job_write:
+ * @job             : screenshot job
+ *
+ * Encodes and writes @job to disk.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool screenshot_job_write(const struct screenshot_job *job)
+{
+   bool ret                       = false;
+#ifdef _XBOX1
+   driver_t *driver               = driver_get_ptr();
+   d3d_video_t *d3d               = (d3d_video_t*)driver->video_data;
+   D3DSurface *surf               = NULL;
+
+   d3d->dev->GetBackBuffer(-1, D3DBACKBUFFER_TYPE_MONO, &surf);
+   ret = XGWriteSurfaceToFile(surf, job->filename);
+   surf->Release();
+
+   if(ret == S_OK)
    {
-      for (j = 0; j < height; j++, u.u8 += pitch)
-         dump_line_bgr(lines[j], u.u8, width);
+      RARCH_LOG("Screenshot saved: %s.\n", job->filename);
+      rarch_main_msg_queue_push("Screenshot saved.", 1, 30, false);
+      return true;
    }
-   else if (video_driver_get_pixel_format() == RETRO_PIXEL_FORMAT_XRGB8888)
+
+   ret = false;
+#elif defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
+   struct scaler_ctx scaler       = {0};
+   uint8_t *out_buffer            = (uint8_t*)
+      malloc(job->out_width * job->out_height * 3);
+
+   if (!out_buffer)
+      return false;
+
+   scaler.in_width    = job->width;
+   scaler.in_height   = job->height;
+   scaler.out_width   = job->out_width;
+   scaler.out_height  = job->out_height;
+   scaler.in_stride   = -job->pitch;
+   scaler.out_stride  = job->out_width * 3;
+   scaler.out_fmt     = SCALER_FMT_BGR24;
+   scaler.scaler_type = SCALER_TYPE_POINT;
+
+   if (job->out_width != job->width || job->out_height != job->height)
+      scaler.scaler_type = SCALER_TYPE_BILINEAR;
+
+   if (job->bgr24)
+      scaler.in_fmt = SCALER_FMT_BGR24;
+   else if (job->pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
+      scaler.in_fmt = SCALER_FMT_ARGB8888;
+   else
+      scaler.in_fmt = SCALER_FMT_RGB565;
+
+   scaler_ctx_gen_filter(&scaler);
+   scaler_ctx_scale(&scaler, out_buffer,
+         job->frame + ((int)job->height - 1) * job->pitch);
+   scaler_ctx_gen_reset(&scaler);
+
+   RARCH_LOG("Using RPNG for PNG screenshots.\n");
+   ret = rpng_save_image_bgr24_opts(job->filename,
+         out_buffer, job->out_width, job->out_height, job->out_width * 3,
+         &job->png_opts);
+   if (!ret)
+      RARCH_ERR("Failed to take screenshot.\n");
+   free(out_buffer);
+#else
+   FILE *file = fopen(job->filename, "wb");
+   if (!file)
    {
-      for (j = 0; j < height; j++, u.u8 += pitch)
-         dump_line_32(lines[j], u.u32, width);
+      RARCH_ERR("Failed to open file \"%s\" for screenshot.\n",
+            job->filename);
+      return false;
    }
-   else /* RGB565 */
+
+   ret = write_header_bmp(file, job->width, job->height);
+
+   if (ret)
+      dump_content(file, job->frame, job->width, job->height,
+            job->pitch, job->bgr24, job->pix_fmt);
+   else
+      RARCH_ERR("Failed to write image header.\n");
+
+   fclose(file);
+#endif
+
+   return ret;
+}
+
+static void screenshot_job_init(struct screenshot_job *job,
+      const char *folder, const void *frame,
+      unsigned width, unsigned height, int pitch, bool bgr24)
+{
+   char shotname[PATH_MAX_LENGTH] = {0};
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
+   settings_t *settings           = config_get_ptr();
+#endif
+
+   fill_dated_filename(shotname, IMG_EXT, sizeof(shotname));
+   fill_pathname_join(job->filename, folder, shotname,
+         sizeof(job->filename));
+
+   job->frame      = (const uint8_t*)frame;
+   job->width      = width;
+   job->height     = height;
+   job->out_width  = width;
+   job->out_height = height;
+   job->pitch      = pitch;
+   job->bgr24      = bgr24;
+   job->pix_fmt    = video_driver_get_pixel_format();
+
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
+   /* Settings are sampled here, the job may be
+    * encoded on another thread. */
+   job->png_opts.level   = settings->video.screenshot_png_level;
+   job->png_opts.threads = settings->video.screenshot_png_threads;
+#endif
+}
+
+static void screenshot_job_free(struct screenshot_job *job)
+{
+   if (!job)
+      return;
+
+   free(job->buffer);
+   free(job);
+}
+
+/**
+ * screenshot_job_new:
+ * @folder          : directory to write the screenshot to
+ * @width           : width of the frame
+ * @height          : height of the frame
+ * @bgr24           : frame is BGR24 instead of the core pixel format
+ *
+ * Allocates a screenshot job together with a tightly
+ * packed frame buffer, which the caller is expected
+ * to fill in bottom-up order.
+ *
+ * Returns: new job if successful, otherwise NULL.
+ **/
+static struct screenshot_job *screenshot_job_new(const char *folder,
+      unsigned width, unsigned height, bool bgr24)
+{
+   size_t bpp;
+   struct screenshot_job *job = (struct screenshot_job*)
+      calloc(1, sizeof(*job));
+
+   if (!job)
+      return NULL;
+
+   screenshot_job_init(job, folder, NULL, width, height, 0, bgr24);
+
+   if (bgr24)
+      bpp = 3;
+   else if (job->pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
+      bpp = sizeof(uint32_t);
+   else
+      bpp = sizeof(uint16_t);
+
+   job->pitch  = width * bpp;
+   job->buffer = (uint8_t*)malloc(job->pitch * height);
+
+   if (!job->buffer)
    {
-      for (j = 0; j < height; j++, u.u8 += pitch)
-         dump_line_16(lines[j], u.u16, width);
+      free(job);
+      return NULL;
    }
 
-   dump_lines_file(file, lines, line_size, height);
+   job->frame  = job->buffer;
 
-end:
-   for (i = 0; i < height; i++)
-      free(lines[i]);
-   free(lines);
+   return job;
+}
+
+static void screenshot_job_finish(struct screenshot_job *job, bool success)
+{
+   if (job->cb)
+      job->cb(success, job->filename, job->userdata);
+   screenshot_job_free(job);
+}
+
+#ifdef HAVE_SCREENSHOT_THREAD
+static void screenshot_thread(void *data)
+{
+   struct screenshot_queue *queue = (struct screenshot_queue*)data;
+
+   for (;;)
+   {
+      struct screenshot_job *job = NULL;
+
+      slock_lock(queue->lock);
+
+      while (!queue->head && !queue->quit)
+         scond_wait(queue->cond, queue->lock);
+
+      /* Pending jobs are drained before honoring quit. */
+      job = queue->head;
+      if (job)
+      {
+         queue->head = job->next;
+         if (!queue->head)
+            queue->tail = NULL;
+      }
+
+      slock_unlock(queue->lock);
+
+      if (!job)
+         break;
+
+      screenshot_job_finish(job, screenshot_job_write(job));
+
+      slock_lock(queue->lock);
+      queue->pending--;
+      slock_unlock(queue->lock);
+   }
 }
+
+static struct screenshot_queue *screenshot_queue_new(void)
+{
+   struct screenshot_queue *queue = (struct screenshot_queue*)
+      calloc(1, sizeof(*queue));
+
+   if (!queue)
+      return NULL;
+
+   queue->lock   = slock_new();
+   queue->cond   = scond_new();
+
+   if (!queue->lock || !queue->cond)
+      goto error;
+
+   queue->thread = sthread_create(screenshot_thread, queue);
+
+   if (!queue->thread)
+      goto error;
+
+   return queue;
+
+error:
+   if (queue->lock)
+      slock_free(queue->lock);
+   if (queue->cond)
+      scond_free(queue->cond);
+   free(queue);
+   return NULL;
+}
+#endif
+
+/**
+ * screenshot_job_push:
+ * @job             : screenshot job, ownership is transferred
+ *
+ * Hands @job over to the screenshot worker thread. Without
+ * thread support, the job is written out immediately.
+ *
+ * Returns: true (1) if the job was accepted, otherwise false (0).
+ * On failure, @job is freed without invoking its callback.
+ **/
+static bool screenshot_job_push(struct screenshot_job *job)
+{
+#ifdef HAVE_SCREENSHOT_THREAD
+   if (!screenshot_queue)
+      screenshot_queue = screenshot_queue_new();
+
+   if (screenshot_queue)
+   {
+      struct screenshot_queue *queue = screenshot_queue;
+
+      slock_lock(queue->lock);
+
+      if (queue->pending >= SCREENSHOT_QUEUE_MAX)
+      {
+         slock_unlock(queue->lock);
+         RARCH_WARN("Screenshot queue is full, dropping screenshot.\n");
+         screenshot_job_free(job);
+         return false;
+      }
+
+      if (queue->tail)
+         queue->tail->next = job;
+      else
+         queue->head       = job;
+      queue->tail          = job;
+      queue->pending++;
+
+      scond_signal(queue->cond);
+      slock_unlock(queue->lock);
+      return true;
+   }
+#endif
+
+   screenshot_job_finish(job, screenshot_job_write(job));
+   return true;
+}
+
+/**
+ * screenshot_deinit:
+ *
+ * Waits for all pending screenshots to be written
+ * and tears down the screenshot worker thread.
+ **/
+void screenshot_deinit(void)
+{
+#ifdef HAVE_SCREENSHOT_THREAD
+   struct screenshot_queue *queue = screenshot_queue;
+
+   if (!queue)
+      return;
+
+   slock_lock(queue->lock);
+   queue->quit = true;
+   scond_signal(queue->cond);
+   slock_unlock(queue->lock);
+
+   sthread_join(queue->thread);
+
+   slock_free(queue->lock);
+   scond_free(queue->cond);
+   free(queue);
+
+   screenshot_queue = NULL;
 #endif
+}
+
+static const char *screenshot_get_dir(char *s, size_t len)
+{
+   settings_t *settings = config_get_ptr();
+   global_t *global     = global_get_ptr();
+
+   if (*settings->screenshot_directory)
+      return settings->screenshot_directory;
+
+   fill_pathname_basedir(s, global->name.base, len);
+   return s;
+}
+
+static void take_screenshot_cb(bool success, const char *path,
+      void *userdata)
+{
+   (void)userdata;
+
+   /* Called from the screenshot worker thread,
+    * the message queue is thread-safe. */
+   if (success)
+   {
+      RARCH_LOG("Screenshot saved: %s.\n", path);
+      rarch_main_msg_queue_push(msg_hash_to_str(MSG_SCREENSHOT_SAVED),
+            1, 180, true);
+      return;
+   }
 
-static bool take_screenshot_viewport(void)
+   RARCH_WARN("%s.\n", msg_hash_to_str(MSG_FAILED_TO_TAKE_SCREENSHOT));
+   rarch_main_msg_queue_push(msg_hash_to_str(MSG_FAILED_TO_TAKE_SCREENSHOT),
+         1, 180, true);
+}
+
+static void take_thumbnail_cb(bool success, const char *path,
+      void *userdata)
+{
+   (void)userdata;
+
+   if (success)
+      RARCH_LOG("Savestate thumbnail saved: %s.\n", path);
+   else
+      RARCH_WARN("Failed to save savestate thumbnail \"%s\".\n", path);
+}
+
+/**
+ * take_screenshot_push:
+ * @job             : screenshot job, ownership is transferred
+ * @thumbnail_path  : path of the thumbnail to write, or NULL
+ *
+ * Queues a captured frame, either as a dated screenshot or,
+ * if @thumbnail_path is set, as a thumbnail downscaled to fit
+ * THUMBNAIL_MAX_WIDTH x THUMBNAIL_MAX_HEIGHT.
+ *
+ * Returns: true (1) if the job was accepted, otherwise false (0).
+ **/
+static bool take_screenshot_push(struct screenshot_job *job,
+      const char *thumbnail_path)
+{
+   if (!thumbnail_path)
+   {
+      job->cb = take_screenshot_cb;
+      return screenshot_job_push(job);
+   }
+
+   strlcpy(job->filename, thumbnail_path, sizeof(job->filename));
+
+   /* Keeps the aspect ratio of the frame, never upscales. */
+   if (job->width * THUMBNAIL_MAX_HEIGHT > job->height * THUMBNAIL_MAX_WIDTH)
+   {
+      if (job->width > THUMBNAIL_MAX_WIDTH)
+      {
+         job->out_width  = THUMBNAIL_MAX_WIDTH;
+         job->out_height = job->height * THUMBNAIL_MAX_WIDTH / job->width;
+      }
+   }
+   else if (job->height > THUMBNAIL_MAX_HEIGHT)
+   {
+      job->out_width  = job->width * THUMBNAIL_MAX_HEIGHT / job->height;
+      job->out_height = THUMBNAIL_MAX_HEIGHT;
+   }
+
+   if (!job->out_width)
+      job->out_width  = 1;
+   if (!job->out_height)
+      job->out_height = 1;
+
+   job->cb = take_thumbnail_cb;
+   return screenshot_job_push(job);
+}
+
+static bool take_screenshot_viewport(const char *thumbnail_path)
 {
    char screenshot_path[PATH_MAX_LENGTH] = {0};
-   const char *screenshot_dir            = NULL;
-   uint8_t *buffer                       = NULL;
-   bool retval                           = false;
+   const char *screenshot_dir            = "";
+   struct screenshot_job *job            = NULL;
    struct video_viewport vp              = {0};
-   settings_t *settings                  = config_get_ptr();
-   global_t *global                      = global_get_ptr();
 
    video_driver_viewport_info(&vp);
 
    if (!vp.width || !vp.height)
       return false;
 
-   if (!(buffer = (uint8_t*)malloc(vp.width * vp.height * 3)))
-      return false;
-
-   if (!video_driver_read_viewport(buffer))
-      goto done;
+   if (!thumbnail_path)
+      screenshot_dir = screenshot_get_dir(screenshot_path,
+            sizeof(screenshot_path));
 
-   screenshot_dir = settings->screenshot_directory;
+   /* Data read from viewport is in bottom-up order, suitable for BMP.
+    * It is read straight into the job buffer, so no further copy
+    * is needed before handing it over to the worker. */
+   if (!(job = screenshot_job_new(screenshot_dir,
+               vp.width, vp.height, true)))
+      return false;
 
-   if (!*settings->screenshot_directory)
+   if (!video_driver_read_viewport(job->buffer))
    {
-      fill_pathname_basedir(screenshot_path, global->name.base,
-            sizeof(screenshot_path));
-      screenshot_dir = screenshot_path;
+      screenshot_job_free(job);
+      return false;
    }
 
-   /* Data read from viewport is in bottom-up order, suitable for BMP. */
-   if (!screenshot_dump(screenshot_dir, buffer, vp.width, vp.height,
-            vp.width * 3, true))
-      goto done;
-
-   retval = true;
-
-done:
-   if (buffer)
-      free(buffer);
-   return retval;
+   return take_screenshot_push(job, thumbnail_path);
 }
 
-static bool take_screenshot_raw(void)
+static bool take_screenshot_raw(const char *thumbnail_path)
 {
-   unsigned width, height;
+   unsigned width, height, i;
    size_t pitch;
    char screenshot_path[PATH_MAX_LENGTH] = {0};
    const void *data                      = NULL;
-   const char *screenshot_dir            = NULL;
-   global_t *global                      = global_get_ptr();
-   settings_t *settings                  = config_get_ptr();
+   const char *screenshot_dir            = "";
+   struct screenshot_job *job            = NULL;
 
    video_driver_cached_frame_get(&data, &width, &height, &pitch);
-   
-   screenshot_dir = settings->screenshot_directory;
 
-   if (!*settings->screenshot_directory)
-   {
-      fill_pathname_basedir(screenshot_path, global->name.base,
+   if (!data || !width || !height)
+      return false;
+
+   if (!thumbnail_path)
+      screenshot_dir = screenshot_get_dir(screenshot_path,
             sizeof(screenshot_path));
-      screenshot_dir = screenshot_path;
-   }
 
-   /* Negative pitch is needed as screenshot takes bottom-up,
-    * but we use top-down.
-    */
-   return screenshot_dump(screenshot_dir,
-         (const uint8_t*)data + (height - 1) * pitch,
-         width, height, -pitch, false);
+   if (!(job = screenshot_job_new(screenshot_dir, width, height, false)))
+      return false;
+
+   /* Screenshot takes bottom-up, but we use top-down.
+    * Flip while copying so the frame can be released
+    * as soon as we return. */
+   for (i = 0; i < height; i++)
+      memcpy(job->buffer + i * job->pitch,
+            (const uint8_t*)data + (height - 1 - i) * pitch,
+            job->pitch);
+
+   return take_screenshot_push(job, thumbnail_path);
 }
 
 /**
- * take_screenshot:
+ * take_screenshot_capture:
+ * @thumbnail_path  : path of the thumbnail to write, or NULL
+ *
+ * Captures the current frame, from the viewport or from the
+ * last frame of the core, and queues it for encoding.
  *
  * Returns: true (1) if successful, otherwise false (0).
  **/
-bool take_screenshot(void)
+static bool take_screenshot_capture(const char *thumbnail_path)
 {
    bool viewport_read   = false;
    bool ret             = true;
-   const char *msg      = NULL;
    driver_t *driver     = driver_get_ptr();
    settings_t *settings = config_get_ptr();
-   global_t *global     = global_get_ptr();
    const struct retro_hw_render_callback *hw_render = 
       (const struct retro_hw_render_callback*)video_driver_callback();
 
-   /* No way to infer screenshot directory. */
-   if ((!*settings->screenshot_directory) && (!*global->name.base))
-      return false;
-
    viewport_read = (settings->video.gpu_screenshot ||
          ((hw_render->context_type
          != RETRO_HW_CONTEXT_NONE) && !driver->video->read_frame_raw))
@@ -284,9 +723,9 @@ bool take_screenshot(void)
    }
 
    if (viewport_read)
-      ret = take_screenshot_viewport();
+      ret = take_screenshot_viewport(thumbnail_path);
    else if (!video_driver_cached_frame_has_valid_fb())
-      ret = take_screenshot_raw();
+      ret = take_screenshot_raw(thumbnail_path);
    else if (driver->video->read_frame_raw)
    {
       unsigned old_width, old_height;
@@ -306,7 +745,7 @@ bool take_screenshot(void)
       if (frame_data)
       {
          video_driver_cached_frame_set_ptr(frame_data);
-         ret = take_screenshot_raw();
+         ret = take_screenshot_raw(thumbnail_path);
          free(frame_data);
       }
       else
@@ -318,6 +757,29 @@ bool take_screenshot(void)
       ret = false;
    }
 
+   return ret;
+}
+
+/**
+ * take_screenshot:
+ *
+ * Captures the current frame and queues it for encoding
+ * on the screenshot worker thread.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool take_screenshot(void)
+{
+   bool ret             = true;
+   const char *msg      = NULL;
+   settings_t *settings = config_get_ptr();
+   global_t *global     = global_get_ptr();
+
+   /* No way to infer screenshot directory. */
+   if ((!*settings->screenshot_directory) && (!*global->name.base))
+      return false;
+
+   ret = take_screenshot_capture(NULL);
 
    if (ret)
    {
@@ -338,94 +800,74 @@ bool take_screenshot(void)
    return ret;
 }
 
-
-/* Take frame bottom-up. */
-bool screenshot_dump(const char *folder, const void *frame,
-      unsigned width, unsigned height, int pitch, bool bgr24)
+/**
+ * take_savestate_thumbnail:
+ * @path            : path of the thumbnail to write
+ *
+ * Captures the current frame and queues it for encoding as
+ * a downscaled PNG on the screenshot worker thread.
+ *
+ * Returns: true (1) if the thumbnail was queued, otherwise false (0).
+ **/
+bool take_savestate_thumbnail(const char *path)
 {
-   char filename[PATH_MAX_LENGTH] = {0};
-   char shotname[PATH_MAX_LENGTH] = {0};
-   struct scaler_ctx scaler       = {0};
-   FILE *file                     = NULL;
-   uint8_t *out_buffer            = NULL;
-   bool ret                       = false;
-   driver_t *driver               = driver_get_ptr();
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG) && !defined(_XBOX1)
+   bool ret = take_screenshot_capture(path);
 
-   (void)file;
-   (void)out_buffer;
-   (void)scaler;
-   (void)driver;
-
-   fill_dated_filename(shotname, IMG_EXT, sizeof(shotname));
-   fill_pathname_join(filename, folder, shotname, sizeof(filename));
-
-#ifdef _XBOX1
-   d3d_video_t *d3d = (d3d_video_t*)driver->video_data;
-   settings_t *settings = config_get_ptr();
+   if (rarch_main_is_paused())
+      video_driver_cached_frame();
 
-   D3DSurface *surf = NULL;
-   d3d->dev->GetBackBuffer(-1, D3DBACKBUFFER_TYPE_MONO, &surf);
-   ret = XGWriteSurfaceToFile(surf, filename);
-   surf->Release();
+   return ret;
+#else
+   /* Thumbnails are only written as PNG. */
+   (void)path;
+   return false;
+#endif
+}
 
-   if(ret == S_OK)
-   {
-      RARCH_LOG("Screenshot saved: %s.\n", filename);
-      rarch_main_msg_queue_push("Screenshot saved.", 1, 30, false);
-      return true;
-   }
+/**
+ * screenshot_dump_async:
+ * @folder          : directory to write the screenshot to
+ * @frame           : frame data, bottom-up
+ * @width           : width of the frame
+ * @height          : height of the frame
+ * @pitch           : pitch of the frame, may be negative
+ * @bgr24           : frame is BGR24 instead of the core pixel format
+ * @cb              : completion callback, may be NULL
+ * @userdata        : userdata passed to @cb
+ *
+ * Copies @frame and encodes it on the screenshot worker thread.
+ * @cb is invoked from the worker thread once the file is written.
+ *
+ * Returns: true (1) if the screenshot was queued, otherwise false (0).
+ **/
+bool screenshot_dump_async(const char *folder, const void *frame,
+      unsigned width, unsigned height, int pitch, bool bgr24,
+      screenshot_cb_t cb, void *userdata)
+{
+   unsigned i;
+   struct screenshot_job *job = NULL;
 
-   ret = false;
-#elif defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
-   out_buffer = (uint8_t*)malloc(width * height * 3);
-   if (!out_buffer)
+   if (!(job = screenshot_job_new(folder, width, height, bgr24)))
       return false;
 
-   scaler.in_width    = width;
-   scaler.in_height   = height;
-   scaler.out_width   = width;
-   scaler.out_height  = height;
-   scaler.in_stride   = -pitch;
-   scaler.out_stride  = width * 3;
-   scaler.out_fmt     = SCALER_FMT_BGR24;
-   scaler.scaler_type = SCALER_TYPE_POINT;
-
-   if (bgr24)
-      scaler.in_fmt = SCALER_FMT_BGR24;
-   else if (video_driver_get_pixel_format() == RETRO_PIXEL_FORMAT_XRGB8888)
-      scaler.in_fmt = SCALER_FMT_ARGB8888;
-   else
-      scaler.in_fmt = SCALER_FMT_RGB565;
+   for (i = 0; i < height; i++)
+      memcpy(job->buffer + i * job->pitch,
+            (const uint8_t*)frame + (int)i * pitch, job->pitch);
 
-   scaler_ctx_gen_filter(&scaler);
-   scaler_ctx_scale(&scaler, out_buffer,
-         (const uint8_t*)frame + ((int)height - 1) * pitch);
-   scaler_ctx_gen_reset(&scaler);
+   job->cb       = cb;
+   job->userdata = userdata;
 
-   RARCH_LOG("Using RPNG for PNG screenshots.\n");
-   ret = rpng_save_image_bgr24(filename,
-         out_buffer, width, height, width * 3);
-   if (!ret)
-      RARCH_ERR("Failed to take screenshot.\n");
-   free(out_buffer);
-#else
-   file = fopen(filename, "wb");
-   if (!file)
-   {
-      RARCH_ERR("Failed to open file \"%s\" for screenshot.\n", filename);
-      return false;
-   }
-
-   ret = write_header_bmp(file, width, height);
+   return screenshot_job_push(job);
+}
 
-   if (ret)
-      dump_content(file, frame, width, height, pitch, bgr24);
-   else
-      RARCH_ERR("Failed to write image header.\n");
+/* Take frame bottom-up. */
+bool screenshot_dump(const char *folder, const void *frame,
+      unsigned width, unsigned height, int pitch, bool bgr24)
+{
+   struct screenshot_job job = {{0}};
 
-   fclose(file);
-#endif
+   screenshot_job_init(&job, folder, frame, width, height, pitch, bgr24);
 
-   return ret;
+   return screenshot_job_write(&job);
 }
-
@@ -25,13 +25,55 @@
 extern "C" {
 #endif
 
+typedef void (*screenshot_cb_t)(bool success, const char *path,
+      void *userdata);
+
 bool screenshot_dump(const char *folder, const void *frame, 
       unsigned width, unsigned height, int pitch, bool bgr24);
 
+/**
+ * screenshot_dump_async:
+ * @folder          : directory to write the screenshot to
+ * @frame           : frame data, bottom-up
+ * @width           : width of the frame
+ * @height          : height of the frame
+ * @pitch           : pitch of the frame, may be negative
+ * @bgr24           : frame is BGR24 instead of the core pixel format
+ * @cb              : completion callback, may be NULL
+ * @userdata        : userdata passed to @cb
+ *
+ * Copies @frame and encodes it on the screenshot worker thread.
+ * @cb is invoked from the worker thread once the file is written.
+ *
+ * Returns: true (1) if the screenshot was queued, otherwise false (0).
+ **/
+bool screenshot_dump_async(const char *folder, const void *frame,
+      unsigned width, unsigned height, int pitch, bool bgr24,
+      screenshot_cb_t cb, void *userdata);
+
+/**
+ * screenshot_deinit:
+ *
+ * Waits for all pending screenshots to be written
+ * and tears down the screenshot worker thread.
+ **/
+void screenshot_deinit(void);
+
 void screenshot_generate_filename(char *filename, size_t size);
 
 bool take_screenshot(void);
 
+/**
+ * take_savestate_thumbnail:
+ * @path            : path of the thumbnail to write
+ *
+ * Captures the current frame and queues it for encoding as
+ * a downscaled PNG on the screenshot worker thread.
+ *
+ * Returns: true (1) if the thumbnail was queued, otherwise false (0).
+ **/
+bool take_savestate_thumbnail(const char *path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,124 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Test module for the core info cache. Writes a cache for cores
+ * sharing .info files, as found once platform suffixes are stripped
+ * from core names, then reads every core back from it.
+ *
+ * Build it after RetroArch, against the same objects except
+ * core_info.o which is included here. Its main() comes first
+ * and takes precedence over the frontend's:
+ *
+ *    cc -I. -Ilibretro-common/include tests/test_core_info_cache.c \
+ *       <RetroArch objects except core_info.o> \
+ *       -Wl,--allow-multiple-definition <RetroArch libraries>
+ */
+
+#include "../core_info.c"
+
+#define TEST_CORES 5
+
+static const char *test_names[TEST_CORES] = {
+   "snes9x_libretro.info",
+   "vba_next_libretro.info",
+   "snes9x_libretro.info",
+   NULL,
+   "bsnes_libretro.info",
+};
+
+static int test_failed;
+
+#define TEST_CHECK(cond) do { \
+   if (!(cond)) \
+   { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", \
+            __FILE__, __LINE__, #cond); \
+      test_failed = 1; \
+   } \
+} while (0)
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   core_info_cache_t cache;
+   core_info_t cores[TEST_CORES];
+   core_info_stamp_t stamps[TEST_CORES];
+   core_info_list_t list;
+   const char *path = (argc > 1) ? argv[1] : "core_info_cache_test.bin";
+
+   memset(cores, 0, sizeof(cores));
+   memset(stamps, 0, sizeof(stamps));
+
+   for (i = 0; i < TEST_CORES; i++)
+   {
+      char name[64];
+
+      snprintf(name, sizeof(name), "Core %u", (unsigned)i);
+      cores[i].display_name = strdup(name);
+
+      stamps[i].name  = test_names[i] ? strdup(test_names[i]) : NULL;
+      stamps[i].mtime = 1000 + i;
+      stamps[i].size  = 100;
+      stamps[i].index = i;
+   }
+
+   /* Cores sharing an .info file got it parsed the same way. */
+   stamps[2].mtime = stamps[0].mtime;
+
+   list.list    = cores;
+   list.count   = TEST_CORES;
+   list.all_ext = NULL;
+
+   core_info_cache_save(path, &list, stamps, TEST_CORES);
+
+   TEST_CHECK(core_info_cache_load(&cache, path));
+   TEST_CHECK(cache.header && cache.header->core_count == 3);
+
+   for (i = 0; i < TEST_CORES; i++)
+   {
+      core_info_t info;
+      core_info_stamp_t stamp;
+
+      if (!test_names[i])
+         continue;
+
+      memset(&info, 0, sizeof(info));
+      stamp.name  = (char*)test_names[i];
+      stamp.mtime = 1000 + (i == 2 ? 0 : i);
+      stamp.size  = 100;
+      stamp.index = i;
+
+      TEST_CHECK(core_info_cache_read(&cache, &stamp, &info));
+      TEST_CHECK(info.display_name && !strcmp(info.display_name,
+               cores[i == 2 ? 0 : i].display_name));
+      free(info.display_name);
+   }
+
+   core_info_cache_free(&cache);
+   remove(path);
+
+   for (i = 0; i < TEST_CORES; i++)
+   {
+      free(stamps[i].name);
+      free(cores[i].display_name);
+   }
+
+   if (test_failed)
+      return 1;
+
+   printf("core info cache: OK\n");
+   return 0;
+}